@@ -1,3 +1,5 @@
+#pragma once
+
 #define NODISCARD [[nodiscard]]
 
 namespace mrt
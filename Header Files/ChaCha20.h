@@ -0,0 +1,471 @@
+#pragma once
+
+#include <array>
+#include <cstdint>
+#include <cstring>
+
+#if defined(__x86_64__) || defined(_M_X64) || defined(__i386__) || defined(_M_IX86)
+#define MRT_CHACHA20_X86
+#include <immintrin.h>
+
+#if defined(_MSC_VER) && !defined(__clang__)
+#include <intrin.h>
+#define MRT_TARGET_SSE2
+#define MRT_TARGET_AVX2
+#else
+// The vector paths are compiled for their instruction sets on their own, and only run once the processor is known to have them.
+#define MRT_TARGET_SSE2 __attribute__((target("sse2")))
+#define MRT_TARGET_AVX2 __attribute__((target("avx2")))
+#endif
+#endif
+
+namespace mrt
+{
+	/// <summary>
+	/// ChaCha20 class encrypts and decrypts bytes with the ChaCha20 stream cipher of RFC 8439, a 256-bit key, a 96-bit nonce and a 32-bit block counter.
+	/// The bytes are XORed with the keystream, so encrypting and decrypting are the same operation, and since each 64-byte block of the keystream
+	/// depends only on its counter, any part of a buffer can be encrypted on its own, such as by several threads at once.
+	///
+	/// The keystream is made several blocks at a time with each word of the blocks side by side, one block in each lane of a vector:
+	/// eight blocks with AVX2, four with SSE2, and four with portable code that compilers vectorize as they can. The fastest path
+	/// the processor has is chosen when the program runs, and every path gives the same bytes.
+	/// </summary>
+	class ChaCha20
+	{
+	public:
+		static constexpr uint64_t s_KeySize = 32;
+		static constexpr uint64_t s_NonceSize = 12;
+		static constexpr uint64_t s_BlockSize = 64;
+
+		/// <summary>
+		/// The code that makes the keystream, from the slowest to the fastest.
+		/// </summary>
+		enum class Path
+		{
+			Portable,
+			Sse2,
+			Avx2
+		};
+
+	private:
+		static constexpr uint64_t s_Lanes = 4;
+
+		// The state of the first block, the counter word is set for each block.
+		std::array<uint32_t, 16> m_State{};
+		Path m_Path;
+	public:
+		/// <summary>
+		/// Initializes a new instance of the <see cref="ChaCha20"/> class.
+		/// </summary>
+		/// <param name="key"> The key, <see cref="s_KeySize"/> bytes. </param>
+		/// <param name="nonce"> The nonce, <see cref="s_NonceSize"/> bytes, a key must never be used twice with the same nonce. </param>
+		/// <param name="path"> The path to make the keystream with, a path the processor does not have falls back to the fastest one it has. </param>
+		ChaCha20(const uint8_t* key, const uint8_t* nonce, Path path = FastestPath())
+			: m_Path(path > FastestPath() ? FastestPath() : path)
+		{
+			m_State[0] = 0x61707865u;
+			m_State[1] = 0x3320646eu;
+			m_State[2] = 0x79622d32u;
+			m_State[3] = 0x6b206574u;
+
+			for (int i = 0; i < 8; i++)
+			{
+				m_State[4 + i] = Load32(key + 4 * i);
+			}
+
+			for (int i = 0; i < 3; i++)
+			{
+				m_State[13 + i] = Load32(nonce + 4 * i);
+			}
+		}
+
+		/// <summary>
+		/// XORs bytes with the keystream, which encrypts plain bytes and decrypts encrypted ones.
+		/// </summary>
+		/// <param name="data"> The bytes, changed in place. </param>
+		/// <param name="size"> The number of bytes. </param>
+		/// <param name="counter"> The counter of the block the first byte is in, so a buffer at offset n continues at counter n / 64. </param>
+		void Apply(char* data, uint64_t size, uint32_t counter) const
+		{
+#if defined(MRT_CHACHA20_X86)
+			uint64_t blocks = 0;
+
+			if (m_Path == Path::Avx2)
+			{
+				blocks = ApplyAvx2(m_State.data(), data, size / (8 * s_BlockSize), counter);
+			}
+			else if (m_Path == Path::Sse2)
+			{
+				blocks = ApplySse2(m_State.data(), data, size / (4 * s_BlockSize), counter);
+			}
+
+			data += blocks * s_BlockSize;
+			size -= blocks * s_BlockSize;
+			counter += static_cast<uint32_t>(blocks);
+#endif
+
+			uint8_t keystream[s_Lanes * s_BlockSize];
+
+			while (size > 0)
+			{
+				Blocks(counter, keystream);
+
+				uint64_t count = size < sizeof(keystream) ? size : sizeof(keystream);
+				uint64_t i = 0;
+
+				for (; i + 8 <= count; i += 8)
+				{
+					uint64_t word;
+					uint64_t key_word;
+					std::memcpy(&word, data + i, sizeof(word));
+					std::memcpy(&key_word, keystream + i, sizeof(key_word));
+					word ^= key_word;
+					std::memcpy(data + i, &word, sizeof(word));
+				}
+
+				for (; i < count; i++)
+				{
+					data[i] ^= static_cast<char>(keystream[i]);
+				}
+
+				data += count;
+				size -= count;
+				counter += s_Lanes;
+			}
+		}
+
+		/// <summary>
+		/// Writes a single block of the keystream, as specified by RFC 8439.
+		/// </summary>
+		/// <param name="counter"> The counter of the block. </param>
+		/// <param name="output"> The buffer to write the <see cref="s_BlockSize"/> bytes of the block to. </param>
+		void Block(uint32_t counter, uint8_t* output) const
+		{
+			uint8_t keystream[s_Lanes * s_BlockSize];
+
+			Blocks(counter, keystream);
+			std::memcpy(output, keystream, s_BlockSize);
+		}
+
+		/// <summary>
+		/// Gets the path the keystream is made with.
+		/// </summary>
+		Path GetPath() const
+		{
+			return m_Path;
+		}
+
+		/// <summary>
+		/// Gets the fastest path the processor has, found once.
+		/// </summary>
+		static Path FastestPath()
+		{
+			static const Path s_Path = DetectPath();
+
+			return s_Path;
+		}
+
+		/// <summary>
+		/// Gets the name of a path, for reports.
+		/// </summary>
+		static const char* PathName(Path path)
+		{
+			switch (path)
+			{
+			case Path::Avx2:
+				return "avx2";
+			case Path::Sse2:
+				return "sse2";
+			default:
+				return "portable";
+			}
+		}
+
+	private:
+		/// <summary>
+		/// Finds the fastest path the processor and the operating system support.
+		/// </summary>
+		static Path DetectPath()
+		{
+#if defined(MRT_CHACHA20_X86)
+#if defined(_MSC_VER) && !defined(__clang__)
+			int info[4];
+			__cpuid(info, 0);
+			int max_leaf = info[0];
+
+			__cpuid(info, 1);
+			bool has_sse2 = (info[3] >> 26) & 1;
+			bool has_avx = ((info[2] >> 27) & 1) && ((info[2] >> 28) & 1) && (_xgetbv(0) & 6) == 6;
+			bool has_avx2 = false;
+
+			if (has_avx && max_leaf >= 7)
+			{
+				__cpuidex(info, 7, 0);
+				has_avx2 = (info[1] >> 5) & 1;
+			}
+#else
+			__builtin_cpu_init();
+			bool has_sse2 = __builtin_cpu_supports("sse2");
+			bool has_avx2 = __builtin_cpu_supports("avx2");
+#endif
+			if (has_avx2)
+				return Path::Avx2;
+
+			if (has_sse2)
+				return Path::Sse2;
+#endif
+			return Path::Portable;
+		}
+
+		/// <summary>
+		/// Writes four blocks of the keystream, starting at the counter, one after the other.
+		/// </summary>
+		void Blocks(uint32_t counter, uint8_t* output) const
+		{
+			uint32_t x[16][s_Lanes];
+
+			for (int word = 0; word < 16; word++)
+			{
+				for (uint64_t lane = 0; lane < s_Lanes; lane++)
+				{
+					x[word][lane] = m_State[word];
+				}
+			}
+
+			for (uint64_t lane = 0; lane < s_Lanes; lane++)
+			{
+				x[12][lane] = counter + static_cast<uint32_t>(lane);
+			}
+
+			uint32_t initial[16][s_Lanes];
+			std::memcpy(initial, x, sizeof(x));
+
+			for (int round = 0; round < 10; round++)
+			{
+				QuarterRound(x[0], x[4], x[8], x[12]);
+				QuarterRound(x[1], x[5], x[9], x[13]);
+				QuarterRound(x[2], x[6], x[10], x[14]);
+				QuarterRound(x[3], x[7], x[11], x[15]);
+
+				QuarterRound(x[0], x[5], x[10], x[15]);
+				QuarterRound(x[1], x[6], x[11], x[12]);
+				QuarterRound(x[2], x[7], x[8], x[13]);
+				QuarterRound(x[3], x[4], x[9], x[14]);
+			}
+
+			for (uint64_t lane = 0; lane < s_Lanes; lane++)
+			{
+				for (int word = 0; word < 16; word++)
+				{
+					Store32(output + lane * s_BlockSize + 4 * word, x[word][lane] + initial[word][lane]);
+				}
+			}
+		}
+
+		/// <summary>
+		/// Runs the quarter round on the same four words of every lane.
+		/// </summary>
+		static void QuarterRound(uint32_t* a, uint32_t* b, uint32_t* c, uint32_t* d)
+		{
+			for (uint64_t lane = 0; lane < s_Lanes; lane++)
+			{
+				a[lane] += b[lane]; d[lane] = Rotate(d[lane] ^ a[lane], 16);
+				c[lane] += d[lane]; b[lane] = Rotate(b[lane] ^ c[lane], 12);
+				a[lane] += b[lane]; d[lane] = Rotate(d[lane] ^ a[lane], 8);
+				c[lane] += d[lane]; b[lane] = Rotate(b[lane] ^ c[lane], 7);
+			}
+		}
+
+#if defined(MRT_CHACHA20_X86)
+		/// <summary>
+		/// XORs groups of four blocks with the keystream, made with SSE2.
+		/// The words of the four blocks are turned back into four blocks of words with unpacks, before they are XORed with the bytes.
+		/// </summary>
+		/// <returns> The number of blocks XORed. </returns>
+		MRT_TARGET_SSE2 static uint64_t ApplySse2(const uint32_t* state, char* data, uint64_t groups, uint32_t counter)
+		{
+			__m128i initial[16];
+
+			for (int word = 0; word < 16; word++)
+			{
+				initial[word] = _mm_set1_epi32(static_cast<int>(state[word]));
+			}
+
+			initial[12] = _mm_add_epi32(_mm_set1_epi32(static_cast<int>(counter)), _mm_setr_epi32(0, 1, 2, 3));
+
+			for (uint64_t group = 0; group < groups; group++)
+			{
+				__m128i x[16];
+
+				for (int word = 0; word < 16; word++)
+				{
+					x[word] = initial[word];
+				}
+
+				for (int round = 0; round < 10; round++)
+				{
+					QuarterRoundSse2(x[0], x[4], x[8], x[12]);
+					QuarterRoundSse2(x[1], x[5], x[9], x[13]);
+					QuarterRoundSse2(x[2], x[6], x[10], x[14]);
+					QuarterRoundSse2(x[3], x[7], x[11], x[15]);
+
+					QuarterRoundSse2(x[0], x[5], x[10], x[15]);
+					QuarterRoundSse2(x[1], x[6], x[11], x[12]);
+					QuarterRoundSse2(x[2], x[7], x[8], x[13]);
+					QuarterRoundSse2(x[3], x[4], x[9], x[14]);
+				}
+
+				for (int word = 0; word < 16; word += 4)
+				{
+					__m128i a = _mm_add_epi32(x[word], initial[word]);
+					__m128i b = _mm_add_epi32(x[word + 1], initial[word + 1]);
+					__m128i c = _mm_add_epi32(x[word + 2], initial[word + 2]);
+					__m128i d = _mm_add_epi32(x[word + 3], initial[word + 3]);
+
+					__m128i ab_low = _mm_unpacklo_epi32(a, b);
+					__m128i cd_low = _mm_unpacklo_epi32(c, d);
+					__m128i ab_high = _mm_unpackhi_epi32(a, b);
+					__m128i cd_high = _mm_unpackhi_epi32(c, d);
+
+					__m128i blocks[4] = {
+						_mm_unpacklo_epi64(ab_low, cd_low),
+						_mm_unpackhi_epi64(ab_low, cd_low),
+						_mm_unpacklo_epi64(ab_high, cd_high),
+						_mm_unpackhi_epi64(ab_high, cd_high)
+					};
+
+					for (int block = 0; block < 4; block++)
+					{
+						__m128i* position = reinterpret_cast<__m128i*>(data + block * s_BlockSize + word * 4);
+						_mm_storeu_si128(position, _mm_xor_si128(_mm_loadu_si128(position), blocks[block]));
+					}
+				}
+
+				initial[12] = _mm_add_epi32(initial[12], _mm_set1_epi32(4));
+				data += 4 * s_BlockSize;
+			}
+
+			return groups * 4;
+		}
+
+		MRT_TARGET_SSE2 static void QuarterRoundSse2(__m128i& a, __m128i& b, __m128i& c, __m128i& d)
+		{
+			a = _mm_add_epi32(a, b); d = _mm_xor_si128(d, a); d = _mm_or_si128(_mm_slli_epi32(d, 16), _mm_srli_epi32(d, 16));
+			c = _mm_add_epi32(c, d); b = _mm_xor_si128(b, c); b = _mm_or_si128(_mm_slli_epi32(b, 12), _mm_srli_epi32(b, 20));
+			a = _mm_add_epi32(a, b); d = _mm_xor_si128(d, a); d = _mm_or_si128(_mm_slli_epi32(d, 8), _mm_srli_epi32(d, 24));
+			c = _mm_add_epi32(c, d); b = _mm_xor_si128(b, c); b = _mm_or_si128(_mm_slli_epi32(b, 7), _mm_srli_epi32(b, 25));
+		}
+
+		/// <summary>
+		/// XORs groups of eight blocks with the keystream, made with AVX2.
+		/// Each half of a vector holds four of the blocks, so the words are unpacked within the halves as with SSE2,
+		/// and the halves are then put together into whole blocks. The rotations by whole bytes are done with a byte shuffle.
+		/// </summary>
+		/// <returns> The number of blocks XORed. </returns>
+		MRT_TARGET_AVX2 static uint64_t ApplyAvx2(const uint32_t* state, char* data, uint64_t groups, uint32_t counter)
+		{
+			__m256i initial[16];
+
+			for (int word = 0; word < 16; word++)
+			{
+				initial[word] = _mm256_set1_epi32(static_cast<int>(state[word]));
+			}
+
+			initial[12] = _mm256_add_epi32(_mm256_set1_epi32(static_cast<int>(counter)), _mm256_setr_epi32(0, 1, 2, 3, 4, 5, 6, 7));
+
+			const __m256i rotate16 = _mm256_setr_epi8(2, 3, 0, 1, 6, 7, 4, 5, 10, 11, 8, 9, 14, 15, 12, 13, 2, 3, 0, 1, 6, 7, 4, 5, 10, 11, 8, 9, 14, 15, 12, 13);
+			const __m256i rotate8 = _mm256_setr_epi8(3, 0, 1, 2, 7, 4, 5, 6, 11, 8, 9, 10, 15, 12, 13, 14, 3, 0, 1, 2, 7, 4, 5, 6, 11, 8, 9, 10, 15, 12, 13, 14);
+
+			for (uint64_t group = 0; group < groups; group++)
+			{
+				__m256i x[16];
+
+				for (int word = 0; word < 16; word++)
+				{
+					x[word] = initial[word];
+				}
+
+				for (int round = 0; round < 10; round++)
+				{
+					QuarterRoundAvx2(x[0], x[4], x[8], x[12], rotate16, rotate8);
+					QuarterRoundAvx2(x[1], x[5], x[9], x[13], rotate16, rotate8);
+					QuarterRoundAvx2(x[2], x[6], x[10], x[14], rotate16, rotate8);
+					QuarterRoundAvx2(x[3], x[7], x[11], x[15], rotate16, rotate8);
+
+					QuarterRoundAvx2(x[0], x[5], x[10], x[15], rotate16, rotate8);
+					QuarterRoundAvx2(x[1], x[6], x[11], x[12], rotate16, rotate8);
+					QuarterRoundAvx2(x[2], x[7], x[8], x[13], rotate16, rotate8);
+					QuarterRoundAvx2(x[3], x[4], x[9], x[14], rotate16, rotate8);
+				}
+
+				// The four words of each quarter of the blocks, for blocks 0 to 3 in the low halves and 4 to 7 in the high halves.
+				__m256i quarters[4][4];
+
+				for (int quarter = 0; quarter < 4; quarter++)
+				{
+					int word = quarter * 4;
+					__m256i a = _mm256_add_epi32(x[word], initial[word]);
+					__m256i b = _mm256_add_epi32(x[word + 1], initial[word + 1]);
+					__m256i c = _mm256_add_epi32(x[word + 2], initial[word + 2]);
+					__m256i d = _mm256_add_epi32(x[word + 3], initial[word + 3]);
+
+					__m256i ab_low = _mm256_unpacklo_epi32(a, b);
+					__m256i cd_low = _mm256_unpacklo_epi32(c, d);
+					__m256i ab_high = _mm256_unpackhi_epi32(a, b);
+					__m256i cd_high = _mm256_unpackhi_epi32(c, d);
+
+					quarters[quarter][0] = _mm256_unpacklo_epi64(ab_low, cd_low);
+					quarters[quarter][1] = _mm256_unpackhi_epi64(ab_low, cd_low);
+					quarters[quarter][2] = _mm256_unpacklo_epi64(ab_high, cd_high);
+					quarters[quarter][3] = _mm256_unpackhi_epi64(ab_high, cd_high);
+				}
+
+				for (int block = 0; block < 4; block++)
+				{
+					XorAvx2(data + block * s_BlockSize, _mm256_permute2x128_si256(quarters[0][block], quarters[1][block], 0x20));
+					XorAvx2(data + block * s_BlockSize + 32, _mm256_permute2x128_si256(quarters[2][block], quarters[3][block], 0x20));
+					XorAvx2(data + (block + 4) * s_BlockSize, _mm256_permute2x128_si256(quarters[0][block], quarters[1][block], 0x31));
+					XorAvx2(data + (block + 4) * s_BlockSize + 32, _mm256_permute2x128_si256(quarters[2][block], quarters[3][block], 0x31));
+				}
+
+				initial[12] = _mm256_add_epi32(initial[12], _mm256_set1_epi32(8));
+				data += 8 * s_BlockSize;
+			}
+
+			return groups * 8;
+		}
+
+		MRT_TARGET_AVX2 static void QuarterRoundAvx2(__m256i& a, __m256i& b, __m256i& c, __m256i& d, __m256i rotate16, __m256i rotate8)
+		{
+			a = _mm256_add_epi32(a, b); d = _mm256_shuffle_epi8(_mm256_xor_si256(d, a), rotate16);
+			c = _mm256_add_epi32(c, d); b = _mm256_xor_si256(b, c); b = _mm256_or_si256(_mm256_slli_epi32(b, 12), _mm256_srli_epi32(b, 20));
+			a = _mm256_add_epi32(a, b); d = _mm256_shuffle_epi8(_mm256_xor_si256(d, a), rotate8);
+			c = _mm256_add_epi32(c, d); b = _mm256_xor_si256(b, c); b = _mm256_or_si256(_mm256_slli_epi32(b, 7), _mm256_srli_epi32(b, 25));
+		}
+
+		MRT_TARGET_AVX2 static void XorAvx2(char* data, __m256i keystream)
+		{
+			__m256i* position = reinterpret_cast<__m256i*>(data);
+			_mm256_storeu_si256(position, _mm256_xor_si256(_mm256_loadu_si256(position), keystream));
+		}
+#endif
+
+		static uint32_t Rotate(uint32_t value, int bits)
+		{
+			return (value << bits) | (value >> (32 - bits));
+		}
+
+		static uint32_t Load32(const uint8_t* position)
+		{
+			return uint32_t(position[0]) | uint32_t(position[1]) << 8 | uint32_t(position[2]) << 16 | uint32_t(position[3]) << 24;
+		}
+
+		static void Store32(uint8_t* position, uint32_t value)
+		{
+			position[0] = static_cast<uint8_t>(value);
+			position[1] = static_cast<uint8_t>(value >> 8);
+			position[2] = static_cast<uint8_t>(value >> 16);
+			position[3] = static_cast<uint8_t>(value >> 24);
+		}
+	};
+}
@@ -0,0 +1,109 @@
+#pragma once
+
+#include "../Header Files/ChaCha20.h"
+#include "../Header Files/Poly1305.h"
+
+#include <cstdint>
+#include <cstring>
+
+namespace mrt
+{
+	/// <summary>
+	/// ChaCha20Poly1305 class encrypts and authenticates bytes with the AEAD_CHACHA20_POLY1305 construction of RFC 8439.
+	/// The bytes are encrypted with <see cref="ChaCha20"/> from block counter 1 on, and a <see cref="Poly1305"/> tag is computed over the
+	/// additional data and the encrypted bytes, with the one-time key taken from block 0 of the keystream of the nonce.
+	/// Opening checks the tag before anything is decrypted, so bytes that were changed, or sealed with another key or nonce, are refused.
+	/// </summary>
+	class ChaCha20Poly1305
+	{
+	public:
+		static constexpr uint64_t s_KeySize = ChaCha20::s_KeySize;
+		static constexpr uint64_t s_NonceSize = ChaCha20::s_NonceSize;
+		static constexpr uint64_t s_TagSize = Poly1305::s_TagSize;
+
+	private:
+		uint8_t m_Key[s_KeySize];
+		ChaCha20::Path m_Path;
+	public:
+		/// <summary>
+		/// Initializes a new instance of the <see cref="ChaCha20Poly1305"/> class.
+		/// </summary>
+		/// <param name="key"> The key, <see cref="s_KeySize"/> bytes. </param>
+		/// <param name="path"> The path the keystream is made with, see <see cref="ChaCha20::Path"/>. </param>
+		explicit ChaCha20Poly1305(const uint8_t* key, ChaCha20::Path path = ChaCha20::FastestPath())
+			: m_Path(path)
+		{
+			std::memcpy(m_Key, key, s_KeySize);
+		}
+
+		/// <summary>
+		/// Encrypts bytes in place and computes their tag.
+		/// </summary>
+		/// <param name="nonce"> The nonce, <see cref="s_NonceSize"/> bytes, which must never be used twice with the same key. </param>
+		/// <param name="additional_data"> Bytes that are authenticated along with the encrypted bytes but not encrypted, such as a header. </param>
+		/// <param name="additional_size"> The number of additional bytes. </param>
+		/// <param name="data"> The bytes, replaced by the encrypted bytes. </param>
+		/// <param name="size"> The number of bytes. </param>
+		/// <param name="tag"> The buffer to write the <see cref="s_TagSize"/> bytes of the tag to. </param>
+		void Seal(const uint8_t* nonce, const void* additional_data, uint64_t additional_size, char* data, uint64_t size, uint8_t* tag) const
+		{
+			ChaCha20 cipher(m_Key, nonce, m_Path);
+
+			cipher.Apply(data, size, 1);
+			ComputeTag(cipher, additional_data, additional_size, data, size, tag);
+		}
+
+		/// <summary>
+		/// Checks the tag of encrypted bytes, then decrypts them in place.
+		/// </summary>
+		/// <param name="nonce"> The nonce the bytes were sealed with. </param>
+		/// <param name="additional_data"> The additional bytes the bytes were sealed with. </param>
+		/// <param name="additional_size"> The number of additional bytes. </param>
+		/// <param name="data"> The encrypted bytes, replaced by the bytes if the tag matches, left as they are otherwise. </param>
+		/// <param name="size"> The number of bytes. </param>
+		/// <param name="tag"> The tag the bytes were sealed with. </param>
+		/// <returns> True if the tag matches and the bytes were decrypted, false otherwise. </returns>
+		bool Open(const uint8_t* nonce, const void* additional_data, uint64_t additional_size, char* data, uint64_t size, const uint8_t* tag) const
+		{
+			ChaCha20 cipher(m_Key, nonce, m_Path);
+			uint8_t expected[s_TagSize];
+
+			ComputeTag(cipher, additional_data, additional_size, data, size, expected);
+
+			if (!Poly1305::Equal(expected, tag))
+				return false;
+
+			cipher.Apply(data, size, 1);
+			return true;
+		}
+
+	private:
+		/// <summary>
+		/// Computes the tag of the additional data and the encrypted bytes, each padded to 16 bytes, followed by their sizes.
+		/// </summary>
+		static void ComputeTag(const ChaCha20& cipher, const void* additional_data, uint64_t additional_size, const char* data, uint64_t size, uint8_t* tag)
+		{
+			uint8_t block[ChaCha20::s_BlockSize];
+			cipher.Block(0, block);
+
+			Poly1305 mac(block);
+			std::memset(block, 0, sizeof(block));
+
+			mac.Update(additional_data, additional_size);
+			mac.PadTo16();
+			mac.Update(data, size);
+			mac.PadTo16();
+
+			uint8_t sizes[16];
+
+			for (int i = 0; i < 8; i++)
+			{
+				sizes[i] = static_cast<uint8_t>(additional_size >> (8 * i));
+				sizes[8 + i] = static_cast<uint8_t>(size >> (8 * i));
+			}
+
+			mac.Update(sizes, sizeof(sizes));
+			mac.Final(tag);
+		}
+	};
+}
@@ -3,6 +3,7 @@
 #include "../Header Files/NoCopy.h"
 #include "../Header Files/View.h"
 #include "../Header Files/TaskManager.h"
+#include "../Header Files/Time.h"
 
 /// <summary>
 /// The Controller class is the main class for the application. 
@@ -11,6 +12,9 @@
 class Controller : public cycfi::elements::app, private NoCopy
 {
 private:
+	// Startup Items
+	mrt::time::Stopwatch m_StartupStopwatch;
+
 	// Modal Items
 	std::unique_ptr<TaskManager> m_TaskManager;
 
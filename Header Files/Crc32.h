@@ -0,0 +1,106 @@
+#pragma once
+
+#include <array>
+#include <cstdint>
+#include <cstddef>
+
+namespace mrt
+{
+	/// <summary>
+	/// Computes the CRC-32 (IEEE 802.3, as used by zip and png) of a buffer.
+	/// Reads eight bytes per step from eight lookup tables, which runs at several bytes per cycle without any special instructions.
+	/// </summary>
+	class Crc32
+	{
+	private:
+		using Tables = std::array<std::array<uint32_t, 256>, 8>;
+
+		uint32_t m_Value{ 0xFFFFFFFFu };
+	public:
+		/// <summary>
+		/// Adds bytes to the checksum, a buffer can be checksummed in several parts.
+		/// </summary>
+		/// <param name="data"> The bytes. </param>
+		/// <param name="size"> The number of bytes. </param>
+		void Update(const void* data, size_t size)
+		{
+			const Tables& tables = GetTables();
+			const unsigned char* bytes = static_cast<const unsigned char*>(data);
+			uint32_t crc = m_Value;
+
+			while (size >= 8)
+			{
+				uint32_t low = crc ^ (uint32_t(bytes[0]) | uint32_t(bytes[1]) << 8 | uint32_t(bytes[2]) << 16 | uint32_t(bytes[3]) << 24);
+				uint32_t high = uint32_t(bytes[4]) | uint32_t(bytes[5]) << 8 | uint32_t(bytes[6]) << 16 | uint32_t(bytes[7]) << 24;
+
+				crc = tables[7][low & 0xFF] ^ tables[6][(low >> 8) & 0xFF] ^ tables[5][(low >> 16) & 0xFF] ^ tables[4][low >> 24] ^
+					tables[3][high & 0xFF] ^ tables[2][(high >> 8) & 0xFF] ^ tables[1][(high >> 16) & 0xFF] ^ tables[0][high >> 24];
+
+				bytes += 8;
+				size -= 8;
+			}
+
+			while (size-- > 0)
+			{
+				crc = tables[0][(crc ^ *bytes++) & 0xFF] ^ (crc >> 8);
+			}
+
+			m_Value = crc;
+		}
+
+		/// <summary>
+		/// Gets the checksum of the bytes added so far.
+		/// </summary>
+		uint32_t Value() const
+		{
+			return m_Value ^ 0xFFFFFFFFu;
+		}
+
+		/// <summary>
+		/// Computes the checksum of a buffer.
+		/// </summary>
+		/// <param name="data"> The bytes. </param>
+		/// <param name="size"> The number of bytes. </param>
+		/// <returns> The checksum. </returns>
+		static uint32_t Of(const void* data, size_t size)
+		{
+			Crc32 crc;
+			crc.Update(data, size);
+			return crc.Value();
+		}
+
+	private:
+		static const Tables& GetTables()
+		{
+			static const Tables tables = []()
+				{
+					Tables result{};
+
+					for (uint32_t i = 0; i < 256; i++)
+					{
+						uint32_t crc = i;
+
+						for (int bit = 0; bit < 8; bit++)
+						{
+							crc = (crc >> 1) ^ (0xEDB88320u & (0u - (crc & 1u)));
+						}
+
+						result[0][i] = crc;
+					}
+
+					// Each further table advances the checksum of its byte by one more byte of zeros.
+					for (uint32_t i = 0; i < 256; i++)
+					{
+						for (size_t table = 1; table < 8; table++)
+						{
+							result[table][i] = (result[table - 1][i] >> 8) ^ result[0][result[table - 1][i] & 0xFF];
+						}
+					}
+
+					return result;
+				}();
+
+			return tables;
+		}
+	};
+}
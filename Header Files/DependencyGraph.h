@@ -0,0 +1,620 @@
+#pragma once
+
+#include "../Header Files/Task.h"
+#include "../Header Files/Vector.h"
+#include "../Header Files/Subscription.h"
+#include "../Header Files/PersistentVector.h"
+
+#include <vector>
+#include <cstdint>
+#include <algorithm>
+#include <unordered_map>
+
+/// <summary>
+/// DependencyGraph class holds the dependencies between tasks as a directed acyclic graph keyed by task id.
+/// The tasks are kept in a topological order that is maintained incrementally with the Pearce-Kelly algorithm:
+/// an edge that agrees with the order costs O(1), an edge that does not only searches and reorders the tasks
+/// between its two ends in the order, and an edge that would close a cycle is found by the same search and rejected.
+/// Each task counts its prerequisites that are not done, so whether a task is ready to start is O(1).
+/// Only tasks with dependencies are in the graph, every other task is ready.
+/// </summary>
+class DependencyGraph
+{
+private:
+    static constexpr uint32_t s_None = UINT32_MAX;
+
+    struct Node
+    {
+        uint64_t task_id{ 0 };
+        uint64_t order{ 0 };
+        std::vector<uint32_t> next;
+        std::vector<uint32_t> previous;
+        uint64_t pending{ 0 };
+        bool is_done{ false };
+        bool in_use{ false };
+        bool is_visited{ false };
+    };
+
+    std::vector<Node> m_Nodes;
+    std::vector<uint32_t> m_FreeNodes;
+    std::unordered_map<uint64_t, uint32_t> m_Index;
+
+    // The node at each position of the topological order, positions of removed nodes are left empty until the order is compacted.
+    std::vector<uint32_t> m_Order;
+    uint64_t m_EmptyPositions{ 0 };
+
+    uint64_t m_EdgeCount{ 0 };
+    uint64_t m_BlockedCount{ 0 };
+
+    // Reused by each reorder, so adding an edge does not allocate once they have grown.
+    std::vector<uint32_t> m_Forward;
+    std::vector<uint32_t> m_Backward;
+    std::vector<uint32_t> m_Stack;
+    std::vector<uint64_t> m_Positions;
+public:
+    /// <summary>
+    /// Adds a task to the graph, or updates whether it is done if it is already there.
+    /// </summary>
+    /// <param name="task_id"> The id of the task. </param>
+    /// <param name="is_done"> Whether the task is done, a task that is not done blocks the tasks after it. </param>
+    void AddTask(uint64_t task_id, bool is_done)
+    {
+        if (m_Index.count(task_id) > 0)
+        {
+            SetDone(task_id, is_done);
+            return;
+        }
+
+        uint32_t index;
+
+        if (!m_FreeNodes.empty())
+        {
+            index = m_FreeNodes.back();
+            m_FreeNodes.pop_back();
+        }
+        else
+        {
+            index = static_cast<uint32_t>(m_Nodes.size());
+            m_Nodes.emplace_back();
+        }
+
+        Node& node = m_Nodes[index];
+        node.task_id = task_id;
+        node.order = m_Order.size();
+        node.pending = 0;
+        node.is_done = is_done;
+        node.in_use = true;
+
+        m_Order.push_back(index);
+        m_Index[task_id] = index;
+    }
+
+    /// <summary>
+    /// Adds a dependency, the task after can only start once the task before is done.
+    /// A task that is not in the graph yet is added as not done, see <see cref="AddTask"/>.
+    /// </summary>
+    /// <param name="before"> The id of the task that has to be done first. </param>
+    /// <param name="after"> The id of the task that waits for it. </param>
+    /// <returns> True if the dependency was added or already existed, false if it would close a cycle. </returns>
+    bool AddEdge(uint64_t before, uint64_t after)
+    {
+        if (before == after)
+            return false;
+
+        uint32_t x = FindOrAdd(before);
+        uint32_t y = FindOrAdd(after);
+
+        if (std::find(m_Nodes[x].next.begin(), m_Nodes[x].next.end(), y) != m_Nodes[x].next.end())
+            return true;
+
+        if (m_Nodes[x].order > m_Nodes[y].order && !Reorder(x, y))
+        {
+            RemoveIfIsolated(x);
+            RemoveIfIsolated(y);
+            return false;
+        }
+
+        Link(x, y);
+        return true;
+    }
+
+    /// <summary>
+    /// Removes a dependency, the tasks stay in the graph while they have other dependencies.
+    /// </summary>
+    /// <param name="before"> The id of the task that had to be done first. </param>
+    /// <param name="after"> The id of the task that waited for it. </param>
+    /// <returns> True if the dependency was removed, false if there was no such dependency. </returns>
+    bool RemoveEdge(uint64_t before, uint64_t after)
+    {
+        auto x = m_Index.find(before);
+        auto y = m_Index.find(after);
+
+        if (x == m_Index.end() || y == m_Index.end() || !Unlink(x->second, y->second))
+            return false;
+
+        RemoveIfIsolated(x->second);
+        RemoveIfIsolated(y->second);
+
+        return true;
+    }
+
+    /// <summary>
+    /// Removes a task and all of its dependencies, the tasks after it are no longer blocked by it.
+    /// </summary>
+    /// <param name="task_id"> The id of the task. </param>
+    /// <returns> True if the task had dependencies, false otherwise. </returns>
+    bool RemoveTask(uint64_t task_id)
+    {
+        auto found = m_Index.find(task_id);
+
+        if (found == m_Index.end())
+            return false;
+
+        uint32_t index = found->second;
+        bool had_edges = !m_Nodes[index].next.empty() || !m_Nodes[index].previous.empty();
+
+        while (!m_Nodes[index].next.empty())
+        {
+            uint32_t next = m_Nodes[index].next.back();
+            Unlink(index, next);
+            RemoveIfIsolated(next);
+        }
+
+        while (!m_Nodes[index].previous.empty())
+        {
+            uint32_t previous = m_Nodes[index].previous.back();
+            Unlink(previous, index);
+            RemoveIfIsolated(previous);
+        }
+
+        RemoveNode(index);
+        return had_edges;
+    }
+
+    /// <summary>
+    /// Sets whether a task is done, which unblocks or blocks the tasks after it in O(number of tasks after it).
+    /// </summary>
+    /// <param name="task_id"> The id of the task. </param>
+    /// <param name="is_done"> Whether the task is done. </param>
+    void SetDone(uint64_t task_id, bool is_done)
+    {
+        auto found = m_Index.find(task_id);
+
+        if (found == m_Index.end() || m_Nodes[found->second].is_done == is_done)
+            return;
+
+        Node& node = m_Nodes[found->second];
+        node.is_done = is_done;
+
+        for (uint32_t next : node.next)
+        {
+            if (is_done)
+            {
+                Unblock(next);
+            }
+            else
+            {
+                Block(next);
+            }
+        }
+    }
+
+    /// <summary>
+    /// Updates the graph for a change made to the tasks, a removed task loses its dependencies.
+    /// A change that affects every task has to be followed by <see cref="Refresh"/>.
+    /// </summary>
+    /// <param name="change"> The change. </param>
+    /// <returns> True if dependencies were removed, false otherwise. </returns>
+    bool Apply(const TaskChange& change)
+    {
+        if (change.affects_all)
+            return false;
+
+        if (change.fields & TaskField::Removed)
+            return RemoveTask(change.id);
+
+        if (change.fields & TaskField::Completed)
+        {
+            SetDone(change.id, change.after.is_done);
+        }
+
+        return false;
+    }
+
+    /// <summary>
+    /// Updates whether each task in the graph is done from a version of the tasks, O(n) in the number of tasks.
+    /// </summary>
+    /// <param name="tasks"> Every task. </param>
+    /// <param name="remove_missing"> Whether the tasks in the graph that are not in the version are removed. </param>
+    /// <returns> True if dependencies were removed, false otherwise. </returns>
+    bool Refresh(const mrt::PersistentVector<Task>& tasks, bool remove_missing)
+    {
+        if (m_Index.empty())
+            return false;
+
+        for (const Task& task : tasks)
+        {
+            auto found = m_Index.find(task.id);
+
+            if (found == m_Index.end())
+                continue;
+
+            SetDone(task.id, task.is_done);
+            m_Nodes[found->second].is_visited = true;
+        }
+
+        std::vector<uint64_t> missing;
+
+        for (Node& node : m_Nodes)
+        {
+            if (node.in_use && !node.is_visited)
+            {
+                missing.push_back(node.task_id);
+            }
+
+            node.is_visited = false;
+        }
+
+        bool removed = false;
+
+        if (remove_missing)
+        {
+            for (uint64_t task_id : missing)
+            {
+                removed = RemoveTask(task_id) || removed;
+            }
+        }
+
+        return removed;
+    }
+
+    /// <summary>
+    /// Checks whether every task a task depends on is done, O(1).
+    /// </summary>
+    /// <param name="task_id"> The id of the task. </param>
+    /// <returns> True if the task can start, false if it waits for another task. </returns>
+    bool IsReady(uint64_t task_id) const
+    {
+        auto found = m_Index.find(task_id);
+
+        return found == m_Index.end() || m_Nodes[found->second].pending == 0;
+    }
+
+    /// <summary>
+    /// Gets the number of tasks a task waits for.
+    /// </summary>
+    uint64_t PendingCount(uint64_t task_id) const
+    {
+        auto found = m_Index.find(task_id);
+
+        return found != m_Index.end() ? m_Nodes[found->second].pending : 0;
+    }
+
+    /// <summary>
+    /// Gets the number of tasks that wait for another task, O(1).
+    /// </summary>
+    uint64_t BlockedCount() const
+    {
+        return m_BlockedCount;
+    }
+
+    /// <summary>
+    /// Gets the ids of the tasks a task depends on.
+    /// </summary>
+    mrt::Vector<uint64_t> GetPrerequisites(uint64_t task_id) const
+    {
+        return Neighbours(task_id, &Node::previous);
+    }
+
+    /// <summary>
+    /// Gets the ids of the tasks that depend on a task.
+    /// </summary>
+    mrt::Vector<uint64_t> GetDependents(uint64_t task_id) const
+    {
+        return Neighbours(task_id, &Node::next);
+    }
+
+    /// <summary>
+    /// Gets every dependency.
+    /// </summary>
+    mrt::Vector<TaskDependency> GetEdges() const
+    {
+        mrt::Vector<TaskDependency> edges;
+
+        for (const Node& node : m_Nodes)
+        {
+            if (!node.in_use)
+                continue;
+
+            for (uint32_t next : node.next)
+            {
+                edges.PushBack({ node.task_id, m_Nodes[next].task_id });
+            }
+        }
+
+        return edges;
+    }
+
+    /// <summary>
+    /// Gets the ids of the tasks in the graph in topological order, every task comes after the tasks it depends on. O(n), nothing is sorted.
+    /// </summary>
+    mrt::Vector<uint64_t> TopologicalOrder() const
+    {
+        mrt::Vector<uint64_t> order;
+
+        for (uint32_t index : m_Order)
+        {
+            if (index != s_None)
+            {
+                order.PushBack(m_Nodes[index].task_id);
+            }
+        }
+
+        return order;
+    }
+
+    /// <summary>
+    /// Checks whether a task is in the graph.
+    /// </summary>
+    bool Contains(uint64_t task_id) const
+    {
+        return m_Index.count(task_id) > 0;
+    }
+
+    /// <summary>
+    /// Gets the number of tasks in the graph.
+    /// </summary>
+    uint64_t Size() const
+    {
+        return m_Index.size();
+    }
+
+    /// <summary>
+    /// Gets the number of dependencies.
+    /// </summary>
+    uint64_t EdgeCount() const
+    {
+        return m_EdgeCount;
+    }
+
+private:
+    /// <summary>
+    /// Restores the topological order before adding an edge from x to y, where y comes before x.
+    /// Searches forward from y and backward from x, only through the tasks between them in the order,
+    /// then gives the tasks found backward the first of their positions and the tasks found forward the rest.
+    /// </summary>
+    /// <returns> True if the order was restored, false if x can be reached from y, so the edge would close a cycle. </returns>
+    bool Reorder(uint32_t x, uint32_t y)
+    {
+        uint64_t lower = m_Nodes[y].order;
+        uint64_t upper = m_Nodes[x].order;
+
+        m_Forward.clear();
+        m_Backward.clear();
+
+        bool is_cycle = !Search(y, upper, true, m_Forward);
+
+        if (!is_cycle)
+        {
+            Search(x, lower, false, m_Backward);
+        }
+
+        for (uint32_t index : m_Forward)
+        {
+            m_Nodes[index].is_visited = false;
+        }
+
+        for (uint32_t index : m_Backward)
+        {
+            m_Nodes[index].is_visited = false;
+        }
+
+        if (is_cycle)
+            return false;
+
+        auto by_order = [this](uint32_t left, uint32_t right)
+            {
+                return m_Nodes[left].order < m_Nodes[right].order;
+            };
+
+        std::sort(m_Forward.begin(), m_Forward.end(), by_order);
+        std::sort(m_Backward.begin(), m_Backward.end(), by_order);
+
+        m_Positions.clear();
+
+        for (uint32_t index : m_Backward)
+        {
+            m_Positions.push_back(m_Nodes[index].order);
+        }
+
+        for (uint32_t index : m_Forward)
+        {
+            m_Positions.push_back(m_Nodes[index].order);
+        }
+
+        std::sort(m_Positions.begin(), m_Positions.end());
+
+        uint64_t position = 0;
+
+        for (std::vector<uint32_t>* nodes : { &m_Backward, &m_Forward })
+        {
+            for (uint32_t index : *nodes)
+            {
+                m_Nodes[index].order = m_Positions[position];
+                m_Order[m_Positions[position]] = index;
+                position++;
+            }
+        }
+
+        return true;
+    }
+
+    /// <summary>
+    /// Searches from a node through the nodes whose position is inside the bound, iteratively so a long chain does not overflow the stack.
+    /// </summary>
+    /// <param name="start"> The node to start from. </param>
+    /// <param name="bound"> Forward, the position of the node that would close a cycle. Backward, the position the search stays above. </param>
+    /// <param name="is_forward"> Whether the search follows the edges forward or backward. </param>
+    /// <param name="found"> The nodes that were found, marked as visited. </param>
+    /// <returns> False if the forward search reached the bound, true otherwise. </returns>
+    bool Search(uint32_t start, uint64_t bound, bool is_forward, std::vector<uint32_t>& found)
+    {
+        m_Stack.clear();
+        m_Stack.push_back(start);
+        m_Nodes[start].is_visited = true;
+
+        while (!m_Stack.empty())
+        {
+            uint32_t index = m_Stack.back();
+            m_Stack.pop_back();
+            found.push_back(index);
+
+            for (uint32_t neighbour : is_forward ? m_Nodes[index].next : m_Nodes[index].previous)
+            {
+                Node& node = m_Nodes[neighbour];
+
+                if (is_forward && node.order == bound)
+                {
+                    // The nodes still waiting on the stack are marked as visited too, so they are cleared with the others.
+                    found.insert(found.end(), m_Stack.begin(), m_Stack.end());
+                    return false;
+                }
+
+                bool is_inside = is_forward ? node.order < bound : node.order > bound;
+
+                if (!node.is_visited && is_inside)
+                {
+                    node.is_visited = true;
+                    m_Stack.push_back(neighbour);
+                }
+            }
+        }
+
+        return true;
+    }
+
+    uint32_t FindOrAdd(uint64_t task_id)
+    {
+        if (m_Index.count(task_id) == 0)
+        {
+            AddTask(task_id, false);
+        }
+
+        return m_Index[task_id];
+    }
+
+    void Link(uint32_t from, uint32_t to)
+    {
+        m_Nodes[from].next.push_back(to);
+        m_Nodes[to].previous.push_back(from);
+        m_EdgeCount++;
+
+        if (!m_Nodes[from].is_done)
+        {
+            Block(to);
+        }
+    }
+
+    bool Unlink(uint32_t from, uint32_t to)
+    {
+        std::vector<uint32_t>& next = m_Nodes[from].next;
+        auto edge = std::find(next.begin(), next.end(), to);
+
+        if (edge == next.end())
+            return false;
+
+        *edge = next.back();
+        next.pop_back();
+
+        std::vector<uint32_t>& previous = m_Nodes[to].previous;
+        auto back_edge = std::find(previous.begin(), previous.end(), from);
+        *back_edge = previous.back();
+        previous.pop_back();
+
+        m_EdgeCount--;
+
+        if (!m_Nodes[from].is_done)
+        {
+            Unblock(to);
+        }
+
+        return true;
+    }
+
+    void Block(uint32_t index)
+    {
+        if (m_Nodes[index].pending++ == 0)
+        {
+            m_BlockedCount++;
+        }
+    }
+
+    void Unblock(uint32_t index)
+    {
+        if (--m_Nodes[index].pending == 0)
+        {
+            m_BlockedCount--;
+        }
+    }
+
+    void RemoveIfIsolated(uint32_t index)
+    {
+        if (m_Nodes[index].next.empty() && m_Nodes[index].previous.empty())
+        {
+            RemoveNode(index);
+        }
+    }
+
+    void RemoveNode(uint32_t index)
+    {
+        Node& node = m_Nodes[index];
+
+        m_Index.erase(node.task_id);
+        m_Order[node.order] = s_None;
+        m_EmptyPositions++;
+
+        node.in_use = false;
+        node.next.clear();
+        node.previous.clear();
+        m_FreeNodes.push_back(index);
+
+        // The empty positions are squeezed out once they outnumber the tasks, which keeps the order O(n) to walk.
+        if (m_EmptyPositions > m_Index.size())
+        {
+            Compact();
+        }
+    }
+
+    void Compact()
+    {
+        uint64_t position = 0;
+
+        for (uint32_t index : m_Order)
+        {
+            if (index == s_None)
+                continue;
+
+            m_Nodes[index].order = position;
+            m_Order[position++] = index;
+        }
+
+        m_Order.resize(position);
+        m_EmptyPositions = 0;
+    }
+
+    mrt::Vector<uint64_t> Neighbours(uint64_t task_id, std::vector<uint32_t> Node::* edges) const
+    {
+        mrt::Vector<uint64_t> neighbours;
+        auto found = m_Index.find(task_id);
+
+        if (found == m_Index.end())
+            return neighbours;
+
+        for (uint32_t index : m_Nodes[found->second].*edges)
+        {
+            neighbours.PushBack(m_Nodes[index].task_id);
+        }
+
+        return neighbours;
+    }
+};
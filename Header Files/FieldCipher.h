@@ -0,0 +1,279 @@
+#pragma once
+
+#include "../lib/easy-encryption/encryption.h"
+
+#include <array>
+#include <cstring>
+#include <string>
+#include <string_view>
+#include <vector>
+#include <cstdint>
+
+namespace mrt
+{
+	/// <summary>
+	/// FieldCipher class encrypts and decrypts single fields with the scheme of the easy-encryption library, Base64 followed by a Vigenere cipher,
+	/// and gives exactly the same text as its <c>encrypt</c> and <c>decrypt</c> functions, so fields encrypted by either are read by the other.
+	/// The fields are changed in place, or encrypted straight into a buffer: the characters are looked up in tables instead of being searched for,
+	/// the key is not extended for every field, and the only buffer is a scratch buffer that each thread reuses from one field to the next.
+	/// The fields can be encrypted and decrypted from several threads at once.
+	/// </summary>
+	class FieldCipher
+	{
+	private:
+		static constexpr int s_CharCount = 63;
+		static constexpr char s_Fill = '=';
+
+		std::string m_Key;
+		std::vector<uint8_t> m_KeyShifts;
+	public:
+		/// <summary>
+		/// Initializes a new instance of the <see cref="FieldCipher"/> class.
+		/// </summary>
+		/// <param name="key"> The key, a key with characters the cipher does not shift by is passed on to the library as it is. </param>
+		explicit FieldCipher(const std::string& key)
+			: m_Key(key)
+		{
+			for (char c : key)
+			{
+				int shift = Tables::Get().shift[static_cast<unsigned char>(c)];
+
+				if (shift < 0)
+				{
+					m_KeyShifts.clear();
+					return;
+				}
+
+				m_KeyShifts.push_back(static_cast<uint8_t>(shift));
+			}
+		}
+
+		/// <summary>
+		/// Gets the size of the encrypted text of a field.
+		/// </summary>
+		/// <param name="size"> The size of the field. </param>
+		static uint64_t EncryptedSize(uint64_t size)
+		{
+			return (size + 2) / 3 * 4;
+		}
+
+		/// <summary>
+		/// Encrypts a field in place.
+		/// </summary>
+		/// <param name="field"> The field, replaced by its encrypted text. </param>
+		void Encrypt(std::string& field) const
+		{
+			static thread_local std::string scratch;
+			scratch.assign(field);
+
+			field.resize(EncryptedSize(scratch.size()));
+			Encrypt(scratch, &field[0]);
+		}
+
+		/// <summary>
+		/// Encrypts a field into a buffer, such as straight into the file the field is written to.
+		/// </summary>
+		/// <param name="field"> The field. </param>
+		/// <param name="output"> The buffer to write the encrypted text to, which has room for <see cref="EncryptedSize"/> characters. </param>
+		void Encrypt(std::string_view field, char* output) const
+		{
+			if (m_KeyShifts.empty())
+			{
+				std::string key = m_Key;
+				std::string text(field);
+				std::string encrypted = encrypt(text, key);
+				std::memcpy(output, encrypted.data(), encrypted.size());
+				return;
+			}
+
+			const Tables& tables = Tables::Get();
+			const unsigned char* data = reinterpret_cast<const unsigned char*>(field.data());
+			uint64_t size = field.size();
+			uint64_t key_index = 0;
+
+			auto put = [&](char c)
+				{
+					*output++ = Shift(tables, c, m_KeyShifts[key_index]);
+					key_index = key_index + 1 == m_KeyShifts.size() ? 0 : key_index + 1;
+				};
+
+			for (uint64_t i = 0; i < size; i += 3)
+			{
+				uint32_t group = static_cast<uint32_t>(data[i]) << 16;
+
+				if (i + 1 < size)
+				{
+					group |= static_cast<uint32_t>(data[i + 1]) << 8;
+				}
+
+				if (i + 2 < size)
+				{
+					group |= data[i + 2];
+				}
+
+				put(tables.base64[(group >> 18) & 0x3F]);
+				put(tables.base64[(group >> 12) & 0x3F]);
+				put(i + 1 < size ? tables.base64[(group >> 6) & 0x3F] : s_Fill);
+				put(i + 2 < size ? tables.base64[group & 0x3F] : s_Fill);
+			}
+		}
+
+		/// <summary>
+		/// Decrypts a field in place. Text that was not written by <see cref="Encrypt"/> is decoded the way the library decodes it.
+		/// </summary>
+		/// <param name="field"> The encrypted field, replaced by its text. </param>
+		void Decrypt(std::string& field) const
+		{
+			if (m_KeyShifts.empty())
+			{
+				std::string key = m_Key;
+				field = decrypt(field, key);
+				return;
+			}
+
+			const Tables& tables = Tables::Get();
+			uint64_t size = field.size();
+			uint64_t key_index = 0;
+
+			for (uint64_t i = 0; i < size; i++)
+			{
+				field[i] = Unshift(tables, field[i], m_KeyShifts[key_index]);
+				key_index = key_index + 1 == m_KeyShifts.size() ? 0 : key_index + 1;
+			}
+
+			// Every 4 characters decode to at most 3 bytes, so the bytes are written behind the characters still to be read.
+			// The characters are read the way the library reads them, reading the terminator past the end of a field cut short.
+			char* data = &field[0];
+			uint64_t written = 0;
+
+			for (uint64_t i = 0; i < size; ++i)
+			{
+				char c = tables.value[static_cast<unsigned char>(data[i])];
+				++i;
+				char c1 = tables.value[static_cast<unsigned char>(data[i])];
+				c = (c << 2) | ((c1 >> 4) & 0x3);
+				data[written++] = c;
+
+				if (++i < size)
+				{
+					c = data[i];
+
+					if (c == s_Fill)
+						break;
+
+					c = tables.value[static_cast<unsigned char>(c)];
+					c1 = ((c1 << 4) & 0xf0) | ((c >> 2) & 0xf);
+					data[written++] = c1;
+				}
+
+				if (++i < size)
+				{
+					c1 = data[i];
+
+					if (c1 == s_Fill)
+						break;
+
+					c1 = tables.value[static_cast<unsigned char>(c1)];
+					c = ((c << 6) & 0xc0) | c1;
+					data[written++] = c;
+				}
+			}
+
+			field.resize(written);
+			Sanitize(field);
+		}
+
+	private:
+		/// <summary>
+		/// The lookup tables of the cipher, built once.
+		/// </summary>
+		struct Tables
+		{
+			std::array<char, 64> base64{};
+			std::array<char, 256> value{};
+			std::array<int8_t, 256> shift{};
+			std::array<char, s_CharCount> chars{};
+
+			Tables()
+			{
+				const std::string base64_chars = "ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz0123456789+/";
+
+				// A character that is not Base64 decodes as npos cast to a char, as it does in the library.
+				value.fill(static_cast<char>(std::string::npos));
+				shift.fill(-1);
+
+				for (int i = 0; i < 64; i++)
+				{
+					base64[i] = base64_chars[i];
+					value[static_cast<unsigned char>(base64_chars[i])] = static_cast<char>(i);
+				}
+
+				for (int i = 0; i < s_CharCount; i++)
+				{
+					chars[i] = AVAILABLE_CHARS[i];
+					shift[static_cast<unsigned char>(AVAILABLE_CHARS[i])] = static_cast<int8_t>(i);
+				}
+			}
+
+			static const Tables& Get()
+			{
+				static const Tables s_Tables;
+
+				return s_Tables;
+			}
+		};
+
+		/// <summary>
+		/// Shifts a character forward by the shift of a key character, the characters that are not letters, digits or spaces are left as they are.
+		/// </summary>
+		static char Shift(const Tables& tables, char c, uint8_t key_shift)
+		{
+			int shift = tables.shift[static_cast<unsigned char>(c)];
+
+			if (shift < 0)
+				return c;
+
+			shift += key_shift;
+			return tables.chars[shift >= s_CharCount ? shift - s_CharCount : shift];
+		}
+
+		/// <summary>
+		/// Shifts a character back by the shift of a key character.
+		/// </summary>
+		static char Unshift(const Tables& tables, char c, uint8_t key_shift)
+		{
+			int shift = tables.shift[static_cast<unsigned char>(c)];
+
+			if (shift < 0)
+				return c;
+
+			shift -= key_shift;
+			return tables.chars[shift < 0 ? shift + s_CharCount : shift];
+		}
+
+		/// <summary>
+		/// Drops the bytes that are not valid UTF-8 in the same way as <c>sanitize_utf8</c>.
+		/// Text that is printable ASCII is left as it is without being copied, which is nearly every field.
+		/// </summary>
+		static void Sanitize(std::string& text)
+		{
+			bool is_plain = true;
+
+			for (char byte : text)
+			{
+				unsigned char c = static_cast<unsigned char>(byte);
+
+				if ((c < 32 && c != 9 && c != 10 && c != 13) || c >= 127)
+				{
+					is_plain = false;
+					break;
+				}
+			}
+
+			if (!is_plain)
+			{
+				text = sanitize_utf8(text);
+			}
+		}
+	};
+}
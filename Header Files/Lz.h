@@ -0,0 +1,311 @@
+#pragma once
+
+#include <array>
+#include <cstdint>
+#include <cstring>
+
+namespace mrt
+{
+	/// <summary>
+	/// Lz class compresses a block of bytes with a fast LZ77 scheme in the style of LZ4, trading some ratio for speed.
+	/// The block is written as sequences, each one a token, a run of literal bytes copied as they are, and a match
+	/// that repeats up to 64 KiB of the bytes already written:
+	///
+	///   token    literal length (high 4 bits) and match length - 4 (low 4 bits), 15 means more length bytes follow
+	///   length   bytes of 255 added to the length, ending with a byte below 255
+	///   literals the literal bytes
+	///   offset   how far back the match starts (u16, little-endian), followed by the more match length bytes
+	///
+	/// The last sequence has only literals and ends the block. A block refers to no other block, so blocks can be
+	/// decompressed in any order, and in parallel. Decompressing checks every length and offset, so a damaged block fails
+	/// instead of reading or writing out of bounds.
+	/// </summary>
+	class Lz
+	{
+	private:
+		static constexpr uint64_t s_MinMatch = 4;
+		static constexpr uint64_t s_MaxOffset = 65535;
+		static constexpr uint64_t s_HashBits = 12;
+
+		// The last bytes of a block are always literals, so a match never reads past the end.
+		static constexpr uint64_t s_LastLiterals = 5;
+	public:
+		/// <summary>
+		/// Gets the largest size a block of the specified size can compress to, when none of it repeats.
+		/// </summary>
+		static uint64_t Bound(uint64_t size)
+		{
+			return size + size / 255 + 16;
+		}
+
+		/// <summary>
+		/// Compresses a block.
+		/// </summary>
+		/// <param name="source"> The bytes to compress. </param>
+		/// <param name="size"> The number of bytes to compress. </param>
+		/// <param name="destination"> The buffer to write the compressed block to. </param>
+		/// <param name="capacity"> The size of the buffer, a buffer of <see cref="Bound"/> always fits the block. </param>
+		/// <returns> The size of the compressed block, 0 if it does not fit the buffer. </returns>
+		static uint64_t Compress(const char* source, uint64_t size, char* destination, uint64_t capacity)
+		{
+			const uint8_t* input = reinterpret_cast<const uint8_t*>(source);
+			const uint8_t* input_end = input + size;
+			uint8_t* output = reinterpret_cast<uint8_t*>(destination);
+			uint8_t* output_end = output + capacity;
+
+			const uint8_t* anchor = input;
+
+			if (size > s_LastLiterals + s_MinMatch)
+			{
+				const uint8_t* limit = input_end - s_LastLiterals;
+				const uint8_t* position = input + 1;
+
+				// The position last seen for each hash of four bytes, a stale or colliding entry fails the comparison.
+				std::array<uint32_t, 1 << s_HashBits> table{};
+
+				while (position + s_MinMatch <= limit)
+				{
+					uint32_t sequence = Read32(position);
+					uint32_t& entry = table[Hash(sequence)];
+					const uint8_t* candidate = input + entry;
+
+					entry = static_cast<uint32_t>(position - input);
+
+					if (candidate >= position || static_cast<uint64_t>(position - candidate) > s_MaxOffset || Read32(candidate) != sequence)
+					{
+						// Runs without a match are skipped faster the longer they get, so incompressible data stays fast.
+						position += 1 + ((position - anchor) >> 6);
+						continue;
+					}
+
+					const uint8_t* match_end = MatchEnd(position + s_MinMatch, candidate + s_MinMatch, limit);
+
+					output = WriteSequence(output, output_end, anchor, position - anchor, position - candidate, match_end - position);
+
+					if (output == nullptr)
+						return 0;
+
+					position = match_end;
+					anchor = position;
+
+					if (position - 2 > input)
+					{
+						table[Hash(Read32(position - 2))] = static_cast<uint32_t>(position - 2 - input);
+					}
+				}
+			}
+
+			output = WriteSequence(output, output_end, anchor, input_end - anchor, 0, 0);
+
+			if (output == nullptr)
+				return 0;
+
+			return output - reinterpret_cast<uint8_t*>(destination);
+		}
+
+		/// <summary>
+		/// Decompresses a block written by <see cref="Compress"/>.
+		/// </summary>
+		/// <param name="source"> The compressed block. </param>
+		/// <param name="size"> The size of the compressed block. </param>
+		/// <param name="destination"> The buffer to write the bytes to. </param>
+		/// <param name="raw_size"> The number of bytes the block holds, the buffer has to be this large. </param>
+		/// <returns> True if the block decompressed to exactly raw_size bytes, false if it is not valid. </returns>
+		static bool Decompress(const char* source, uint64_t size, char* destination, uint64_t raw_size)
+		{
+			const uint8_t* input = reinterpret_cast<const uint8_t*>(source);
+			const uint8_t* input_end = input + size;
+			uint8_t* output = reinterpret_cast<uint8_t*>(destination);
+			uint8_t* output_start = output;
+			uint8_t* output_end = output + raw_size;
+
+			while (input < input_end)
+			{
+				uint8_t token = *input++;
+				uint64_t literals = token >> 4;
+
+				if (!ReadLength(input, input_end, literals))
+					return false;
+
+				if (literals > static_cast<uint64_t>(input_end - input) || literals > static_cast<uint64_t>(output_end - output))
+					return false;
+
+				// Most runs are short, a fixed size copy is a couple of moves where a call to copy the exact size is not.
+				if (literals <= 16 && input_end - input >= 16 && output_end - output >= 16)
+				{
+					std::memcpy(output, input, 16);
+				}
+				else
+				{
+					std::memcpy(output, input, literals);
+				}
+
+				output += literals;
+				input += literals;
+
+				if (input == input_end)
+					break;
+
+				if (input_end - input < 2)
+					return false;
+
+				uint64_t offset = input[0] | (static_cast<uint64_t>(input[1]) << 8);
+				input += 2;
+
+				uint64_t length = token & 0x0F;
+
+				if (!ReadLength(input, input_end, length))
+					return false;
+
+				length += s_MinMatch;
+
+				if (offset == 0 || offset > static_cast<uint64_t>(output - output_start) || length > static_cast<uint64_t>(output_end - output))
+					return false;
+
+				const uint8_t* match = output - offset;
+
+				if (offset >= 8 && static_cast<uint64_t>(output_end - output) >= length + 8)
+				{
+					// Each 8 bytes are copied from at least 8 bytes back, so a copy never reads the bytes it writes,
+					// and the bytes written past the match are written again by the next sequence.
+					uint8_t* end = output + length;
+
+					for (; output < end; output += 8, match += 8)
+					{
+						std::memcpy(output, match, 8);
+					}
+
+					output = end;
+				}
+				else if (offset >= length)
+				{
+					std::memcpy(output, match, length);
+					output += length;
+				}
+				else
+				{
+					// The match overlaps the bytes it writes, which repeats its first offset bytes.
+					for (uint64_t i = 0; i < length; i++)
+					{
+						*output++ = *match++;
+					}
+				}
+			}
+
+			return output == output_end;
+		}
+
+	private:
+		static uint32_t Read32(const uint8_t* position)
+		{
+			uint32_t value;
+			std::memcpy(&value, position, sizeof(value));
+			return value;
+		}
+
+		static uint32_t Hash(uint32_t sequence)
+		{
+			return (sequence * 2654435761u) >> (32 - s_HashBits);
+		}
+
+		/// <summary>
+		/// Finds where a match stops repeating, comparing 8 bytes at a time while they are equal.
+		/// </summary>
+		/// <returns> The first byte after the match, at most limit. </returns>
+		static const uint8_t* MatchEnd(const uint8_t* position, const uint8_t* candidate, const uint8_t* limit)
+		{
+			while (limit - position >= 8)
+			{
+				uint64_t a;
+				uint64_t b;
+				std::memcpy(&a, position, sizeof(a));
+				std::memcpy(&b, candidate, sizeof(b));
+
+				if (a != b)
+					break;
+
+				position += 8;
+				candidate += 8;
+			}
+
+			while (position < limit && *position == *candidate)
+			{
+				position++;
+				candidate++;
+			}
+
+			return position;
+		}
+
+		/// <summary>
+		/// Writes a sequence, a match length of 0 writes the last sequence, which has no match.
+		/// </summary>
+		/// <returns> The end of the sequence, null if it does not fit. </returns>
+		static uint8_t* WriteSequence(uint8_t* output, uint8_t* output_end, const uint8_t* literals, uint64_t literal_count, uint64_t offset, uint64_t match_length)
+		{
+			uint64_t match_code = match_length > 0 ? match_length - s_MinMatch : 0;
+			uint64_t needed = 1 + literal_count + literal_count / 255 + 1 + (match_length > 0 ? 2 + match_code / 255 + 1 : 0);
+
+			if (needed > static_cast<uint64_t>(output_end - output))
+				return nullptr;
+
+			uint8_t* token = output++;
+			*token = static_cast<uint8_t>((literal_count >= 15 ? 15 : literal_count) << 4);
+			output = WriteLength(output, literal_count);
+
+			std::memcpy(output, literals, literal_count);
+			output += literal_count;
+
+			if (match_length == 0)
+				return output;
+
+			*output++ = static_cast<uint8_t>(offset);
+			*output++ = static_cast<uint8_t>(offset >> 8);
+
+			*token |= static_cast<uint8_t>(match_code >= 15 ? 15 : match_code);
+			return WriteLength(output, match_code);
+		}
+
+		/// <summary>
+		/// Writes the bytes of a length that does not fit its 4 bits of the token.
+		/// </summary>
+		static uint8_t* WriteLength(uint8_t* output, uint64_t length)
+		{
+			if (length < 15)
+				return output;
+
+			length -= 15;
+
+			while (length >= 255)
+			{
+				*output++ = 255;
+				length -= 255;
+			}
+
+			*output++ = static_cast<uint8_t>(length);
+			return output;
+		}
+
+		/// <summary>
+		/// Reads the bytes of a length that did not fit its 4 bits of the token.
+		/// </summary>
+		static bool ReadLength(const uint8_t*& input, const uint8_t* input_end, uint64_t& length)
+		{
+			if (length < 15)
+				return true;
+
+			uint8_t byte;
+
+			do
+			{
+				if (input == input_end)
+					return false;
+
+				byte = *input++;
+				length += byte;
+			} while (byte == 255);
+
+			return true;
+		}
+	};
+}
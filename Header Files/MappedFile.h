@@ -0,0 +1,190 @@
+#pragma once
+
+#include "../Header Files/NoCopy.h"
+
+#include <string>
+#include <cstdint>
+
+#if defined(_WIN32)
+#ifndef NOMINMAX
+#define NOMINMAX
+#endif
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#endif
+
+namespace mrt
+{
+	/// <summary>
+	/// MappedFile class maps a whole file into memory read-only, so it can be parsed in place without reading it into a buffer.
+	/// The pages are read by the operating system as they are touched and can be dropped again under memory pressure,
+	/// so the file never takes up more than its own size, and the mapping is released when the object is destroyed.
+	/// </summary>
+	class MappedFile : private NoCopy
+	{
+	private:
+		const char* m_Data{ nullptr };
+		uint64_t m_Size{ 0 };
+		bool m_IsOpen{ false };
+
+#if defined(_WIN32)
+		HANDLE m_File{ INVALID_HANDLE_VALUE };
+		HANDLE m_Mapping{ nullptr };
+#endif
+	public:
+		MappedFile() = default;
+
+		/// <summary>
+		/// Maps the file at the specified path, see <see cref="Open"/>.
+		/// </summary>
+		explicit MappedFile(const std::string& path)
+		{
+			Open(path);
+		}
+
+		~MappedFile()
+		{
+			Close();
+		}
+
+		/// <summary>
+		/// Maps the file at the specified path, unmapping any file that was mapped before.
+		/// An empty file is opened without a mapping, its data is null and its size is 0.
+		/// </summary>
+		/// <param name="path"> The path of the file. </param>
+		/// <returns> True if the file was mapped, false if it could not be opened or mapped. </returns>
+		bool Open(const std::string& path)
+		{
+			Close();
+
+#if defined(_WIN32)
+			m_File = CreateFileA(path.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING, FILE_FLAG_SEQUENTIAL_SCAN, nullptr);
+
+			if (m_File == INVALID_HANDLE_VALUE)
+				return false;
+
+			LARGE_INTEGER size;
+
+			if (!GetFileSizeEx(m_File, &size))
+			{
+				Close();
+				return false;
+			}
+
+			m_Size = static_cast<uint64_t>(size.QuadPart);
+
+			if (m_Size > 0)
+			{
+				m_Mapping = CreateFileMappingA(m_File, nullptr, PAGE_READONLY, 0, 0, nullptr);
+				m_Data = m_Mapping != nullptr ? static_cast<const char*>(MapViewOfFile(m_Mapping, FILE_MAP_READ, 0, 0, 0)) : nullptr;
+
+				if (m_Data == nullptr)
+				{
+					Close();
+					return false;
+				}
+			}
+#else
+			int file = ::open(path.c_str(), O_RDONLY);
+
+			if (file < 0)
+				return false;
+
+			struct stat status;
+
+			if (::fstat(file, &status) != 0)
+			{
+				::close(file);
+				return false;
+			}
+
+			m_Size = static_cast<uint64_t>(status.st_size);
+
+			if (m_Size > 0)
+			{
+				void* data = ::mmap(nullptr, m_Size, PROT_READ, MAP_PRIVATE, file, 0);
+
+				if (data == MAP_FAILED)
+				{
+					::close(file);
+					m_Size = 0;
+					return false;
+				}
+
+				// The files are parsed from start to end, so the kernel can read ahead and drop the pages behind.
+				::madvise(data, m_Size, MADV_SEQUENTIAL);
+				m_Data = static_cast<const char*>(data);
+			}
+
+			// The mapping stays valid once the file is closed.
+			::close(file);
+#endif
+
+			m_IsOpen = true;
+			return true;
+		}
+
+		/// <summary>
+		/// Unmaps the file.
+		/// </summary>
+		void Close()
+		{
+#if defined(_WIN32)
+			if (m_Data != nullptr)
+			{
+				UnmapViewOfFile(m_Data);
+			}
+
+			if (m_Mapping != nullptr)
+			{
+				CloseHandle(m_Mapping);
+			}
+
+			if (m_File != INVALID_HANDLE_VALUE)
+			{
+				CloseHandle(m_File);
+			}
+
+			m_Mapping = nullptr;
+			m_File = INVALID_HANDLE_VALUE;
+#else
+			if (m_Data != nullptr)
+			{
+				::munmap(const_cast<char*>(m_Data), m_Size);
+			}
+#endif
+
+			m_Data = nullptr;
+			m_Size = 0;
+			m_IsOpen = false;
+		}
+
+		/// <summary>
+		/// Checks whether a file is mapped.
+		/// </summary>
+		bool IsOpen() const
+		{
+			return m_IsOpen;
+		}
+
+		/// <summary>
+		/// Gets the first byte of the file, null if the file is empty.
+		/// </summary>
+		const char* Data() const
+		{
+			return m_Data;
+		}
+
+		/// <summary>
+		/// Gets the size of the file in bytes.
+		/// </summary>
+		uint64_t Size() const
+		{
+			return m_Size;
+		}
+	};
+}
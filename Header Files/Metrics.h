@@ -0,0 +1,323 @@
+#pragma once
+
+#include "../Header Files/NoCopy.h"
+
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <fstream>
+#include <functional>
+#include <filesystem>
+#include <condition_variable>
+
+#if defined(_MSC_VER)
+#include <intrin.h>
+#endif
+
+// Set to 0 to compile the instrumentation out, recording then does nothing and the snapshots are empty.
+#ifndef DAILY_TASK_MANAGER_METRICS
+#define DAILY_TASK_MANAGER_METRICS 1
+#endif
+
+namespace mrt
+{
+	namespace metrics
+	{
+		/// <summary>
+		/// A copy of the counts of a <see cref="LatencyHistogram"/>, used to read percentiles without touching the live histogram.
+		/// </summary>
+		struct HistogramSnapshot
+		{
+			static constexpr uint64_t s_SubBucketBits = 5;
+			static constexpr uint64_t s_SubBuckets = uint64_t(1) << s_SubBucketBits;
+			static constexpr uint64_t s_HalfSubBuckets = s_SubBuckets / 2;
+			static constexpr uint64_t s_Buckets = (64 - s_SubBucketBits + 1) * s_HalfSubBuckets + s_HalfSubBuckets;
+
+			std::array<uint64_t, s_Buckets> buckets{};
+			uint64_t count{ 0 };
+			uint64_t total_ns{ 0 };
+			uint64_t max_ns{ 0 };
+
+			/// <summary>
+			/// Gets the bucket that a value is counted in.
+			/// Values below the number of sub-buckets have a bucket each, above that every power of two is split into
+			/// half as many sub-buckets, so a bucket is never wider than 1/16, about 6.25%, of the values it counts.
+			/// </summary>
+			/// <param name="value"> The value. </param>
+			/// <returns> The index of the bucket. </returns>
+			static uint64_t BucketIndex(uint64_t value)
+			{
+				if (value < s_SubBuckets)
+					return value;
+
+#if defined(_MSC_VER)
+				unsigned long msb = 0;
+				_BitScanReverse64(&msb, value);
+#else
+				uint64_t msb = 63 - __builtin_clzll(value);
+#endif
+
+				uint64_t shift = msb - (s_SubBucketBits - 1);
+
+				return shift * s_HalfSubBuckets + (value >> shift);
+			}
+
+			/// <summary>
+			/// Gets the highest value that is counted in a bucket.
+			/// </summary>
+			/// <param name="index"> The index of the bucket. </param>
+			/// <returns> The highest value of the bucket. </returns>
+			static uint64_t BucketUpperBound(uint64_t index)
+			{
+				if (index < s_SubBuckets)
+					return index;
+
+				uint64_t shift = index / s_HalfSubBuckets - 1;
+				uint64_t sub_bucket = index - shift * s_HalfSubBuckets;
+
+				return ((sub_bucket + 1) << shift) - 1;
+			}
+
+			/// <summary>
+			/// Gets the value below which the specified fraction of the recorded values fall.
+			/// </summary>
+			/// <param name="fraction"> The fraction, such as 0.99 for the 99th percentile. </param>
+			/// <returns> The percentile in nanoseconds, or 0 if nothing was recorded. </returns>
+			uint64_t PercentileNs(double fraction) const
+			{
+				if (count == 0)
+					return 0;
+
+				uint64_t rank = static_cast<uint64_t>(fraction * count + 0.5);
+				rank = rank < 1 ? 1 : (rank > count ? count : rank);
+
+				uint64_t seen = 0;
+
+				for (uint64_t i = 0; i < s_Buckets; i++)
+				{
+					seen += buckets[i];
+
+					if (seen >= rank)
+					{
+						uint64_t bound = BucketUpperBound(i);
+						return bound < max_ns ? bound : max_ns;
+					}
+				}
+
+				return max_ns;
+			}
+
+			/// <summary>
+			/// Gets the mean of the recorded values.
+			/// </summary>
+			/// <returns> The mean in nanoseconds, or 0 if nothing was recorded. </returns>
+			double MeanNs() const
+			{
+				return count == 0 ? 0.0 : static_cast<double>(total_ns) / count;
+			}
+		};
+
+		/// <summary>
+		/// LatencyHistogram class records latencies into log-linear buckets, in the style of an HDR histogram.
+		/// Recording is lock-free and wait-free, every bucket is an atomic counter so any thread can record at any time.
+		/// </summary>
+		class LatencyHistogram : private NoCopy
+		{
+		private:
+			std::array<std::atomic<uint64_t>, HistogramSnapshot::s_Buckets> m_Buckets{};
+			std::atomic<uint64_t> m_Count{ 0 };
+			std::atomic<uint64_t> m_Total{ 0 };
+			std::atomic<uint64_t> m_Max{ 0 };
+		public:
+			/// <summary>
+			/// Records a latency.
+			/// </summary>
+			/// <param name="nanoseconds"> The latency in nanoseconds. </param>
+			void Record(uint64_t nanoseconds)
+			{
+#if DAILY_TASK_MANAGER_METRICS
+				m_Buckets[HistogramSnapshot::BucketIndex(nanoseconds)].fetch_add(1, std::memory_order_relaxed);
+				m_Total.fetch_add(nanoseconds, std::memory_order_relaxed);
+
+				uint64_t max = m_Max.load(std::memory_order_relaxed);
+
+				while (nanoseconds > max && !m_Max.compare_exchange_weak(max, nanoseconds, std::memory_order_relaxed))
+				{
+				}
+#else
+				(void)nanoseconds;
+#endif
+			}
+
+			/// <summary>
+			/// Copies the counts of the histogram.
+			/// Values recorded while the copy is taken may be partly included.
+			/// </summary>
+			/// <returns> The copy of the counts. </returns>
+			HistogramSnapshot Snapshot() const
+			{
+				HistogramSnapshot snapshot;
+
+				for (uint64_t i = 0; i < HistogramSnapshot::s_Buckets; i++)
+				{
+					snapshot.buckets[i] = m_Buckets[i].load(std::memory_order_relaxed);
+					snapshot.count += snapshot.buckets[i];
+				}
+
+				snapshot.total_ns = m_Total.load(std::memory_order_relaxed);
+				snapshot.max_ns = m_Max.load(std::memory_order_relaxed);
+
+				return snapshot;
+			}
+		};
+
+		/// <summary>
+		/// A lock-free counter.
+		/// </summary>
+		class Counter : private NoCopy
+		{
+		private:
+			std::atomic<uint64_t> m_Value{ 0 };
+		public:
+			void Add(uint64_t value = 1)
+			{
+#if DAILY_TASK_MANAGER_METRICS
+				m_Value.fetch_add(value, std::memory_order_relaxed);
+#else
+				(void)value;
+#endif
+			}
+
+			uint64_t Get() const
+			{
+				return m_Value.load(std::memory_order_relaxed);
+			}
+		};
+
+		/// <summary>
+		/// Records the time from its creation to the end of its scope into a histogram.
+		/// </summary>
+		class ScopedLatency : private NoCopy
+		{
+#if DAILY_TASK_MANAGER_METRICS
+		private:
+			LatencyHistogram& m_Histogram;
+			std::chrono::steady_clock::time_point m_Start;
+		public:
+			ScopedLatency(LatencyHistogram& histogram)
+				: m_Histogram(histogram), m_Start(std::chrono::steady_clock::now())
+			{
+			}
+
+			~ScopedLatency()
+			{
+				m_Histogram.Record(std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - m_Start).count());
+			}
+#else
+		public:
+			ScopedLatency(LatencyHistogram&)
+			{
+			}
+#endif
+		};
+
+		/// <summary>
+		/// Formats a histogram as a single line, with the count, the mean and the percentiles in microseconds.
+		/// </summary>
+		/// <param name="name"> The name of the histogram. </param>
+		/// <param name="snapshot"> The counts of the histogram. </param>
+		/// <returns> The formatted line. </returns>
+		inline std::string FormatHistogram(const std::string& name, const HistogramSnapshot& snapshot)
+		{
+			char buffer[256];
+
+			std::snprintf(buffer, sizeof(buffer), "%-10s count=%llu mean_us=%.2f p50_us=%.2f p90_us=%.2f p99_us=%.2f p999_us=%.2f max_us=%.2f\n",
+				name.c_str(),
+				static_cast<unsigned long long>(snapshot.count),
+				snapshot.MeanNs() / 1000.0,
+				snapshot.PercentileNs(0.50) / 1000.0,
+				snapshot.PercentileNs(0.90) / 1000.0,
+				snapshot.PercentileNs(0.99) / 1000.0,
+				snapshot.PercentileNs(0.999) / 1000.0,
+				snapshot.max_ns / 1000.0);
+
+			return buffer;
+		}
+
+		/// <summary>
+		/// PeriodicDump class writes a report to a file at a fixed interval, on its own thread.
+		/// The report is written to a temporary file first and then renamed, so a reader never sees a partly written report.
+		/// </summary>
+		class PeriodicDump : private NoCopy
+		{
+		public:
+			using report_func = std::function<std::string()>;
+
+		private:
+			std::mutex m_Mutex;
+			std::condition_variable m_Condition;
+			bool m_Running{ true };
+			std::thread m_Thread;
+		public:
+			/// <summary>
+			/// Starts writing the report.
+			/// </summary>
+			/// <param name="path"> The file the report is written to. </param>
+			/// <param name="interval"> The time between two writes. </param>
+			/// <param name="report"> Creates the report, called from the dump thread. </param>
+			PeriodicDump(const std::string& path, std::chrono::milliseconds interval, report_func report)
+			{
+				m_Thread = std::thread([this, path, interval, report]()
+					{
+						std::unique_lock<std::mutex> lock(m_Mutex);
+
+						while (m_Running)
+						{
+							m_Condition.wait_for(lock, interval, [this]()
+								{
+									return !m_Running;
+								});
+
+							WriteReport(path, report());
+						}
+					});
+			}
+
+			/// <summary>
+			/// Stops writing the report, after writing it one last time.
+			/// </summary>
+			~PeriodicDump()
+			{
+				{
+					std::lock_guard<std::mutex> lock(m_Mutex);
+					m_Running = false;
+				}
+
+				m_Condition.notify_all();
+				m_Thread.join();
+			}
+
+		private:
+			static void WriteReport(const std::string& path, const std::string& report)
+			{
+				std::string temporary_path = path + ".tmp";
+
+				{
+					std::ofstream file(temporary_path, std::ios::trunc);
+
+					if (!file)
+						return;
+
+					file << report;
+				}
+
+				std::error_code error;
+				std::filesystem::rename(temporary_path, path, error);
+			}
+		};
+	}
+}
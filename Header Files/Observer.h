@@ -1,7 +1,7 @@
 #pragma once
 
 #include "../Header Files/Task.h"
-#include "../Header Files/Vector.h"
+#include "../Header Files/PersistentVector.h"
 
 /// <summary>
 /// Interface for the Observer pattern
@@ -10,5 +10,5 @@ class Observer
 {
 public:
     virtual ~Observer() {}
-    virtual void Update(const mrt::Vector<Task>& tasks) = 0;
+    virtual void Update(const mrt::PersistentVector<Task>& tasks) = 0;
 };
\ No newline at end of file
@@ -0,0 +1,346 @@
+#pragma once
+
+#include "../Header Files/NoCopy.h"
+#include "../Header Files/Observer.h"
+#include "../Header Files/Vector.h"
+#include "../Header Files/PersistentVector.h"
+
+#include <mutex>
+#include <algorithm>
+#include <chrono>
+#include <memory>
+#include <thread>
+#include <functional>
+#include <condition_variable>
+
+/// <summary>
+/// Runs a function on the thread that owns an observer, such as posting it to the UI thread's event loop.
+/// </summary>
+using Executor = std::function<void(std::function<void()>)>;
+
+/// <summary>
+/// A snapshot of the measurements taken by the <see cref="ObserverDispatcher"/>.
+/// The latency is the time from a notification being queued until the observer is updated.
+/// </summary>
+struct DispatchMetrics
+{
+    uint64_t notifications{ 0 };
+    uint64_t coalesced{ 0 };
+    uint64_t deliveries{ 0 };
+    uint64_t queue_depth{ 0 };
+    uint64_t max_queue_depth{ 0 };
+    double average_latency_ms{ 0.0 };
+    double max_latency_ms{ 0.0 };
+};
+
+/// <summary>
+/// ObserverDispatcher class delivers notifications to observers on their own executors, away from the thread that made the change.
+/// Notifications for an observer are coalesced, only the latest tasks are kept until the observer is updated.
+/// A dispatch thread hands the pending notifications to the executors at most once per frame,
+/// and an observer is not handed another notification while its last one is still waiting to run.
+/// </summary>
+class ObserverDispatcher : private NoCopy
+{
+private:
+    using Clock = std::chrono::steady_clock;
+
+    /// <summary>
+    /// The state of a single observer, shared with the deliveries that have been handed to its executor.
+    /// The update mutex is held while the observer is updated, the state mutex guards the rest.
+    /// </summary>
+    struct Subscription
+    {
+        Observer* observer{ nullptr };
+        Executor executor;
+
+        std::recursive_mutex update_mutex;
+        std::mutex mutex;
+        bool attached{ true };
+        bool pending{ false };
+        bool in_flight{ false };
+        Clock::time_point queued_at;
+        mrt::PersistentVector<Task> tasks;
+    };
+
+    /// <summary>
+    /// The measurements, shared with the deliveries so they can outlive the dispatcher.
+    /// </summary>
+    struct Measurements
+    {
+        std::mutex mutex;
+        DispatchMetrics metrics;
+        double total_latency_ms{ 0.0 };
+    };
+
+    std::mutex m_Mutex;
+    std::condition_variable m_Condition;
+    std::thread m_Thread;
+    bool m_Running{ false };
+    bool m_HasPending{ false };
+    Clock::duration m_FrameInterval;
+
+    mrt::Vector<std::shared_ptr<Subscription>> m_Subscriptions;
+    std::shared_ptr<Measurements> m_Measurements{ std::make_shared<Measurements>() };
+public:
+    /// <summary>
+    /// Initializes a new instance of the <see cref="ObserverDispatcher"/> class.
+    /// The dispatch thread is started when the first observer is added.
+    /// </summary>
+    /// <param name="frame_interval"> The minimum time between two deliveries to the same observer. </param>
+    ObserverDispatcher(Clock::duration frame_interval = std::chrono::microseconds(16667))
+        : m_FrameInterval(frame_interval)
+    {
+    }
+
+    /// <summary>
+    /// Finalizes an instance of the <see cref="ObserverDispatcher"/> class.
+    /// Stops the dispatch thread, notifications that have not been handed to an executor are dropped.
+    /// </summary>
+    ~ObserverDispatcher()
+    {
+        {
+            std::lock_guard<std::mutex> lock(m_Mutex);
+            m_Running = false;
+        }
+
+        m_Condition.notify_all();
+
+        if (m_Thread.joinable())
+        {
+            m_Thread.join();
+        }
+    }
+
+    /// <summary>
+    /// Adds an observer that will be updated on the specified executor.
+    /// </summary>
+    /// <param name="observer"> The observer. </param>
+    /// <param name="executor"> The executor that runs the observer's updates, it may also run them inline on the dispatch thread. </param>
+    void Add(Observer* observer, Executor executor)
+    {
+        std::shared_ptr<Subscription> subscription = std::make_shared<Subscription>();
+        subscription->observer = observer;
+        subscription->executor = executor;
+
+        std::lock_guard<std::mutex> lock(m_Mutex);
+
+        m_Subscriptions.PushBack(subscription);
+
+        if (!m_Running)
+        {
+            m_Running = true;
+            m_Thread = std::thread([this]()
+                {
+                    Run();
+                });
+        }
+    }
+
+    /// <summary>
+    /// Removes an observer, it will not be updated again once this returns.
+    /// Waits for an update of the observer that is currently running on another thread.
+    /// </summary>
+    /// <param name="observer"> The observer. </param>
+    void Remove(Observer* observer)
+    {
+        std::shared_ptr<Subscription> subscription;
+
+        {
+            std::lock_guard<std::mutex> lock(m_Mutex);
+
+            for (uint64_t i = 0; i < m_Subscriptions.Size(); i++)
+            {
+                if (m_Subscriptions[i]->observer == observer)
+                {
+                    subscription = m_Subscriptions[i];
+                    m_Subscriptions.Erase(i);
+                    break;
+                }
+            }
+        }
+
+        if (subscription)
+        {
+            std::lock_guard<std::recursive_mutex> update_lock(subscription->update_mutex);
+            std::lock_guard<std::mutex> lock(subscription->mutex);
+
+            subscription->attached = false;
+
+            if (subscription->pending)
+            {
+                std::lock_guard<std::mutex> measurements_lock(m_Measurements->mutex);
+                m_Measurements->metrics.queue_depth--;
+            }
+        }
+    }
+
+    /// <summary>
+    /// Checks whether the observer was added to this dispatcher.
+    /// </summary>
+    /// <param name="observer"> The observer. </param>
+    /// <returns> True if the observer is updated by this dispatcher, false otherwise. </returns>
+    bool Contains(Observer* observer)
+    {
+        std::lock_guard<std::mutex> lock(m_Mutex);
+
+        for (const std::shared_ptr<Subscription>& subscription : m_Subscriptions)
+        {
+            if (subscription->observer == observer)
+                return true;
+        }
+
+        return false;
+    }
+
+    /// <summary>
+    /// Queues a notification for an observer, replacing any notification that has not been delivered yet.
+    /// </summary>
+    /// <param name="observer"> The observer. </param>
+    /// <param name="tasks"> The tasks to update the observer with. </param>
+    void Enqueue(Observer* observer, const mrt::PersistentVector<Task>& tasks)
+    {
+        std::lock_guard<std::mutex> lock(m_Mutex);
+
+        for (const std::shared_ptr<Subscription>& subscription : m_Subscriptions)
+        {
+            if (subscription->observer != observer)
+                continue;
+
+            std::lock_guard<std::mutex> subscription_lock(subscription->mutex);
+            std::lock_guard<std::mutex> measurements_lock(m_Measurements->mutex);
+
+            DispatchMetrics& metrics = m_Measurements->metrics;
+            metrics.notifications++;
+
+            if (subscription->pending)
+            {
+                metrics.coalesced++;
+            }
+            else
+            {
+                subscription->pending = true;
+                subscription->queued_at = Clock::now();
+
+                metrics.queue_depth++;
+                metrics.max_queue_depth = std::max(metrics.max_queue_depth, metrics.queue_depth);
+            }
+
+            subscription->tasks = tasks;
+            m_HasPending = true;
+        }
+
+        m_Condition.notify_one();
+    }
+
+    /// <summary>
+    /// Gets a snapshot of the dispatch measurements.
+    /// </summary>
+    /// <returns> The dispatch measurements. </returns>
+    DispatchMetrics GetMetrics() const
+    {
+        std::lock_guard<std::mutex> lock(m_Measurements->mutex);
+
+        return m_Measurements->metrics;
+    }
+
+private:
+    /// <summary>
+    /// The dispatch thread, hands the pending notifications to the executors once per frame.
+    /// </summary>
+    void Run()
+    {
+        std::unique_lock<std::mutex> lock(m_Mutex);
+
+        while (m_Running)
+        {
+            m_Condition.wait(lock, [this]()
+                {
+                    return !m_Running || m_HasPending;
+                });
+
+            if (!m_Running)
+                break;
+
+            m_HasPending = false;
+
+            mrt::Vector<std::shared_ptr<Subscription>> deliveries;
+
+            for (const std::shared_ptr<Subscription>& subscription : m_Subscriptions)
+            {
+                std::lock_guard<std::mutex> subscription_lock(subscription->mutex);
+
+                if (!subscription->pending)
+                    continue;
+
+                if (subscription->in_flight)
+                {
+                    m_HasPending = true;
+                    continue;
+                }
+
+                subscription->in_flight = true;
+                deliveries.PushBack(subscription);
+            }
+
+            // The executors are called without holding any lock, so an executor may run the delivery inline
+            // and a slow executor does not hold up the threads queueing notifications.
+            lock.unlock();
+
+            for (const std::shared_ptr<Subscription>& subscription : deliveries)
+            {
+                subscription->executor([subscription, measurements = m_Measurements]()
+                    {
+                        Deliver(subscription, *measurements);
+                    });
+            }
+
+            deliveries.Clear();
+            lock.lock();
+
+            if (!m_Running)
+                break;
+
+            Clock::time_point next_frame = Clock::now() + m_FrameInterval;
+
+            m_Condition.wait_until(lock, next_frame, [this]()
+                {
+                    return !m_Running;
+                });
+        }
+    }
+
+    /// <summary>
+    /// Updates an observer with its latest tasks, runs on the observer's executor.
+    /// </summary>
+    static void Deliver(const std::shared_ptr<Subscription>& subscription, Measurements& measurements)
+    {
+        std::lock_guard<std::recursive_mutex> update_lock(subscription->update_mutex);
+
+        mrt::PersistentVector<Task> tasks;
+
+        {
+            std::lock_guard<std::mutex> lock(subscription->mutex);
+
+            subscription->in_flight = false;
+
+            if (!subscription->attached || !subscription->pending)
+                return;
+
+            double latency_ms = std::chrono::duration<double, std::milli>(Clock::now() - subscription->queued_at).count();
+
+            tasks = subscription->tasks;
+            subscription->pending = false;
+
+            std::lock_guard<std::mutex> measurements_lock(measurements.mutex);
+
+            DispatchMetrics& metrics = measurements.metrics;
+            metrics.deliveries++;
+            metrics.queue_depth--;
+            measurements.total_latency_ms += latency_ms;
+            metrics.average_latency_ms = measurements.total_latency_ms / metrics.deliveries;
+            metrics.max_latency_ms = std::max(metrics.max_latency_ms, latency_ms);
+        }
+
+        subscription->observer->Update(tasks);
+    }
+};
\ No newline at end of file
@@ -0,0 +1,519 @@
+#pragma once
+
+#include <array>
+#include <memory>
+#include <cstdint>
+#include <utility>
+#include <stdexcept>
+
+#include "../Header Files/Vector.h"
+
+#define NODISCARD [[nodiscard]]
+
+namespace mrt
+{
+    /// <summary>
+    /// PersistentVectorIterator class
+    /// Used to iterate through the persistent vector like the standard library iterators
+    /// Caches the leaf being walked, so stepping through the vector is O(1) per element
+    /// </summary>
+    /// <typeparam name="_Vec"> Persistent vector type. </typeparam>
+    template <typename _Vec>
+    class PersistentVectorIterator
+    {
+    public:
+        using ValueType = typename _Vec::ValueType;
+        using PointerType = const ValueType*;
+        using ReferenceType = const ValueType&;
+        using SizeType = typename _Vec::SizeType;
+
+    public:
+        PersistentVectorIterator(const _Vec* vector, SizeType index)
+            : m_Vector(vector), m_Index(index), m_Leaf(nullptr)
+        {
+            if (m_Index < m_Vector->Size())
+            {
+                m_Leaf = m_Vector->LeafFor(m_Index);
+            }
+        }
+
+        PersistentVectorIterator& operator++()
+        {
+            m_Index++;
+
+            if ((m_Index & _Vec::s_Mask) == 0)
+            {
+                m_Leaf = (m_Index < m_Vector->Size()) ? m_Vector->LeafFor(m_Index) : nullptr;
+            }
+
+            return *this;
+        }
+
+        PersistentVectorIterator operator++(int)
+        {
+            PersistentVectorIterator iterator = *this;
+            ++(*this);
+            return iterator;
+        }
+
+        SizeType operator-(const PersistentVectorIterator& other) const
+        {
+            return m_Index - other.m_Index;
+        }
+
+        PointerType operator->() const
+        {
+            return &m_Leaf[m_Index & _Vec::s_Mask];
+        }
+
+        ReferenceType operator*() const
+        {
+            return m_Leaf[m_Index & _Vec::s_Mask];
+        }
+
+        bool operator==(const PersistentVectorIterator& other) const
+        {
+            return m_Index == other.m_Index && m_Vector == other.m_Vector;
+        }
+
+        bool operator!=(const PersistentVectorIterator& other) const
+        {
+            return !(*this == other);
+        }
+
+    private:
+        const _Vec* m_Vector;
+        SizeType m_Index;
+        PointerType m_Leaf;
+    };
+
+    /// <summary>
+    /// PersistentVector class
+    /// An immutable-by-version vector implemented as a 32-way trie with a tail buffer.
+    /// Copying a persistent vector is O(1), the copy shares every node with the original.
+    /// Modifying a version only copies the O(log32 n) nodes on the path to the changed element,
+    /// so every other version that shares those nodes keeps its old values.
+    /// Nodes that are owned by a single version are modified in place, so building a vector is still cheap.
+    /// </summary>
+    /// <typeparam name="_Type"> Vector type. </typeparam>
+    template <typename _Type>
+    class PersistentVector
+    {
+    public:
+        using ValueType = _Type;
+        using SizeType = uint64_t;
+        using ConstIterator = PersistentVectorIterator<PersistentVector<_Type>>;
+
+        friend class PersistentVectorIterator<PersistentVector<_Type>>;
+
+    private:
+        static constexpr uint32_t s_Bits = 5;
+        static constexpr SizeType s_Width = SizeType(1) << s_Bits;
+        static constexpr SizeType s_Mask = s_Width - 1;
+
+        struct Node
+        {
+            virtual ~Node() = default;
+        };
+
+        struct Branch : public Node
+        {
+            std::array<std::shared_ptr<Node>, s_Width> m_Children;
+        };
+
+        struct Leaf : public Node
+        {
+            std::array<_Type, s_Width> m_Values;
+        };
+
+    public:
+        /// <summary>
+        /// Initializes a new, empty instance of the <see cref="PersistentVector"/> class.
+        /// No nodes are allocated until the first element is added.
+        /// </summary>
+        PersistentVector()
+            : m_Size(0), m_Shift(s_Bits)
+        {
+        }
+
+        /// <summary>
+        /// Initializes a new instance of the <see cref="PersistentVector"/> class.
+        /// Initializes the vector with the elements of the specified vector
+        /// </summary>
+        /// <param name="other"> The vector to initialize with. </param>
+        PersistentVector(const Vector<_Type>& other)
+            : PersistentVector()
+        {
+            for (const _Type& value : other)
+            {
+                PushBack(value);
+            }
+        }
+
+        PersistentVector(const PersistentVector<_Type>& other) = default;
+        PersistentVector(PersistentVector<_Type>&& other) noexcept = default;
+        PersistentVector& operator=(const PersistentVector<_Type>& other) = default;
+        PersistentVector& operator=(PersistentVector<_Type>&& other) noexcept = default;
+
+        /// <summary>
+        /// Adds the specified value to the end of the vector
+        /// Once the tail is full it is pushed into the trie, growing the trie by a level when the root is full
+        /// </summary>
+        /// <param name="value"> The value to add. </param>
+        void PushBack(const _Type& value)
+        {
+            if (m_Size - TailOffset() < s_Width)
+            {
+                MutableLeaf(m_Tail)->m_Values[m_Size - TailOffset()] = value;
+                m_Size++;
+                return;
+            }
+
+            if ((m_Size >> s_Bits) > (SizeType(1) << m_Shift))
+            {
+                std::shared_ptr<Branch> new_root = std::make_shared<Branch>();
+
+                new_root->m_Children[0] = m_Root;
+                new_root->m_Children[1] = NewPath(m_Shift, m_Tail);
+
+                m_Root = new_root;
+                m_Shift += s_Bits;
+            }
+            else
+            {
+                PushTail(m_Shift, m_Root, m_Tail);
+            }
+
+            m_Tail = std::make_shared<Leaf>();
+            m_Tail->m_Values[0] = value;
+            m_Size++;
+        }
+
+        /// <summary>
+        /// Removes the last element from the vector
+        /// When the tail becomes empty the last leaf of the trie becomes the new tail
+        /// </summary>
+        void PopBack()
+        {
+            if (m_Size == 0)
+            {
+                return;
+            }
+
+            if (m_Size == 1)
+            {
+                Clear();
+                return;
+            }
+
+            if (m_Size - TailOffset() > 1)
+            {
+                MutableLeaf(m_Tail)->m_Values[m_Size - TailOffset() - 1] = _Type();
+                m_Size--;
+                return;
+            }
+
+            m_Tail = std::static_pointer_cast<Leaf>(LeafNodeFor(m_Size - 2));
+
+            PopTail(m_Shift, m_Root);
+
+            if (m_Shift > s_Bits && m_Root && static_cast<Branch*>(m_Root.get())->m_Children[1] == nullptr)
+            {
+                m_Root = static_cast<Branch*>(m_Root.get())->m_Children[0];
+                m_Shift -= s_Bits;
+            }
+
+            m_Size--;
+        }
+
+        /// <summary>
+        /// Replaces the element at the specified index
+        /// Only the nodes on the path to the element are copied
+        /// </summary>
+        /// <param name="index"> The index of the element. </param>
+        /// <param name="value"> The new value of the element. </param>
+        void Set(SizeType index, const _Type& value)
+        {
+            if (index >= m_Size)
+            {
+                throw std::out_of_range("Index out of range");
+            }
+
+            if (index >= TailOffset())
+            {
+                MutableLeaf(m_Tail)->m_Values[index & s_Mask] = value;
+                return;
+            }
+
+            std::shared_ptr<Node>* slot = &m_Root;
+
+            for (uint32_t level = m_Shift; level > 0; level -= s_Bits)
+            {
+                slot = &MutableBranch(*slot)->m_Children[(index >> level) & s_Mask];
+            }
+
+            MutableLeaf(*slot)->m_Values[index & s_Mask] = value;
+        }
+
+        /// <summary>
+        /// Removes the element at the specified index
+        /// The elements before the index stay shared with the previous version,
+        /// the elements after the index are re-appended, so this is O(n - index)
+        /// </summary>
+        /// <param name="index"> The index of the element. </param>
+        void Erase(SizeType index)
+        {
+            if (index >= m_Size)
+            {
+                throw std::out_of_range("Index out of range");
+            }
+
+            PersistentVector<_Type> previous(*this);
+
+            while (m_Size > index)
+            {
+                PopBack();
+            }
+
+            for (SizeType i = index + 1; i < previous.Size(); i++)
+            {
+                PushBack(previous[i]);
+            }
+        }
+
+        /// <summary>
+        /// Clears the vector, releasing this version's references to its nodes
+        /// </summary>
+        void Clear()
+        {
+            m_Root.reset();
+            m_Tail.reset();
+            m_Size = 0;
+            m_Shift = s_Bits;
+        }
+
+        /// <summary>
+        /// Copies the elements into a <see cref="Vector"/>
+        /// </summary>
+        /// <returns> A vector containing the elements of this version. </returns>
+        NODISCARD Vector<_Type> ToVector() const
+        {
+            Vector<_Type> result(m_Size > 0 ? m_Size : 1);
+
+            for (const _Type& value : *this)
+            {
+                result.PushBack(value);
+            }
+
+            return result;
+        }
+
+        /// <summary>
+        /// Returns the size of the vector
+        /// </summary>
+        /// <returns> The size of the vector. </returns>
+        NODISCARD SizeType Size() const
+        {
+            return m_Size;
+        }
+
+        /// <summary>
+        /// Checks if the vector is empty
+        /// </summary>
+        /// <returns> True if the vector is empty, false otherwise. </returns>
+        NODISCARD bool Empty() const
+        {
+            return (m_Size == 0);
+        }
+
+        /// <summary>
+        /// Returns the element at the specified index
+        /// </summary>
+        /// <param name="index"> The index of the element. </param>
+        /// <returns> The element at the specified index. </returns>
+        NODISCARD const _Type& At(SizeType index) const
+        {
+            return LeafFor(index)[index & s_Mask];
+        }
+
+        /// <summary>
+        /// Returns the element at the specified index
+        /// Uses the subscript operator to return the element
+        /// </summary>
+        /// <param name="index"> The index of the element. </param>
+        /// <returns> The element at the specified index. </returns>
+        NODISCARD const _Type& operator[](SizeType index) const
+        {
+            return LeafFor(index)[index & s_Mask];
+        }
+
+        /// <summary>
+        /// Returns the element at the back of the vector
+        /// </summary>
+        /// <returns> The element at the back of the vector. </returns>
+        NODISCARD const _Type& Back() const
+        {
+            return At(m_Size - 1);
+        }
+
+        /// <summary>
+        /// The begin iterator of the vector
+        /// </summary>
+        /// <returns> The begin iterator of the vector. </returns>
+        NODISCARD ConstIterator begin() const
+        {
+            return ConstIterator(this, 0);
+        }
+
+        /// <summary>
+        /// The end iterator of the vector
+        /// </summary>
+        /// <returns> The end iterator of the vector. </returns>
+        NODISCARD ConstIterator end() const
+        {
+            return ConstIterator(this, m_Size);
+        }
+
+    private:
+        /// <summary>
+        /// The index of the first element held in the tail.
+        /// </summary>
+        SizeType TailOffset() const
+        {
+            return (m_Size < s_Width) ? 0 : ((m_Size - 1) >> s_Bits) << s_Bits;
+        }
+
+        /// <summary>
+        /// Finds the leaf node within the trie that holds the specified index.
+        /// The index must be before the tail offset.
+        /// </summary>
+        const std::shared_ptr<Node>& LeafNodeFor(SizeType index) const
+        {
+            const std::shared_ptr<Node>* node = &m_Root;
+
+            for (uint32_t level = m_Shift; level > 0; level -= s_Bits)
+            {
+                node = &static_cast<Branch*>(node->get())->m_Children[(index >> level) & s_Mask];
+            }
+
+            return *node;
+        }
+
+        /// <summary>
+        /// Gets the values array of the leaf that holds the specified index.
+        /// </summary>
+        const _Type* LeafFor(SizeType index) const
+        {
+            if (index >= TailOffset())
+            {
+                return m_Tail->m_Values.data();
+            }
+
+            return static_cast<Leaf*>(LeafNodeFor(index).get())->m_Values.data();
+        }
+
+        /// <summary>
+        /// Makes sure the branch in the slot is only owned by this version, copying it if it is shared.
+        /// </summary>
+        static Branch* MutableBranch(std::shared_ptr<Node>& slot)
+        {
+            if (!slot)
+            {
+                slot = std::make_shared<Branch>();
+            }
+            else if (slot.use_count() != 1)
+            {
+                slot = std::make_shared<Branch>(*static_cast<Branch*>(slot.get()));
+            }
+
+            return static_cast<Branch*>(slot.get());
+        }
+
+        /// <summary>
+        /// Makes sure the leaf in the slot is only owned by this version, copying it if it is shared.
+        /// </summary>
+        template <typename _Ptr>
+        static Leaf* MutableLeaf(_Ptr& slot)
+        {
+            if (!slot)
+            {
+                slot = std::make_shared<Leaf>();
+            }
+            else if (slot.use_count() != 1)
+            {
+                slot = std::make_shared<Leaf>(*static_cast<Leaf*>(slot.get()));
+            }
+
+            return static_cast<Leaf*>(slot.get());
+        }
+
+        /// <summary>
+        /// Creates a chain of branches down to the specified leaf.
+        /// </summary>
+        static std::shared_ptr<Node> NewPath(uint32_t level, const std::shared_ptr<Leaf>& leaf)
+        {
+            if (level == 0)
+            {
+                return leaf;
+            }
+
+            std::shared_ptr<Branch> branch = std::make_shared<Branch>();
+            branch->m_Children[0] = NewPath(level - s_Bits, leaf);
+            return branch;
+        }
+
+        /// <summary>
+        /// Pushes a full tail into the trie, copying the shared branches along the way.
+        /// </summary>
+        void PushTail(uint32_t level, std::shared_ptr<Node>& slot, const std::shared_ptr<Leaf>& tail)
+        {
+            Branch* branch = MutableBranch(slot);
+            std::shared_ptr<Node>& child = branch->m_Children[((m_Size - 1) >> level) & s_Mask];
+
+            if (level == s_Bits)
+            {
+                child = tail;
+            }
+            else if (child)
+            {
+                PushTail(level - s_Bits, child, tail);
+            }
+            else
+            {
+                child = NewPath(level - s_Bits, tail);
+            }
+        }
+
+        /// <summary>
+        /// Removes the last leaf from the trie, dropping branches that become empty.
+        /// </summary>
+        void PopTail(uint32_t level, std::shared_ptr<Node>& slot)
+        {
+            SizeType sub_index = ((m_Size - 2) >> level) & s_Mask;
+
+            if (level > s_Bits)
+            {
+                PopTail(level - s_Bits, MutableBranch(slot)->m_Children[sub_index]);
+
+                if (sub_index == 0 && static_cast<Branch*>(slot.get())->m_Children[0] == nullptr)
+                {
+                    slot.reset();
+                }
+            }
+            else if (sub_index == 0)
+            {
+                slot.reset();
+            }
+            else
+            {
+                MutableBranch(slot)->m_Children[sub_index].reset();
+            }
+        }
+
+    private:
+        std::shared_ptr<Node> m_Root;
+        std::shared_ptr<Leaf> m_Tail;
+        SizeType m_Size;
+        uint32_t m_Shift;
+    };
+}
\ No newline at end of file
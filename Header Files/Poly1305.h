@@ -0,0 +1,220 @@
+#pragma once
+
+#include <cstdint>
+#include <cstddef>
+#include <cstring>
+
+namespace mrt
+{
+	/// <summary>
+	/// Poly1305 class computes the Poly1305 message authentication code of RFC 8439, a 16-byte tag of a message under a 32-byte one-time key.
+	/// The accumulator is held in five 26-bit limbs, so every product fits 64 bits on any processor without wider multiplies.
+	/// A key must authenticate a single message, which <see cref="ChaCha20Poly1305"/> does by making a new key for every nonce.
+	/// </summary>
+	class Poly1305
+	{
+	public:
+		static constexpr uint64_t s_KeySize = 32;
+		static constexpr uint64_t s_TagSize = 16;
+
+	private:
+		static constexpr uint32_t s_LimbMask = 0x3FFFFFF;
+
+		uint32_t m_R[5];
+		uint32_t m_H[5]{};
+		uint32_t m_Pad[4];
+
+		// A block that is not full yet, kept until more bytes are added or the tag is taken.
+		uint8_t m_Buffer[16];
+		uint64_t m_Buffered{ 0 };
+	public:
+		/// <summary>
+		/// Initializes a new instance of the <see cref="Poly1305"/> class.
+		/// </summary>
+		/// <param name="key"> The one-time key, <see cref="s_KeySize"/> bytes. </param>
+		explicit Poly1305(const uint8_t* key)
+		{
+			// r is clamped as the specification requires, which keeps the products within 64 bits.
+			m_R[0] = Load32(key) & 0x3FFFFFF;
+			m_R[1] = (Load32(key + 3) >> 2) & 0x3FFFF03;
+			m_R[2] = (Load32(key + 6) >> 4) & 0x3FFC0FF;
+			m_R[3] = (Load32(key + 9) >> 6) & 0x3F03FFF;
+			m_R[4] = (Load32(key + 12) >> 8) & 0x00FFFFF;
+
+			for (int i = 0; i < 4; i++)
+			{
+				m_Pad[i] = Load32(key + 16 + 4 * i);
+			}
+		}
+
+		/// <summary>
+		/// Adds bytes to the message, a message can be added in several parts.
+		/// </summary>
+		/// <param name="data"> The bytes. </param>
+		/// <param name="size"> The number of bytes. </param>
+		void Update(const void* data, size_t size)
+		{
+			const uint8_t* bytes = static_cast<const uint8_t*>(data);
+
+			if (m_Buffered > 0)
+			{
+				size_t count = size < 16 - m_Buffered ? size : static_cast<size_t>(16 - m_Buffered);
+
+				std::memcpy(m_Buffer + m_Buffered, bytes, count);
+				m_Buffered += count;
+				bytes += count;
+				size -= count;
+
+				if (m_Buffered < 16)
+					return;
+
+				Blocks(m_Buffer, 16, 1u << 24);
+				m_Buffered = 0;
+			}
+
+			size_t whole = size & ~static_cast<size_t>(15);
+
+			Blocks(bytes, whole, 1u << 24);
+
+			std::memcpy(m_Buffer, bytes + whole, size - whole);
+			m_Buffered = size - whole;
+		}
+
+		/// <summary>
+		/// Adds zero bytes up to the next multiple of 16 bytes of the message, as the AEAD construction pads its parts.
+		/// </summary>
+		void PadTo16()
+		{
+			if (m_Buffered == 0)
+				return;
+
+			std::memset(m_Buffer + m_Buffered, 0, 16 - m_Buffered);
+			Blocks(m_Buffer, 16, 1u << 24);
+			m_Buffered = 0;
+		}
+
+		/// <summary>
+		/// Gets the tag of the message added so far.
+		/// </summary>
+		/// <param name="tag"> The buffer to write the <see cref="s_TagSize"/> bytes of the tag to. </param>
+		void Final(uint8_t* tag)
+		{
+			if (m_Buffered > 0)
+			{
+				// The last block is ended with a 1 byte in place of the bit above a full block.
+				m_Buffer[m_Buffered] = 1;
+				std::memset(m_Buffer + m_Buffered + 1, 0, 15 - m_Buffered);
+				Blocks(m_Buffer, 16, 0);
+				m_Buffered = 0;
+			}
+
+			uint32_t h0 = m_H[0], h1 = m_H[1], h2 = m_H[2], h3 = m_H[3], h4 = m_H[4];
+			uint32_t carry;
+
+			carry = h1 >> 26; h1 &= s_LimbMask;
+			h2 += carry; carry = h2 >> 26; h2 &= s_LimbMask;
+			h3 += carry; carry = h3 >> 26; h3 &= s_LimbMask;
+			h4 += carry; carry = h4 >> 26; h4 &= s_LimbMask;
+			h0 += carry * 5; carry = h0 >> 26; h0 &= s_LimbMask;
+			h1 += carry;
+
+			// g = h + 5 - 2^130, which is h reduced modulo 2^130 - 5 when it does not go below zero.
+			uint32_t g0 = h0 + 5; carry = g0 >> 26; g0 &= s_LimbMask;
+			uint32_t g1 = h1 + carry; carry = g1 >> 26; g1 &= s_LimbMask;
+			uint32_t g2 = h2 + carry; carry = g2 >> 26; g2 &= s_LimbMask;
+			uint32_t g3 = h3 + carry; carry = g3 >> 26; g3 &= s_LimbMask;
+			uint32_t g4 = h4 + carry - (1u << 26);
+
+			// The choice is made with a mask instead of a branch, so the time taken does not depend on the tag.
+			uint32_t mask = (g4 >> 31) - 1;
+			h0 = (h0 & ~mask) | (g0 & mask);
+			h1 = (h1 & ~mask) | (g1 & mask);
+			h2 = (h2 & ~mask) | (g2 & mask);
+			h3 = (h3 & ~mask) | (g3 & mask);
+			h4 = (h4 & ~mask) | (g4 & mask);
+
+			uint32_t words[4] = {
+				h0 | (h1 << 26),
+				(h1 >> 6) | (h2 << 20),
+				(h2 >> 12) | (h3 << 14),
+				(h3 >> 18) | (h4 << 8)
+			};
+
+			uint64_t sum = 0;
+
+			for (int i = 0; i < 4; i++)
+			{
+				sum += static_cast<uint64_t>(words[i]) + m_Pad[i];
+				Store32(tag + 4 * i, static_cast<uint32_t>(sum));
+				sum >>= 32;
+			}
+		}
+
+		/// <summary>
+		/// Compares two tags in a time that does not depend on where they differ.
+		/// </summary>
+		static bool Equal(const uint8_t* a, const uint8_t* b)
+		{
+			uint8_t difference = 0;
+
+			for (uint64_t i = 0; i < s_TagSize; i++)
+			{
+				difference |= a[i] ^ b[i];
+			}
+
+			return difference == 0;
+		}
+
+	private:
+		/// <summary>
+		/// Adds whole blocks to the accumulator and multiplies it by r, modulo 2^130 - 5.
+		/// </summary>
+		/// <param name="high_bit"> The bit above the 128 bits of each block, set for every block but a padded last one. </param>
+		void Blocks(const uint8_t* bytes, size_t size, uint32_t high_bit)
+		{
+			const uint64_t r0 = m_R[0], r1 = m_R[1], r2 = m_R[2], r3 = m_R[3], r4 = m_R[4];
+			const uint64_t s1 = r1 * 5, s2 = r2 * 5, s3 = r3 * 5, s4 = r4 * 5;
+
+			uint32_t h0 = m_H[0], h1 = m_H[1], h2 = m_H[2], h3 = m_H[3], h4 = m_H[4];
+
+			for (; size >= 16; bytes += 16, size -= 16)
+			{
+				h0 += Load32(bytes) & s_LimbMask;
+				h1 += (Load32(bytes + 3) >> 2) & s_LimbMask;
+				h2 += (Load32(bytes + 6) >> 4) & s_LimbMask;
+				h3 += (Load32(bytes + 9) >> 6) & s_LimbMask;
+				h4 += (Load32(bytes + 12) >> 8) | high_bit;
+
+				uint64_t d0 = h0 * r0 + h1 * s4 + h2 * s3 + h3 * s2 + h4 * s1;
+				uint64_t d1 = h0 * r1 + h1 * r0 + h2 * s4 + h3 * s3 + h4 * s2;
+				uint64_t d2 = h0 * r2 + h1 * r1 + h2 * r0 + h3 * s4 + h4 * s3;
+				uint64_t d3 = h0 * r3 + h1 * r2 + h2 * r1 + h3 * r0 + h4 * s4;
+				uint64_t d4 = h0 * r4 + h1 * r3 + h2 * r2 + h3 * r1 + h4 * r0;
+
+				uint64_t carry;
+				carry = d0 >> 26; h0 = static_cast<uint32_t>(d0) & s_LimbMask;
+				d1 += carry; carry = d1 >> 26; h1 = static_cast<uint32_t>(d1) & s_LimbMask;
+				d2 += carry; carry = d2 >> 26; h2 = static_cast<uint32_t>(d2) & s_LimbMask;
+				d3 += carry; carry = d3 >> 26; h3 = static_cast<uint32_t>(d3) & s_LimbMask;
+				d4 += carry; carry = d4 >> 26; h4 = static_cast<uint32_t>(d4) & s_LimbMask;
+				h0 += static_cast<uint32_t>(carry * 5); carry = h0 >> 26; h0 &= s_LimbMask;
+				h1 += static_cast<uint32_t>(carry);
+			}
+
+			m_H[0] = h0; m_H[1] = h1; m_H[2] = h2; m_H[3] = h3; m_H[4] = h4;
+		}
+
+		static uint32_t Load32(const uint8_t* position)
+		{
+			return uint32_t(position[0]) | uint32_t(position[1]) << 8 | uint32_t(position[2]) << 16 | uint32_t(position[3]) << 24;
+		}
+
+		static void Store32(uint8_t* position, uint32_t value)
+		{
+			position[0] = static_cast<uint8_t>(value);
+			position[1] = static_cast<uint8_t>(value >> 8);
+			position[2] = static_cast<uint8_t>(value >> 16);
+			position[3] = static_cast<uint8_t>(value >> 24);
+		}
+	};
+}
@@ -0,0 +1,341 @@
+#pragma once
+
+#include "../Header Files/Task.h"
+#include "../Header Files/Time.h"
+#include "../Header Files/Vector.h"
+
+#include <map>
+#include <vector>
+#include <cstdint>
+#include <utility>
+#include <unordered_map>
+
+/// <summary>
+/// How often a recurring task occurs.
+/// </summary>
+enum class RecurrenceKind
+{
+    Daily,
+    Weekdays,
+    EveryNDays,
+    Weekly
+};
+
+/// <summary>
+/// A rule that creates a task on every day that it occurs, the task is stored once with the rule rather than once per day.
+/// </summary>
+struct RecurrenceRule
+{
+    /// <summary>
+    /// Creates a rule that occurs every day.
+    /// </summary>
+    /// <param name="task"> The task created on each day. </param>
+    /// <param name="from"> The first day, formatted as dd-mm-yyyy. </param>
+    /// <returns> The rule. </returns>
+    static RecurrenceRule Daily(const Task& task, const std::string& from)
+    {
+        return RecurrenceRule(RecurrenceKind::Daily, task, from);
+    }
+
+    /// <summary>
+    /// Creates a rule that occurs from Monday to Friday.
+    /// </summary>
+    /// <param name="task"> The task created on each day. </param>
+    /// <param name="from"> The first day, formatted as dd-mm-yyyy. </param>
+    /// <returns> The rule. </returns>
+    static RecurrenceRule Weekdays(const Task& task, const std::string& from)
+    {
+        return RecurrenceRule(RecurrenceKind::Weekdays, task, from);
+    }
+
+    /// <summary>
+    /// Creates a rule that occurs every N days, counted from the first day.
+    /// </summary>
+    /// <param name="task"> The task created on each day. </param>
+    /// <param name="days"> The number of days between two occurrences. </param>
+    /// <param name="from"> The first day, formatted as dd-mm-yyyy. </param>
+    /// <returns> The rule. </returns>
+    static RecurrenceRule EveryNDays(const Task& task, uint64_t days, const std::string& from)
+    {
+        RecurrenceRule rule(RecurrenceKind::EveryNDays, task, from);
+        rule.interval = days > 0 ? days : 1;
+        return rule;
+    }
+
+    /// <summary>
+    /// Creates a rule that occurs on the given days of every week, or of every N weeks.
+    /// </summary>
+    /// <param name="task"> The task created on each day. </param>
+    /// <param name="weekday_mask"> The days of the week, bit 0 for Sunday through bit 6 for Saturday. </param>
+    /// <param name="from"> The first day, formatted as dd-mm-yyyy. </param>
+    /// <param name="weeks"> The number of weeks between two weeks with occurrences. </param>
+    /// <returns> The rule. </returns>
+    static RecurrenceRule Weekly(const Task& task, uint32_t weekday_mask, const std::string& from, uint64_t weeks = 1)
+    {
+        RecurrenceRule rule(RecurrenceKind::Weekly, task, from);
+        rule.weekdays = weekday_mask;
+        rule.interval = weeks > 0 ? weeks : 1;
+        return rule;
+    }
+
+    RecurrenceRule() = default;
+
+    RecurrenceRule(RecurrenceKind kind, const Task& task, const std::string& from)
+        : kind{ kind }, task{ task }, from_day{ mrt::time::ParseDate(from) }
+    {
+    }
+
+    /// <summary>
+    /// Checks whether the rule creates its task on a day.
+    /// </summary>
+    /// <param name="day"> The days since 01-01-1970. </param>
+    /// <returns> True if the task occurs on the day, false otherwise. </returns>
+    bool OccursOn(int64_t day) const
+    {
+        if (from_day < 0 || day < from_day || (until_day >= 0 && day > until_day))
+            return false;
+
+        int day_of_week = mrt::time::DayOfWeek(day);
+
+        switch (kind)
+        {
+        case RecurrenceKind::Daily:
+            return true;
+        case RecurrenceKind::Weekdays:
+            return day_of_week >= 1 && day_of_week <= 5;
+        case RecurrenceKind::EveryNDays:
+            return (day - from_day) % static_cast<int64_t>(interval) == 0;
+        case RecurrenceKind::Weekly:
+        {
+            // Weeks are counted from the Sunday of the week of the first day.
+            int64_t first_week_start = from_day - mrt::time::DayOfWeek(from_day);
+            int64_t week = (day - first_week_start) / 7;
+
+            return (weekdays & (1u << day_of_week)) != 0 && week % static_cast<int64_t>(interval) == 0;
+        }
+        }
+
+        return false;
+    }
+
+    uint64_t id{ 0 };
+    RecurrenceKind kind{ RecurrenceKind::Daily };
+    uint64_t interval{ 1 };
+    uint32_t weekdays{ 0 };
+    Task task;
+    int64_t from_day{ -1 };
+    int64_t until_day{ -1 };
+};
+
+/// <summary>
+/// A change made to a single occurrence of a recurring task, only the occurrences that differ from their rule are stored.
+/// </summary>
+struct RecurrenceException
+{
+    uint64_t rule_id{ 0 };
+    int64_t day{ 0 };
+    bool is_done{ false };
+    bool is_skipped{ false };
+    bool is_edited{ false };
+    Task task;
+};
+
+/// <summary>
+/// RecurrenceSet class holds the recurrence rules and their exceptions, and expands them into the tasks of a day.
+/// A day is expanded the first time it is asked for and then cached, until a rule or an exception of the day changes.
+/// Each occurrence is given an id made from its rule and its day, with the top bit set so it never matches the id of a stored task.
+/// </summary>
+class RecurrenceSet
+{
+private:
+    static constexpr uint64_t s_OccurrenceBit = uint64_t(1) << 63;
+    static constexpr uint64_t s_DayBits = 20;
+    static constexpr uint64_t s_MaxCachedDays = 400;
+
+    std::map<uint64_t, RecurrenceRule> m_Rules;
+    std::map<std::pair<uint64_t, int64_t>, RecurrenceException> m_Exceptions;
+    mutable std::unordered_map<int64_t, std::vector<Task>> m_Cache;
+public:
+    /// <summary>
+    /// Adds a rule, replacing any rule with the same id.
+    /// </summary>
+    /// <param name="rule"> The rule. </param>
+    void AddRule(const RecurrenceRule& rule)
+    {
+        m_Rules[rule.id] = rule;
+        m_Cache.clear();
+    }
+
+    /// <summary>
+    /// Removes a rule and the exceptions of its occurrences.
+    /// </summary>
+    /// <param name="rule_id"> The id of the rule. </param>
+    /// <returns> True if the rule was removed, false if there was no such rule. </returns>
+    bool RemoveRule(uint64_t rule_id)
+    {
+        if (m_Rules.erase(rule_id) == 0)
+            return false;
+
+        m_Exceptions.erase(m_Exceptions.lower_bound({ rule_id, INT64_MIN }), m_Exceptions.upper_bound({ rule_id, INT64_MAX }));
+        m_Cache.clear();
+
+        return true;
+    }
+
+    /// <summary>
+    /// Finds a rule.
+    /// </summary>
+    /// <param name="rule_id"> The id of the rule. </param>
+    /// <returns> The rule, or null if there is no such rule. </returns>
+    const RecurrenceRule* FindRule(uint64_t rule_id) const
+    {
+        auto rule = m_Rules.find(rule_id);
+
+        return rule != m_Rules.end() ? &rule->second : nullptr;
+    }
+
+    /// <summary>
+    /// Adds an exception, replacing the exception the occurrence already has.
+    /// </summary>
+    /// <param name="exception"> The exception. </param>
+    void AddException(const RecurrenceException& exception)
+    {
+        m_Exceptions[{ exception.rule_id, exception.day }] = exception;
+        m_Cache.erase(exception.day);
+    }
+
+    /// <summary>
+    /// Gets the exception of an occurrence, an occurrence without an exception gets one that matches its rule.
+    /// </summary>
+    /// <param name="rule_id"> The id of the rule. </param>
+    /// <param name="day"> The day of the occurrence. </param>
+    /// <returns> A copy of the exception. </returns>
+    RecurrenceException GetException(uint64_t rule_id, int64_t day) const
+    {
+        auto exception = m_Exceptions.find({ rule_id, day });
+
+        if (exception != m_Exceptions.end())
+            return exception->second;
+
+        RecurrenceException created;
+        created.rule_id = rule_id;
+        created.day = day;
+
+        return created;
+    }
+
+    /// <summary>
+    /// Gets the tasks that occur on a day, with their exceptions applied.
+    /// </summary>
+    /// <param name="day"> The days since 01-01-1970. </param>
+    /// <returns> The occurrences of the day. </returns>
+    std::vector<Task> Expand(int64_t day) const
+    {
+        auto cached = m_Cache.find(day);
+
+        if (cached != m_Cache.end())
+            return cached->second;
+
+        std::vector<Task> occurrences;
+
+        for (const auto& [rule_id, rule] : m_Rules)
+        {
+            if (!rule.OccursOn(day))
+                continue;
+
+            Task occurrence(rule.task);
+            auto exception = m_Exceptions.find({ rule_id, day });
+
+            if (exception != m_Exceptions.end())
+            {
+                if (exception->second.is_skipped)
+                    continue;
+
+                if (exception->second.is_edited)
+                {
+                    occurrence = exception->second.task;
+                }
+
+                occurrence.is_done = exception->second.is_done;
+            }
+
+            occurrence.id = OccurrenceId(rule_id, day);
+            occurrences.push_back(occurrence);
+        }
+
+        // The cache only needs to hold the days being viewed, it is emptied rather than evicting a day at a time.
+        if (m_Cache.size() >= s_MaxCachedDays)
+        {
+            m_Cache.clear();
+        }
+
+        m_Cache.emplace(day, occurrences);
+
+        return occurrences;
+    }
+
+    /// <summary>
+    /// Gets the rules.
+    /// </summary>
+    mrt::Vector<RecurrenceRule> GetRules() const
+    {
+        mrt::Vector<RecurrenceRule> rules;
+
+        for (const auto& [rule_id, rule] : m_Rules)
+        {
+            rules.PushBack(rule);
+        }
+
+        return rules;
+    }
+
+    /// <summary>
+    /// Gets the exceptions.
+    /// </summary>
+    mrt::Vector<RecurrenceException> GetExceptions() const
+    {
+        mrt::Vector<RecurrenceException> exceptions;
+
+        for (const auto& [key, exception] : m_Exceptions)
+        {
+            exceptions.PushBack(exception);
+        }
+
+        return exceptions;
+    }
+
+    /// <summary>
+    /// Checks whether there are no rules.
+    /// </summary>
+    bool Empty() const
+    {
+        return m_Rules.empty();
+    }
+
+    /// <summary>
+    /// Gets the id of an occurrence.
+    /// </summary>
+    /// <param name="rule_id"> The id of the rule. </param>
+    /// <param name="day"> The day of the occurrence. </param>
+    /// <returns> The id of the occurrence. </returns>
+    static uint64_t OccurrenceId(uint64_t rule_id, int64_t day)
+    {
+        return s_OccurrenceBit | (rule_id << s_DayBits) | (static_cast<uint64_t>(day) & ((uint64_t(1) << s_DayBits) - 1));
+    }
+
+    /// <summary>
+    /// Checks whether a task id is the id of an occurrence.
+    /// </summary>
+    static bool IsOccurrenceId(uint64_t id)
+    {
+        return (id & s_OccurrenceBit) != 0;
+    }
+
+    /// <summary>
+    /// Gets the rule of an occurrence from its id.
+    /// </summary>
+    static uint64_t RuleOf(uint64_t id)
+    {
+        return (id & ~s_OccurrenceBit) >> s_DayBits;
+    }
+};
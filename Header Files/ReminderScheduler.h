@@ -0,0 +1,476 @@
+#pragma once
+
+#include "../Header Files/NoCopy.h"
+#include "../Header Files/Task.h"
+#include "../Header Files/Time.h"
+#include "../Header Files/TimingWheel.h"
+#include "../Header Files/Subscription.h"
+#include "../Header Files/PersistentVector.h"
+
+#include <mutex>
+#include <chrono>
+#include <thread>
+#include <vector>
+#include <algorithm>
+#include <functional>
+#include <unordered_map>
+#include <condition_variable>
+
+/// <summary>
+/// Whether a reminder is for the start or the end of a task.
+/// </summary>
+enum class ReminderKind
+{
+    Start,
+    End
+};
+
+/// <summary>
+/// A reminder that a task has started or ended.
+/// </summary>
+struct Reminder
+{
+    ReminderKind kind{ ReminderKind::Start };
+    Task task;
+
+    // Whether every task the task depends on is done, a start reminder for a task that is not ready can be shown as waiting.
+    bool is_ready{ true };
+};
+
+/// <summary>
+/// Interface for the observers of the <see cref="ReminderScheduler"/>.
+/// </summary>
+class ReminderObserver
+{
+public:
+    virtual ~ReminderObserver() {}
+    virtual void Remind(const Reminder& reminder) = 0;
+};
+
+/// <summary>
+/// ReminderScheduler class fires a reminder when a task's start time and end time arrive.
+/// The reminders are held in a <see cref="mrt::TimingWheel"/>, so scheduling and cancelling are O(1)
+/// and each tick only costs as much as the reminders that fire, however many are pending.
+/// The times of the tasks are for the current day, times that have already passed are not scheduled.
+/// When the clock passes midnight the reminders of the day that ended are fired, the tasks are armed again for the new day
+/// and the owner is told the day has started, so it can replace the tasks with those of the new day.
+/// A single timer thread advances the wheel once per tick, and the observers are reminded on that thread.
+/// The clock can be replaced, and the timer thread left out, so the reminders can be driven by calling <see cref="Poll"/>.
+/// </summary>
+class ReminderScheduler : private NoCopy
+{
+public:
+    using Clock = std::chrono::system_clock;
+    using clock_func = std::function<Clock::time_point()>;
+    using ready_func = std::function<bool(uint64_t)>;
+    using day_func = std::function<void()>;
+
+private:
+    /// <summary>
+    /// The value held by each timer of the wheel.
+    /// </summary>
+    struct PendingReminder
+    {
+        uint64_t task_id{ 0 };
+        ReminderKind kind{ ReminderKind::Start };
+    };
+
+    /// <summary>
+    /// A task with reminders, and the handles of its timers, 0 if the reminder is not pending.
+    /// A task is kept after its reminders fire, so it can be armed again on the next day.
+    /// </summary>
+    struct ScheduledTask
+    {
+        Task task;
+        mrt::TimingWheel<PendingReminder>::Handle start{ 0 };
+        mrt::TimingWheel<PendingReminder>::Handle end{ 0 };
+    };
+
+    clock_func m_Clock;
+    Clock::duration m_Tick;
+    Clock::time_point m_Origin;
+    Clock::time_point m_DayStart;
+    Clock::time_point m_NextDayStart;
+    bool m_UseTimerThread;
+
+    std::mutex m_Mutex;
+    std::condition_variable m_Condition;
+    std::thread m_Thread;
+    bool m_Running{ false };
+    mrt::TimingWheel<PendingReminder> m_Wheel;
+    std::unordered_map<uint64_t, ScheduledTask> m_Scheduled;
+    ready_func m_IsReady;
+    day_func m_OnDayStart;
+
+    std::recursive_mutex m_ObserversMutex;
+    std::vector<ReminderObserver*> m_Observers;
+public:
+    /// <summary>
+    /// Initializes a new instance of the <see cref="ReminderScheduler"/> class.
+    /// The timer thread is started when the first reminder is scheduled.
+    /// </summary>
+    /// <param name="clock"> Reads the current time. </param>
+    /// <param name="use_timer_thread"> Whether a timer thread polls the reminders, otherwise <see cref="Poll"/> has to be called. </param>
+    /// <param name="tick"> The resolution of the reminders. </param>
+    ReminderScheduler(clock_func clock = Clock::now, bool use_timer_thread = true, Clock::duration tick = std::chrono::seconds(1))
+        : m_Clock(clock), m_Tick(tick), m_Origin(clock()), m_DayStart(mrt::time::StartOfDay(m_Origin)),
+        m_NextDayStart(mrt::time::StartOfNextDay(m_Origin)), m_UseTimerThread(use_timer_thread)
+    {
+    }
+
+    /// <summary>
+    /// Finalizes an instance of the <see cref="ReminderScheduler"/> class.
+    /// Stops the timer thread, pending reminders are dropped.
+    /// </summary>
+    ~ReminderScheduler()
+    {
+        Stop();
+    }
+
+    /// <summary>
+    /// Stops the timer thread and waits for a poll that is running on it, the thread is not started again.
+    /// The owner calls this before it is destroyed, so the ready check and the day start handler are not called on a destroyed owner.
+    /// </summary>
+    void Stop()
+    {
+        {
+            std::lock_guard<std::mutex> lock(m_Mutex);
+            m_Running = false;
+            m_UseTimerThread = false;
+        }
+
+        m_Condition.notify_all();
+
+        if (m_Thread.joinable())
+        {
+            m_Thread.join();
+        }
+    }
+
+    /// <summary>
+    /// Attaches an observer to be reminded when tasks start and end.
+    /// </summary>
+    /// <param name="observer"> The observer. </param>
+    void Attach(ReminderObserver* observer)
+    {
+        std::lock_guard<std::recursive_mutex> lock(m_ObserversMutex);
+
+        m_Observers.push_back(observer);
+    }
+
+    /// <summary>
+    /// Detaches an observer, waits for a reminder that is being fired on the timer thread.
+    /// </summary>
+    /// <param name="observer"> The observer. </param>
+    void Detach(ReminderObserver* observer)
+    {
+        std::lock_guard<std::recursive_mutex> lock(m_ObserversMutex);
+
+        m_Observers.erase(std::remove(m_Observers.begin(), m_Observers.end(), observer), m_Observers.end());
+    }
+
+    /// <summary>
+    /// Schedules the reminders of a task, replacing the reminders it already has.
+    /// Completed tasks, and times that are not valid or have passed, have no reminders.
+    /// </summary>
+    /// <param name="task"> The task. </param>
+    void Schedule(const Task& task)
+    {
+        std::lock_guard<std::mutex> lock(m_Mutex);
+
+        ScheduleLocked(task);
+    }
+
+    /// <summary>
+    /// Cancels the reminders of a task.
+    /// </summary>
+    /// <param name="task_id"> The id of the task. </param>
+    void Cancel(uint64_t task_id)
+    {
+        std::lock_guard<std::mutex> lock(m_Mutex);
+
+        CancelLocked(task_id);
+    }
+
+    /// <summary>
+    /// Updates the reminders for a change made to the tasks.
+    /// Only the changed task is touched, a change that affects every task has to be followed by <see cref="Rebuild"/>.
+    /// </summary>
+    /// <param name="change"> The change. </param>
+    void Apply(const TaskChange& change)
+    {
+        if (change.affects_all)
+            return;
+
+        std::lock_guard<std::mutex> lock(m_Mutex);
+
+        if (change.fields & TaskField::Removed)
+        {
+            CancelLocked(change.id);
+        }
+        else
+        {
+            ScheduleLocked(change.after);
+        }
+    }
+
+    /// <summary>
+    /// Replaces every reminder with the reminders of the specified tasks, O(n) in the number of tasks.
+    /// </summary>
+    /// <param name="tasks"> The tasks. </param>
+    void Rebuild(const mrt::PersistentVector<Task>& tasks)
+    {
+        std::lock_guard<std::mutex> lock(m_Mutex);
+
+        m_Wheel.Clear();
+        m_Scheduled.clear();
+
+        for (const Task& task : tasks)
+        {
+            ScheduleLocked(task);
+        }
+    }
+
+    /// <summary>
+    /// Gets the number of reminders that have not fired.
+    /// </summary>
+    /// <returns> The number of pending reminders. </returns>
+    uint64_t PendingCount()
+    {
+        std::lock_guard<std::mutex> lock(m_Mutex);
+
+        return m_Wheel.Size();
+    }
+
+    /// <summary>
+    /// Sets the check of whether a task can start, asked for each start reminder as it fires.
+    /// The check is called without the scheduler's lock held, so it can take the lock of the task manager.
+    /// </summary>
+    /// <param name="is_ready"> Returns true if the task with the id can start, or null to treat every task as ready. </param>
+    void SetReadyCheck(ready_func is_ready)
+    {
+        std::lock_guard<std::mutex> lock(m_Mutex);
+
+        m_IsReady = is_ready;
+    }
+
+    /// <summary>
+    /// Sets the handler called when the clock passes midnight, once the reminders of the day that ended have fired
+    /// and before any reminder of the new day fires. Days that passed without a poll are skipped, the handler is called once.
+    /// The handler is called without the scheduler's lock held, so it can take the lock of the task manager and rebuild the reminders.
+    /// </summary>
+    /// <param name="on_day_start"> The handler, or null. </param>
+    void SetDayStartHandler(day_func on_day_start)
+    {
+        std::lock_guard<std::mutex> lock(m_Mutex);
+
+        m_OnDayStart = on_day_start;
+    }
+
+    /// <summary>
+    /// Fires the reminders that are due by the current time of the clock.
+    /// Called once per tick by the timer thread, or by the owner when there is no timer thread.
+    /// </summary>
+    void Poll()
+    {
+        Clock::time_point time = m_Clock();
+        std::vector<Reminder> due;
+        day_func on_day_start;
+
+        {
+            std::lock_guard<std::mutex> lock(m_Mutex);
+
+            if (time >= m_NextDayStart)
+            {
+                // The day that ended fires up to the tick before midnight, the reminders at 00:00 belong to the new day.
+                uint64_t midnight = TickOf(m_NextDayStart);
+                AdvanceLocked(midnight > 0 ? midnight - 1 : 0, due);
+
+                m_DayStart = mrt::time::StartOfDay(time);
+                m_NextDayStart = mrt::time::StartOfNextDay(time);
+
+                uint64_t day_start = TickOf(m_DayStart);
+                AdvanceLocked(day_start > 0 ? day_start - 1 : 0, due);
+
+                for (auto& scheduled : m_Scheduled)
+                {
+                    ArmLocked(scheduled.second, m_Wheel.Now());
+                }
+
+                on_day_start = m_OnDayStart;
+            }
+        }
+
+        Fire(due);
+
+        if (on_day_start)
+        {
+            on_day_start();
+        }
+
+        due.clear();
+
+        {
+            std::lock_guard<std::mutex> lock(m_Mutex);
+
+            AdvanceLocked(TickOf(time), due);
+        }
+
+        Fire(due);
+    }
+
+private:
+    /// <summary>
+    /// Advances the wheel to a tick, adding the reminders that fire to the due reminders.
+    /// </summary>
+    void AdvanceLocked(uint64_t tick, std::vector<Reminder>& due)
+    {
+        m_Wheel.Advance(tick, [this, &due](const PendingReminder& pending)
+            {
+                auto scheduled = m_Scheduled.find(pending.task_id);
+
+                if (scheduled == m_Scheduled.end())
+                    return;
+
+                (pending.kind == ReminderKind::Start ? scheduled->second.start : scheduled->second.end) = 0;
+                due.push_back({ pending.kind, scheduled->second.task });
+            });
+    }
+
+    /// <summary>
+    /// Asks whether each start reminder's task is ready, then reminds the observers.
+    /// Called without the scheduler's lock held.
+    /// </summary>
+    void Fire(std::vector<Reminder>& due)
+    {
+        if (due.empty())
+            return;
+
+        ready_func is_ready;
+
+        {
+            std::lock_guard<std::mutex> lock(m_Mutex);
+
+            is_ready = m_IsReady;
+        }
+
+        if (is_ready)
+        {
+            for (Reminder& reminder : due)
+            {
+                if (reminder.kind == ReminderKind::Start)
+                {
+                    reminder.is_ready = is_ready(reminder.task.id);
+                }
+            }
+        }
+
+        std::lock_guard<std::recursive_mutex> lock(m_ObserversMutex);
+
+        for (const Reminder& reminder : due)
+        {
+            for (uint64_t i = 0; i < m_Observers.size(); i++)
+            {
+                m_Observers[i]->Remind(reminder);
+            }
+        }
+    }
+
+    /// <summary>
+    /// Gets the tick of a point in time, counted from when the scheduler was created.
+    /// </summary>
+    uint64_t TickOf(Clock::time_point time) const
+    {
+        return time <= m_Origin ? 0 : static_cast<uint64_t>((time - m_Origin) / m_Tick);
+    }
+
+    /// <summary>
+    /// Gets the tick that a time of day of the task arrives at.
+    /// </summary>
+    /// <returns> The tick, or 0 if the time is not valid or has passed. </returns>
+    uint64_t DeadlineOf(const std::string& time, uint64_t now) const
+    {
+        int minute = mrt::time::ParseMinuteOfDay(time);
+
+        if (minute < 0)
+            return 0;
+
+        uint64_t deadline = TickOf(m_DayStart + std::chrono::minutes(minute));
+
+        return deadline > now ? deadline : 0;
+    }
+
+    void ScheduleLocked(const Task& task)
+    {
+        CancelLocked(task.id);
+
+        if (task.is_done || (mrt::time::ParseMinuteOfDay(task.start_time) < 0 && mrt::time::ParseMinuteOfDay(task.end_time) < 0))
+            return;
+
+        ScheduledTask& scheduled = m_Scheduled[task.id];
+        scheduled.task = task;
+
+        ArmLocked(scheduled, std::max(TickOf(m_Clock()), m_Wheel.Now()));
+
+        if (m_UseTimerThread && !m_Running)
+        {
+            m_Running = true;
+            m_Thread = std::thread([this]()
+                {
+                    Run();
+                });
+        }
+    }
+
+    /// <summary>
+    /// Schedules the reminders of a task that are still to come on the current day, replacing its pending reminders.
+    /// </summary>
+    /// <param name="scheduled"> The task. </param>
+    /// <param name="now"> The current tick, reminders at or before it are not scheduled. </param>
+    void ArmLocked(ScheduledTask& scheduled, uint64_t now)
+    {
+        m_Wheel.Cancel(scheduled.start);
+        m_Wheel.Cancel(scheduled.end);
+
+        uint64_t start = DeadlineOf(scheduled.task.start_time, now);
+        uint64_t end = DeadlineOf(scheduled.task.end_time, now);
+
+        scheduled.start = start != 0 ? m_Wheel.Schedule(start, { scheduled.task.id, ReminderKind::Start }) : 0;
+        scheduled.end = end != 0 ? m_Wheel.Schedule(end, { scheduled.task.id, ReminderKind::End }) : 0;
+    }
+
+    void CancelLocked(uint64_t task_id)
+    {
+        auto scheduled = m_Scheduled.find(task_id);
+
+        if (scheduled == m_Scheduled.end())
+            return;
+
+        m_Wheel.Cancel(scheduled->second.start);
+        m_Wheel.Cancel(scheduled->second.end);
+        m_Scheduled.erase(scheduled);
+    }
+
+    /// <summary>
+    /// The timer thread, polls the reminders once per tick.
+    /// </summary>
+    void Run()
+    {
+        std::unique_lock<std::mutex> lock(m_Mutex);
+
+        while (m_Running)
+        {
+            m_Condition.wait_for(lock, m_Tick, [this]()
+                {
+                    return !m_Running;
+                });
+
+            if (!m_Running)
+                break;
+
+            lock.unlock();
+            Poll();
+            lock.lock();
+        }
+    }
+};
@@ -5,8 +5,114 @@
 #include "../Header Files/Vector.h"
 #include "../Header Files/Task.h"
 #include "../Header Files/Time.h"
+#include "../Header Files/Recurrence.h"
+#include "../Header Files/TaskStatistics.h"
+#include "../Header Files/MappedFile.h"
+#include "../Header Files/ThreadPool.h"
+#include "../Header Files/Poly1305.h"
 
+#include <array>
+#include <atomic>
+#include <charconv>
+#include <cstdio>
 #include <filesystem>
+#include <functional>
+#include <mutex>
+#include <random>
+#include <cstring>
+#include <memory>
+#include <vector>
+#include <string_view>
+#include <unordered_map>
+
+/// <summary>
+/// FileStage class turns the bytes of a task file into the bytes stored on disk and back, such as compressing them.
+/// Stages are added to a storage with <see cref="Storage::AddFileStage"/> and run on the whole task file.
+/// </summary>
+class FileStage
+{
+public:
+	virtual ~FileStage() = default;
+
+	/// <summary>
+	/// Turns the bytes of a task file into the bytes to store.
+	/// </summary>
+	/// <param name="bytes"> The bytes of the file, replaced by the bytes to store. </param>
+	/// <returns> True if the bytes were encoded, false otherwise. </returns>
+	virtual bool Encode(std::string& bytes) = 0;
+
+	/// <summary>
+	/// Turns the stored bytes back into the bytes of the task file.
+	/// Bytes this stage did not write are left as they are, so files written before the stage was added still load.
+	/// </summary>
+	/// <param name="bytes"> The stored bytes, replaced by the bytes of the file. </param>
+	/// <returns> True if the bytes were decoded, false if they are damaged. </returns>
+	virtual bool Decode(std::string& bytes) = 0;
+
+	/// <summary>
+	/// Checks whether this stage encodes the text fields of the tasks along with the rest of the file, such as by encrypting the whole file.
+	/// The fields of a file written through such a stage are written as they are instead of through the field stage of the storage.
+	/// </summary>
+	virtual bool CoversFields() const
+	{
+		return false;
+	}
+
+	/// <summary>
+	/// Checks whether stored bytes were written by this stage, which tells a stage that covers the fields whether the fields of a file
+	/// were written before it was added, and so have to be read through the field stage.
+	/// </summary>
+	/// <param name="bytes"> The stored bytes, as they are passed to <see cref="Decode"/>. </param>
+	virtual bool IsEncoded(const std::string& /*bytes*/) const
+	{
+		return false;
+	}
+};
+
+/// <summary>
+/// FieldStage class turns each text field of the tasks in a task file into the text stored for it and back, such as encrypting it.
+/// A stage is set on a storage with <see cref="Storage::SetFieldStage"/>, which runs it on each field as the field is written into the file,
+/// so the tasks do not have to be copied to change their fields. The stage is run from several threads at once.
+/// </summary>
+class FieldStage
+{
+public:
+	virtual ~FieldStage() = default;
+
+	/// <summary>
+	/// Gets the size of the text stored for a field of the specified size.
+	/// </summary>
+	virtual uint64_t EncodedSize(uint64_t size) const = 0;
+
+	/// <summary>
+	/// Writes the text to store for a field.
+	/// </summary>
+	/// <param name="field"> The field. </param>
+	/// <param name="output"> The buffer to write the text to, which has room for <see cref="EncodedSize"/> characters. </param>
+	virtual void Encode(std::string_view field, char* output) const = 0;
+
+	/// <summary>
+	/// Turns the stored text of a field back into the field, in place.
+	/// </summary>
+	/// <param name="field"> The stored text, replaced by the field. </param>
+	virtual void Decode(std::string& field) const = 0;
+};
+
+/// <summary>
+/// A struct that holds the changes made to the tasks since they were last saved, see <see cref="Storage::WriteDelta"/>.
+/// </summary>
+struct TaskDelta
+{
+	// The latest version of each task added or edited, in the order the tasks were first changed.
+	mrt::Vector<Task> changed;
+	mrt::Vector<uint64_t> removed;
+	uint64_t task_count{ 0 };
+
+	bool Empty() const
+	{
+		return changed.Empty() && removed.Empty();
+	}
+};
 
 /// <summary>
 /// Storage class is responsible for reading and writing tasks to a file.
@@ -16,6 +122,22 @@ class Storage : private NoCopy
 {
 private:
 	std::string m_CurrentDirectory;
+	std::atomic<uint64_t> m_BytesWritten{ 0 };
+	std::vector<std::shared_ptr<FileStage>> m_FileStages;
+	std::shared_ptr<FieldStage> m_FieldStage;
+
+	/// <summary>
+	/// The bytes last written to a file, so writing the same bytes again can be skipped.
+	/// </summary>
+	struct WrittenFile
+	{
+		uint64_t size{ 0 };
+		std::filesystem::file_time_type modified;
+		std::array<uint8_t, mrt::Poly1305::s_TagSize> digest{};
+	};
+
+	std::mutex m_WrittenMutex;
+	std::unordered_map<std::string, WrittenFile> m_Written;
 public:
 	/// <summary>
 	/// Default constructor that sets the current directory to the current working directory.
@@ -27,62 +149,964 @@ public:
 
 	/// <summary>
 	/// Writes the tasks to a file.
-	/// Uses the XML library to write the tasks to a file.
+	/// The tasks are written straight to the file as XML, one node at a time, without building the document first,
+	/// through a buffer that each thread reuses from one write to the next.
 	/// </summary>
 	/// <param name="file_name"> The name of the file to write to. </param>
 	/// <param name="tasks"> The tasks to write to the file. </param>
 	/// <returns> True if the tasks were written to the file, false otherwise. </returns>
 	virtual bool Write(const std::string& file_name, const mrt::Vector<Task>& tasks)
 	{
-		mrt::XML_Node root("daily-tasks");
+		static thread_local std::string buffer;
 
-		root.AddAttribute("date", mrt::time::FormatTime(mrt::time::Read(), "%d-%m-%Y"));
+		// The file stages run on the whole file, so the document is kept in a buffer of its own instead of being streamed.
+		std::string document;
+		mrt::XML_StreamWriter writer(HasFileStages() ? document : buffer);
 
-		for (Task& task : tasks)
-		{
-			mrt::XML_Node task_node("task");
+		if ((HasFileStages() ? writer.Open() : writer.Open(GetPath(file_name))) != mrt::XML_Document_FileError::SUCCESS)
+			return false;
 
-			task_node.AddChild(mrt::XML_Node("name", task.title));
-			task_node.AddChild(mrt::XML_Node("description", task.description));
-			task_node.AddChild(mrt::XML_Node("start_time", task.start_time));
-			task_node.AddChild(mrt::XML_Node("end_time", task.end_time));
-			task_node.AddChild(mrt::XML_Node("completed", task.is_done ? "true" : "false"));
+		writer.WriteProlog("1.0");
+		writer.WriteStartNode("daily-tasks", 0, { mrt::XML_Attribute("date", mrt::time::FormatTime(mrt::time::Read(), "%d-%m-%Y")) });
 
-			root.AddChild(task_node);
+		for (const Task& task : tasks)
+		{
+			writer.WriteStartNode("task", 1);
+			writer.WriteNode("name", EncodeField(task.title), 2);
+			writer.WriteNode("description", EncodeField(task.description), 2);
+			writer.WriteNode("start_time", EncodeField(task.start_time), 2);
+			writer.WriteNode("end_time", EncodeField(task.end_time), 2);
+			writer.WriteNode("completed", task.is_done ? "true" : "false", 2);
+			writer.WriteNode("id", std::to_string(task.id), 2);
+			writer.WriteEndNode("task", 1);
 		}
 
-		mrt::XML_Document doc(root, "1.0");
+		writer.WriteEndNode("daily-tasks", 0);
+
+		if (writer.Close() != mrt::XML_Document_FileError::SUCCESS)
+			return false;
+
+		if (HasFileStages())
+			return WriteFile(GetPath(file_name), document);
 
-		return (doc.WriteDocument(m_CurrentDirectory + "\\" + file_name + ".xml", doc) == mrt::XML_Document_FileError::SUCCESS) ? true : false;
+		CountWritten(GetPath(file_name));
+		return true;
 	}
 
 	/// <summary>
 	/// Reads the tasks from a file.
-	/// Uses the XML library to read the tasks from a file.
+	/// The tasks are built as the file is read, without building the XML document first.
+	/// If the file turns out not to be valid XML, the tasks read from it are taken away again before the error is thrown.
 	/// </summary>
 	/// <param name="file_name"> The name of the file to read from. </param>
 	/// <param name="tasks"> The tasks to read from the file. </param>
 	/// <returns> True if the tasks were read from the file, false otherwise. </returns>
 	virtual bool Read(const std::string& file_name, mrt::Vector<Task>& tasks)
+	{
+		uint64_t size = tasks.Size();
+		TaskReader reader(tasks, UINT64_MAX, nullptr);
+		bool fields_covered = false;
+
+		try
+		{
+			if (HasFileStages())
+			{
+				std::string document;
+
+				if (!ReadFile(GetPath(file_name), document, fields_covered) || document.empty())
+					return false;
+
+				mrt::XML_StreamReader(reader).Read(document.data(), document.data() + document.size());
+			}
+			else if (mrt::XML_StreamReader(reader).ReadFile(GetPath(file_name)) != mrt::XML_Document_FileError::SUCCESS)
+			{
+				return false;
+			}
+
+			if (!fields_covered)
+			{
+				DecodeFields(tasks, size);
+			}
+
+			return true;
+		}
+		catch (...)
+		{
+			while (tasks.Size() > size)
+			{
+				tasks.PopBack();
+			}
+
+			throw;
+		}
+	}
+
+	/// <summary>
+	/// Reads the tasks from a file, handing them over in batches as they are read.
+	/// Each batch is handed over as soon as its last task has been read, so the caller can start using the first tasks
+	/// before the rest of the file has been read, and only one batch is held at a time.
+	/// The batches handed over before an error in the file is found have already been handed over when the error is thrown.
+	/// </summary>
+	/// <param name="file_name"> The name of the file to read from. </param>
+	/// <param name="batch_size"> The number of tasks in each batch. </param>
+	/// <param name="on_batch"> Called with each batch of tasks, the last batch may be smaller. </param>
+	/// <returns> True if the tasks were read from the file, false otherwise. </returns>
+	virtual bool Read(const std::string& file_name, uint64_t batch_size, const std::function<void(mrt::Vector<Task>&)>& on_batch)
+	{
+		mrt::Vector<Task> batch(batch_size);
+		bool fields_covered = false;
+
+		std::function<void(mrt::Vector<Task>&)> on_decoded_batch = [this, &on_batch, &fields_covered](mrt::Vector<Task>& tasks)
+			{
+				if (!fields_covered)
+				{
+					DecodeFields(tasks, 0);
+				}
+
+				on_batch(tasks);
+			};
+
+		TaskReader reader(batch, batch_size, &on_decoded_batch);
+
+		if (HasFileStages())
+		{
+			std::string document;
+
+			if (!ReadFile(GetPath(file_name), document, fields_covered) || document.empty())
+				return false;
+
+			mrt::XML_StreamReader(reader).Read(document.data(), document.data() + document.size());
+		}
+		else if (mrt::XML_StreamReader(reader).ReadFile(GetPath(file_name)) != mrt::XML_Document_FileError::SUCCESS)
+		{
+			return false;
+		}
+
+		if (!batch.Empty())
+		{
+			on_decoded_batch(batch);
+		}
+
+		return true;
+	}
+
+	/// <summary>
+	/// Writes only the tasks that changed since the tasks were last written or read.
+	/// The XML file cannot be patched, so it is written again from every task, a storage with a file it can patch overrides this.
+	/// </summary>
+	/// <param name="file_name"> The name of the file to write to. </param>
+	/// <param name="delta"> The tasks added, edited and removed since the file was last written. </param>
+	/// <param name="all_tasks"> Gets every task, for when the whole file has to be written. </param>
+	/// <returns> True if the changes were written to the file, false otherwise. </returns>
+	virtual bool WriteDelta(const std::string& file_name, const TaskDelta& /*delta*/, const std::function<mrt::Vector<Task>()>& all_tasks)
+	{
+		return Write(file_name, all_tasks());
+	}
+
+	/// <summary>
+	/// Writes the recurrence rules and their exceptions to their own file, next to the tasks.
+	/// </summary>
+	/// <param name="file_name"> The name of the task store. </param>
+	/// <param name="rules"> The recurrence rules. </param>
+	/// <param name="exceptions"> The exceptions of single occurrences. </param>
+	/// <returns> True if the rules were written to the file, false otherwise. </returns>
+	virtual bool WriteRecurrences(const std::string& file_name, const mrt::Vector<RecurrenceRule>& rules, const mrt::Vector<RecurrenceException>& exceptions)
+	{
+		mrt::XML_Node root("daily-task-rules");
+
+		for (RecurrenceRule& rule : rules)
+		{
+			mrt::XML_Node rule_node("rule");
+
+			rule_node.AddChild(mrt::XML_Node("id", std::to_string(rule.id)));
+			rule_node.AddChild(mrt::XML_Node("kind", std::to_string(static_cast<int>(rule.kind))));
+			rule_node.AddChild(mrt::XML_Node("interval", std::to_string(rule.interval)));
+			rule_node.AddChild(mrt::XML_Node("weekdays", std::to_string(rule.weekdays)));
+			rule_node.AddChild(mrt::XML_Node("from", mrt::time::FormatDate(rule.from_day)));
+			rule_node.AddChild(mrt::XML_Node("until", rule.until_day >= 0 ? mrt::time::FormatDate(rule.until_day) : "never"));
+			AddTaskFields(rule_node, rule.task);
+
+			root.AddChild(rule_node);
+		}
+
+		for (RecurrenceException& exception : exceptions)
+		{
+			mrt::XML_Node exception_node("exception");
+
+			exception_node.AddChild(mrt::XML_Node("rule", std::to_string(exception.rule_id)));
+			exception_node.AddChild(mrt::XML_Node("date", mrt::time::FormatDate(exception.day)));
+			exception_node.AddChild(mrt::XML_Node("completed", exception.is_done ? "true" : "false"));
+			exception_node.AddChild(mrt::XML_Node("skipped", exception.is_skipped ? "true" : "false"));
+			exception_node.AddChild(mrt::XML_Node("edited", exception.is_edited ? "true" : "false"));
+
+			if (exception.is_edited)
+			{
+				AddTaskFields(exception_node, exception.task);
+			}
+
+			root.AddChild(exception_node);
+		}
+
+		mrt::XML_Document doc(root, "1.0");
+
+		if (doc.WriteDocument(GetPath(file_name + "-recurring"), doc) != mrt::XML_Document_FileError::SUCCESS)
+			return false;
+
+		CountWritten(GetPath(file_name + "-recurring"));
+		return true;
+	}
+
+	/// <summary>
+	/// Reads the recurrence rules and their exceptions.
+	/// A rule or an exception that is damaged is skipped, the others are read.
+	/// </summary>
+	/// <param name="file_name"> The name of the task store. </param>
+	/// <param name="rules"> The recurrence rules that were read. </param>
+	/// <param name="exceptions"> The exceptions that were read. </param>
+	/// <returns> True if the rules were read from the file, false otherwise. </returns>
+	virtual bool ReadRecurrences(const std::string& file_name, mrt::Vector<RecurrenceRule>& rules, mrt::Vector<RecurrenceException>& exceptions)
 	{
 		mrt::XML_Document doc;
 
-		if (doc.ReadDocument(m_CurrentDirectory + "\\" + file_name + ".xml", doc) != mrt::XML_Document_FileError::SUCCESS)
+		if (!ReadSideFile(GetPath(file_name + "-recurring"), doc))
 			return false;
 
-		mrt::XML_Node root = doc.GetRoot();
+		for (mrt::XML_Node& node : doc.GetRoot().GetAllChildren())
+		{
+			if (node.GetName() == "rule")
+			{
+				RecurrenceRule rule;
+				int kind = 0;
+
+				if (node.GetChildCount() < 10 || !ParseNumber(node.GetChild(0).GetValue(), rule.id) ||
+					!ParseNumber(node.GetChild(1).GetValue(), kind) || kind < 0 || kind > static_cast<int>(RecurrenceKind::Weekly) ||
+					!ParseNumber(node.GetChild(2).GetValue(), rule.interval) || rule.interval == 0 ||
+					!ParseNumber(node.GetChild(3).GetValue(), rule.weekdays))
+					continue;
+
+				rule.kind = static_cast<RecurrenceKind>(kind);
+				rule.from_day = mrt::time::ParseDate(node.GetChild(4).GetValue());
+				rule.until_day = mrt::time::ParseDate(node.GetChild(5).GetValue());
+				rule.task = ReadTaskFields(node, 6);
+				rules.PushBack(rule);
+			}
+			else
+			{
+				RecurrenceException exception;
 
-		for (mrt::XML_Node& task_node : root.GetAllChildren())
+				if (node.GetChildCount() < 5 || !ParseNumber(node.GetChild(0).GetValue(), exception.rule_id))
+					continue;
+
+				exception.day = mrt::time::ParseDate(node.GetChild(1).GetValue());
+				exception.is_done = node.GetChild(2).GetValue() == "true";
+				exception.is_skipped = node.GetChild(3).GetValue() == "true";
+				exception.is_edited = node.GetChild(4).GetValue() == "true";
+
+				if (exception.is_edited)
+				{
+					if (node.GetChildCount() < 9)
+						continue;
+
+					exception.task = ReadTaskFields(node, 5);
+				}
+
+				exceptions.PushBack(exception);
+			}
+		}
+
+		return true;
+	}
+
+	/// <summary>
+	/// Writes the dependencies between the tasks to their own file, next to the tasks.
+	/// </summary>
+	/// <param name="file_name"> The name of the task store. </param>
+	/// <param name="dependencies"> The dependencies. </param>
+	/// <returns> True if the dependencies were written to the file, false otherwise. </returns>
+	virtual bool WriteDependencies(const std::string& file_name, const mrt::Vector<TaskDependency>& dependencies)
+	{
+		mrt::XML_Node root("daily-task-dependencies");
+
+		for (TaskDependency& dependency : dependencies)
 		{
-			tasks.EmplaceBack(
-				task_node.GetChild(0).GetValue(),
-				task_node.GetChild(1).GetValue(),
-				task_node.GetChild(2).GetValue(),
-				task_node.GetChild(3).GetValue(),
-				task_node.GetChild(4).GetValue() == "true" ? true : false
-			);
+			mrt::XML_Node edge_node("edge");
+
+			edge_node.AddChild(mrt::XML_Node("before", std::to_string(dependency.before)));
+			edge_node.AddChild(mrt::XML_Node("after", std::to_string(dependency.after)));
+
+			root.AddChild(edge_node);
 		}
 
+		mrt::XML_Document doc(root, "1.0");
+
+		if (doc.WriteDocument(GetPath(file_name + "-dependencies"), doc) != mrt::XML_Document_FileError::SUCCESS)
+			return false;
+
+		CountWritten(GetPath(file_name + "-dependencies"));
+		return true;
+	}
+
+	/// <summary>
+	/// Reads the dependencies between the tasks.
+	/// </summary>
+	/// <param name="file_name"> The name of the task store. </param>
+	/// <param name="dependencies"> The dependencies that were read. </param>
+	/// <returns> True if the dependencies were read from the file, false otherwise. </returns>
+	virtual bool ReadDependencies(const std::string& file_name, mrt::Vector<TaskDependency>& dependencies)
+	{
+		mrt::XML_Document doc;
+
+		if (!ReadSideFile(GetPath(file_name + "-dependencies"), doc))
+			return false;
+
+		for (mrt::XML_Node& node : doc.GetRoot().GetAllChildren())
+		{
+			TaskDependency dependency;
+
+			// A damaged edge is skipped, the tasks it linked are then independent.
+			if (node.GetChildCount() < 2 || !ParseNumber(node.GetChild(0).GetValue(), dependency.before) ||
+				!ParseNumber(node.GetChild(1).GetValue(), dependency.after))
+				continue;
+
+			dependencies.PushBack(dependency);
+		}
+
+		return true;
+	}
+
+	/// <summary>
+	/// Writes the statistics rollups of the days to their own file, next to the tasks.
+	/// </summary>
+	/// <param name="file_name"> The name of the task store. </param>
+	/// <param name="rollups"> The rollups, one per day. </param>
+	/// <returns> True if the rollups were written to the file, false otherwise. </returns>
+	virtual bool WriteRollups(const std::string& file_name, const mrt::Vector<DayRollup>& rollups)
+	{
+		mrt::XML_Node root("daily-task-rollups");
+
+		for (DayRollup& rollup : rollups)
+		{
+			mrt::XML_Node day_node("day");
+
+			day_node.AddChild(mrt::XML_Node("date", mrt::time::FormatDate(rollup.day)));
+			day_node.AddChild(mrt::XML_Node("tasks", std::to_string(rollup.task_count)));
+			day_node.AddChild(mrt::XML_Node("completed", std::to_string(rollup.completed_count)));
+			day_node.AddChild(mrt::XML_Node("timed", std::to_string(rollup.timed_count)));
+			day_node.AddChild(mrt::XML_Node("minutes", std::to_string(rollup.total_minutes)));
+			day_node.AddChild(mrt::XML_Node("hourly", JoinCounts(rollup.hourly_minutes.data(), rollup.hourly_minutes.size())));
+			day_node.AddChild(mrt::XML_Node("durations", JoinCounts(rollup.duration_counts.data(), rollup.duration_counts.size())));
+
+			root.AddChild(day_node);
+		}
+
+		mrt::XML_Document doc(root, "1.0");
+
+		if (doc.WriteDocument(GetPath(file_name + "-rollups"), doc) != mrt::XML_Document_FileError::SUCCESS)
+			return false;
+
+		CountWritten(GetPath(file_name + "-rollups"));
+		return true;
+	}
+
+	/// <summary>
+	/// Reads the statistics rollups of the days.
+	/// </summary>
+	/// <param name="file_name"> The name of the task store. </param>
+	/// <param name="rollups"> The rollups that were read. </param>
+	/// <returns> True if the rollups were read from the file, false otherwise. </returns>
+	virtual bool ReadRollups(const std::string& file_name, mrt::Vector<DayRollup>& rollups)
+	{
+		mrt::XML_Document doc;
+
+		if (!ReadSideFile(GetPath(file_name + "-rollups"), doc))
+			return false;
+
+		for (mrt::XML_Node& node : doc.GetRoot().GetAllChildren())
+		{
+			DayRollup rollup;
+
+			// A damaged day is skipped, its statistics are then missing until the day is counted again.
+			if (node.GetChildCount() < 7)
+				continue;
+
+			rollup.day = mrt::time::ParseDate(node.GetChild(0).GetValue());
+
+			if (rollup.day < 0 ||
+				!ParseNumber(node.GetChild(1).GetValue(), rollup.task_count) ||
+				!ParseNumber(node.GetChild(2).GetValue(), rollup.completed_count) ||
+				!ParseNumber(node.GetChild(3).GetValue(), rollup.timed_count) ||
+				!ParseNumber(node.GetChild(4).GetValue(), rollup.total_minutes) ||
+				!SplitCounts(node.GetChild(5).GetValue(), rollup.hourly_minutes.data(), rollup.hourly_minutes.size()) ||
+				!SplitCounts(node.GetChild(6).GetValue(), rollup.duration_counts.data(), rollup.duration_counts.size()))
+				continue;
+
+			rollups.PushBack(rollup);
+		}
+
+		return true;
+	}
+
+	/// <summary>
+	/// Gets the full path of a storage file.
+	/// </summary>
+	/// <param name="file_name"> The name of the file. </param>
+	/// <returns> The path of the file within the current directory. </returns>
+	std::string GetPath(const std::string& file_name) const
+	{
+		return GetPath(file_name, ".xml");
+	}
+
+	/// <summary>
+	/// Gets the full path of a storage file with the specified extension.
+	/// </summary>
+	/// <param name="file_name"> The name of the file. </param>
+	/// <param name="extension"> The extension of the file, including the dot. </param>
+	/// <returns> The path of the file within the current directory. </returns>
+	std::string GetPath(const std::string& file_name, const std::string& extension) const
+	{
+		return (std::filesystem::path(m_CurrentDirectory) / (file_name + extension)).string();
+	}
+
+	/// <summary>
+	/// Gets the number of bytes written to the storage files since the storage was created.
+	/// </summary>
+	/// <returns> The number of bytes written. </returns>
+	virtual uint64_t BytesWritten() const
+	{
+		return m_BytesWritten.load(std::memory_order_relaxed);
+	}
+
+	/// <summary>
+	/// Adds a stage the task file is passed through when it is written and read, the other files of a task store are not.
+	/// The stages added last are closest to the caller: they encode first and decode last.
+	/// This way a decorator that adds its stage to the storage it wraps sees the bytes before the stages added by the storages it wraps.
+	/// </summary>
+	/// <param name="stage"> The stage to add. </param>
+	virtual void AddFileStage(std::shared_ptr<FileStage> stage)
+	{
+		m_FileStages.push_back(std::move(stage));
+	}
+
+	/// <summary>
+	/// Sets the stage the text fields of the tasks in the task file are passed through when they are written and read.
+	/// A storage runs one field stage, so a stage set while there is one already is not set.
+	/// </summary>
+	/// <param name="stage"> The stage to set. </param>
+	/// <returns> True if the stage was set, false if the storage already has a field stage. </returns>
+	virtual bool SetFieldStage(std::shared_ptr<FieldStage> stage)
+	{
+		if (m_FieldStage != nullptr)
+			return false;
+
+		m_FieldStage = std::move(stage);
 		return true;
 	}
+
+protected:
+	// Fewer tasks than this are handled on the calling thread by ForEachTask, as handing them to the pool would take longer.
+	static constexpr uint64_t s_ParallelTasks = 256;
+
+	/// <summary>
+	/// Runs a function on every task, in parallel on the shared thread pool once there are enough tasks.
+	/// Each worker takes a chunk of the tasks, so the function must only change the task it is called with.
+	/// </summary>
+	/// <param name="tasks"> The tasks. </param>
+	/// <param name="first"> The index of the first task to run the function on. </param>
+	/// <param name="func"> The function to run on each task. </param>
+	template <typename _Func>
+	static void ForEachTask(mrt::Vector<Task>& tasks, uint64_t first, _Func func)
+	{
+		uint64_t count = tasks.Size() > first ? tasks.Size() - first : 0;
+
+		if (count < s_ParallelTasks)
+		{
+			for (uint64_t i = first; i < tasks.Size(); i++)
+			{
+				func(tasks[i]);
+			}
+
+			return;
+		}
+
+		ThreadPool::Shared().ParallelFor(count, [&tasks, &func, first](uint64_t i)
+			{
+				func(tasks[first + i]);
+			});
+	}
+
+	/// <summary>
+	/// Gets the field stage the fields of the task file are written through, see <see cref="SetFieldStage"/>.
+	/// </summary>
+	/// <returns> The field stage, null if there is none or a file stage covers the fields. </returns>
+	const FieldStage* GetFieldStage() const
+	{
+		for (const std::shared_ptr<FileStage>& stage : m_FileStages)
+		{
+			if (stage->CoversFields())
+				return nullptr;
+		}
+
+		return m_FieldStage.get();
+	}
+
+	/// <summary>
+	/// Passes a field through the field stage into a buffer that each thread reuses, for a writer that takes the text of a field.
+	/// </summary>
+	/// <returns> The text to store, valid until the next field is encoded on the same thread. </returns>
+	std::string_view EncodeField(const std::string& field) const
+	{
+		const FieldStage* stage = GetFieldStage();
+
+		if (stage == nullptr)
+			return field;
+
+		static thread_local std::string buffer;
+
+		buffer.resize(stage->EncodedSize(field.size()));
+		stage->Encode(field, &buffer[0]);
+		return buffer;
+	}
+
+	/// <summary>
+	/// Passes the text fields of the tasks that were read back through the field stage, in place.
+	/// A task file read through <see cref="ReadFile"/> only has its fields decoded if no file stage covered them.
+	/// </summary>
+	/// <param name="tasks"> The tasks. </param>
+	/// <param name="first"> The index of the first task that was read. </param>
+	void DecodeFields(mrt::Vector<Task>& tasks, uint64_t first) const
+	{
+		if (m_FieldStage == nullptr)
+			return;
+
+		const FieldStage& stage = *m_FieldStage;
+
+		ForEachTask(tasks, first, [&stage](Task& task)
+			{
+				stage.Decode(task.title);
+				stage.Decode(task.description);
+				stage.Decode(task.start_time);
+				stage.Decode(task.end_time);
+			});
+	}
+
+	/// <summary>
+	/// Checks whether the task file has to be passed through any file stages.
+	/// </summary>
+	bool HasFileStages() const
+	{
+		return !m_FileStages.empty();
+	}
+
+	/// <summary>
+	/// Passes the bytes of a task file through the file stages, see <see cref="AddFileStage"/>.
+	/// </summary>
+	bool EncodeFile(std::string& bytes) const
+	{
+		for (auto stage = m_FileStages.rbegin(); stage != m_FileStages.rend(); ++stage)
+		{
+			if (!(*stage)->Encode(bytes))
+				return false;
+		}
+
+		return true;
+	}
+
+	/// <summary>
+	/// Passes the stored bytes of a task file back through the file stages, in the opposite order of <see cref="EncodeFile"/>.
+	/// </summary>
+	/// <param name="bytes"> The stored bytes, replaced by the bytes of the file. </param>
+	/// <param name="fields_covered"> Set to whether a stage that covers the fields wrote the file, so its fields are stored as they are. </param>
+	bool DecodeFile(std::string& bytes, bool& fields_covered) const
+	{
+		fields_covered = false;
+
+		for (const std::shared_ptr<FileStage>& stage : m_FileStages)
+		{
+			if (stage->CoversFields() && stage->IsEncoded(bytes))
+			{
+				fields_covered = true;
+			}
+
+			if (!stage->Decode(bytes))
+				return false;
+		}
+
+		return true;
+	}
+
+	/// <summary>
+	/// Passes the bytes of a task file through the file stages and writes them,
+	/// through a temporary file that replaces the file once written, so a failed write leaves the previous file.
+	/// Bytes with the same digest as the bytes this storage last wrote to the file are not written again,
+	/// as long as the file still has the size and the modification time it was written with.
+	/// </summary>
+	/// <param name="path"> The path of the file. </param>
+	/// <param name="bytes"> The bytes of the file, replaced by the bytes that were stored unless the write was skipped. </param>
+	/// <returns> True if the file was written or already held the bytes, false otherwise. </returns>
+	bool WriteFile(const std::string& path, std::string& bytes)
+	{
+		std::array<uint8_t, mrt::Poly1305::s_TagSize> digest = Digest(bytes);
+
+		if (IsWritten(path, digest))
+			return true;
+
+		if (!EncodeFile(bytes))
+			return false;
+
+		std::string temporary_path = path + ".tmp";
+
+		std::FILE* file = std::fopen(temporary_path.c_str(), "wb");
+
+		if (file == nullptr)
+			return false;
+
+		bool written = std::fwrite(bytes.data(), 1, bytes.size(), file) == bytes.size();
+		written = std::fclose(file) == 0 && written;
+
+		std::error_code error;
+
+		if (written)
+		{
+			std::filesystem::rename(temporary_path, path, error);
+		}
+
+		if (!written || error)
+		{
+			std::filesystem::remove(temporary_path, error);
+			ForgetWritten(path);
+			return false;
+		}
+
+		CountWritten(path);
+
+		WrittenFile written_file;
+		written_file.size = bytes.size();
+		written_file.modified = std::filesystem::last_write_time(path, error);
+		written_file.digest = digest;
+
+		std::lock_guard<std::mutex> lock(m_WrittenMutex);
+
+		if (error)
+		{
+			m_Written.erase(path);
+		}
+		else
+		{
+			m_Written[path] = written_file;
+		}
+
+		return true;
+	}
+
+	/// <summary>
+	/// Checks whether bytes with the specified digest were the last bytes written to a file,
+	/// and the file has the size and the modification time it was written with, so it was not changed by anything else since.
+	/// </summary>
+	bool IsWritten(const std::string& path, const std::array<uint8_t, mrt::Poly1305::s_TagSize>& digest)
+	{
+		std::lock_guard<std::mutex> lock(m_WrittenMutex);
+
+		auto written = m_Written.find(path);
+
+		if (written == m_Written.end() || !mrt::Poly1305::Equal(written->second.digest.data(), digest.data()))
+			return false;
+
+		std::error_code error;
+		uint64_t size = std::filesystem::file_size(path, error);
+
+		if (error || size != written->second.size)
+			return false;
+
+		std::filesystem::file_time_type modified = std::filesystem::last_write_time(path, error);
+
+		return !error && modified == written->second.modified;
+	}
+
+	/// <summary>
+	/// Gets the digest of the bytes of a file, a Poly1305 tag under a key drawn once for the process and never stored.
+	/// As the key is secret, two different files only share a digest by chance, which is below 2^-76 for files of up to a gigabyte,
+	/// and a file cannot be made to share the digest of another.
+	/// </summary>
+	static std::array<uint8_t, mrt::Poly1305::s_TagSize> Digest(std::string_view bytes)
+	{
+		static const std::array<uint8_t, mrt::Poly1305::s_KeySize> s_Key = []()
+			{
+				std::array<uint8_t, mrt::Poly1305::s_KeySize> key{};
+				std::random_device random;
+
+				for (uint64_t i = 0; i < key.size(); i += 4)
+				{
+					uint32_t value = random();
+					std::memcpy(key.data() + i, &value, 4);
+				}
+
+				return key;
+			}();
+
+		std::array<uint8_t, mrt::Poly1305::s_TagSize> digest{};
+		mrt::Poly1305 mac(s_Key.data());
+
+		mac.Update(bytes.data(), bytes.size());
+		mac.Final(digest.data());
+		return digest;
+	}
+
+	/// <summary>
+	/// Forgets the bytes last written to a file, so the next write is not skipped.
+	/// </summary>
+	void ForgetWritten(const std::string& path)
+	{
+		std::lock_guard<std::mutex> lock(m_WrittenMutex);
+
+		m_Written.erase(path);
+	}
+
+	/// <summary>
+	/// Reads a task file and passes its bytes back through the file stages.
+	/// </summary>
+	/// <param name="path"> The path of the file. </param>
+	/// <param name="bytes"> Set to the bytes of the file. </param>
+	/// <param name="fields_covered"> Set to whether a stage that covers the fields wrote the file, see <see cref="DecodeFile"/>. </param>
+	/// <returns> True if the file was read, false if it could not be opened or a stage found it damaged. </returns>
+	bool ReadFile(const std::string& path, std::string& bytes, bool& fields_covered) const
+	{
+		mrt::MappedFile file;
+
+		fields_covered = false;
+
+		if (!file.Open(path))
+			return false;
+
+		bytes.assign(file.Data() != nullptr ? file.Data() : "", file.Size());
+		file.Close();
+
+		return DecodeFile(bytes, fields_covered);
+	}
+
+	/// <summary>
+	/// Adds the size of a file that was just written to the number of bytes written.
+	/// </summary>
+	/// <param name="path"> The path of the file. </param>
+	void CountWritten(const std::string& path)
+	{
+		std::error_code error;
+		uint64_t size = std::filesystem::file_size(path, error);
+
+		if (!error)
+		{
+			CountWritten(size);
+		}
+	}
+
+	/// <summary>
+	/// Adds a number of bytes that were just appended to a file to the number of bytes written.
+	/// </summary>
+	/// <param name="size"> The number of bytes. </param>
+	void CountWritten(uint64_t size)
+	{
+		m_BytesWritten.fetch_add(size, std::memory_order_relaxed);
+	}
+
+	/// <summary>
+	/// Reads one of the small files kept next to the tasks, such as the manifest or the dependencies.
+	/// A file that is not well-formed is treated as missing, so a damaged file does not stop the task store from opening.
+	/// </summary>
+	/// <param name="path"> The path of the file. </param>
+	/// <param name="doc"> The document to read the file into. </param>
+	/// <returns> True if the file was read, false if it is missing or damaged. </returns>
+	static bool ReadSideFile(const std::string& path, mrt::XML_Document& doc)
+	{
+		try
+		{
+			return doc.ReadDocument(path, doc) == mrt::XML_Document_FileError::SUCCESS;
+		}
+		catch (const std::exception&)
+		{
+			return false;
+		}
+	}
+
+	/// <summary>
+	/// Reads a number written with <c>std::to_string</c>, the whole text has to be the number.
+	/// </summary>
+	/// <param name="text"> The text. </param>
+	/// <param name="value"> The number that was read, left as it is if the text is not a number. </param>
+	/// <returns> True if the text is a number that fits the type, false otherwise. </returns>
+	template <typename _Ty>
+	static bool ParseNumber(std::string_view text, _Ty& value)
+	{
+		const char* end = text.data() + text.size();
+		std::from_chars_result result = std::from_chars(text.data(), end, value);
+
+		return result.ec == std::errc() && result.ptr == end;
+	}
+
+	/// <summary>
+	/// Adds the fields that make up a task to a node, in the order they are written for a task.
+	/// </summary>
+	static void AddTaskFields(mrt::XML_Node& node, const Task& task)
+	{
+		node.AddChild(mrt::XML_Node("name", task.title));
+		node.AddChild(mrt::XML_Node("description", task.description));
+		node.AddChild(mrt::XML_Node("start_time", task.start_time));
+		node.AddChild(mrt::XML_Node("end_time", task.end_time));
+	}
+
+	/// <summary>
+	/// Reads the fields written by <see cref="AddTaskFields"/>, starting at a child of the node.
+	/// </summary>
+	static Task ReadTaskFields(const mrt::XML_Node& node, uint64_t first_child)
+	{
+		return Task(
+			node.GetChild(first_child).GetValue(),
+			node.GetChild(first_child + 1).GetValue(),
+			node.GetChild(first_child + 2).GetValue(),
+			node.GetChild(first_child + 3).GetValue(),
+			false
+		);
+	}
+
+	/// <summary>
+	/// Joins counts into a comma separated list, so a histogram is written as a single node.
+	/// </summary>
+	static std::string JoinCounts(const uint64_t* counts, uint64_t count)
+	{
+		std::string text;
+
+		for (uint64_t i = 0; i < count; i++)
+		{
+			text += (i > 0 ? "," : "") + std::to_string(counts[i]);
+		}
+
+		return text;
+	}
+
+	/// <summary>
+	/// Reads the counts written by <see cref="JoinCounts"/>, counts that are missing are left as they are.
+	/// </summary>
+	/// <returns> True if the counts were read, false if one of them is not a number. </returns>
+	static bool SplitCounts(const std::string& text, uint64_t* counts, uint64_t count)
+	{
+		uint64_t start = 0;
+
+		for (uint64_t i = 0; i < count && start < text.size(); i++)
+		{
+			uint64_t end = std::min<uint64_t>(text.find(',', start), text.size());
+
+			if (!ParseNumber(std::string_view(text).substr(start, end - start), counts[i]))
+				return false;
+
+			start = end + 1;
+		}
+
+		return true;
+	}
+
+	/// <summary>
+	/// TaskReader class builds the tasks of a task file as its nodes are read by an <see cref="mrt::XML_StreamReader"/>.
+	/// The fields of a task are matched by their names, and each value is copied once, from the file into the task.
+	/// Files written before tasks had an id do not have the id node, those tasks are read with an id of 0.
+	/// </summary>
+	class TaskReader : public mrt::XML_Handler
+	{
+	private:
+		mrt::Vector<Task>& m_Tasks;
+		uint64_t m_BatchSize;
+		const std::function<void(mrt::Vector<Task>&)>* m_OnBatch;
+
+		uint64_t m_Depth{ 0 };
+		Task* m_Task{ nullptr };
+
+		// The value of the field being read, the text of the completed and id fields is converted once the field ends.
+		std::string* m_Field{ nullptr };
+		std::string m_Text;
+	public:
+		/// <summary>
+		/// Initializes a new instance of the <see cref="TaskReader"/> class.
+		/// </summary>
+		/// <param name="tasks"> The tasks to add the tasks read to. </param>
+		/// <param name="batch_size"> The number of tasks to hand over at a time. </param>
+		/// <param name="on_batch"> Called with the tasks once there are a batch of them, which are then cleared, may be null to keep every task. </param>
+		TaskReader(mrt::Vector<Task>& tasks, uint64_t batch_size, const std::function<void(mrt::Vector<Task>&)>* on_batch)
+			: m_Tasks(tasks), m_BatchSize(batch_size), m_OnBatch(on_batch)
+		{
+		}
+
+		void OnStartNode(std::string_view name, const std::vector<mrt::XML_Attribute>&) override
+		{
+			m_Depth++;
+
+			if (m_Depth == 2 && name == "task")
+			{
+				m_Task = &m_Tasks.EmplaceBack();
+			}
+			else if (m_Depth == 3 && m_Task != nullptr)
+			{
+				m_Field = FieldOf(name);
+
+				if (m_Field != nullptr)
+				{
+					m_Field->clear();
+				}
+			}
+		}
+
+		void OnValue(std::string_view text) override
+		{
+			if (m_Depth == 3 && m_Field != nullptr)
+			{
+				mrt::XML_StreamReader::CopyValue(text, *m_Field);
+			}
+		}
+
+		void OnEndNode(std::string_view name) override
+		{
+			if (m_Depth == 3 && m_Task != nullptr)
+			{
+				if (name == "completed")
+				{
+					m_Task->is_done = m_Text == "true";
+				}
+				else if (name == "id")
+				{
+					m_Task->id = std::stoull(m_Text);
+				}
+
+				m_Field = nullptr;
+			}
+			else if (m_Depth == 2 && m_Task != nullptr)
+			{
+				m_Task = nullptr;
+
+				if (m_OnBatch != nullptr && m_Tasks.Size() >= m_BatchSize)
+				{
+					(*m_OnBatch)(m_Tasks);
+					m_Tasks.Clear();
+				}
+			}
+
+			m_Depth--;
+		}
+
+	private:
+		std::string* FieldOf(std::string_view name)
+		{
+			if (name == "name")
+				return &m_Task->title;
+
+			if (name == "description")
+				return &m_Task->description;
+
+			if (name == "start_time")
+				return &m_Task->start_time;
+
+			if (name == "end_time")
+				return &m_Task->end_time;
+
+			if (name == "completed" || name == "id")
+				return &m_Text;
+
+			return nullptr;
+		}
+	};
 };
\ No newline at end of file
@@ -0,0 +1,377 @@
+#pragma once
+
+#include "../Header Files/Storage.h"
+#include "../Header Files/ChaCha20Poly1305.h"
+#include "../Header Files/ThreadPool.h"
+
+#include <array>
+#include <atomic>
+#include <algorithm>
+#include <cstring>
+#include <memory>
+#include <random>
+#include <string>
+
+/// <summary>
+/// AuthenticatedStage class encrypts and authenticates a whole task file with <see cref="mrt::ChaCha20Poly1305"/>, split into chunks that are sealed on their own:
+///
+///   header   "DTMA", version (u16), header size (u16), chunk size (u32), nonce (12 bytes), size of the file (u64)
+///   chunks   per chunk: the encrypted chunk, followed by its 16-byte tag
+///
+/// Every number is little-endian. The nonce is drawn at random for every write, and each chunk is sealed with the nonce XORed with
+/// its index in the last 8 bytes and with the header as its additional data, so a chunk that is changed, moved, dropped or taken from
+/// another file is found, and so is a header that is changed. The chunks are sealed and opened in parallel on the shared thread pool.
+/// Unlike the other stages, a file that does not start with the magic is refused rather than read as it is, since such a file
+/// could have been written by anyone.
+/// </summary>
+class AuthenticatedStage : public FileStage
+{
+public:
+	static constexpr uint16_t s_Version = 1;
+	static constexpr uint16_t s_HeaderSize = 32;
+	static constexpr uint64_t s_DefaultChunkSize = 64 * 1024;
+
+private:
+	static constexpr char s_Magic[4] = { 'D', 'T', 'M', 'A' };
+	static constexpr uint64_t s_TagSize = mrt::ChaCha20Poly1305::s_TagSize;
+
+	mrt::ChaCha20Poly1305 m_Cipher;
+	uint64_t m_ChunkSize;
+public:
+	/// <summary>
+	/// Initializes a new instance of the <see cref="AuthenticatedStage"/> class.
+	/// </summary>
+	/// <param name="key"> The 256-bit key. </param>
+	/// <param name="chunk_size"> The number of bytes in each chunk, smaller chunks are opened with more threads but add more tags. </param>
+	explicit AuthenticatedStage(const std::array<uint8_t, mrt::ChaCha20Poly1305::s_KeySize>& key, uint64_t chunk_size = s_DefaultChunkSize)
+		: m_Cipher(key.data()), m_ChunkSize(std::min<uint64_t>(std::max<uint64_t>(chunk_size, 1024), UINT32_MAX))
+	{
+	}
+
+	/// <summary>
+	/// Encrypts and authenticates the file.
+	/// </summary>
+	/// <param name="bytes"> The bytes of the file, replaced by the sealed file. </param>
+	/// <returns> True if the file was sealed. </returns>
+	virtual bool Encode(std::string& bytes) override
+	{
+		uint8_t nonce[mrt::ChaCha20Poly1305::s_NonceSize];
+		std::random_device random;
+
+		for (uint64_t i = 0; i < sizeof(nonce); i += 4)
+		{
+			uint32_t value = random();
+			std::memcpy(nonce + i, &value, 4);
+		}
+
+		uint64_t size = bytes.size();
+		uint64_t chunk_count = ChunkCount(size, m_ChunkSize);
+		std::string sealed(s_HeaderSize + size + chunk_count * s_TagSize, '\0');
+
+		char* header = &sealed[0];
+		std::memcpy(header, s_Magic, sizeof(s_Magic));
+		PutLittle<uint16_t>(header + 4, s_Version);
+		PutLittle<uint16_t>(header + 6, s_HeaderSize);
+		PutLittle<uint32_t>(header + 8, static_cast<uint32_t>(m_ChunkSize));
+		std::memcpy(header + 12, nonce, sizeof(nonce));
+		PutLittle<uint64_t>(header + 24, size);
+
+		ThreadPool::Shared().ParallelFor(chunk_count, [&](uint64_t i)
+			{
+				uint64_t offset = i * m_ChunkSize;
+				uint64_t chunk_size = std::min<uint64_t>(m_ChunkSize, size - offset);
+				char* chunk = header + s_HeaderSize + i * (m_ChunkSize + s_TagSize);
+				uint8_t chunk_nonce[mrt::ChaCha20Poly1305::s_NonceSize];
+
+				ChunkNonce(nonce, i, chunk_nonce);
+				std::memcpy(chunk, bytes.data() + offset, chunk_size);
+				m_Cipher.Seal(chunk_nonce, header, s_HeaderSize, chunk, chunk_size, reinterpret_cast<uint8_t*>(chunk + chunk_size));
+			});
+
+		bytes = std::move(sealed);
+		return true;
+	}
+
+	/// <summary>
+	/// Checks and decrypts the file.
+	/// </summary>
+	/// <param name="bytes"> The stored bytes, replaced by the bytes of the file. </param>
+	/// <returns> True if the file was decrypted, false if it was not sealed, was changed, or was sealed with another key. </returns>
+	virtual bool Decode(std::string& bytes) override
+	{
+		if (!IsEncoded(bytes) || bytes.size() < s_HeaderSize)
+			return false;
+
+		const char* header = bytes.data();
+		uint16_t version = GetLittle<uint16_t>(header + 4);
+		uint16_t header_size = GetLittle<uint16_t>(header + 6);
+		uint64_t chunk_size = GetLittle<uint32_t>(header + 8);
+		uint64_t size = GetLittle<uint64_t>(header + 24);
+
+		if (version > s_Version || header_size != s_HeaderSize || chunk_size == 0)
+			return false;
+
+		uint64_t chunk_count = ChunkCount(size, chunk_size);
+
+		if (size > bytes.size() || chunk_count > (bytes.size() - s_HeaderSize) / s_TagSize || s_HeaderSize + size + chunk_count * s_TagSize != bytes.size())
+			return false;
+
+		uint8_t nonce[mrt::ChaCha20Poly1305::s_NonceSize];
+		std::memcpy(nonce, header + 12, sizeof(nonce));
+
+		std::string plain(size, '\0');
+		std::atomic<bool> valid{ true };
+
+		ThreadPool::Shared().ParallelFor(chunk_count, [&](uint64_t i)
+			{
+				uint64_t offset = i * chunk_size;
+				uint64_t size_of_chunk = std::min<uint64_t>(chunk_size, size - offset);
+				const char* chunk = header + s_HeaderSize + i * (chunk_size + s_TagSize);
+				uint8_t chunk_nonce[mrt::ChaCha20Poly1305::s_NonceSize];
+
+				ChunkNonce(nonce, i, chunk_nonce);
+				std::memcpy(&plain[0] + offset, chunk, size_of_chunk);
+
+				if (!m_Cipher.Open(chunk_nonce, header, s_HeaderSize, &plain[0] + offset, size_of_chunk, reinterpret_cast<const uint8_t*>(chunk + size_of_chunk)))
+				{
+					valid.store(false, std::memory_order_relaxed);
+				}
+			});
+
+		if (!valid.load(std::memory_order_relaxed))
+			return false;
+
+		bytes = std::move(plain);
+		return true;
+	}
+
+	/// <summary>
+	/// The stage encrypts the fields along with the rest of the file, so they are written as they are.
+	/// </summary>
+	virtual bool CoversFields() const override
+	{
+		return true;
+	}
+
+	/// <summary>
+	/// Checks whether the stored bytes start with the magic of the stage.
+	/// </summary>
+	virtual bool IsEncoded(const std::string& bytes) const override
+	{
+		return bytes.size() >= sizeof(s_Magic) && std::memcmp(bytes.data(), s_Magic, sizeof(s_Magic)) == 0;
+	}
+
+private:
+	/// <summary>
+	/// Gets the number of chunks of a file, an empty file still has one chunk so that it has a tag.
+	/// </summary>
+	static uint64_t ChunkCount(uint64_t size, uint64_t chunk_size)
+	{
+		return std::max<uint64_t>(1, (size + chunk_size - 1) / chunk_size);
+	}
+
+	/// <summary>
+	/// Gets the nonce of a chunk, the nonce of the file with the index of the chunk XORed into its last 8 bytes.
+	/// </summary>
+	static void ChunkNonce(const uint8_t* nonce, uint64_t index, uint8_t* chunk_nonce)
+	{
+		std::memcpy(chunk_nonce, nonce, mrt::ChaCha20Poly1305::s_NonceSize);
+
+		for (int i = 0; i < 8; i++)
+		{
+			chunk_nonce[4 + i] ^= static_cast<uint8_t>(index >> (8 * i));
+		}
+	}
+
+	template <typename _Ty>
+	static void PutLittle(char* position, _Ty value)
+	{
+		for (size_t i = 0; i < sizeof(_Ty); i++)
+		{
+			position[i] = static_cast<char>(static_cast<uint64_t>(value) >> (8 * i));
+		}
+	}
+
+	template <typename _Ty>
+	static _Ty GetLittle(const char* position)
+	{
+		uint64_t value = 0;
+
+		for (size_t i = 0; i < sizeof(_Ty); i++)
+		{
+			value |= static_cast<uint64_t>(static_cast<unsigned char>(position[i])) << (8 * i);
+		}
+
+		return static_cast<_Ty>(value);
+	}
+};
+
+/// <summary>
+/// StorageAuthenticated class is a decorator class that encrypts and authenticates the task files of the storage instance, see <see cref="AuthenticatedStage"/>.
+/// A task file that was changed, or that was not written through the decorator, fails to read instead of giving tasks that were not saved.
+/// The fields of the tasks are sealed along with the rest of the file, so the field stage of a StorageEncrypted it wraps is not applied
+/// to the task files, while the tasks of its recurrence rules are still encrypted per field.
+/// The recurrence rules, the dependencies, the rollups and the manifest are not task files, and are written as they are.
+/// </summary>
+class StorageAuthenticated : public Storage
+{
+private:
+	std::shared_ptr<Storage> m_StorageInstance;
+public:
+	/// <summary>
+	/// Constructor for the StorageAuthenticated class.
+	/// Adds the authenticated encryption to the task files of the storage instance.
+	/// </summary>
+	/// <param name="storage_instance"> The storage that writes the task files. </param>
+	/// <param name="key"> The 256-bit key. </param>
+	/// <param name="chunk_size"> The number of bytes sealed in each chunk. </param>
+	StorageAuthenticated(std::shared_ptr<Storage> storage_instance, const std::array<uint8_t, mrt::ChaCha20Poly1305::s_KeySize>& key,
+		uint64_t chunk_size = AuthenticatedStage::s_DefaultChunkSize)
+		: m_StorageInstance(storage_instance)
+	{
+		m_StorageInstance->AddFileStage(std::make_shared<AuthenticatedStage>(key, chunk_size));
+	}
+
+	/// <summary>
+	/// Writes the tasks using the storage instance, which seals the file.
+	/// </summary>
+	/// <param name="file_name"> The name of the file to write to. </param>
+	/// <param name="tasks"> The tasks to write to the file. </param>
+	/// <returns> True if the write operation was successful, false otherwise. </returns>
+	virtual bool Write(const std::string& file_name, const mrt::Vector<Task>& tasks) override
+	{
+		return m_StorageInstance->Write(file_name, tasks);
+	}
+
+	/// <summary>
+	/// Reads the tasks using the storage instance, which checks and decrypts the file.
+	/// </summary>
+	/// <param name="file_name"> The name of the file to read from. </param>
+	/// <param name="tasks"> The tasks that were read. </param>
+	/// <returns> True if the read operation was successful, false otherwise. </returns>
+	virtual bool Read(const std::string& file_name, mrt::Vector<Task>& tasks) override
+	{
+		return m_StorageInstance->Read(file_name, tasks);
+	}
+
+	/// <summary>
+	/// Reads the tasks in batches using the storage instance.
+	/// The whole file is checked before the first batch is handed over.
+	/// </summary>
+	/// <param name="file_name"> The name of the file to read from. </param>
+	/// <param name="batch_size"> The number of tasks in each batch. </param>
+	/// <param name="on_batch"> Called with each batch of tasks. </param>
+	/// <returns> True if the read operation was successful, false otherwise. </returns>
+	virtual bool Read(const std::string& file_name, uint64_t batch_size, const std::function<void(mrt::Vector<Task>&)>& on_batch) override
+	{
+		return m_StorageInstance->Read(file_name, batch_size, on_batch);
+	}
+
+	/// <summary>
+	/// Writes the changed tasks using the storage instance, which writes the whole sealed file as a sealed file cannot be patched.
+	/// </summary>
+	/// <param name="file_name"> The name of the file to write to. </param>
+	/// <param name="delta"> The tasks added, edited and removed since the file was last written. </param>
+	/// <param name="all_tasks"> Gets every task, for when the whole file has to be written. </param>
+	/// <returns> True if the changes were written, false otherwise. </returns>
+	virtual bool WriteDelta(const std::string& file_name, const TaskDelta& delta, const std::function<mrt::Vector<Task>()>& all_tasks) override
+	{
+		return m_StorageInstance->WriteDelta(file_name, delta, all_tasks);
+	}
+
+	/// <summary>
+	/// Writes the recurrence rules using the storage instance.
+	/// </summary>
+	/// <param name="file_name"> The name of the task store. </param>
+	/// <param name="rules"> The recurrence rules. </param>
+	/// <param name="exceptions"> The exceptions of single occurrences. </param>
+	/// <returns> True if the write operation was successful, false otherwise. </returns>
+	virtual bool WriteRecurrences(const std::string& file_name, const mrt::Vector<RecurrenceRule>& rules, const mrt::Vector<RecurrenceException>& exceptions) override
+	{
+		return m_StorageInstance->WriteRecurrences(file_name, rules, exceptions);
+	}
+
+	/// <summary>
+	/// Reads the recurrence rules using the storage instance.
+	/// </summary>
+	/// <param name="file_name"> The name of the task store. </param>
+	/// <param name="rules"> The recurrence rules that were read. </param>
+	/// <param name="exceptions"> The exceptions that were read. </param>
+	/// <returns> True if the read operation was successful, false otherwise. </returns>
+	virtual bool ReadRecurrences(const std::string& file_name, mrt::Vector<RecurrenceRule>& rules, mrt::Vector<RecurrenceException>& exceptions) override
+	{
+		return m_StorageInstance->ReadRecurrences(file_name, rules, exceptions);
+	}
+
+	/// <summary>
+	/// Writes the dependencies using the storage instance.
+	/// </summary>
+	/// <param name="file_name"> The name of the task store. </param>
+	/// <param name="dependencies"> The dependencies. </param>
+	/// <returns> True if the write operation was successful, false otherwise. </returns>
+	virtual bool WriteDependencies(const std::string& file_name, const mrt::Vector<TaskDependency>& dependencies) override
+	{
+		return m_StorageInstance->WriteDependencies(file_name, dependencies);
+	}
+
+	/// <summary>
+	/// Reads the dependencies using the storage instance.
+	/// </summary>
+	/// <param name="file_name"> The name of the task store. </param>
+	/// <param name="dependencies"> The dependencies that were read. </param>
+	/// <returns> True if the read operation was successful, false otherwise. </returns>
+	virtual bool ReadDependencies(const std::string& file_name, mrt::Vector<TaskDependency>& dependencies) override
+	{
+		return m_StorageInstance->ReadDependencies(file_name, dependencies);
+	}
+
+	/// <summary>
+	/// Writes the statistics rollups using the storage instance.
+	/// </summary>
+	/// <param name="file_name"> The name of the task store. </param>
+	/// <param name="rollups"> The rollups, one per day. </param>
+	/// <returns> True if the write operation was successful, false otherwise. </returns>
+	virtual bool WriteRollups(const std::string& file_name, const mrt::Vector<DayRollup>& rollups) override
+	{
+		return m_StorageInstance->WriteRollups(file_name, rollups);
+	}
+
+	/// <summary>
+	/// Reads the statistics rollups using the storage instance.
+	/// </summary>
+	/// <param name="file_name"> The name of the task store. </param>
+	/// <param name="rollups"> The rollups that were read. </param>
+	/// <returns> True if the read operation was successful, false otherwise. </returns>
+	virtual bool ReadRollups(const std::string& file_name, mrt::Vector<DayRollup>& rollups) override
+	{
+		return m_StorageInstance->ReadRollups(file_name, rollups);
+	}
+
+	/// <summary>
+	/// Adds a stage to the task files of the storage instance, it sees the bytes before they are sealed.
+	/// </summary>
+	/// <param name="stage"> The stage to add. </param>
+	virtual void AddFileStage(std::shared_ptr<FileStage> stage) override
+	{
+		m_StorageInstance->AddFileStage(std::move(stage));
+	}
+
+	/// <summary>
+	/// Sets the field stage of the storage instance, which is not applied to the task files as the file is sealed as a whole.
+	/// </summary>
+	/// <param name="stage"> The stage to set. </param>
+	/// <returns> True if the stage was set, false if the storage instance already has a field stage. </returns>
+	virtual bool SetFieldStage(std::shared_ptr<FieldStage> stage) override
+	{
+		return m_StorageInstance->SetFieldStage(std::move(stage));
+	}
+
+	/// <summary>
+	/// Gets the number of bytes written by the storage instance, which is the size of the sealed files.
+	/// </summary>
+	/// <returns> The number of bytes written. </returns>
+	virtual uint64_t BytesWritten() const override
+	{
+		return m_StorageInstance->BytesWritten();
+	}
+};
@@ -0,0 +1,896 @@
+#pragma once
+
+#include "../Header Files/Storage.h"
+#include "../Header Files/Crc32.h"
+#include "../Header Files/MappedFile.h"
+
+#include <cstddef>
+#include <cstdio>
+#include <cstring>
+#include <string>
+#include <vector>
+#include <algorithm>
+#include <filesystem>
+#include <unordered_map>
+
+/// <summary>
+/// StorageBinary class stores the tasks in a versioned binary file instead of XML, the other files of a task store are kept as XML.
+/// The file starts with a fixed header, followed by a table of the fields each record holds and then the records:
+///
+///   header   "DTMB", version (u16), header size (u16), field count (u32), CRC-32 of everything after the header (u32),
+///            record count (u64), size of everything after the header (u64)
+///   fields   per field: type (u8), name length (u8), name
+///   records  per task: record size (u32), then each field in the order of the table,
+///            strings as a length (u32) and their bytes, booleans as a u8, integers as a u64
+///
+/// Every number is little-endian. A reader matches the fields by name and skips the ones it does not know, using their type,
+/// so fields can be added without changing the version. The records are built in one buffer and written with a single write,
+/// and decoded straight from a memory mapping of the file, so saving and loading cost little more than copying the bytes.
+/// A task store that has no binary file yet is read from its XML file, and is written as binary from then on.
+///
+/// <see cref="WriteDelta"/> appends the tasks that changed to a journal next to the file instead of writing every task:
+///
+///   header   "DTMJ", version (u16), header size (u16), CRC-32 of the body of the binary file it follows (u32), reserved (u32),
+///            size of that body (u64)
+///   blocks   per save: size of the rest of the block (u32), CRC-32 of the rest of the block (u32), record count (u32),
+///            removed count (u32), index of the records (id u64, offset u32 from the first record), removed ids (u64),
+///            then the records, in the field order of this version
+///
+/// Reading replays the blocks over the binary file, in order: a record replaces the task with its id in place, or is added at the end,
+/// and a removed id drops its task. A block cut short by a failed save fails its checksum, and it and any block after it are ignored.
+/// A journal only applies to the body it names, so one left over from before the file was last written in full is ignored.
+/// The file is written in full, and the journal removed, once the journal outgrows half the file.
+/// </summary>
+class StorageBinary : public Storage
+{
+public:
+	static constexpr uint16_t s_Version = 1;
+	static constexpr uint16_t s_HeaderSize = 32;
+
+private:
+	static constexpr char s_Magic[4] = { 'D', 'T', 'M', 'B' };
+	static constexpr const char* s_Extension = ".dtb";
+
+	static constexpr char s_JournalMagic[4] = { 'D', 'T', 'M', 'J' };
+	static constexpr const char* s_JournalExtension = ".dtj";
+	static constexpr uint16_t s_JournalVersion = 1;
+	static constexpr uint16_t s_JournalHeaderSize = 24;
+	static constexpr uint64_t s_BlockHeaderSize = 16;
+	static constexpr uint64_t s_IndexEntrySize = 12;
+
+	// A journal smaller than this is not folded into the file, however small the file.
+	static constexpr uint64_t s_MinJournalSize = 64 * 1024;
+
+	/// <summary>
+	/// The types of the fields in the field table.
+	/// </summary>
+	enum FieldType : uint8_t
+	{
+		String = 1,
+		Boolean = 2,
+		Integer = 3
+	};
+
+	/// <summary>
+	/// The fields of a task, in the order they are written.
+	/// </summary>
+	enum FieldSlot
+	{
+		Title,
+		Description,
+		StartTime,
+		EndTime,
+		Completed,
+		Id,
+		FieldCount,
+		Unknown = FieldCount
+	};
+
+	struct Field
+	{
+		FieldType type;
+		const char* name;
+	};
+
+	static constexpr Field s_Fields[FieldCount] = {
+		{ String, "title" },
+		{ String, "description" },
+		{ String, "start_time" },
+		{ String, "end_time" },
+		{ Boolean, "completed" },
+		{ Integer, "id" }
+	};
+
+	/// <summary>
+	/// Reads the numbers and strings of a buffer in order, failing instead of reading past its end.
+	/// </summary>
+	struct Reader
+	{
+		const char* position;
+		const char* end;
+
+		bool Has(uint64_t size) const
+		{
+			return static_cast<uint64_t>(end - position) >= size;
+		}
+
+		template <typename _Ty>
+		bool Read(_Ty& value)
+		{
+			if (!Has(sizeof(_Ty)))
+				return false;
+
+			value = GetLittle<_Ty>(position);
+			position += sizeof(_Ty);
+			return true;
+		}
+
+		bool ReadString(std::string& value)
+		{
+			uint32_t size;
+
+			if (!Read(size) || !Has(size))
+				return false;
+
+			value.assign(position, size);
+			position += size;
+			return true;
+		}
+
+		bool Skip(FieldType type)
+		{
+			uint32_t size = 0;
+
+			switch (type)
+			{
+			case String:
+				if (!Read(size))
+					return false;
+				break;
+			case Boolean:
+				size = 1;
+				break;
+			case Integer:
+				size = 8;
+				break;
+			default:
+				return false;
+			}
+
+			if (!Has(size))
+				return false;
+
+			position += size;
+			return true;
+		}
+	};
+public:
+	/// <summary>
+	/// Writes the tasks to the binary file, through a temporary file that replaces it once written, so a failed write leaves the previous tasks.
+	/// The journal is removed, as its changes are in the file. Tasks that encode to the bytes already in the file are not written again.
+	/// </summary>
+	/// <param name="file_name"> The name of the file to write to. </param>
+	/// <param name="tasks"> The tasks to write to the file. </param>
+	/// <returns> True if the tasks were written to the file, false otherwise. </returns>
+	virtual bool Write(const std::string& file_name, const mrt::Vector<Task>& tasks) override
+	{
+		std::string buffer;
+		Encode(tasks, buffer, GetFieldStage());
+
+		if (!WriteFile(GetPath(file_name, s_Extension), buffer))
+			return false;
+
+		std::error_code error;
+		std::filesystem::remove(GetPath(file_name, s_JournalExtension), error);
+
+		return true;
+	}
+
+	/// <summary>
+	/// Appends the changed tasks to the journal of the binary file as one block, so a save costs as much as the changes.
+	/// The file is written in full instead when there is no binary file yet, when the journal has outgrown the file,
+	/// or when the file has stages, as a stage such as compression runs on whole files.
+	/// </summary>
+	/// <param name="file_name"> The name of the file to write to. </param>
+	/// <param name="delta"> The tasks added, edited and removed since the file was last written. </param>
+	/// <param name="all_tasks"> Gets every task, for when the whole file has to be written. </param>
+	/// <returns> True if the changes were written, false otherwise. </returns>
+	virtual bool WriteDelta(const std::string& file_name, const TaskDelta& delta, const std::function<mrt::Vector<Task>()>& all_tasks) override
+	{
+		std::string path = GetPath(file_name, s_Extension);
+		std::string journal_path = GetPath(file_name, s_JournalExtension);
+
+		uint32_t body_checksum;
+		uint64_t body_size;
+
+		if (HasFileStages() || !ReadHeader(path, body_checksum, body_size))
+			return Write(file_name, all_tasks());
+
+		if (delta.Empty())
+			return true;
+
+		std::string block;
+		EncodeBlock(delta, block, GetFieldStage());
+
+		uint64_t journal_size = JournalSize(journal_path, body_checksum, body_size);
+
+		if (journal_size + block.size() > std::max(s_MinJournalSize, body_size / 2))
+			return Write(file_name, all_tasks());
+
+		std::string journal_header;
+
+		if (journal_size == 0)
+		{
+			journal_header.assign(s_JournalHeaderSize, '\0');
+			std::memcpy(&journal_header[0], s_JournalMagic, sizeof(s_JournalMagic));
+			PutLittle<uint16_t>(&journal_header[4], s_JournalVersion);
+			PutLittle<uint16_t>(&journal_header[6], s_JournalHeaderSize);
+			PutLittle<uint32_t>(&journal_header[8], body_checksum);
+			PutLittle<uint64_t>(&journal_header[16], body_size);
+		}
+
+		std::FILE* file = std::fopen(journal_path.c_str(), journal_size == 0 ? "wb" : "ab");
+
+		if (file == nullptr)
+			return false;
+
+		bool written = std::fwrite(journal_header.data(), 1, journal_header.size(), file) == journal_header.size();
+		written = written && std::fwrite(block.data(), 1, block.size(), file) == block.size();
+		written = std::fclose(file) == 0 && written;
+
+		if (!written)
+		{
+			// A block cut short would hide the blocks appended after it, so the journal is put back as it was.
+			std::error_code error;
+			std::filesystem::resize_file(journal_path, journal_size, error);
+			return false;
+		}
+
+		CountWritten(journal_header.size() + block.size());
+		return true;
+	}
+
+	/// <summary>
+	/// Reads the tasks from the binary file, or from the XML file if the task store has not been written as binary yet.
+	/// </summary>
+	/// <param name="file_name"> The name of the file to read from. </param>
+	/// <param name="tasks"> The tasks to read from the file. </param>
+	/// <returns> True if the tasks were read from the file, false if there is no file or it is not valid. </returns>
+	virtual bool Read(const std::string& file_name, mrt::Vector<Task>& tasks) override
+	{
+		std::string path = GetPath(file_name, s_Extension);
+		std::error_code error;
+
+		if (!std::filesystem::exists(path, error))
+			return Storage::Read(file_name, tasks);
+
+		return ReadBinary(file_name, UINT64_MAX, [&tasks](mrt::Vector<Task>& batch)
+			{
+				if (tasks.Empty())
+				{
+					tasks = std::move(batch);
+					return;
+				}
+
+				for (Task& task : batch)
+				{
+					tasks.PushBack(std::move(task));
+				}
+			});
+	}
+
+	/// <summary>
+	/// Reads the tasks from the binary file, handing them over in batches as they are decoded.
+	/// Falls back to the XML file if the task store has not been written as binary yet.
+	/// </summary>
+	/// <param name="file_name"> The name of the file to read from. </param>
+	/// <param name="batch_size"> The number of tasks in each batch. </param>
+	/// <param name="on_batch"> Called with each batch of tasks, the last batch may be smaller. </param>
+	/// <returns> True if the tasks were read from the file, false if there is no file or it is not valid. </returns>
+	virtual bool Read(const std::string& file_name, uint64_t batch_size, const std::function<void(mrt::Vector<Task>&)>& on_batch) override
+	{
+		std::string path = GetPath(file_name, s_Extension);
+		std::error_code error;
+
+		if (!std::filesystem::exists(path, error))
+			return Storage::Read(file_name, batch_size, on_batch);
+
+		return ReadBinary(file_name, batch_size, on_batch);
+	}
+
+	/// <summary>
+	/// Encodes the tasks into the binary format.
+	/// Once there are enough tasks, the records are written in chunks in parallel on the shared thread pool,
+	/// each chunk straight into its place in the buffer.
+	/// </summary>
+	/// <param name="tasks"> The tasks. </param>
+	/// <param name="buffer"> Set to the encoded file. </param>
+	/// <param name="stage"> The stage the text fields are written through, may be null to write them as they are. </param>
+	static void Encode(const mrt::Vector<Task>& tasks, std::string& buffer, const FieldStage* stage = nullptr)
+	{
+		uint64_t table_size = 0;
+
+		for (const Field& field : s_Fields)
+		{
+			table_size += 2 + std::strlen(field.name);
+		}
+
+		uint64_t chunk_count = std::max<uint64_t>(1, std::min<uint64_t>(ThreadPool::Shared().Size(), tasks.Size() / s_ParallelTasks));
+		uint64_t chunk_size = (tasks.Size() + chunk_count - 1) / chunk_count;
+
+		// The offset of the first record of each chunk from the first record.
+		std::vector<uint64_t> chunk_offsets(chunk_count + 1, 0);
+
+		for (uint64_t i = 0; i < tasks.Size(); i++)
+		{
+			chunk_offsets[i / chunk_size + 1] += 4 + RecordSize(tasks[i], stage);
+		}
+
+		for (uint64_t chunk = 0; chunk < chunk_count; chunk++)
+		{
+			chunk_offsets[chunk + 1] += chunk_offsets[chunk];
+		}
+
+		uint64_t body_size = table_size + chunk_offsets[chunk_count];
+
+		// The buffer is sized once, then filled in place.
+		buffer.assign(s_HeaderSize + body_size, '\0');
+		char* position = &buffer[s_HeaderSize];
+
+		for (const Field& field : s_Fields)
+		{
+			uint8_t name_size = static_cast<uint8_t>(std::strlen(field.name));
+
+			position = PutLittle<uint8_t>(position, field.type);
+			position = PutLittle<uint8_t>(position, name_size);
+			std::memcpy(position, field.name, name_size);
+			position += name_size;
+		}
+
+		char* records = position;
+
+		ThreadPool::Shared().ParallelFor(chunk_count, [&tasks, stage, records, chunk_size, &chunk_offsets](uint64_t chunk)
+			{
+				char* record = records + chunk_offsets[chunk];
+
+				for (uint64_t i = chunk * chunk_size; i < std::min<uint64_t>(tasks.Size(), (chunk + 1) * chunk_size); i++)
+				{
+					record = PutRecord(record, tasks[i], stage);
+				}
+			});
+
+		char* header = &buffer[0];
+		std::memcpy(header, s_Magic, sizeof(s_Magic));
+		PutLittle<uint16_t>(header + 4, s_Version);
+		PutLittle<uint16_t>(header + 6, s_HeaderSize);
+		PutLittle<uint32_t>(header + 8, FieldCount);
+		PutLittle<uint32_t>(header + 12, mrt::Crc32::Of(buffer.data() + s_HeaderSize, body_size));
+		PutLittle<uint64_t>(header + 16, tasks.Size());
+		PutLittle<uint64_t>(header + 24, body_size);
+	}
+
+	/// <summary>
+	/// Decodes the tasks of a file in the binary format, after checking its header and checksum.
+	/// </summary>
+	/// <param name="buffer"> The contents of the file. </param>
+	/// <param name="batch_size"> The number of tasks in each batch. </param>
+	/// <param name="on_batch"> Called with each batch of tasks, the last batch may be smaller. </param>
+	/// <returns> True if the file is valid, false otherwise. No tasks are handed over from a file that is not valid. </returns>
+	static bool Decode(const std::string& buffer, uint64_t batch_size, const std::function<void(mrt::Vector<Task>&)>& on_batch)
+	{
+		return Decode(buffer.data(), buffer.size(), batch_size, on_batch);
+	}
+
+	/// <summary>
+	/// Decodes the tasks of a file in the binary format where it lies, such as in a memory mapping of the file.
+	/// Each string is copied once, from the file into its task.
+	/// </summary>
+	/// <param name="data"> The contents of the file, may be null if the size is 0. </param>
+	/// <param name="size"> The size of the file in bytes. </param>
+	/// <param name="batch_size"> The number of tasks in each batch. </param>
+	/// <param name="on_batch"> Called with each batch of tasks, the last batch may be smaller. </param>
+	/// <returns> True if the file is valid, false otherwise. No tasks are handed over from a file that is not valid. </returns>
+	static bool Decode(const char* data, uint64_t size, uint64_t batch_size, const std::function<void(mrt::Vector<Task>&)>& on_batch)
+	{
+		if (size < s_HeaderSize || std::memcmp(data, s_Magic, sizeof(s_Magic)) != 0)
+			return false;
+
+		const char* header = data;
+		uint16_t version = GetLittle<uint16_t>(header + 4);
+		uint16_t header_size = GetLittle<uint16_t>(header + 6);
+		uint32_t field_count = GetLittle<uint32_t>(header + 8);
+		uint32_t checksum = GetLittle<uint32_t>(header + 12);
+		uint64_t record_count = GetLittle<uint64_t>(header + 16);
+		uint64_t body_size = GetLittle<uint64_t>(header + 24);
+
+		if (version > s_Version || header_size < s_HeaderSize || header_size > size || body_size != size - header_size)
+			return false;
+
+		if (mrt::Crc32::Of(header + header_size, body_size) != checksum)
+			return false;
+
+		Reader reader{ header + header_size, header + size };
+		std::vector<std::pair<FieldType, FieldSlot>> fields;
+
+		for (uint32_t i = 0; i < field_count; i++)
+		{
+			uint8_t type;
+			uint8_t name_size;
+
+			if (!reader.Read(type) || !reader.Read(name_size) || !reader.Has(name_size))
+				return false;
+
+			fields.emplace_back(static_cast<FieldType>(type), SlotOf(type, std::string(reader.position, name_size)));
+			reader.position += name_size;
+		}
+
+		// Every record is read before any is handed over, so a file that turns out to be cut short adds no tasks.
+		std::ptrdiff_t remaining = reader.end - reader.position;
+		mrt::Vector<Task> tasks(remaining >= 0 && record_count < static_cast<uint64_t>(remaining) ? record_count : 0);
+
+		for (uint64_t i = 0; i < record_count; i++)
+		{
+			uint32_t record_size;
+
+			if (!reader.Read(record_size) || !reader.Has(record_size))
+				return false;
+
+			Reader record{ reader.position, reader.position + record_size };
+			Task& task = tasks.EmplaceBack();
+
+			for (const std::pair<FieldType, FieldSlot>& field : fields)
+			{
+				if (!ReadField(record, field.first, field.second, task))
+					return false;
+			}
+
+			reader.position = record.end;
+		}
+
+		if (reader.position != reader.end)
+			return false;
+
+		HandOver(tasks, batch_size, on_batch);
+		return true;
+	}
+
+private:
+	/// <summary>
+	/// Decodes the binary file of a task store, straight from a memory mapping of the file,
+	/// or from the bytes the file stages turn it back into when there are any.
+	/// </summary>
+	bool ReadBinary(const std::string& file_name, uint64_t batch_size, const std::function<void(mrt::Vector<Task>&)>& on_batch) const
+	{
+		std::string path = GetPath(file_name, s_Extension);
+
+		bool fields_covered = false;
+
+		std::function<void(mrt::Vector<Task>&)> on_decoded_batch = [this, &on_batch, &fields_covered](mrt::Vector<Task>& batch)
+			{
+				if (!fields_covered)
+				{
+					DecodeFields(batch, 0);
+				}
+
+				on_batch(batch);
+			};
+
+		if (HasFileStages())
+		{
+			std::string buffer;
+
+			if (!ReadFile(path, buffer, fields_covered))
+				return false;
+
+			return DecodeWithJournal(buffer.data(), buffer.size(), file_name, batch_size, on_decoded_batch);
+		}
+
+		mrt::MappedFile file;
+
+		if (!file.Open(path))
+			return false;
+
+		return DecodeWithJournal(file.Data(), file.Size(), file_name, batch_size, on_decoded_batch);
+	}
+
+	/// <summary>
+	/// Decodes the binary file, then replays its journal over the tasks if it has one.
+	/// Without a journal the tasks are handed over as they are decoded.
+	/// </summary>
+	bool DecodeWithJournal(const char* data, uint64_t size, const std::string& file_name, uint64_t batch_size, const std::function<void(mrt::Vector<Task>&)>& on_batch) const
+	{
+		mrt::MappedFile journal;
+
+		if (!journal.Open(GetPath(file_name, s_JournalExtension)) || journal.Size() == 0)
+			return Decode(data, size, batch_size, on_batch);
+
+		mrt::Vector<Task> tasks;
+
+		bool decoded = Decode(data, size, UINT64_MAX, [&tasks](mrt::Vector<Task>& batch)
+			{
+				tasks = std::move(batch);
+			});
+
+		if (!decoded)
+			return false;
+
+		ApplyJournal(journal.Data(), journal.Size(), GetLittle<uint32_t>(data + 12), GetLittle<uint64_t>(data + 24), tasks);
+
+		HandOver(tasks, batch_size, on_batch);
+		return true;
+	}
+
+	/// <summary>
+	/// Replays the blocks of a journal over the decoded tasks, see <see cref="StorageBinary"/>.
+	/// The tasks are indexed by id once, so each record in the journal costs O(1) to apply.
+	/// </summary>
+	/// <param name="data"> The contents of the journal. </param>
+	/// <param name="size"> The size of the journal in bytes. </param>
+	/// <param name="body_checksum"> The checksum of the body of the binary file the tasks were decoded from. </param>
+	/// <param name="body_size"> The size of that body. </param>
+	/// <param name="tasks"> The decoded tasks, which are changed in place. </param>
+	static void ApplyJournal(const char* data, uint64_t size, uint32_t body_checksum, uint64_t body_size, mrt::Vector<Task>& tasks)
+	{
+		if (!IsJournalOf(data, size, body_checksum, body_size))
+			return;
+
+		std::unordered_map<uint64_t, uint64_t> positions;
+		std::vector<bool> removed(tasks.Size(), false);
+
+		for (uint64_t i = 0; i < tasks.Size(); i++)
+		{
+			positions[tasks[i].id] = i;
+		}
+
+		Reader reader{ data + GetLittle<uint16_t>(data + 6), data + size };
+
+		while (reader.Has(8))
+		{
+			uint32_t block_size = GetLittle<uint32_t>(reader.position);
+			uint32_t checksum = GetLittle<uint32_t>(reader.position + 4);
+
+			if (block_size < s_BlockHeaderSize - 8 || !reader.Has(8 + static_cast<uint64_t>(block_size)))
+				break;
+
+			const char* block = reader.position + 8;
+
+			if (mrt::Crc32::Of(block, block_size) != checksum)
+				break;
+
+			reader.position = block + block_size;
+
+			uint64_t record_count = GetLittle<uint32_t>(block);
+			uint64_t removed_count = GetLittle<uint32_t>(block + 4);
+			uint64_t tables_size = record_count * s_IndexEntrySize + removed_count * 8;
+
+			if (tables_size > block_size - 8)
+				break;
+
+			const char* index = block + 8;
+			const char* removed_ids = index + record_count * s_IndexEntrySize;
+			const char* records = removed_ids + removed_count * 8;
+			const char* block_end = block + block_size;
+
+			for (uint64_t i = 0; i < removed_count; i++)
+			{
+				auto position = positions.find(GetLittle<uint64_t>(removed_ids + i * 8));
+
+				if (position != positions.end())
+				{
+					removed[position->second] = true;
+				}
+			}
+
+			for (uint64_t i = 0; i < record_count; i++)
+			{
+				uint64_t offset = GetLittle<uint32_t>(index + i * s_IndexEntrySize + 8);
+				Reader record{ records + std::min<uint64_t>(offset, block_end - records), block_end };
+				Task task;
+
+				if (!ReadRecord(record, task))
+					break;
+
+				auto position = positions.find(task.id);
+
+				if (position != positions.end())
+				{
+					tasks[position->second] = std::move(task);
+					removed[position->second] = false;
+				}
+				else
+				{
+					positions[task.id] = tasks.Size();
+					tasks.PushBack(std::move(task));
+					removed.push_back(false);
+				}
+			}
+		}
+
+		if (std::find(removed.begin(), removed.end(), true) == removed.end())
+			return;
+
+		mrt::Vector<Task> kept(tasks.Size());
+
+		for (uint64_t i = 0; i < tasks.Size(); i++)
+		{
+			if (!removed[i])
+			{
+				kept.PushBack(std::move(tasks[i]));
+			}
+		}
+
+		tasks = std::move(kept);
+	}
+
+	/// <summary>
+	/// Encodes the changes of a save as a block of the journal.
+	/// </summary>
+	static void EncodeBlock(const TaskDelta& delta, std::string& block, const FieldStage* stage)
+	{
+		uint64_t records_size = 0;
+
+		for (const Task& task : delta.changed)
+		{
+			records_size += 4 + RecordSize(task, stage);
+		}
+
+		uint64_t tables_size = delta.changed.Size() * s_IndexEntrySize + delta.removed.Size() * 8;
+
+		block.assign(s_BlockHeaderSize + tables_size + records_size, '\0');
+
+		char* index = &block[s_BlockHeaderSize];
+		char* removed_ids = index + delta.changed.Size() * s_IndexEntrySize;
+		char* records = removed_ids + delta.removed.Size() * 8;
+		char* position = records;
+
+		for (const Task& task : delta.changed)
+		{
+			index = PutLittle<uint64_t>(index, task.id);
+			index = PutLittle<uint32_t>(index, static_cast<uint32_t>(position - records));
+			position = PutRecord(position, task, stage);
+		}
+
+		for (uint64_t id : delta.removed)
+		{
+			removed_ids = PutLittle<uint64_t>(removed_ids, id);
+		}
+
+		PutLittle<uint32_t>(&block[0], static_cast<uint32_t>(block.size() - 8));
+		PutLittle<uint32_t>(&block[8], static_cast<uint32_t>(delta.changed.Size()));
+		PutLittle<uint32_t>(&block[12], static_cast<uint32_t>(delta.removed.Size()));
+		PutLittle<uint32_t>(&block[4], mrt::Crc32::Of(block.data() + 8, block.size() - 8));
+	}
+
+	/// <summary>
+	/// Reads the checksum and the size of the body from the header of a binary file, without reading the rest of the file.
+	/// </summary>
+	/// <returns> True if the file exists and starts with a header of this version, false otherwise. </returns>
+	static bool ReadHeader(const std::string& path, uint32_t& body_checksum, uint64_t& body_size)
+	{
+		char header[s_HeaderSize];
+
+		std::FILE* file = std::fopen(path.c_str(), "rb");
+
+		if (file == nullptr)
+			return false;
+
+		bool read = std::fread(header, 1, sizeof(header), file) == sizeof(header);
+		std::fclose(file);
+
+		if (!read || std::memcmp(header, s_Magic, sizeof(s_Magic)) != 0 || GetLittle<uint16_t>(header + 4) > s_Version)
+			return false;
+
+		body_checksum = GetLittle<uint32_t>(header + 12);
+		body_size = GetLittle<uint64_t>(header + 24);
+		return true;
+	}
+
+	/// <summary>
+	/// Gets the size of the journal of a binary file.
+	/// </summary>
+	/// <returns> The size of the journal, 0 if there is none or it follows another body. </returns>
+	static uint64_t JournalSize(const std::string& journal_path, uint32_t body_checksum, uint64_t body_size)
+	{
+		char header[s_JournalHeaderSize];
+
+		std::FILE* file = std::fopen(journal_path.c_str(), "rb");
+
+		if (file == nullptr)
+			return 0;
+
+		bool read = std::fread(header, 1, sizeof(header), file) == sizeof(header);
+		std::fclose(file);
+
+		if (!read || !IsJournalOf(header, sizeof(header), body_checksum, body_size))
+			return 0;
+
+		std::error_code error;
+		uint64_t size = std::filesystem::file_size(journal_path, error);
+
+		return error ? 0 : size;
+	}
+
+	/// <summary>
+	/// Checks whether a journal starts with a header of this version that follows the specified body.
+	/// </summary>
+	static bool IsJournalOf(const char* data, uint64_t size, uint32_t body_checksum, uint64_t body_size)
+	{
+		if (size < s_JournalHeaderSize || std::memcmp(data, s_JournalMagic, sizeof(s_JournalMagic)) != 0)
+			return false;
+
+		uint16_t header_size = GetLittle<uint16_t>(data + 6);
+
+		return GetLittle<uint16_t>(data + 4) == s_JournalVersion && header_size >= s_JournalHeaderSize && header_size <= size &&
+			GetLittle<uint32_t>(data + 8) == body_checksum && GetLittle<uint64_t>(data + 16) == body_size;
+	}
+
+	/// <summary>
+	/// Reads a record of the journal, whose fields are in the order of <see cref="s_Fields"/>.
+	/// </summary>
+	static bool ReadRecord(Reader& reader, Task& task)
+	{
+		uint32_t record_size;
+
+		if (!reader.Read(record_size) || !reader.Has(record_size))
+			return false;
+
+		Reader record{ reader.position, reader.position + record_size };
+
+		for (int slot = 0; slot < FieldCount; slot++)
+		{
+			if (!ReadField(record, s_Fields[slot].type, static_cast<FieldSlot>(slot), task))
+				return false;
+		}
+
+		reader.position = record.end;
+		return true;
+	}
+
+	/// <summary>
+	/// Hands the decoded tasks over in batches, a single batch is handed over without copying the tasks.
+	/// </summary>
+	static void HandOver(mrt::Vector<Task>& tasks, uint64_t batch_size, const std::function<void(mrt::Vector<Task>&)>& on_batch)
+	{
+		if (tasks.Size() <= batch_size)
+		{
+			if (!tasks.Empty())
+			{
+				on_batch(tasks);
+			}
+
+			return;
+		}
+
+		mrt::Vector<Task> batch(batch_size);
+
+		for (Task& task : tasks)
+		{
+			batch.PushBack(std::move(task));
+
+			if (batch.Size() >= batch_size)
+			{
+				on_batch(batch);
+				batch.Clear();
+			}
+		}
+
+		if (!batch.Empty())
+		{
+			on_batch(batch);
+		}
+	}
+
+	static bool ReadField(Reader& record, FieldType type, FieldSlot slot, Task& task)
+	{
+		switch (slot)
+		{
+		case Title:
+			return record.ReadString(task.title);
+		case Description:
+			return record.ReadString(task.description);
+		case StartTime:
+			return record.ReadString(task.start_time);
+		case EndTime:
+			return record.ReadString(task.end_time);
+		case Completed:
+		{
+			uint8_t is_done;
+
+			if (!record.Read(is_done))
+				return false;
+
+			task.is_done = is_done != 0;
+			return true;
+		}
+		case Id:
+			return record.Read(task.id);
+		default:
+			return record.Skip(type);
+		}
+	}
+
+	/// <summary>
+	/// Finds the field of a task that a field of the table holds, a field whose name or type is not known is skipped.
+	/// </summary>
+	static FieldSlot SlotOf(uint8_t type, const std::string& name)
+	{
+		for (int slot = 0; slot < FieldCount; slot++)
+		{
+			if (s_Fields[slot].type == type && name == s_Fields[slot].name)
+				return static_cast<FieldSlot>(slot);
+		}
+
+		return Unknown;
+	}
+
+	static uint64_t RecordSize(const Task& task, const FieldStage* stage)
+	{
+		return 16 + StringSize(task.title, stage) + StringSize(task.description, stage) + StringSize(task.start_time, stage) + StringSize(task.end_time, stage) + 1 + 8;
+	}
+
+	/// <summary>
+	/// Writes a task as a record, its size followed by its fields in the order of <see cref="s_Fields"/>.
+	/// </summary>
+	static char* PutRecord(char* position, const Task& task, const FieldStage* stage)
+	{
+		position = PutLittle<uint32_t>(position, static_cast<uint32_t>(RecordSize(task, stage)));
+		position = PutString(position, task.title, stage);
+		position = PutString(position, task.description, stage);
+		position = PutString(position, task.start_time, stage);
+		position = PutString(position, task.end_time, stage);
+		position = PutLittle<uint8_t>(position, task.is_done ? 1 : 0);
+		return PutLittle<uint64_t>(position, task.id);
+	}
+
+	static uint64_t StringSize(const std::string& value, const FieldStage* stage)
+	{
+		return stage != nullptr ? stage->EncodedSize(value.size()) : value.size();
+	}
+
+	/// <summary>
+	/// Writes a string as its size and its bytes, passing it through the field stage straight into the record if there is one.
+	/// </summary>
+	static char* PutString(char* position, const std::string& value, const FieldStage* stage)
+	{
+		uint64_t size = StringSize(value, stage);
+		position = PutLittle<uint32_t>(position, static_cast<uint32_t>(size));
+
+		if (stage != nullptr)
+		{
+			stage->Encode(value, position);
+		}
+		else
+		{
+			std::memcpy(position, value.data(), value.size());
+		}
+
+		return position + size;
+	}
+
+	/// <summary>
+	/// Writes a number as little-endian, whatever the byte order of the machine. Compilers turn the shifts into a single store.
+	/// </summary>
+	template <typename _Ty>
+	static char* PutLittle(char* position, _Ty value)
+	{
+		for (size_t i = 0; i < sizeof(_Ty); i++)
+		{
+			position[i] = static_cast<char>(static_cast<uint64_t>(value) >> (8 * i));
+		}
+
+		return position + sizeof(_Ty);
+	}
+
+	template <typename _Ty>
+	static _Ty GetLittle(const char* position)
+	{
+		uint64_t value = 0;
+
+		for (size_t i = 0; i < sizeof(_Ty); i++)
+		{
+			value |= static_cast<uint64_t>(static_cast<unsigned char>(position[i])) << (8 * i);
+		}
+
+		return static_cast<_Ty>(value);
+	}
+};
@@ -0,0 +1,393 @@
+#pragma once
+
+#include "../Header Files/Storage.h"
+#include "../Header Files/Lz.h"
+#include "../Header Files/Crc32.h"
+#include "../Header Files/ThreadPool.h"
+
+#include <atomic>
+#include <string>
+#include <cstring>
+#include <algorithm>
+#include <vector>
+#include <memory>
+
+/// <summary>
+/// CompressionStage class compresses a whole task file with <see cref="mrt::Lz"/>, split into blocks that are compressed on their own:
+///
+///   header   "DTMZ", version (u16), header size (u16), block size (u32), block count (u32), size of the file (u64),
+///            CRC-32 of the block table (u32), reserved (u32)
+///   table    per block: stored size (u32, the top bit set when the block is stored as it is), CRC-32 of the block (u32)
+///   blocks   the stored blocks, one after the other
+///
+/// Every number is little-endian. Each block refers to no other block, so the blocks are compressed and decompressed in parallel
+/// on the shared thread pool, and a block that does not get smaller is stored as it is. A file that does not start with the
+/// magic was written before the stage was added, and is read as it is.
+/// </summary>
+class CompressionStage : public FileStage
+{
+public:
+	static constexpr uint16_t s_Version = 1;
+	static constexpr uint16_t s_HeaderSize = 32;
+	static constexpr uint64_t s_DefaultBlockSize = 128 * 1024;
+
+private:
+	static constexpr char s_Magic[4] = { 'D', 'T', 'M', 'Z' };
+	static constexpr uint32_t s_StoredFlag = 0x80000000u;
+
+	uint64_t m_BlockSize;
+public:
+	/// <summary>
+	/// Initializes a new instance of the <see cref="CompressionStage"/> class.
+	/// </summary>
+	/// <param name="block_size"> The number of bytes in each block, smaller blocks decompress with more threads but compress less. </param>
+	explicit CompressionStage(uint64_t block_size = s_DefaultBlockSize)
+		: m_BlockSize(std::min<uint64_t>(std::max<uint64_t>(block_size, 1024), s_StoredFlag - 1))
+	{
+	}
+
+	/// <summary>
+	/// Compresses the file.
+	/// </summary>
+	/// <param name="bytes"> The bytes of the file, replaced by the compressed file. </param>
+	/// <returns> True if the file was compressed, false if it is too large for the block table. </returns>
+	virtual bool Encode(std::string& bytes) override
+	{
+		uint64_t block_count = (bytes.size() + m_BlockSize - 1) / m_BlockSize;
+
+		if (block_count > UINT32_MAX)
+			return false;
+
+		std::vector<std::string> blocks(block_count);
+		std::vector<uint32_t> checksums(block_count);
+
+		ThreadPool::Shared().ParallelFor(block_count, [&](uint64_t i)
+			{
+				const char* block = bytes.data() + i * m_BlockSize;
+				uint64_t size = std::min<uint64_t>(m_BlockSize, bytes.size() - i * m_BlockSize);
+
+				// The block is only compressed into a buffer smaller than itself, a block that does not fit is stored as it is.
+				blocks[i].resize(size);
+				blocks[i].resize(mrt::Lz::Compress(block, size, blocks[i].data(), size - 1));
+				checksums[i] = mrt::Crc32::Of(block, size);
+			});
+
+		uint64_t table_size = block_count * 8;
+		uint64_t stored_size = s_HeaderSize + table_size;
+
+		for (uint64_t i = 0; i < block_count; i++)
+		{
+			stored_size += blocks[i].empty() ? std::min<uint64_t>(m_BlockSize, bytes.size() - i * m_BlockSize) : blocks[i].size();
+		}
+
+		std::string stored(stored_size, '\0');
+		char* table = stored.data() + s_HeaderSize;
+		char* position = table + table_size;
+
+		for (uint64_t i = 0; i < block_count; i++)
+		{
+			uint64_t size = blocks[i].size();
+
+			if (blocks[i].empty())
+			{
+				size = std::min<uint64_t>(m_BlockSize, bytes.size() - i * m_BlockSize);
+				std::memcpy(position, bytes.data() + i * m_BlockSize, size);
+			}
+			else
+			{
+				std::memcpy(position, blocks[i].data(), size);
+			}
+
+			PutLittle<uint32_t>(table + i * 8, static_cast<uint32_t>(size) | (blocks[i].empty() ? s_StoredFlag : 0));
+			PutLittle<uint32_t>(table + i * 8 + 4, checksums[i]);
+			position += size;
+		}
+
+		char* header = stored.data();
+		std::memcpy(header, s_Magic, sizeof(s_Magic));
+		PutLittle<uint16_t>(header + 4, s_Version);
+		PutLittle<uint16_t>(header + 6, s_HeaderSize);
+		PutLittle<uint32_t>(header + 8, static_cast<uint32_t>(m_BlockSize));
+		PutLittle<uint32_t>(header + 12, static_cast<uint32_t>(block_count));
+		PutLittle<uint64_t>(header + 16, bytes.size());
+		PutLittle<uint32_t>(header + 24, mrt::Crc32::Of(table, table_size));
+
+		bytes = std::move(stored);
+		return true;
+	}
+
+	/// <summary>
+	/// Decompresses the file, a file that was not compressed is left as it is.
+	/// </summary>
+	/// <param name="bytes"> The stored bytes, replaced by the bytes of the file. </param>
+	/// <returns> True if the file was decompressed, false if it is damaged or was written by a newer version. </returns>
+	virtual bool Decode(std::string& bytes) override
+	{
+		if (bytes.size() < sizeof(s_Magic) || std::memcmp(bytes.data(), s_Magic, sizeof(s_Magic)) != 0)
+			return true;
+
+		if (bytes.size() < s_HeaderSize)
+			return false;
+
+		const char* header = bytes.data();
+		uint16_t version = GetLittle<uint16_t>(header + 4);
+		uint16_t header_size = GetLittle<uint16_t>(header + 6);
+		uint64_t block_size = GetLittle<uint32_t>(header + 8);
+		uint64_t block_count = GetLittle<uint32_t>(header + 12);
+		uint64_t raw_size = GetLittle<uint64_t>(header + 16);
+
+		if (version > s_Version || header_size < s_HeaderSize || header_size > bytes.size() || block_size == 0)
+			return false;
+
+		if (block_count > (bytes.size() - header_size) / 8 || raw_size > block_count * block_size || raw_size + block_size <= block_count * block_size)
+			return false;
+
+		const char* table = header + header_size;
+
+		if (mrt::Crc32::Of(table, block_count * 8) != GetLittle<uint32_t>(header + 24))
+			return false;
+
+		// The table gives where each block starts, so every block can be decompressed by any thread.
+		std::vector<uint64_t> offsets(block_count + 1);
+		offsets[0] = header_size + block_count * 8;
+
+		for (uint64_t i = 0; i < block_count; i++)
+		{
+			offsets[i + 1] = offsets[i] + (GetLittle<uint32_t>(table + i * 8) & ~s_StoredFlag);
+		}
+
+		if (offsets[block_count] != bytes.size())
+			return false;
+
+		std::string raw(raw_size, '\0');
+		std::atomic<bool> valid{ true };
+
+		ThreadPool::Shared().ParallelFor(block_count, [&](uint64_t i)
+			{
+				uint32_t entry = GetLittle<uint32_t>(table + i * 8);
+				const char* block = bytes.data() + offsets[i];
+				uint64_t size = offsets[i + 1] - offsets[i];
+				char* destination = raw.data() + i * block_size;
+				uint64_t destination_size = std::min<uint64_t>(block_size, raw_size - i * block_size);
+
+				bool decoded = false;
+
+				if ((entry & s_StoredFlag) == 0)
+				{
+					decoded = mrt::Lz::Decompress(block, size, destination, destination_size);
+				}
+				else if (size == destination_size)
+				{
+					std::memcpy(destination, block, size);
+					decoded = true;
+				}
+
+				if (!decoded || mrt::Crc32::Of(destination, destination_size) != GetLittle<uint32_t>(table + i * 8 + 4))
+				{
+					valid.store(false, std::memory_order_relaxed);
+				}
+			});
+
+		if (!valid.load(std::memory_order_relaxed))
+			return false;
+
+		bytes = std::move(raw);
+		return true;
+	}
+
+private:
+	/// <summary>
+	/// Writes a number as little-endian, whatever the byte order of the machine.
+	/// </summary>
+	template <typename _Ty>
+	static void PutLittle(char* position, _Ty value)
+	{
+		for (size_t i = 0; i < sizeof(_Ty); i++)
+		{
+			position[i] = static_cast<char>(static_cast<uint64_t>(value) >> (8 * i));
+		}
+	}
+
+	/// <summary>
+	/// Reads a number written by <see cref="PutLittle"/>.
+	/// </summary>
+	template <typename _Ty>
+	static _Ty GetLittle(const char* position)
+	{
+		uint64_t value = 0;
+
+		for (size_t i = 0; i < sizeof(_Ty); i++)
+		{
+			value |= static_cast<uint64_t>(static_cast<unsigned char>(position[i])) << (8 * i);
+		}
+
+		return static_cast<_Ty>(value);
+	}
+};
+
+/// <summary>
+/// StorageCompressed class is a decorator class that compresses the task files of the storage instance, see <see cref="CompressionStage"/>.
+/// The compression runs on the bytes the storage instance writes, so it works the same over the XML and the binary files,
+/// and over the encrypted tasks whether it wraps the encrypted storage or is wrapped by it.
+/// The recurrence rules, the dependencies, the rollups and the manifest are small, and are written as they are.
+/// </summary>
+class StorageCompressed : public Storage
+{
+private:
+	std::shared_ptr<Storage> m_StorageInstance;
+public:
+	/// <summary>
+	/// Constructor for the StorageCompressed class.
+	/// Adds the compression to the task files of the storage instance.
+	/// </summary>
+	/// <param name="storage_instance"> The storage that writes the task files. </param>
+	/// <param name="block_size"> The number of bytes compressed in each block. </param>
+	StorageCompressed(std::shared_ptr<Storage> storage_instance, uint64_t block_size = CompressionStage::s_DefaultBlockSize)
+		: m_StorageInstance(storage_instance)
+	{
+		m_StorageInstance->AddFileStage(std::make_shared<CompressionStage>(block_size));
+	}
+
+	/// <summary>
+	/// Writes the tasks using the storage instance, which compresses the file.
+	/// </summary>
+	/// <param name="file_name"> The name of the file to write to. </param>
+	/// <param name="tasks"> The tasks to write to the file. </param>
+	/// <returns> True if the write operation was successful, false otherwise. </returns>
+	virtual bool Write(const std::string& file_name, const mrt::Vector<Task>& tasks) override
+	{
+		return m_StorageInstance->Write(file_name, tasks);
+	}
+
+	/// <summary>
+	/// Reads the tasks using the storage instance, which decompresses the file.
+	/// </summary>
+	/// <param name="file_name"> The name of the file to read from. </param>
+	/// <param name="tasks"> The tasks that were read. </param>
+	/// <returns> True if the read operation was successful, false otherwise. </returns>
+	virtual bool Read(const std::string& file_name, mrt::Vector<Task>& tasks) override
+	{
+		return m_StorageInstance->Read(file_name, tasks);
+	}
+
+	/// <summary>
+	/// Reads the tasks in batches using the storage instance.
+	/// The file is decompressed as a whole before the first batch is handed over.
+	/// </summary>
+	/// <param name="file_name"> The name of the file to read from. </param>
+	/// <param name="batch_size"> The number of tasks in each batch. </param>
+	/// <param name="on_batch"> Called with each batch of tasks. </param>
+	/// <returns> True if the read operation was successful, false otherwise. </returns>
+	virtual bool Read(const std::string& file_name, uint64_t batch_size, const std::function<void(mrt::Vector<Task>&)>& on_batch) override
+	{
+		return m_StorageInstance->Read(file_name, batch_size, on_batch);
+	}
+
+	/// <summary>
+	/// Writes the changed tasks using the storage instance, which writes the whole compressed file as a file cannot be patched once compressed.
+	/// </summary>
+	/// <param name="file_name"> The name of the file to write to. </param>
+	/// <param name="delta"> The tasks added, edited and removed since the file was last written. </param>
+	/// <param name="all_tasks"> Gets every task, for when the whole file has to be written. </param>
+	/// <returns> True if the changes were written, false otherwise. </returns>
+	virtual bool WriteDelta(const std::string& file_name, const TaskDelta& delta, const std::function<mrt::Vector<Task>()>& all_tasks) override
+	{
+		return m_StorageInstance->WriteDelta(file_name, delta, all_tasks);
+	}
+
+	/// <summary>
+	/// Writes the recurrence rules using the storage instance.
+	/// </summary>
+	/// <param name="file_name"> The name of the task store. </param>
+	/// <param name="rules"> The recurrence rules. </param>
+	/// <param name="exceptions"> The exceptions of single occurrences. </param>
+	/// <returns> True if the write operation was successful, false otherwise. </returns>
+	virtual bool WriteRecurrences(const std::string& file_name, const mrt::Vector<RecurrenceRule>& rules, const mrt::Vector<RecurrenceException>& exceptions) override
+	{
+		return m_StorageInstance->WriteRecurrences(file_name, rules, exceptions);
+	}
+
+	/// <summary>
+	/// Reads the recurrence rules using the storage instance.
+	/// </summary>
+	/// <param name="file_name"> The name of the task store. </param>
+	/// <param name="rules"> The recurrence rules that were read. </param>
+	/// <param name="exceptions"> The exceptions that were read. </param>
+	/// <returns> True if the read operation was successful, false otherwise. </returns>
+	virtual bool ReadRecurrences(const std::string& file_name, mrt::Vector<RecurrenceRule>& rules, mrt::Vector<RecurrenceException>& exceptions) override
+	{
+		return m_StorageInstance->ReadRecurrences(file_name, rules, exceptions);
+	}
+
+	/// <summary>
+	/// Writes the dependencies using the storage instance.
+	/// </summary>
+	/// <param name="file_name"> The name of the task store. </param>
+	/// <param name="dependencies"> The dependencies. </param>
+	/// <returns> True if the write operation was successful, false otherwise. </returns>
+	virtual bool WriteDependencies(const std::string& file_name, const mrt::Vector<TaskDependency>& dependencies) override
+	{
+		return m_StorageInstance->WriteDependencies(file_name, dependencies);
+	}
+
+	/// <summary>
+	/// Reads the dependencies using the storage instance.
+	/// </summary>
+	/// <param name="file_name"> The name of the task store. </param>
+	/// <param name="dependencies"> The dependencies that were read. </param>
+	/// <returns> True if the read operation was successful, false otherwise. </returns>
+	virtual bool ReadDependencies(const std::string& file_name, mrt::Vector<TaskDependency>& dependencies) override
+	{
+		return m_StorageInstance->ReadDependencies(file_name, dependencies);
+	}
+
+	/// <summary>
+	/// Writes the statistics rollups using the storage instance.
+	/// </summary>
+	/// <param name="file_name"> The name of the task store. </param>
+	/// <param name="rollups"> The rollups, one per day. </param>
+	/// <returns> True if the write operation was successful, false otherwise. </returns>
+	virtual bool WriteRollups(const std::string& file_name, const mrt::Vector<DayRollup>& rollups) override
+	{
+		return m_StorageInstance->WriteRollups(file_name, rollups);
+	}
+
+	/// <summary>
+	/// Reads the statistics rollups using the storage instance.
+	/// </summary>
+	/// <param name="file_name"> The name of the task store. </param>
+	/// <param name="rollups"> The rollups that were read. </param>
+	/// <returns> True if the read operation was successful, false otherwise. </returns>
+	virtual bool ReadRollups(const std::string& file_name, mrt::Vector<DayRollup>& rollups) override
+	{
+		return m_StorageInstance->ReadRollups(file_name, rollups);
+	}
+
+	/// <summary>
+	/// Adds a stage to the task files of the storage instance, it sees the bytes before they are compressed.
+	/// </summary>
+	/// <param name="stage"> The stage to add. </param>
+	virtual void AddFileStage(std::shared_ptr<FileStage> stage) override
+	{
+		m_StorageInstance->AddFileStage(std::move(stage));
+	}
+
+	/// <summary>
+	/// Sets the field stage of the storage instance, the fields are encoded before the file is compressed.
+	/// </summary>
+	/// <param name="stage"> The stage to set. </param>
+	/// <returns> True if the stage was set, false if the storage instance already has a field stage. </returns>
+	virtual bool SetFieldStage(std::shared_ptr<FieldStage> stage) override
+	{
+		return m_StorageInstance->SetFieldStage(std::move(stage));
+	}
+
+	/// <summary>
+	/// Gets the number of bytes written by the storage instance, which is the size of the compressed files.
+	/// </summary>
+	/// <returns> The number of bytes written. </returns>
+	virtual uint64_t BytesWritten() const override
+	{
+		return m_StorageInstance->BytesWritten();
+	}
+};
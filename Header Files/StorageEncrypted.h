@@ -1,77 +1,523 @@
 #pragma once
 
 #include "../Header Files/Storage.h"
-#include "../lib/easy-encryption/encryption.h"
+#include "../Header Files/FieldCipher.h"
+#include "../Header Files/ChaCha20.h"
+#include "../Header Files/Crc32.h"
+#include "../Header Files/ThreadPool.h"
+
+#include <random>
+
+/// <summary>
+/// StreamCipherStage class encrypts a whole task file as one stream with <see cref="mrt::ChaCha20"/>, in place of encrypting each field:
+///
+///   header   "DTME", version (u16), header size (u16), nonce (12 bytes), size of the file (u64), CRC-32 of the file (u32)
+///   body     the file XORed with the keystream, from block counter 1 on
+///
+/// Every number is little-endian. The nonce is drawn at random for every write, and the keystream is made in chunks in parallel
+/// on the shared thread pool, as each chunk starts at a counter of its own. The checksum of the file finds a damaged file or a wrong key.
+/// A file that does not start with the magic was written before the stage was added, and is read as it is.
+/// </summary>
+class StreamCipherStage : public FileStage
+{
+public:
+	static constexpr uint16_t s_Version = 1;
+	static constexpr uint16_t s_HeaderSize = 32;
+
+private:
+	static constexpr char s_Magic[4] = { 'D', 'T', 'M', 'E' };
+
+	// The number of bytes each worker encrypts at a time, a whole number of keystream blocks.
+	static constexpr uint64_t s_ChunkSize = 64 * 1024;
+
+	uint8_t m_Key[mrt::ChaCha20::s_KeySize];
+public:
+	/// <summary>
+	/// Initializes a new instance of the <see cref="StreamCipherStage"/> class.
+	/// </summary>
+	/// <param name="key"> The key, any text, which is stretched to the 256 bits of the cipher with the cipher itself. </param>
+	explicit StreamCipherStage(const std::string& key)
+	{
+		uint8_t material[mrt::ChaCha20::s_KeySize] = {};
+		uint8_t nonce[mrt::ChaCha20::s_NonceSize] = {};
+		uint8_t block[mrt::ChaCha20::s_BlockSize];
+
+		for (uint64_t i = 0; i < sizeof(material) && !key.empty(); i++)
+		{
+			material[i] = static_cast<uint8_t>(key[i % key.size()]);
+		}
+
+		mrt::ChaCha20(material, nonce).Block(0, block);
+		std::memcpy(m_Key, block, sizeof(m_Key));
+	}
+
+	/// <summary>
+	/// Encrypts the file.
+	/// </summary>
+	/// <param name="bytes"> The bytes of the file, replaced by the encrypted file. </param>
+	/// <returns> True if the file was encrypted, false if it is too large for the counter of the cipher. </returns>
+	virtual bool Encode(std::string& bytes) override
+	{
+		if (bytes.size() / mrt::ChaCha20::s_BlockSize >= UINT32_MAX)
+			return false;
+
+		uint8_t nonce[mrt::ChaCha20::s_NonceSize];
+		std::random_device random;
+
+		for (uint64_t i = 0; i < sizeof(nonce); i += 4)
+		{
+			uint32_t value = random();
+			std::memcpy(nonce + i, &value, 4);
+		}
+
+		char header[s_HeaderSize] = {};
+		std::memcpy(header, s_Magic, sizeof(s_Magic));
+		PutLittle<uint16_t>(header + 4, s_Version);
+		PutLittle<uint16_t>(header + 6, s_HeaderSize);
+		std::memcpy(header + 8, nonce, sizeof(nonce));
+		PutLittle<uint64_t>(header + 20, bytes.size());
+		PutLittle<uint32_t>(header + 28, mrt::Crc32::Of(bytes.data(), bytes.size()));
+
+		Apply(nonce, &bytes[0], bytes.size());
+
+		bytes.insert(0, header, s_HeaderSize);
+		return true;
+	}
+
+	/// <summary>
+	/// Decrypts the file, a file written before the stage was added is left as it is.
+	/// </summary>
+	/// <param name="bytes"> The stored bytes, replaced by the bytes of the file. </param>
+	/// <returns> True if the file was decrypted, false if it is damaged or was encrypted with another key. </returns>
+	virtual bool Decode(std::string& bytes) override
+	{
+		if (!IsEncoded(bytes))
+			return true;
+
+		if (bytes.size() < s_HeaderSize)
+			return false;
+
+		const char* header = bytes.data();
+		uint16_t version = GetLittle<uint16_t>(header + 4);
+		uint16_t header_size = GetLittle<uint16_t>(header + 6);
+		uint64_t size = GetLittle<uint64_t>(header + 20);
+		uint32_t checksum = GetLittle<uint32_t>(header + 28);
+
+		if (version > s_Version || header_size < s_HeaderSize || header_size > bytes.size() || size != bytes.size() - header_size)
+			return false;
+
+		uint8_t nonce[mrt::ChaCha20::s_NonceSize];
+		std::memcpy(nonce, header + 8, sizeof(nonce));
+
+		bytes.erase(0, header_size);
+		Apply(nonce, &bytes[0], bytes.size());
+
+		return mrt::Crc32::Of(bytes.data(), bytes.size()) == checksum;
+	}
+
+	/// <summary>
+	/// The stage encrypts the fields along with the rest of the file, so they are written as they are.
+	/// </summary>
+	virtual bool CoversFields() const override
+	{
+		return true;
+	}
+
+	/// <summary>
+	/// Checks whether the stored bytes start with the magic of the stage.
+	/// </summary>
+	virtual bool IsEncoded(const std::string& bytes) const override
+	{
+		return bytes.size() >= sizeof(s_Magic) && std::memcmp(bytes.data(), s_Magic, sizeof(s_Magic)) == 0;
+	}
+
+private:
+	/// <summary>
+	/// XORs the bytes with the keystream of the nonce, in chunks on the shared thread pool.
+	/// </summary>
+	void Apply(const uint8_t* nonce, char* data, uint64_t size) const
+	{
+		mrt::ChaCha20 cipher(m_Key, nonce);
+		uint64_t chunk_count = (size + s_ChunkSize - 1) / s_ChunkSize;
+
+		ThreadPool::Shared().ParallelFor(chunk_count, [&cipher, data, size](uint64_t i)
+			{
+				uint64_t offset = i * s_ChunkSize;
+
+				cipher.Apply(data + offset, std::min<uint64_t>(s_ChunkSize, size - offset), static_cast<uint32_t>(1 + offset / mrt::ChaCha20::s_BlockSize));
+			});
+	}
+
+	template <typename _Ty>
+	static void PutLittle(char* position, _Ty value)
+	{
+		for (size_t i = 0; i < sizeof(_Ty); i++)
+		{
+			position[i] = static_cast<char>(static_cast<uint64_t>(value) >> (8 * i));
+		}
+	}
+
+	template <typename _Ty>
+	static _Ty GetLittle(const char* position)
+	{
+		uint64_t value = 0;
+
+		for (size_t i = 0; i < sizeof(_Ty); i++)
+		{
+			value |= static_cast<uint64_t>(static_cast<unsigned char>(position[i])) << (8 * i);
+		}
+
+		return static_cast<_Ty>(value);
+	}
+};
 
 /// <summary>
 /// StorageEncrypted class is a decorator class that encrypts and decrypts the data before writing and reading it from the storage.
+/// The tasks are encrypted in one of two modes:
+///
+///   Fields   each text field is encrypted on its own by the storage instance as it writes the field into the file, through a field stage,
+///            so saving neither copies the tasks nor builds a string for each encrypted field
+///   Stream   the whole task file is encrypted as one stream by a <see cref="StreamCipherStage"/>, which is faster and leaves the file
+///            its size, as the fields are not Base64 encoded. A file stage runs on whole files, so every save writes the file in full
+///
+/// The stream mode reads the task files written with their fields encrypted, so a task store can move to it. The other files of
+/// a task store are not task files, the tasks of the recurrence rules are encrypted per field in both modes.
+/// A storage instance that already has a field stage, such as another StorageEncrypted, is handed encrypted copies of the tasks instead.
+/// The tasks are split into chunks that are encrypted and decrypted in parallel on the shared thread pool.
 /// </summary>
 class StorageEncrypted : public Storage
 {
+public:
+	/// <summary>
+	/// How the task files are encrypted, see <see cref="StorageEncrypted"/>.
+	/// </summary>
+	enum class Mode
+	{
+		Fields,
+		Stream
+	};
+
 private:
-	std::string m_Key;
+	/// <summary>
+	/// CipherStage class encrypts each field as the storage instance writes it, and decrypts it once read.
+	/// </summary>
+	class CipherStage : public FieldStage
+	{
+	public:
+		mrt::FieldCipher cipher;
+
+		explicit CipherStage(const std::string& key)
+			: cipher(key)
+		{
+		}
+
+		virtual uint64_t EncodedSize(uint64_t size) const override
+		{
+			return mrt::FieldCipher::EncryptedSize(size);
+		}
+
+		virtual void Encode(std::string_view field, char* output) const override
+		{
+			cipher.Encrypt(field, output);
+		}
+
+		virtual void Decode(std::string& field) const override
+		{
+			cipher.Decrypt(field);
+		}
+	};
+
 	std::shared_ptr<Storage> m_StorageInstance;
+	std::shared_ptr<CipherStage> m_Stage;
+
+	// Whether the storage instance encrypts the fields of the task files itself, through the stage.
+	bool m_IsStaged;
 public:
 	/// <summary>
 	/// Constructor for the StorageEncrypted class.
 	/// Generates a key based on the hash code of the class type and initializes the storage instance.
 	/// </summary>
 	/// <param name="storage_instance"></param>
-	StorageEncrypted(std::shared_ptr<Storage> storage_instance)
-		: m_StorageInstance(storage_instance)
+	/// <param name="mode"> How the task files are encrypted. </param>
+	StorageEncrypted(std::shared_ptr<Storage> storage_instance, Mode mode = Mode::Fields)
+		: m_StorageInstance(storage_instance), m_Stage(std::make_shared<CipherStage>(GenerateKey())),
+		m_IsStaged(m_StorageInstance->SetFieldStage(m_Stage))
 	{
-		std::string key = std::to_string(typeid(this).hash_code());
-
-		for (char& c : key)
+		// The field stage stays set in the stream mode, to read the files that were written with their fields encrypted.
+		if (mode == Mode::Stream)
 		{
-			c = (char)('a' + (c - '0'));
+			m_StorageInstance->AddFileStage(std::make_shared<StreamCipherStage>(GenerateKey()));
 		}
-
-		m_Key = key;
 	}
 
 	/// <summary>
-	/// First encrypts all the data that was passed in.
-	/// Then writes the encrypted data to the storage, using the storage instance.
+	/// Writes the tasks to the storage using the storage instance, which encrypts each field as it writes it.
 	/// </summary>
 	/// <param name="file_name"> The name of the file to write to. </param>
 	/// <param name="tasks"> The tasks to encrypt/write to the file. </param>
 	/// <returns> True if the write operation was successful, false otherwise. </returns>
 	virtual bool Write(const std::string& file_name, const mrt::Vector<Task>& tasks) override
 	{
+		if (m_IsStaged)
+			return m_StorageInstance->Write(file_name, tasks);
+
 		mrt::Vector<Task> encrypted_tasks(tasks);
 
-		for (Task& task : encrypted_tasks)
-		{
-			task.title = encrypt(task.title, m_Key);
-			task.description = encrypt(task.description, m_Key);
-			task.start_time = encrypt(task.start_time, m_Key);
-			task.end_time = encrypt(task.end_time, m_Key);
-		}
+		ForEachTask(encrypted_tasks, 0, [this](Task& task)
+			{
+				EncryptTask(task);
+			});
 
 		return m_StorageInstance->Write(file_name, encrypted_tasks);
 	}
 
 	/// <summary>
-	/// Reads the data from the storage using the storage instance.
-	/// Then decrypts the data that was read.
+	/// Reads the data from the storage using the storage instance, which decrypts the fields in place once read.
 	/// </summary>
 	/// <param name="file_name"> The name of the file to read from. </param>
 	/// <param name="tasks"> The tasks to read/decrypt from the file. </param>
 	/// <returns> True if the read operation was successful, false otherwise. </returns>
 	virtual bool Read(const std::string& file_name, mrt::Vector<Task>& tasks) override
 	{
+		if (m_IsStaged)
+			return m_StorageInstance->Read(file_name, tasks);
+
+		uint64_t size = tasks.Size();
+
 		if (!m_StorageInstance->Read(file_name, tasks))
 			return false;
 
-		for (Task& task : tasks)
+		ForEachTask(tasks, size, [this](Task& task)
+			{
+				DecryptTask(task);
+			});
+
+		return true;
+	}
+
+	/// <summary>
+	/// Reads the data from the storage in batches using the storage instance.
+	/// Each batch is decrypted before it is handed over, so the first tasks are usable before the rest are decrypted.
+	/// </summary>
+	/// <param name="file_name"> The name of the file to read from. </param>
+	/// <param name="batch_size"> The number of tasks in each batch. </param>
+	/// <param name="on_batch"> Called with each batch of decrypted tasks. </param>
+	/// <returns> True if the read operation was successful, false otherwise. </returns>
+	virtual bool Read(const std::string& file_name, uint64_t batch_size, const std::function<void(mrt::Vector<Task>&)>& on_batch) override
+	{
+		if (m_IsStaged)
+			return m_StorageInstance->Read(file_name, batch_size, on_batch);
+
+		return m_StorageInstance->Read(file_name, batch_size, [this, &on_batch](mrt::Vector<Task>& batch)
+			{
+				ForEachTask(batch, 0, [this](Task& task)
+					{
+						DecryptTask(task);
+					});
+
+				on_batch(batch);
+			});
+	}
+
+	/// <summary>
+	/// Writes the changed tasks using the storage instance, which encrypts each field as it writes it.
+	/// Without the stage, the changed tasks are encrypted first, and every task only if the storage instance has to write the whole file.
+	/// </summary>
+	/// <param name="file_name"> The name of the file to write to. </param>
+	/// <param name="delta"> The tasks added, edited and removed since the file was last written. </param>
+	/// <param name="all_tasks"> Gets every task, for when the whole file has to be written. </param>
+	/// <returns> True if the changes were written, false otherwise. </returns>
+	virtual bool WriteDelta(const std::string& file_name, const TaskDelta& delta, const std::function<mrt::Vector<Task>()>& all_tasks) override
+	{
+		if (m_IsStaged)
+			return m_StorageInstance->WriteDelta(file_name, delta, all_tasks);
+
+		TaskDelta encrypted_delta(delta);
+
+		for (Task& task : encrypted_delta.changed)
+		{
+			EncryptTask(task);
+		}
+
+		return m_StorageInstance->WriteDelta(file_name, encrypted_delta, [this, &all_tasks]()
+			{
+				mrt::Vector<Task> encrypted_tasks = all_tasks();
+
+				ForEachTask(encrypted_tasks, 0, [this](Task& task)
+					{
+						EncryptTask(task);
+					});
+
+				return encrypted_tasks;
+			});
+	}
+
+	/// <summary>
+	/// Encrypts the tasks of the recurrence rules and of the edited occurrences, then writes them using the storage instance.
+	/// </summary>
+	/// <param name="file_name"> The name of the task store. </param>
+	/// <param name="rules"> The recurrence rules. </param>
+	/// <param name="exceptions"> The exceptions of single occurrences. </param>
+	/// <returns> True if the write operation was successful, false otherwise. </returns>
+	virtual bool WriteRecurrences(const std::string& file_name, const mrt::Vector<RecurrenceRule>& rules, const mrt::Vector<RecurrenceException>& exceptions) override
+	{
+		mrt::Vector<RecurrenceRule> encrypted_rules(rules);
+		mrt::Vector<RecurrenceException> encrypted_exceptions(exceptions);
+
+		for (RecurrenceRule& rule : encrypted_rules)
 		{
-			task.title = decrypt(task.title, m_Key);
-			task.description = decrypt(task.description, m_Key);
-			task.start_time = decrypt(task.start_time, m_Key);
-			task.end_time = decrypt(task.end_time, m_Key);
+			EncryptTask(rule.task);
+		}
+
+		for (RecurrenceException& exception : encrypted_exceptions)
+		{
+			if (exception.is_edited)
+			{
+				EncryptTask(exception.task);
+			}
+		}
+
+		return m_StorageInstance->WriteRecurrences(file_name, encrypted_rules, encrypted_exceptions);
+	}
+
+	/// <summary>
+	/// Reads the recurrence rules using the storage instance, then decrypts their tasks.
+	/// </summary>
+	/// <param name="file_name"> The name of the task store. </param>
+	/// <param name="rules"> The recurrence rules that were read. </param>
+	/// <param name="exceptions"> The exceptions that were read. </param>
+	/// <returns> True if the read operation was successful, false otherwise. </returns>
+	virtual bool ReadRecurrences(const std::string& file_name, mrt::Vector<RecurrenceRule>& rules, mrt::Vector<RecurrenceException>& exceptions) override
+	{
+		if (!m_StorageInstance->ReadRecurrences(file_name, rules, exceptions))
+			return false;
+
+		for (RecurrenceRule& rule : rules)
+		{
+			DecryptTask(rule.task);
+		}
+
+		for (RecurrenceException& exception : exceptions)
+		{
+			if (exception.is_edited)
+			{
+				DecryptTask(exception.task);
+			}
 		}
 
 		return true;
 	}
+
+	/// <summary>
+	/// Writes the dependencies using the storage instance, they only hold task ids so they are not encrypted.
+	/// </summary>
+	/// <param name="file_name"> The name of the task store. </param>
+	/// <param name="dependencies"> The dependencies. </param>
+	/// <returns> True if the write operation was successful, false otherwise. </returns>
+	virtual bool WriteDependencies(const std::string& file_name, const mrt::Vector<TaskDependency>& dependencies) override
+	{
+		return m_StorageInstance->WriteDependencies(file_name, dependencies);
+	}
+
+	/// <summary>
+	/// Reads the dependencies using the storage instance.
+	/// </summary>
+	/// <param name="file_name"> The name of the task store. </param>
+	/// <param name="dependencies"> The dependencies that were read. </param>
+	/// <returns> True if the read operation was successful, false otherwise. </returns>
+	virtual bool ReadDependencies(const std::string& file_name, mrt::Vector<TaskDependency>& dependencies) override
+	{
+		return m_StorageInstance->ReadDependencies(file_name, dependencies);
+	}
+
+	/// <summary>
+	/// Writes the statistics rollups using the storage instance, they only hold counts so they are not encrypted.
+	/// </summary>
+	/// <param name="file_name"> The name of the task store. </param>
+	/// <param name="rollups"> The rollups, one per day. </param>
+	/// <returns> True if the write operation was successful, false otherwise. </returns>
+	virtual bool WriteRollups(const std::string& file_name, const mrt::Vector<DayRollup>& rollups) override
+	{
+		return m_StorageInstance->WriteRollups(file_name, rollups);
+	}
+
+	/// <summary>
+	/// Reads the statistics rollups using the storage instance.
+	/// </summary>
+	/// <param name="file_name"> The name of the task store. </param>
+	/// <param name="rollups"> The rollups that were read. </param>
+	/// <returns> True if the read operation was successful, false otherwise. </returns>
+	virtual bool ReadRollups(const std::string& file_name, mrt::Vector<DayRollup>& rollups) override
+	{
+		return m_StorageInstance->ReadRollups(file_name, rollups);
+	}
+
+	/// <summary>
+	/// Adds a stage to the task files of the storage instance, the stage sees the bytes the encrypted tasks are stored as.
+	/// </summary>
+	/// <param name="stage"> The stage to add. </param>
+	virtual void AddFileStage(std::shared_ptr<FileStage> stage) override
+	{
+		m_StorageInstance->AddFileStage(std::move(stage));
+	}
+
+	/// <summary>
+	/// Sets the field stage of the storage instance, which fails if it runs the stage of this storage already.
+	/// </summary>
+	/// <param name="stage"> The stage to set. </param>
+	/// <returns> True if the stage was set, false if the storage instance already has a field stage. </returns>
+	virtual bool SetFieldStage(std::shared_ptr<FieldStage> stage) override
+	{
+		return m_StorageInstance->SetFieldStage(std::move(stage));
+	}
+
+	/// <summary>
+	/// Gets the number of bytes written by the storage instance.
+	/// </summary>
+	/// <returns> The number of bytes written. </returns>
+	virtual uint64_t BytesWritten() const override
+	{
+		return m_StorageInstance->BytesWritten();
+	}
+
+private:
+	/// <summary>
+	/// Generates the key from the hash code of the class type, so every instance encrypts with the same key.
+	/// </summary>
+	/// <returns> The key. </returns>
+	static std::string GenerateKey()
+	{
+		std::string key = std::to_string(typeid(StorageEncrypted*).hash_code());
+
+		for (char& c : key)
+		{
+			c = (char)('a' + (c - '0'));
+		}
+
+		return key;
+	}
+
+	/// <summary>
+	/// Encrypts all the fields of a task that are encrypted in the storage.
+	/// </summary>
+	/// <param name="task"> The task to encrypt. </param>
+	void EncryptTask(Task& task) const
+	{
+		m_Stage->cipher.Encrypt(task.title);
+		m_Stage->cipher.Encrypt(task.description);
+		m_Stage->cipher.Encrypt(task.start_time);
+		m_Stage->cipher.Encrypt(task.end_time);
+	}
+
+	/// <summary>
+	/// Decrypts all the encrypted fields of a task.
+	/// </summary>
+	/// <param name="task"> The task to decrypt. </param>
+	void DecryptTask(Task& task) const
+	{
+		m_Stage->cipher.Decrypt(task.title);
+		m_Stage->cipher.Decrypt(task.description);
+		m_Stage->cipher.Decrypt(task.start_time);
+		m_Stage->cipher.Decrypt(task.end_time);
+	}
 };
\ No newline at end of file
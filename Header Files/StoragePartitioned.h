@@ -0,0 +1,537 @@
+#pragma once
+
+#include "../Header Files/Storage.h"
+#include "../Header Files/Algorithm.h"
+
+#include <mutex>
+#include <filesystem>
+
+/// <summary>
+/// A struct that describes a single day of stored tasks, as listed in the manifest.
+/// </summary>
+struct StoragePartition
+{
+	StoragePartition() = default;
+
+	StoragePartition(const std::string& date, uint64_t task_count)
+		: date{ date }, task_count{ task_count }
+	{
+	}
+
+	std::string date{ "" };
+	uint64_t task_count{ 0 };
+};
+
+/// <summary>
+/// StoragePartitioned class is a decorator class that splits the stored tasks into one file per day.
+/// Each day is written to its own partition file by the storage instance, a small manifest lists the stored days.
+/// The manifest also keeps the next task id of the store, so the ids of every day are unique and a day's ids can be given out before the day is read.
+/// Reading and writing without a date uses the active day, which is set when the storage is created and moved on to the next day with <see cref="SetActiveDate"/>.
+/// Older days are only read when they are asked for.
+/// </summary>
+class StoragePartitioned : public Storage
+{
+private:
+	std::shared_ptr<Storage> m_StorageInstance;
+	std::string m_ActiveDate;
+
+	// Also guards the active date, which is moved on while other threads read and write.
+	mutable std::mutex m_ManifestMutex;
+	std::string m_ManifestName;
+	mrt::Vector<StoragePartition> m_Manifest;
+
+	// One past the highest task id given out in the store, 0 if it is not known.
+	uint64_t m_NextId{ 0 };
+public:
+	/// <summary>
+	/// Constructor for the StoragePartitioned class.
+	/// The active day is set to the current date.
+	/// </summary>
+	/// <param name="storage_instance"> The storage used to read and write each partition. </param>
+	StoragePartitioned(std::shared_ptr<Storage> storage_instance)
+		: m_StorageInstance(storage_instance), m_ActiveDate(Today())
+	{
+	}
+
+	/// <summary>
+	/// Writes the tasks to the partition of the active day.
+	/// </summary>
+	/// <param name="file_name"> The name of the task store. </param>
+	/// <param name="tasks"> The tasks to write. </param>
+	/// <returns> True if the write operation was successful, false otherwise. </returns>
+	virtual bool Write(const std::string& file_name, const mrt::Vector<Task>& tasks) override
+	{
+		return WriteDay(file_name, GetActiveDate(), tasks);
+	}
+
+	/// <summary>
+	/// Writes the changed tasks to the partition of the active day.
+	/// A day that is not in the manifest yet, such as a store that has not been partitioned, is written in full.
+	/// </summary>
+	/// <param name="file_name"> The name of the task store. </param>
+	/// <param name="delta"> The tasks added, edited and removed since the partition was last written. </param>
+	/// <param name="all_tasks"> Gets every task of the active day, for when the whole partition has to be written. </param>
+	/// <returns> True if the changes were written, false otherwise. </returns>
+	virtual bool WriteDelta(const std::string& file_name, const TaskDelta& delta, const std::function<mrt::Vector<Task>()>& all_tasks) override
+	{
+		std::string date = GetActiveDate();
+
+		if (!HasPartition(file_name, date))
+			return WriteDay(file_name, date, all_tasks());
+
+		if (!m_StorageInstance->WriteDelta(file_name + "-" + date, delta, all_tasks))
+			return false;
+
+		std::lock_guard<std::mutex> lock(m_ManifestMutex);
+
+		StoragePartition* partition = FindPartitionLocked(file_name, date);
+
+		if (partition == nullptr || partition->task_count == delta.task_count)
+			return true;
+
+		partition->task_count = delta.task_count;
+		return WriteManifest();
+	}
+
+	/// <summary>
+	/// Reads the tasks from the partition of the active day.
+	/// </summary>
+	/// <param name="file_name"> The name of the task store. </param>
+	/// <param name="tasks"> The tasks that were read. </param>
+	/// <returns> True if the read operation was successful, false otherwise. </returns>
+	virtual bool Read(const std::string& file_name, mrt::Vector<Task>& tasks) override
+	{
+		return ReadDay(file_name, GetActiveDate(), tasks);
+	}
+
+	/// <summary>
+	/// Reads the tasks from the partition of the active day in batches.
+	/// If the store has not been partitioned yet, the tasks are read from the single file it used before.
+	/// </summary>
+	/// <param name="file_name"> The name of the task store. </param>
+	/// <param name="batch_size"> The number of tasks in each batch. </param>
+	/// <param name="on_batch"> Called with each batch of tasks. </param>
+	/// <returns> True if the read operation was successful, false otherwise. </returns>
+	virtual bool Read(const std::string& file_name, uint64_t batch_size, const std::function<void(mrt::Vector<Task>&)>& on_batch) override
+	{
+		return m_StorageInstance->Read(PartitionFileName(file_name, GetActiveDate()), batch_size, on_batch);
+	}
+
+	/// <summary>
+	/// Writes the recurrence rules, they are shared by every day so they are not partitioned.
+	/// </summary>
+	/// <param name="file_name"> The name of the task store. </param>
+	/// <param name="rules"> The recurrence rules. </param>
+	/// <param name="exceptions"> The exceptions of single occurrences. </param>
+	/// <returns> True if the write operation was successful, false otherwise. </returns>
+	virtual bool WriteRecurrences(const std::string& file_name, const mrt::Vector<RecurrenceRule>& rules, const mrt::Vector<RecurrenceException>& exceptions) override
+	{
+		return m_StorageInstance->WriteRecurrences(file_name, rules, exceptions);
+	}
+
+	/// <summary>
+	/// Reads the recurrence rules.
+	/// </summary>
+	/// <param name="file_name"> The name of the task store. </param>
+	/// <param name="rules"> The recurrence rules that were read. </param>
+	/// <param name="exceptions"> The exceptions that were read. </param>
+	/// <returns> True if the read operation was successful, false otherwise. </returns>
+	virtual bool ReadRecurrences(const std::string& file_name, mrt::Vector<RecurrenceRule>& rules, mrt::Vector<RecurrenceException>& exceptions) override
+	{
+		return m_StorageInstance->ReadRecurrences(file_name, rules, exceptions);
+	}
+
+	/// <summary>
+	/// Writes the dependencies, which are not partitioned. The task ids are unique across the days of the store, see <see cref="GetNextId"/>,
+	/// so an edge never attaches to a task of another day that reuses an id.
+	/// </summary>
+	/// <param name="file_name"> The name of the task store. </param>
+	/// <param name="dependencies"> The dependencies. </param>
+	/// <returns> True if the write operation was successful, false otherwise. </returns>
+	virtual bool WriteDependencies(const std::string& file_name, const mrt::Vector<TaskDependency>& dependencies) override
+	{
+		return m_StorageInstance->WriteDependencies(file_name, dependencies);
+	}
+
+	/// <summary>
+	/// Reads the dependencies.
+	/// </summary>
+	/// <param name="file_name"> The name of the task store. </param>
+	/// <param name="dependencies"> The dependencies that were read. </param>
+	/// <returns> True if the read operation was successful, false otherwise. </returns>
+	virtual bool ReadDependencies(const std::string& file_name, mrt::Vector<TaskDependency>& dependencies) override
+	{
+		return m_StorageInstance->ReadDependencies(file_name, dependencies);
+	}
+
+	/// <summary>
+	/// Writes the statistics rollups, they hold one entry per day so they are not partitioned.
+	/// </summary>
+	/// <param name="file_name"> The name of the task store. </param>
+	/// <param name="rollups"> The rollups, one per day. </param>
+	/// <returns> True if the write operation was successful, false otherwise. </returns>
+	virtual bool WriteRollups(const std::string& file_name, const mrt::Vector<DayRollup>& rollups) override
+	{
+		return m_StorageInstance->WriteRollups(file_name, rollups);
+	}
+
+	/// <summary>
+	/// Reads the statistics rollups.
+	/// </summary>
+	/// <param name="file_name"> The name of the task store. </param>
+	/// <param name="rollups"> The rollups that were read. </param>
+	/// <returns> True if the read operation was successful, false otherwise. </returns>
+	virtual bool ReadRollups(const std::string& file_name, mrt::Vector<DayRollup>& rollups) override
+	{
+		return m_StorageInstance->ReadRollups(file_name, rollups);
+	}
+
+	/// <summary>
+	/// Writes the tasks to the partition of the specified day, and records the day in the manifest.
+	/// </summary>
+	/// <param name="file_name"> The name of the task store. </param>
+	/// <param name="date"> The date of the partition, formatted as dd-mm-yyyy. </param>
+	/// <param name="tasks"> The tasks to write. </param>
+	/// <returns> True if the write operation was successful, false otherwise. </returns>
+	bool WriteDay(const std::string& file_name, const std::string& date, const mrt::Vector<Task>& tasks)
+	{
+		if (!m_StorageInstance->Write(file_name + "-" + date, tasks))
+			return false;
+
+		std::lock_guard<std::mutex> lock(m_ManifestMutex);
+
+		StoragePartition* partition = FindPartitionLocked(file_name, date);
+
+		if (partition != nullptr)
+		{
+			partition->task_count = tasks.Size();
+		}
+		else
+		{
+			m_Manifest.EmplaceBack(date, tasks.Size());
+		}
+
+		return WriteManifest();
+	}
+
+	/// <summary>
+	/// Reads the tasks from the partition of the specified day.
+	/// </summary>
+	/// <param name="file_name"> The name of the task store. </param>
+	/// <param name="date"> The date of the partition, formatted as dd-mm-yyyy. </param>
+	/// <param name="tasks"> The tasks that were read. </param>
+	/// <returns> True if the read operation was successful, false otherwise. </returns>
+	bool ReadDay(const std::string& file_name, const std::string& date, mrt::Vector<Task>& tasks)
+	{
+		return m_StorageInstance->Read(PartitionFileName(file_name, date), tasks);
+	}
+
+	/// <summary>
+	/// Gets the days that have been stored, in the order they were first written.
+	/// </summary>
+	/// <param name="file_name"> The name of the task store. </param>
+	/// <returns> The stored days and the number of tasks in each. </returns>
+	mrt::Vector<StoragePartition> GetPartitions(const std::string& file_name)
+	{
+		std::lock_guard<std::mutex> lock(m_ManifestMutex);
+
+		LoadManifest(file_name);
+
+		mrt::Vector<StoragePartition> partitions;
+
+		for (const StoragePartition& partition : m_Manifest)
+		{
+			partitions.PushBack(partition);
+		}
+
+		return partitions;
+	}
+
+	/// <summary>
+	/// Gets the next task id of the store, one past the highest id given out on any day.
+	/// A store written before the next id was kept, or whose manifest was damaged, has it worked out once from the tasks of every stored day.
+	/// </summary>
+	/// <param name="file_name"> The name of the task store. </param>
+	/// <returns> The next task id, or 0 if the store has no partitions yet. </returns>
+	uint64_t GetNextId(const std::string& file_name)
+	{
+		std::lock_guard<std::mutex> lock(m_ManifestMutex);
+
+		LoadManifest(file_name);
+
+		if (m_NextId != 0 || m_Manifest.Empty())
+			return m_NextId;
+
+		uint64_t next_id = 1;
+
+		for (const StoragePartition& partition : m_Manifest)
+		{
+			mrt::Vector<Task> tasks;
+			m_StorageInstance->Read(file_name + "-" + partition.date, tasks);
+
+			for (const Task& task : tasks)
+			{
+				next_id = std::max(next_id, task.id + 1);
+			}
+		}
+
+		m_NextId = next_id;
+		WriteManifest();
+
+		return m_NextId;
+	}
+
+	/// <summary>
+	/// Records the next task id of the store, it has to be written before the tasks that have the ids given out.
+	/// The next id never goes back, a lower id than the one recorded is ignored.
+	/// </summary>
+	/// <param name="file_name"> The name of the task store. </param>
+	/// <param name="next_id"> One past the highest id given out. </param>
+	/// <returns> True if the next id is recorded, false if the manifest could not be written. </returns>
+	bool SetNextId(const std::string& file_name, uint64_t next_id)
+	{
+		std::lock_guard<std::mutex> lock(m_ManifestMutex);
+
+		LoadManifest(file_name);
+
+		if (next_id <= m_NextId)
+			return true;
+
+		m_NextId = next_id;
+		return WriteManifest();
+	}
+
+	/// <summary>
+	/// Gets the active day, the day that reading and writing without a date use.
+	/// </summary>
+	/// <returns> The active date, formatted as dd-mm-yyyy. </returns>
+	std::string GetActiveDate() const
+	{
+		std::lock_guard<std::mutex> lock(m_ManifestMutex);
+
+		return m_ActiveDate;
+	}
+
+	/// <summary>
+	/// Moves the active day on, such as once the clock has passed midnight. The partition of the day that ended is left as it is.
+	/// </summary>
+	/// <param name="date"> The new active day, formatted as dd-mm-yyyy. </param>
+	void SetActiveDate(const std::string& date)
+	{
+		std::lock_guard<std::mutex> lock(m_ManifestMutex);
+
+		m_ActiveDate = date;
+	}
+
+	/// <summary>
+	/// Adds a stage to the partition files of the storage instance, the manifest is not passed through it.
+	/// </summary>
+	/// <param name="stage"> The stage to add. </param>
+	virtual void AddFileStage(std::shared_ptr<FileStage> stage) override
+	{
+		m_StorageInstance->AddFileStage(std::move(stage));
+	}
+
+	/// <summary>
+	/// Sets the field stage of the storage instance, which runs it on the fields of each partition.
+	/// </summary>
+	/// <param name="stage"> The stage to set. </param>
+	/// <returns> True if the stage was set, false if the storage instance already has a field stage. </returns>
+	virtual bool SetFieldStage(std::shared_ptr<FieldStage> stage) override
+	{
+		return m_StorageInstance->SetFieldStage(std::move(stage));
+	}
+
+	/// <summary>
+	/// Gets the number of bytes written to the partitions and the manifest.
+	/// </summary>
+	/// <returns> The number of bytes written. </returns>
+	virtual uint64_t BytesWritten() const override
+	{
+		return m_StorageInstance->BytesWritten() + Storage::BytesWritten();
+	}
+
+	/// <summary>
+	/// Gets the current date in the format used for the partitions.
+	/// </summary>
+	/// <returns> The current date, formatted as dd-mm-yyyy. </returns>
+	static std::string Today()
+	{
+		return mrt::time::LocalDate(std::chrono::system_clock::now());
+	}
+
+private:
+	/// <summary>
+	/// Gets the file name of a day's partition.
+	/// Before the first partition is written there is no manifest, the active day then reads the single file used by older versions.
+	/// </summary>
+	/// <param name="file_name"> The name of the task store. </param>
+	/// <param name="date"> The date of the partition. </param>
+	/// <returns> The name of the file holding the day's tasks. </returns>
+	std::string PartitionFileName(const std::string& file_name, const std::string& date)
+	{
+		std::lock_guard<std::mutex> lock(m_ManifestMutex);
+
+		LoadManifest(file_name);
+
+		if (m_Manifest.Empty() && date == m_ActiveDate)
+			return file_name;
+
+		return file_name + "-" + date;
+	}
+
+	/// <summary>
+	/// Checks whether a day is listed in the manifest.
+	/// </summary>
+	bool HasPartition(const std::string& file_name, const std::string& date)
+	{
+		std::lock_guard<std::mutex> lock(m_ManifestMutex);
+
+		return FindPartitionLocked(file_name, date) != nullptr;
+	}
+
+	/// <summary>
+	/// Finds the entry of a day in the manifest, the manifest lock has to be held.
+	/// </summary>
+	/// <returns> The entry of the day, or null if the day is not in the manifest. </returns>
+	StoragePartition* FindPartitionLocked(const std::string& file_name, const std::string& date)
+	{
+		LoadManifest(file_name);
+
+		auto partition = mrt::FindIf(m_Manifest.begin(), m_Manifest.end(), [&date](const StoragePartition& partition)->bool
+			{
+				return partition.date == date;
+			});
+
+		return partition != m_Manifest.end() ? &*partition : nullptr;
+	}
+
+	/// <summary>
+	/// Reads the manifest of the task store, if it has not been read already.
+	/// A damaged manifest is built again from the partition files, see <see cref="RebuildManifest"/>.
+	/// </summary>
+	/// <param name="file_name"> The name of the task store. </param>
+	void LoadManifest(const std::string& file_name)
+	{
+		if (m_ManifestName == file_name + "-manifest")
+			return;
+
+		m_ManifestName = file_name + "-manifest";
+		m_Manifest.Clear();
+		m_NextId = 0;
+
+		if (!std::filesystem::exists(GetPath(m_ManifestName)))
+			return;
+
+		mrt::XML_Document doc;
+
+		if (!ReadSideFile(GetPath(m_ManifestName), doc))
+		{
+			RebuildManifest(file_name);
+			return;
+		}
+
+		for (mrt::XML_Node& node : doc.GetRoot().GetAllChildren())
+		{
+			if (node.GetName() == "next-id")
+			{
+				if (!ParseNumber(node.GetValue(), m_NextId))
+				{
+					RebuildManifest(file_name);
+					return;
+				}
+
+				continue;
+			}
+
+			uint64_t task_count = 0;
+
+			if (node.GetChildCount() < 2 || mrt::time::ParseDate(node.GetChild(0).GetValue()) < 0 ||
+				!ParseNumber(node.GetChild(1).GetValue(), task_count))
+			{
+				RebuildManifest(file_name);
+				return;
+			}
+
+			m_Manifest.EmplaceBack(node.GetChild(0).GetValue(), task_count);
+		}
+	}
+
+	/// <summary>
+	/// Builds the manifest again from the partition files of the task store and writes it.
+	/// Without it the active day would be read from the file used before partitioning, and its partition written over on the next save.
+	/// The number of tasks of each day is not known until the day is written again, so it is listed as 0, and the next id is worked out again.
+	/// </summary>
+	/// <param name="file_name"> The name of the task store. </param>
+	void RebuildManifest(const std::string& file_name)
+	{
+		std::string prefix = file_name + "-";
+		std::filesystem::path directory = std::filesystem::path(GetPath(file_name)).parent_path();
+		std::error_code error;
+
+		m_Manifest.Clear();
+		m_NextId = 0;
+
+		for (const auto& entry : std::filesystem::directory_iterator(directory, error))
+		{
+			std::string name = entry.path().stem().string();
+
+			if (name.size() != prefix.size() + 10 || name.compare(0, prefix.size(), prefix) != 0)
+				continue;
+
+			std::string date = name.substr(prefix.size());
+
+			if (mrt::time::ParseDate(date) < 0)
+				continue;
+
+			bool is_listed = mrt::FindIf(m_Manifest.begin(), m_Manifest.end(), [&date](const StoragePartition& partition)->bool
+				{
+					return partition.date == date;
+				}) != m_Manifest.end();
+
+			if (!is_listed)
+			{
+				m_Manifest.EmplaceBack(date, 0);
+			}
+		}
+
+		mrt::Sort(m_Manifest.begin(), m_Manifest.end(), [](const StoragePartition& a, const StoragePartition& b)->bool
+			{
+				return mrt::time::ParseDate(a.date) < mrt::time::ParseDate(b.date);
+			});
+
+		WriteManifest();
+	}
+
+	/// <summary>
+	/// Writes the manifest of the task store.
+	/// </summary>
+	/// <returns> True if the manifest was written, false otherwise. </returns>
+	bool WriteManifest()
+	{
+		mrt::XML_Node root("daily-tasks-manifest");
+
+		if (m_NextId != 0)
+		{
+			root.AddChild(mrt::XML_Node("next-id", std::to_string(m_NextId)));
+		}
+
+		for (const StoragePartition& partition : m_Manifest)
+		{
+			mrt::XML_Node partition_node("partition");
+
+			partition_node.AddChild(mrt::XML_Node("date", partition.date));
+			partition_node.AddChild(mrt::XML_Node("tasks", std::to_string(partition.task_count)));
+
+			root.AddChild(partition_node);
+		}
+
+		mrt::XML_Document doc(root, "1.0");
+
+		if (doc.WriteDocument(GetPath(m_ManifestName), doc) != mrt::XML_Document_FileError::SUCCESS)
+			return false;
+
+		CountWritten(GetPath(m_ManifestName));
+		return true;
+	}
+};
\ No newline at end of file
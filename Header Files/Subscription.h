@@ -0,0 +1,435 @@
+#pragma once
+
+#include "../Header Files/Task.h"
+#include "../Header Files/Time.h"
+#include "../Header Files/Observer.h"
+
+#include <vector>
+#include <cstdint>
+#include <algorithm>
+#include <unordered_map>
+#include <unordered_set>
+
+/// <summary>
+/// The parts of a task that a change can affect, used as a bit mask.
+/// </summary>
+namespace TaskField
+{
+    constexpr uint32_t Title = 1 << 0;
+    constexpr uint32_t Description = 1 << 1;
+    constexpr uint32_t StartTime = 1 << 2;
+    constexpr uint32_t EndTime = 1 << 3;
+    constexpr uint32_t Completed = 1 << 4;
+    constexpr uint32_t Added = 1 << 5;
+    constexpr uint32_t Removed = 1 << 6;
+
+    constexpr uint32_t Count = 7;
+    constexpr uint32_t All = (1 << Count) - 1;
+}
+
+/// <summary>
+/// Describes a change made to the tasks, used to decide which subscriptions are notified.
+/// A change that affects every task, such as an undo, has no single task and matches every subscription.
+/// </summary>
+struct TaskChange
+{
+    /// <summary>
+    /// Creates a change that affects every task.
+    /// </summary>
+    /// <returns> The change. </returns>
+    static TaskChange Everything()
+    {
+        TaskChange change;
+        change.fields = TaskField::All;
+        change.affects_all = true;
+        return change;
+    }
+
+    /// <summary>
+    /// Creates a change to a single task, the fields that changed are found by comparing the two versions.
+    /// </summary>
+    /// <param name="before"> The task before the change. </param>
+    /// <param name="after"> The task after the change. </param>
+    /// <returns> The change. </returns>
+    static TaskChange Modified(const Task& before, const Task& after)
+    {
+        TaskChange change;
+        change.id = after.id;
+        change.before = before;
+        change.after = after;
+        change.fields =
+            (before.title != after.title ? TaskField::Title : 0) |
+            (before.description != after.description ? TaskField::Description : 0) |
+            (before.start_time != after.start_time ? TaskField::StartTime : 0) |
+            (before.end_time != after.end_time ? TaskField::EndTime : 0) |
+            (before.is_done != after.is_done ? TaskField::Completed : 0);
+        return change;
+    }
+
+    /// <summary>
+    /// Creates a change that adds a task.
+    /// </summary>
+    /// <param name="task"> The added task. </param>
+    /// <returns> The change. </returns>
+    static TaskChange Added(const Task& task)
+    {
+        TaskChange change;
+        change.id = task.id;
+        change.after = task;
+        change.fields = TaskField::Added;
+        return change;
+    }
+
+    /// <summary>
+    /// Creates a change that removes a task.
+    /// </summary>
+    /// <param name="task"> The removed task. </param>
+    /// <returns> The change. </returns>
+    static TaskChange Removed(const Task& task)
+    {
+        TaskChange change;
+        change.id = task.id;
+        change.before = task;
+        change.fields = TaskField::Removed;
+        return change;
+    }
+
+    uint32_t fields{ 0 };
+    bool affects_all{ false };
+    uint64_t id{ 0 };
+    Task before;
+    Task after;
+};
+
+/// <summary>
+/// Describes which changes a subscription wants to be notified about.
+/// Each part of the filter that is set must match: the changed fields, the task id, and the task's time window.
+/// The default filter matches every change.
+/// </summary>
+struct SubscriptionFilter
+{
+    /// <summary>
+    /// Creates a filter that matches changes to the specified fields.
+    /// </summary>
+    /// <param name="field_mask"> The <see cref="TaskField"/> bits to match. </param>
+    /// <returns> The filter. </returns>
+    static SubscriptionFilter Fields(uint32_t field_mask)
+    {
+        SubscriptionFilter filter;
+        filter.fields = field_mask;
+        return filter;
+    }
+
+    /// <summary>
+    /// Creates a filter that matches changes to the specified tasks.
+    /// </summary>
+    /// <param name="task_ids"> The ids of the tasks to match. </param>
+    /// <returns> The filter. </returns>
+    static SubscriptionFilter Ids(const std::unordered_set<uint64_t>& task_ids)
+    {
+        SubscriptionFilter filter;
+        filter.ids = task_ids;
+        return filter;
+    }
+
+    /// <summary>
+    /// Creates a filter that matches changes to tasks that overlap a time window.
+    /// A window that ends before it starts, such as 22:00 to 06:00, runs overnight into the next day.
+    /// </summary>
+    /// <param name="from"> The start of the window, formatted as HH:MM. </param>
+    /// <param name="to"> The end of the window, formatted as HH:MM. </param>
+    /// <param name="filter"> Set to the filter. </param>
+    /// <returns> True if both times are valid, false otherwise. </returns>
+    static bool TimeRange(const std::string& from, const std::string& to, SubscriptionFilter& filter)
+    {
+        int from_minute = mrt::time::ParseMinuteOfDay(from);
+        int to_minute = mrt::time::ParseMinuteOfDay(to);
+
+        if (from_minute < 0 || to_minute < 0)
+            return false;
+
+        filter = SubscriptionFilter();
+        filter.has_time_range = true;
+        filter.from_minute = from_minute;
+        filter.to_minute = to_minute;
+        return true;
+    }
+
+    /// <summary>
+    /// Gets the end of the time window in minutes since the midnight it starts after, at least 24 * 60 for an overnight window.
+    /// </summary>
+    int WindowEnd() const
+    {
+        return to_minute < from_minute ? to_minute + 24 * 60 : to_minute;
+    }
+
+    uint32_t fields{ TaskField::All };
+    std::unordered_set<uint64_t> ids;
+    bool has_time_range{ false };
+    int from_minute{ 0 };
+    int to_minute{ 0 };
+};
+
+/// <summary>
+/// SubscriptionIndex class holds the filtered subscriptions of the observers and finds the ones that match a change.
+/// The filters are indexed when a subscription is added or removed, each subscription has a bit in a set of bit masks:
+/// one mask per field, one per subscribed task id, and one per hour of the day covered by a time window.
+/// Matching a change combines the masks of the change instead of testing every filter.
+/// </summary>
+class SubscriptionIndex
+{
+public:
+    /// <summary>
+    /// A subscribed observer, and whether it is updated synchronously or through the dispatcher.
+    /// </summary>
+    struct Entry
+    {
+        Observer* observer{ nullptr };
+        bool is_async{ false };
+        SubscriptionFilter filter;
+    };
+
+private:
+    using Mask = std::vector<uint64_t>;
+
+    static constexpr int s_Hours = 24;
+
+    std::vector<Entry> m_Entries;
+
+    Mask m_FieldMasks[TaskField::Count];
+    Mask m_AnyId;
+    std::unordered_map<uint64_t, Mask> m_IdMasks;
+    Mask m_AnyTime;
+    Mask m_HourMasks[s_Hours];
+public:
+    /// <summary>
+    /// Adds a subscription, replacing any subscription the observer already has.
+    /// </summary>
+    /// <param name="observer"> The observer. </param>
+    /// <param name="is_async"> Whether the observer is updated through the dispatcher. </param>
+    /// <param name="filter"> The changes the observer wants to be notified about. </param>
+    void Add(Observer* observer, bool is_async, const SubscriptionFilter& filter)
+    {
+        Remove(observer);
+
+        m_Entries.push_back({ observer, is_async, filter });
+        Rebuild();
+    }
+
+    /// <summary>
+    /// Removes the subscription of an observer.
+    /// </summary>
+    /// <param name="observer"> The observer. </param>
+    /// <returns> The removed subscription, with a null observer if there was none. </returns>
+    Entry Remove(Observer* observer)
+    {
+        auto entry = std::find_if(m_Entries.begin(), m_Entries.end(), [observer](const Entry& entry)
+            {
+                return entry.observer == observer;
+            });
+
+        if (entry == m_Entries.end())
+            return Entry();
+
+        Entry removed = *entry;
+        m_Entries.erase(entry);
+        Rebuild();
+
+        return removed;
+    }
+
+    /// <summary>
+    /// Calls the function for every subscription.
+    /// </summary>
+    /// <param name="func"> The function to call with each subscription. </param>
+    template <typename _Func>
+    void ForEach(_Func func) const
+    {
+        for (const Entry& entry : m_Entries)
+        {
+            func(entry);
+        }
+    }
+
+    /// <summary>
+    /// Calls the function for every subscription that matches the change.
+    /// </summary>
+    /// <param name="change"> The change. </param>
+    /// <param name="func"> The function to call with each matching subscription. </param>
+    template <typename _Func>
+    void ForEachMatch(const TaskChange& change, _Func func) const
+    {
+        if (change.affects_all)
+        {
+            ForEach(func);
+            return;
+        }
+
+        Mask matches(Words(), 0);
+
+        for (uint32_t field = 0; field < TaskField::Count; field++)
+        {
+            if (change.fields & (1 << field))
+            {
+                Or(matches, m_FieldMasks[field]);
+            }
+        }
+
+        Mask id_matches(m_AnyId);
+        auto id_mask = m_IdMasks.find(change.id);
+
+        if (id_mask != m_IdMasks.end())
+        {
+            Or(id_matches, id_mask->second);
+        }
+
+        Mask time_matches(m_AnyTime);
+        AddHours(time_matches, change.before);
+        AddHours(time_matches, change.after);
+
+        for (uint64_t word = 0; word < matches.size(); word++)
+        {
+            uint64_t bits = matches[word] & id_matches[word] & time_matches[word];
+
+            while (bits != 0)
+            {
+                uint64_t bit = 0;
+
+                while (((bits >> bit) & 1) == 0)
+                {
+                    bit++;
+                }
+
+                bits &= bits - 1;
+
+                const Entry& entry = m_Entries[word * 64 + bit];
+
+                // The hour masks are coarse, so the time window is checked exactly for the remaining subscriptions.
+                if (!entry.filter.has_time_range || Overlaps(entry.filter, change.before) || Overlaps(entry.filter, change.after))
+                {
+                    func(entry);
+                }
+            }
+        }
+    }
+
+private:
+    /// <summary>
+    /// Gets the number of 64 bit words needed for a bit per subscription.
+    /// </summary>
+    uint64_t Words() const
+    {
+        return (m_Entries.size() + 63) / 64;
+    }
+
+    /// <summary>
+    /// Rebuilds the masks after a subscription was added or removed.
+    /// </summary>
+    void Rebuild()
+    {
+        for (Mask& mask : m_FieldMasks)
+        {
+            mask.assign(Words(), 0);
+        }
+
+        for (Mask& mask : m_HourMasks)
+        {
+            mask.assign(Words(), 0);
+        }
+
+        m_AnyId.assign(Words(), 0);
+        m_AnyTime.assign(Words(), 0);
+        m_IdMasks.clear();
+
+        for (uint64_t i = 0; i < m_Entries.size(); i++)
+        {
+            const SubscriptionFilter& filter = m_Entries[i].filter;
+
+            for (uint32_t field = 0; field < TaskField::Count; field++)
+            {
+                if (filter.fields & (1 << field))
+                {
+                    Set(m_FieldMasks[field], i);
+                }
+            }
+
+            if (filter.ids.empty())
+            {
+                Set(m_AnyId, i);
+            }
+
+            for (uint64_t id : filter.ids)
+            {
+                Mask& mask = m_IdMasks[id];
+                mask.resize(Words(), 0);
+                Set(mask, i);
+            }
+
+            if (!filter.has_time_range)
+            {
+                Set(m_AnyTime, i);
+            }
+            else
+            {
+                // An overnight window covers the hours from its start until midnight, and the hours of the next day until its end.
+                for (int hour = filter.from_minute / 60; hour <= filter.WindowEnd() / 60; hour++)
+                {
+                    Set(m_HourMasks[hour % s_Hours], i);
+                }
+            }
+        }
+    }
+
+    /// <summary>
+    /// Adds the subscriptions whose time window covers an hour of the task.
+    /// </summary>
+    void AddHours(Mask& mask, const Task& task) const
+    {
+        int start;
+        int end;
+
+        if (!mrt::time::ParseTimeSpan(task.start_time, task.end_time, start, end))
+            return;
+
+        // A task that runs past midnight covers the hours from its start and the hours of the next day until its end.
+        for (int hour = start / 60; hour <= end / 60; hour++)
+        {
+            Or(mask, m_HourMasks[hour % s_Hours]);
+        }
+    }
+
+    /// <summary>
+    /// Checks if a task overlaps the time window of a filter.
+    /// </summary>
+    static bool Overlaps(const SubscriptionFilter& filter, const Task& task)
+    {
+        int start;
+        int end;
+
+        if (!mrt::time::ParseTimeSpan(task.start_time, task.end_time, start, end))
+            return false;
+
+        // Either may run past midnight, so the window is also checked a day earlier and a day later:
+        // a task in the morning is in the part of an overnight window that began the evening before.
+        for (int shift : { -24 * 60, 0, 24 * 60 })
+        {
+            if (start <= filter.WindowEnd() + shift && end >= filter.from_minute + shift)
+                return true;
+        }
+
+        return false;
+    }
+
+    static void Set(Mask& mask, uint64_t index)
+    {
+        mask[index / 64] |= uint64_t(1) << (index % 64);
+    }
+
+    static void Or(Mask& mask, const Mask& other)
+    {
+        for (uint64_t word = 0; word < mask.size() && word < other.size(); word++)
+        {
+            mask[word] |= other[word];
+        }
+    }
+};
\ No newline at end of file
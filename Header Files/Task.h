@@ -1,6 +1,7 @@
 #pragma once
 
 #include <string>
+#include <cstdint>
 
 /// <summary>
 /// A struct that represents a task within the application.
@@ -27,4 +28,16 @@ struct Task
 	std::string start_time{ "" };
 	std::string end_time{ "" };
 	bool is_done{ false };
+
+	// Assigned by the task manager, 0 until the task has been added.
+	uint64_t id{ 0 };
+};
+
+/// <summary>
+/// A dependency between two tasks, the task after can only start once the task before is done.
+/// </summary>
+struct TaskDependency
+{
+	uint64_t before{ 0 };
+	uint64_t after{ 0 };
 };
\ No newline at end of file
@@ -0,0 +1,1014 @@
+#pragma once
+
+#include "../Header Files/NoCopy.h"
+#include "../Header Files/Task.h"
+#include "../Header Files/Time.h"
+#include "../Header Files/Vector.h"
+#include "../Header Files/TaskManager.h"
+
+#include <mutex>
+#include <atomic>
+#include <string>
+#include <thread>
+#include <vector>
+#include <cstring>
+#include <fstream>
+#include <cstdint>
+#include <functional>
+#include <string_view>
+
+/// <summary>
+/// The formats the <see cref="TaskImporter"/> reads.
+/// Csv has a header row naming the columns: title, description, start, end and done, only title is required.
+/// Ndjson has one JSON object per line, with the same keys.
+/// </summary>
+enum class ImportFormat
+{
+    Csv,
+    Ndjson
+};
+
+/// <summary>
+/// The progress of an import.
+/// </summary>
+struct ImportProgress
+{
+    uint64_t bytes_read{ 0 };
+    uint64_t total_bytes{ 0 };
+    uint64_t tasks_imported{ 0 };
+    uint64_t rows_rejected{ 0 };
+    bool is_done{ false };
+    bool succeeded{ false };
+
+    // The first problem found, a rejected row or the reason the import stopped.
+    std::string error;
+};
+
+/// <summary>
+/// TaskImporter class reads tasks from a CSV or NDJSON file on a background thread and adds them to a <see cref="TaskManager"/> in batches.
+/// The file is read in fixed size chunks, and each row is parsed in place in the chunk, so the memory used does not grow with the size of the file.
+/// Fields are views into the chunk until a row passes validation. Rows with a missing title, a time that is not H:MM or HH:MM,
+/// or a different number of CSV fields than the header are rejected and counted. Times are stored as HH:MM.
+/// Each batch is added with <see cref="TaskManager::AddTasks"/>, so the observers are notified once per batch and the batch is undone as a whole.
+/// </summary>
+class TaskImporter : private NoCopy
+{
+public:
+    using progress_func = std::function<void(const ImportProgress&)>;
+
+    static constexpr uint64_t s_DefaultChunkSize = 64 * 1024;
+    static constexpr uint64_t s_DefaultBatchSize = 1024;
+
+private:
+    /// <summary>
+    /// The fields of a row, as views into the chunk.
+    /// </summary>
+    struct Row
+    {
+        std::string_view title;
+        std::string_view description;
+        std::string_view start;
+        std::string_view end;
+        std::string_view done;
+    };
+
+    enum class Column
+    {
+        Ignored,
+        Title,
+        Description,
+        Start,
+        End,
+        Done
+    };
+
+    TaskManager& m_Manager;
+    uint64_t m_ChunkSize;
+    uint64_t m_BatchSize;
+
+    std::thread m_Thread;
+    std::atomic<bool> m_IsCancelled{ false };
+    std::atomic<bool> m_IsRunning{ false };
+
+    mutable std::mutex m_ProgressMutex;
+    ImportProgress m_Progress;
+    progress_func m_OnProgress;
+
+    // Only used by the import thread.
+    std::ifstream m_File;
+    ImportFormat m_Format{ ImportFormat::Csv };
+    std::vector<Column> m_Columns;
+    mrt::Vector<Task> m_Batch;
+    uint64_t m_Row{ 0 };
+public:
+    /// <summary>
+    /// Initializes a new instance of the <see cref="TaskImporter"/> class.
+    /// </summary>
+    /// <param name="manager"> The task manager the tasks are added to. </param>
+    /// <param name="batch_size"> The number of tasks added at a time. </param>
+    /// <param name="chunk_size"> The number of bytes read at a time, also the longest row that can be read. </param>
+    TaskImporter(TaskManager& manager, uint64_t batch_size = s_DefaultBatchSize, uint64_t chunk_size = s_DefaultChunkSize)
+        : m_Manager(manager), m_ChunkSize(chunk_size > 0 ? chunk_size : s_DefaultChunkSize), m_BatchSize(batch_size > 0 ? batch_size : s_DefaultBatchSize)
+    {
+    }
+
+    /// <summary>
+    /// Finalizes an instance of the <see cref="TaskImporter"/> class.
+    /// Cancels an import that is running, the batches already added are kept.
+    /// </summary>
+    ~TaskImporter()
+    {
+        Cancel();
+        Wait();
+    }
+
+    /// <summary>
+    /// Starts importing a file on a background thread.
+    /// </summary>
+    /// <param name="path"> The path of the file. </param>
+    /// <param name="format"> The format of the file. </param>
+    /// <param name="on_progress"> Called from the import thread after each batch, and once the import has finished. </param>
+    /// <returns> True if the import was started, false if an import is already running or the file cannot be opened. </returns>
+    bool Start(const std::string& path, ImportFormat format, progress_func on_progress = nullptr)
+    {
+        if (m_IsRunning)
+            return false;
+
+        Wait();
+
+        m_File = std::ifstream(path, std::ios::binary | std::ios::ate);
+
+        if (!m_File.is_open())
+            return false;
+
+        {
+            std::lock_guard<std::mutex> lock(m_ProgressMutex);
+
+            m_Progress = ImportProgress();
+            m_Progress.total_bytes = static_cast<uint64_t>(m_File.tellg());
+        }
+
+        m_File.seekg(0);
+        m_Format = format;
+        m_OnProgress = on_progress;
+        m_IsCancelled = false;
+        m_IsRunning = true;
+
+        m_Thread = std::thread([this]()
+            {
+                Run();
+            });
+
+        return true;
+    }
+
+    /// <summary>
+    /// Stops the import after the batch being read, the batches already added are kept.
+    /// </summary>
+    void Cancel()
+    {
+        m_IsCancelled = true;
+    }
+
+    /// <summary>
+    /// Waits for the import to finish.
+    /// </summary>
+    /// <returns> The final progress of the import. </returns>
+    ImportProgress Wait()
+    {
+        if (m_Thread.joinable())
+        {
+            m_Thread.join();
+        }
+
+        return Progress();
+    }
+
+    /// <summary>
+    /// Gets the progress of the import.
+    /// </summary>
+    ImportProgress Progress() const
+    {
+        std::lock_guard<std::mutex> lock(m_ProgressMutex);
+
+        return m_Progress;
+    }
+
+    /// <summary>
+    /// Checks whether an import is running.
+    /// </summary>
+    bool IsRunning() const
+    {
+        return m_IsRunning;
+    }
+
+    /// <summary>
+    /// Gets the format of a file from its extension, .csv or .ndjson and .jsonl.
+    /// </summary>
+    /// <param name="path"> The path of the file. </param>
+    /// <param name="format"> Set to the format of the file. </param>
+    /// <returns> True if the extension is known, false otherwise. </returns>
+    static bool FormatOf(const std::string& path, ImportFormat& format)
+    {
+        auto ends_with = [&path](const std::string& extension)
+            {
+                return path.size() >= extension.size() && path.compare(path.size() - extension.size(), extension.size(), extension) == 0;
+            };
+
+        if (ends_with(".csv"))
+        {
+            format = ImportFormat::Csv;
+            return true;
+        }
+
+        if (ends_with(".ndjson") || ends_with(".jsonl"))
+        {
+            format = ImportFormat::Ndjson;
+            return true;
+        }
+
+        return false;
+    }
+
+private:
+    /// <summary>
+    /// The import thread, reads the file a chunk at a time and parses every complete row in the chunk.
+    /// A row that is cut off by the end of the chunk is moved to the front of the buffer and completed by the next read.
+    /// </summary>
+    void Run()
+    {
+        // Room for a chunk and the start of a row left over from the previous chunk, which is never longer than a chunk.
+        std::vector<char> buffer(m_ChunkSize * 2);
+        uint64_t begin = 0;
+        uint64_t end = 0;
+        bool is_skipping = false;
+        bool is_eof = false;
+        bool succeeded = true;
+
+        m_Columns.clear();
+        m_Batch.Clear();
+        m_Row = 0;
+
+        while (!m_IsCancelled && succeeded)
+        {
+            if (!is_eof && end - begin < m_ChunkSize)
+            {
+                std::memmove(buffer.data(), buffer.data() + begin, end - begin);
+                end -= begin;
+                begin = 0;
+
+                m_File.read(buffer.data() + end, static_cast<std::streamsize>(buffer.size() - end));
+                uint64_t read = static_cast<uint64_t>(m_File.gcount());
+
+                end += read;
+                is_eof = read == 0 || m_File.eof();
+
+                std::lock_guard<std::mutex> lock(m_ProgressMutex);
+                m_Progress.bytes_read += read;
+            }
+
+            if (is_skipping)
+            {
+                // The rest of a row that was too long is dropped up to the next line.
+                const char* newline = static_cast<const char*>(std::memchr(buffer.data() + begin, '\n', end - begin));
+
+                if (newline == nullptr)
+                {
+                    begin = end;
+
+                    if (is_eof)
+                        break;
+
+                    continue;
+                }
+
+                begin = static_cast<uint64_t>(newline - buffer.data()) + 1;
+                is_skipping = false;
+            }
+
+            uint64_t row_end = FindRowEnd(buffer.data() + begin, buffer.data() + end);
+
+            if (row_end == UINT64_MAX)
+            {
+                if (is_eof)
+                {
+                    // The last row does not end with a new line.
+                    if (begin < end)
+                    {
+                        succeeded = ParseRow(buffer.data() + begin, buffer.data() + end);
+                    }
+
+                    break;
+                }
+
+                if (end - begin >= m_ChunkSize)
+                {
+                    succeeded = RejectLongRow();
+                    begin = end;
+                    is_skipping = true;
+                }
+
+                continue;
+            }
+
+            if (row_end > m_ChunkSize)
+            {
+                succeeded = RejectLongRow();
+            }
+            else
+            {
+                succeeded = ParseRow(buffer.data() + begin, buffer.data() + begin + row_end);
+            }
+
+            begin += row_end + 1;
+        }
+
+        if (succeeded && m_Format == ImportFormat::Csv && m_Columns.empty())
+        {
+            succeeded = Fail("the file has no header row");
+        }
+
+        Flush();
+
+        m_File.close();
+
+        {
+            std::lock_guard<std::mutex> lock(m_ProgressMutex);
+
+            m_Progress.is_done = true;
+            m_Progress.succeeded = succeeded && !m_IsCancelled;
+
+            if (m_IsCancelled && m_Progress.error.empty())
+            {
+                m_Progress.error = "the import was cancelled";
+            }
+        }
+
+        ReportProgress();
+
+        m_IsRunning = false;
+    }
+
+    /// <summary>
+    /// Finds the new line that ends the row starting at the specified position, a new line inside a quoted CSV field does not end the row.
+    /// Only a quote at the start of a field opens a quoted field, a quote inside an unquoted field such as 5" screen is kept as it is.
+    /// </summary>
+    /// <returns> The offset of the new line, or UINT64_MAX if the row is not complete. </returns>
+    uint64_t FindRowEnd(const char* begin, const char* end) const
+    {
+        if (m_Format == ImportFormat::Ndjson)
+        {
+            const char* newline = static_cast<const char*>(std::memchr(begin, '\n', end - begin));
+
+            return newline != nullptr ? static_cast<uint64_t>(newline - begin) : UINT64_MAX;
+        }
+
+        enum class State
+        {
+            FieldStart,
+            Unquoted,
+            Quoted,
+            QuoteInQuoted
+        };
+
+        State state = State::FieldStart;
+
+        for (const char* c = begin; c < end; c++)
+        {
+            switch (state)
+            {
+            case State::Quoted:
+                state = *c == '"' ? State::QuoteInQuoted : State::Quoted;
+                continue;
+            case State::QuoteInQuoted:
+                // Two quotes are a quote inside the field, otherwise the field was closed.
+                if (*c == '"')
+                {
+                    state = State::Quoted;
+                    continue;
+                }
+
+                break;
+            case State::FieldStart:
+                if (*c == '"')
+                {
+                    state = State::Quoted;
+                    continue;
+                }
+
+                break;
+            default:
+                break;
+            }
+
+            if (*c == '\n')
+                return static_cast<uint64_t>(c - begin);
+
+            state = *c == ',' ? State::FieldStart : State::Unquoted;
+        }
+
+        return UINT64_MAX;
+    }
+
+    /// <summary>
+    /// Parses a complete row, adds it to the batch if it is valid, and adds the batch once it is full.
+    /// </summary>
+    /// <returns> False if the import cannot go on, true otherwise. </returns>
+    bool ParseRow(char* begin, char* end)
+    {
+        m_Row++;
+
+        if (end > begin && end[-1] == '\r')
+        {
+            end--;
+        }
+
+        if (begin == end)
+            return true;
+
+        Row row;
+
+        if (m_Format == ImportFormat::Csv)
+        {
+            if (m_Columns.empty())
+                return ParseHeader(begin, end);
+
+            if (!ParseCsvRow(begin, end, row))
+                return true;
+        }
+        else if (!ParseJsonRow(begin, end, row))
+        {
+            return true;
+        }
+
+        if (row.title.empty())
+        {
+            Reject("the task has no title");
+            return true;
+        }
+
+        std::string start_time;
+        std::string end_time;
+
+        if (!NormaliseTime(row.start, start_time) || !NormaliseTime(row.end, end_time))
+        {
+            Reject("a time is not formatted as HH:MM");
+            return true;
+        }
+
+        bool is_done = false;
+
+        if (!ParseDone(row.done, is_done))
+        {
+            Reject("done is not true or false");
+            return true;
+        }
+
+        m_Batch.EmplaceBack(std::string(row.title), std::string(row.description), start_time, end_time, is_done);
+
+        if (m_Batch.Size() >= m_BatchSize)
+        {
+            Flush();
+        }
+
+        return true;
+    }
+
+    /// <summary>
+    /// Adds the batch to the task manager and reports the progress.
+    /// </summary>
+    void Flush()
+    {
+        if (m_Batch.Empty())
+            return;
+
+        m_Manager.AddTasks(m_Batch);
+
+        {
+            std::lock_guard<std::mutex> lock(m_ProgressMutex);
+            m_Progress.tasks_imported += m_Batch.Size();
+        }
+
+        m_Batch.Clear();
+
+        ReportProgress();
+    }
+
+    void ReportProgress()
+    {
+        if (m_OnProgress)
+        {
+            m_OnProgress(Progress());
+        }
+    }
+
+    void Reject(const std::string& reason)
+    {
+        std::lock_guard<std::mutex> lock(m_ProgressMutex);
+
+        m_Progress.rows_rejected++;
+
+        if (m_Progress.error.empty())
+        {
+            m_Progress.error = "row " + std::to_string(m_Row) + ": " + reason;
+        }
+    }
+
+    bool Fail(const std::string& reason)
+    {
+        std::lock_guard<std::mutex> lock(m_ProgressMutex);
+
+        m_Progress.error = reason;
+        return false;
+    }
+
+    /// <summary>
+    /// Rejects a row that is longer than a chunk, the header row cannot be skipped so it fails the import instead.
+    /// </summary>
+    /// <returns> False if the row was the header row, true otherwise. </returns>
+    bool RejectLongRow()
+    {
+        m_Row++;
+
+        if (m_Format == ImportFormat::Csv && m_Columns.empty())
+            return Fail("the header row is longer than " + std::to_string(m_ChunkSize) + " bytes");
+
+        Reject("the row is longer than " + std::to_string(m_ChunkSize) + " bytes");
+        return true;
+    }
+
+    // CSV.
+
+    /// <summary>
+    /// Reads the next field of a CSV row, a quoted field is unquoted in place.
+    /// </summary>
+    /// <param name="position"> The start of the field, moved past the field and its comma. </param>
+    /// <param name="has_more"> Set to whether a comma followed the field, so another field follows it, even an empty one. </param>
+    /// <returns> The field. </returns>
+    static std::string_view NextCsvField(char*& position, char* end, bool& has_more)
+    {
+        char* field = position;
+
+        if (position == end || *position != '"')
+        {
+            while (position < end && *position != ',')
+            {
+                position++;
+            }
+
+            std::string_view value(field, static_cast<uint64_t>(position - field));
+
+            has_more = position < end;
+
+            if (has_more)
+            {
+                position++;
+            }
+
+            return value;
+        }
+
+        // Quotes are written as two quotes, the unquoted field is never longer so it is written over itself.
+        char* write = field;
+        position++;
+
+        while (position < end)
+        {
+            if (*position == '"')
+            {
+                if (position + 1 < end && position[1] == '"')
+                {
+                    *write++ = '"';
+                    position += 2;
+                    continue;
+                }
+
+                position++;
+                break;
+            }
+
+            *write++ = *position++;
+        }
+
+        while (position < end && *position != ',')
+        {
+            position++;
+        }
+
+        has_more = position < end;
+
+        if (has_more)
+        {
+            position++;
+        }
+
+        return std::string_view(field, static_cast<uint64_t>(write - field));
+    }
+
+    bool ParseHeader(char* begin, char* end)
+    {
+        static const char s_ByteOrderMark[] = "\xEF\xBB\xBF";
+
+        if (end - begin >= 3 && std::memcmp(begin, s_ByteOrderMark, 3) == 0)
+        {
+            begin += 3;
+        }
+
+        bool has_title = false;
+        bool has_more = false;
+
+        do
+        {
+            Column column = ColumnOf(Trim(NextCsvField(begin, end, has_more)));
+
+            has_title = has_title || column == Column::Title;
+            m_Columns.push_back(column);
+        } while (has_more);
+
+        if (!has_title)
+            return Fail("the header row has no title column");
+
+        return true;
+    }
+
+    /// <summary>
+    /// Reads the fields of a CSV row into the columns named by the header.
+    /// </summary>
+    /// <returns> True if the row has a field for each column, otherwise the row is rejected and false is returned. </returns>
+    bool ParseCsvRow(char* begin, char* end, Row& row)
+    {
+        uint64_t fields = 0;
+        bool has_more = true;
+
+        while (has_more)
+        {
+            std::string_view value = Trim(NextCsvField(begin, end, has_more));
+
+            if (fields < m_Columns.size())
+            {
+                SetField(row, m_Columns[fields], value);
+            }
+
+            fields++;
+        }
+
+        if (fields != m_Columns.size())
+        {
+            Reject("the row has " + std::to_string(fields) + " fields, the header has " + std::to_string(m_Columns.size()));
+            return false;
+        }
+
+        return true;
+    }
+
+    // NDJSON.
+
+    /// <summary>
+    /// Reads a JSON string and unescapes it in place, the unescaped string is never longer than the escaped one.
+    /// </summary>
+    /// <param name="position"> The opening quote, moved past the closing quote. </param>
+    /// <param name="value"> Set to the string. </param>
+    /// <returns> True if the string is valid, false otherwise. </returns>
+    static bool ParseJsonString(char*& position, char* end, std::string_view& value)
+    {
+        char* write = ++position;
+        char* start = write;
+
+        while (position < end && *position != '"')
+        {
+            if (*position != '\\')
+            {
+                *write++ = *position++;
+                continue;
+            }
+
+            if (++position == end)
+                return false;
+
+            char escaped = *position++;
+
+            switch (escaped)
+            {
+            case 'n':
+                *write++ = '\n';
+                break;
+            case 't':
+                *write++ = '\t';
+                break;
+            case 'r':
+                *write++ = '\r';
+                break;
+            case 'b':
+                *write++ = '\b';
+                break;
+            case 'f':
+                *write++ = '\f';
+                break;
+            case 'u':
+            {
+                uint32_t code = 0;
+
+                if (!ParseHex(position, end, code))
+                    return false;
+
+                // A high surrogate is joined with the low surrogate that follows it.
+                if (code >= 0xD800 && code < 0xDC00 && end - position >= 6 && position[0] == '\\' && position[1] == 'u')
+                {
+                    char* low_position = position + 2;
+                    uint32_t low = 0;
+
+                    if (ParseHex(low_position, end, low) && low >= 0xDC00 && low < 0xE000)
+                    {
+                        code = 0x10000 + ((code - 0xD800) << 10) + (low - 0xDC00);
+                        position = low_position;
+                    }
+                }
+
+                write = WriteUtf8(write, code);
+                break;
+            }
+            default:
+                *write++ = escaped;
+                break;
+            }
+        }
+
+        if (position == end)
+            return false;
+
+        value = std::string_view(start, static_cast<uint64_t>(write - start));
+        position++;
+
+        return true;
+    }
+
+    bool ParseJsonRow(char* begin, char* end, Row& row)
+    {
+        char* position = SkipSpaces(begin, end);
+
+        if (position == end || *position != '{')
+        {
+            Reject("the row is not a JSON object");
+            return false;
+        }
+
+        position = SkipSpaces(position + 1, end);
+
+        while (position < end && *position != '}')
+        {
+            std::string_view key;
+            std::string_view value;
+
+            if (*position != '"' || !ParseJsonString(position, end, key))
+            {
+                Reject("expected a key");
+                return false;
+            }
+
+            position = SkipSpaces(position, end);
+
+            if (position == end || *position != ':')
+            {
+                Reject("expected : after a key");
+                return false;
+            }
+
+            position = SkipSpaces(position + 1, end);
+
+            if (position < end && *position == '"')
+            {
+                if (!ParseJsonString(position, end, value))
+                {
+                    Reject("a string is not terminated");
+                    return false;
+                }
+            }
+            else
+            {
+                // true, false, null and numbers are kept as they are written.
+                char* start = position;
+
+                while (position < end && *position != ',' && *position != '}' && !IsSpace(*position))
+                {
+                    if (*position == '{' || *position == '[')
+                    {
+                        Reject("nested values are not supported");
+                        return false;
+                    }
+
+                    position++;
+                }
+
+                value = std::string_view(start, static_cast<uint64_t>(position - start));
+
+                if (value == "null")
+                {
+                    value = std::string_view();
+                }
+            }
+
+            SetField(row, ColumnOf(key), value);
+
+            position = SkipSpaces(position, end);
+
+            if (position < end && *position == ',')
+            {
+                position = SkipSpaces(position + 1, end);
+
+                if (position < end && *position == '}')
+                {
+                    Reject("expected a key after ,");
+                    return false;
+                }
+            }
+            else if (position < end && *position != '}')
+            {
+                Reject("expected , or } after a value");
+                return false;
+            }
+        }
+
+        if (position == end)
+        {
+            Reject("the JSON object is not closed");
+            return false;
+        }
+
+        return true;
+    }
+
+    static bool ParseHex(char*& position, char* end, uint32_t& code)
+    {
+        if (end - position < 4)
+            return false;
+
+        code = 0;
+
+        for (int i = 0; i < 4; i++, position++)
+        {
+            char c = *position;
+            code <<= 4;
+
+            if (c >= '0' && c <= '9')
+                code |= c - '0';
+            else if (c >= 'a' && c <= 'f')
+                code |= c - 'a' + 10;
+            else if (c >= 'A' && c <= 'F')
+                code |= c - 'A' + 10;
+            else
+                return false;
+        }
+
+        return true;
+    }
+
+    static char* WriteUtf8(char* write, uint32_t code)
+    {
+        if (code < 0x80)
+        {
+            *write++ = static_cast<char>(code);
+        }
+        else if (code < 0x800)
+        {
+            *write++ = static_cast<char>(0xC0 | (code >> 6));
+            *write++ = static_cast<char>(0x80 | (code & 0x3F));
+        }
+        else if (code < 0x10000)
+        {
+            *write++ = static_cast<char>(0xE0 | (code >> 12));
+            *write++ = static_cast<char>(0x80 | ((code >> 6) & 0x3F));
+            *write++ = static_cast<char>(0x80 | (code & 0x3F));
+        }
+        else
+        {
+            *write++ = static_cast<char>(0xF0 | (code >> 18));
+            *write++ = static_cast<char>(0x80 | ((code >> 12) & 0x3F));
+            *write++ = static_cast<char>(0x80 | ((code >> 6) & 0x3F));
+            *write++ = static_cast<char>(0x80 | (code & 0x3F));
+        }
+
+        return write;
+    }
+
+    // Fields.
+
+    static Column ColumnOf(std::string_view name)
+    {
+        if (EqualsIgnoringCase(name, "title"))
+            return Column::Title;
+        if (EqualsIgnoringCase(name, "description"))
+            return Column::Description;
+        if (EqualsIgnoringCase(name, "start") || EqualsIgnoringCase(name, "start_time"))
+            return Column::Start;
+        if (EqualsIgnoringCase(name, "end") || EqualsIgnoringCase(name, "end_time"))
+            return Column::End;
+        if (EqualsIgnoringCase(name, "done") || EqualsIgnoringCase(name, "is_done"))
+            return Column::Done;
+
+        return Column::Ignored;
+    }
+
+    static void SetField(Row& row, Column column, std::string_view value)
+    {
+        switch (column)
+        {
+        case Column::Title:
+            row.title = value;
+            break;
+        case Column::Description:
+            row.description = value;
+            break;
+        case Column::Start:
+            row.start = value;
+            break;
+        case Column::End:
+            row.end = value;
+            break;
+        case Column::Done:
+            row.done = value;
+            break;
+        default:
+            break;
+        }
+    }
+
+    /// <summary>
+    /// Writes a time as HH:MM, the form the tasks are stored in, so a time written as H:MM sorts and compares like the others.
+    /// </summary>
+    /// <param name="time"> The time, empty or formatted as H:MM or HH:MM. </param>
+    /// <param name="normalised"> Set to the time as HH:MM, or empty. </param>
+    /// <returns> True if the time is empty or valid, false otherwise. </returns>
+    static bool NormaliseTime(std::string_view time, std::string& normalised)
+    {
+        normalised = time.size() == 4 ? "0" + std::string(time) : std::string(time);
+
+        return normalised.empty() || mrt::time::ParseMinuteOfDay(normalised) >= 0;
+    }
+
+    static bool ParseDone(std::string_view value, bool& is_done)
+    {
+        for (const char* yes : { "true", "1", "yes", "x" })
+        {
+            if (EqualsIgnoringCase(value, yes))
+            {
+                is_done = true;
+                return true;
+            }
+        }
+
+        for (const char* no : { "", "false", "0", "no" })
+        {
+            if (EqualsIgnoringCase(value, no))
+            {
+                is_done = false;
+                return true;
+            }
+        }
+
+        return false;
+    }
+
+    static bool EqualsIgnoringCase(std::string_view value, std::string_view expected)
+    {
+        if (value.size() != expected.size())
+            return false;
+
+        for (uint64_t i = 0; i < value.size(); i++)
+        {
+            if (tolower(static_cast<unsigned char>(value[i])) != expected[i])
+                return false;
+        }
+
+        return true;
+    }
+
+    static bool IsSpace(char c)
+    {
+        return c == ' ' || c == '\t' || c == '\r' || c == '\n';
+    }
+
+    static char* SkipSpaces(char* position, char* end)
+    {
+        while (position < end && IsSpace(*position))
+        {
+            position++;
+        }
+
+        return position;
+    }
+
+    static std::string_view Trim(std::string_view value)
+    {
+        while (!value.empty() && IsSpace(value.front()))
+        {
+            value.remove_prefix(1);
+        }
+
+        while (!value.empty() && IsSpace(value.back()))
+        {
+            value.remove_suffix(1);
+        }
+
+        return value;
+    }
+};
@@ -2,68 +2,653 @@
 
 #include "../Header Files/Subject.h"
 #include "../Header Files/Observer.h"
+#include "../Header Files/ObserverDispatcher.h"
+#include "../Header Files/Subscription.h"
+#include "../Header Files/ReminderScheduler.h"
+#include "../Header Files/TaskView.h"
+#include "../Header Files/TaskQuery.h"
+#include "../Header Files/DependencyGraph.h"
+#include "../Header Files/TaskStatistics.h"
 #include "../Header Files/Vector.h"
+#include "../Header Files/PersistentVector.h"
 #include "../Header Files/Algorithm.h"
 #include "../Header Files/StorageEncrypted.h"
+#include "../Header Files/StoragePartitioned.h"
+#include "../Header Files/StorageBinary.h"
+#include "../Header Files/Time.h"
+#include "../Header Files/Metrics.h"
+
+#include <map>
+#include <mutex>
+#include <memory>
+#include <string>
+#include <thread>
+#include <vector>
+#include <functional>
+#include <unordered_map>
+#include <unordered_set>
+
+/// <summary>
+/// Timings of the background load of the tasks, measured from when the <see cref="TaskManager"/> was created.
+/// A load that failed keeps the tasks read before the failure, and gives the reason in the error.
+/// </summary>
+struct TaskLoadMetrics
+{
+    double first_tasks_ms{ 0.0 };
+    double fully_loaded_ms{ 0.0 };
+    uint64_t first_task_count{ 0 };
+    uint64_t task_count{ 0 };
+    bool failed{ false };
+    std::string error;
+};
+
+/// <summary>
+/// A snapshot of the instrumentation of the <see cref="TaskManager"/>.
+/// The latencies of the changes include the time spent waiting for the lock and notifying the synchronous observers.
+/// </summary>
+struct TaskManagerStats
+{
+    mrt::metrics::HistogramSnapshot add;
+    mrt::metrics::HistogramSnapshot add_batch;
+    mrt::metrics::HistogramSnapshot remove;
+    mrt::metrics::HistogramSnapshot complete;
+    mrt::metrics::HistogramSnapshot notify;
+    mrt::metrics::HistogramSnapshot load;
+    mrt::metrics::HistogramSnapshot save;
+
+    uint64_t task_count{ 0 };
+    uint64_t bytes_persisted{ 0 };
+    uint64_t notifications_sent{ 0 };
+
+    /// <summary>
+    /// Formats the stats as text, one line per histogram followed by the counters.
+    /// </summary>
+    /// <returns> The formatted stats. </returns>
+    std::string ToString() const
+    {
+        std::string text;
+
+        text += mrt::metrics::FormatHistogram("add", add);
+        text += mrt::metrics::FormatHistogram("add_batch", add_batch);
+        text += mrt::metrics::FormatHistogram("remove", remove);
+        text += mrt::metrics::FormatHistogram("complete", complete);
+        text += mrt::metrics::FormatHistogram("notify", notify);
+        text += mrt::metrics::FormatHistogram("load", load);
+        text += mrt::metrics::FormatHistogram("save", save);
+        text += "task_count=" + std::to_string(task_count) + "\n";
+        text += "bytes_persisted=" + std::to_string(bytes_persisted) + "\n";
+        text += "notifications_sent=" + std::to_string(notifications_sent) + "\n";
+
+        return text;
+    }
+};
 
 /// <summary>
 /// TaskManager class is a concrete subject class that inherits from the Subject interface.
 /// It is responsible for managing the tasks and notifying the observers when a task is added, removed or completed.
+/// The tasks of the active day are held in a persistent vector, so every change creates a new version that shares its nodes with the previous one,
+/// and the previous versions are kept to allow changes to be undone and redone. The other days are stored and read one partition at a time.
 /// </summary>
 class TaskManager : public Subject, private NoCopy 
 {
+public:
+    using loaded_func = std::function<void(const TaskLoadMetrics&)>;
+    using clock_func = ReminderScheduler::clock_func;
+
 private:
-    mrt::Vector<Observer*> m_Observers;
-    mrt::Vector<Task> m_Tasks;
+    // The number of tasks that fill the view, these are published as soon as they are decrypted.
+    static constexpr uint64_t s_FirstScreenTasks = 32;
+    static constexpr uint64_t s_MaxPreparedQueries = 64;
+    static constexpr uint64_t s_DefaultUndoDepth = 100;
+
+    mutable std::recursive_mutex m_Mutex;
+    SubscriptionIndex m_Subscriptions;
+    ObserverDispatcher m_Dispatcher;
+
+    // Declared before the reminders, so it outlives the timer thread that asks whether tasks are ready.
+    DependencyGraph m_Dependencies;
+    bool m_DependenciesChanged{ false };
+
+    ReminderScheduler m_Reminders;
+    std::vector<std::weak_ptr<TaskView>> m_Views;
+    std::map<QueryField, std::shared_ptr<TaskView>> m_QueryIndexes;
+    mrt::PersistentVector<Task> m_Tasks;
+    uint64_t m_NextId{ 1 };
+    std::unordered_set<uint64_t> m_IdsGivenWhileLoading;
+    mrt::Vector<mrt::PersistentVector<Task>> m_UndoHistory;
+    mrt::Vector<mrt::PersistentVector<Task>> m_RedoHistory;
+    uint64_t m_UndoDepth{ s_DefaultUndoDepth };
+
+    std::string m_StoreName;
+    std::shared_ptr<StoragePartitioned> m_Storage;
+    std::map<std::string, mrt::PersistentVector<Task>> m_PastDays;
+    TaskStatistics m_Statistics;
+
+    // The tasks changed since the last save, by id so new tasks are saved in the order they were added.
+    std::map<uint64_t, Task> m_ChangedTasks;
+    std::unordered_set<uint64_t> m_RemovedIds;
+    bool m_AllChanged{ false };
+
+    // Held for the whole of a save, so the changes taken by one save are written before the next save takes its own.
+    std::mutex m_SaveMutex;
+
+    RecurrenceSet m_Recurrences;
+    uint64_t m_NextRuleId{ 1 };
+    int64_t m_ActiveDay{ 0 };
+    clock_func m_Clock;
+    std::chrono::system_clock::time_point m_NextDayStart;
+    bool m_RecurrencesChanged{ false };
+    std::vector<uint64_t> m_RemindedOccurrences;
+
+    mrt::time::Stopwatch m_LoadStopwatch;
+    TaskLoadMetrics m_LoadMetrics;
+    loaded_func m_OnLoaded;
+    bool m_IsLoaded{ false };
+    std::thread m_Loader;
+
+    std::mutex m_PreparedQueriesMutex;
+    std::unordered_map<std::string, std::shared_ptr<const TaskQuery>> m_PreparedQueries;
+
+    mrt::metrics::LatencyHistogram m_AddLatency;
+    mrt::metrics::LatencyHistogram m_AddBatchLatency;
+    mrt::metrics::LatencyHistogram m_RemoveLatency;
+    mrt::metrics::LatencyHistogram m_CompleteLatency;
+    mrt::metrics::LatencyHistogram m_NotifyLatency;
+    mrt::metrics::LatencyHistogram m_LoadLatency;
+    mrt::metrics::LatencyHistogram m_SaveLatency;
+    mrt::metrics::Counter m_NotificationsSent;
+    std::unique_ptr<mrt::metrics::PeriodicDump> m_StatsDump;
 public:
     /// <summary>
     /// Initializes a new instance of the <see cref="TaskManager"/> class.
-    /// Will read the tasks from the storage and initialize the tasks vector.
+    /// Will start reading the tasks from the storage on a background thread.
+    /// </summary>
+    /// <param name="on_loaded"> Called from the loading thread once all the tasks have been loaded, or the load failed, see <see cref="TaskLoadMetrics"/>. </param>
+    TaskManager(loaded_func on_loaded = nullptr)
+        : TaskManager(std::to_string(typeid(TaskManager*).hash_code()), on_loaded)
+    {
+    }
+
+    /// <summary>
+    /// Initializes a new instance of the <see cref="TaskManager"/> class that uses the specified task store.
+    /// Will start reading the tasks from the storage on a background thread.
+    /// </summary>
+    /// <param name="store_name"> The name of the task store, tools use their own store to leave the application's tasks untouched. </param>
+    /// <param name="on_loaded"> Called from the loading thread once all the tasks have been loaded, or the load failed, see <see cref="TaskLoadMetrics"/>. </param>
+    TaskManager(const std::string& store_name, loaded_func on_loaded = nullptr)
+        : TaskManager(store_name, ReminderScheduler::Clock::now, on_loaded)
+    {
+    }
+
+    /// <summary>
+    /// Initializes a new instance of the <see cref="TaskManager"/> class that uses the specified task store and clock.
+    /// Will start reading the tasks from the storage on a background thread.
     /// </summary>
-    TaskManager()
+    /// <param name="store_name"> The name of the task store. </param>
+    /// <param name="clock"> Reads the current time, which decides the active day and when the reminders fire, see <see cref="RollOver"/>. </param>
+    /// <param name="on_loaded"> Called from the loading thread once all the tasks have been loaded, or the load failed, see <see cref="TaskLoadMetrics"/>. </param>
+    TaskManager(const std::string& store_name, clock_func clock, loaded_func on_loaded = nullptr)
+        : m_Reminders(clock),
+        m_StoreName(store_name),
+        m_Storage(std::make_shared<StoragePartitioned>(std::make_shared<StorageEncrypted>(std::make_shared<StorageBinary>()))),
+        m_Clock(clock),
+        m_OnLoaded(on_loaded)
     {
-        StorageEncrypted s(std::make_shared<Storage>());
-        s.Read(std::to_string(typeid(this).hash_code()), m_Tasks);
+        ReminderScheduler::Clock::time_point now = m_Clock();
+
+        m_Storage->SetActiveDate(mrt::time::LocalDate(now));
+        m_ActiveDay = mrt::time::ParseDate(m_Storage->GetActiveDate());
+        m_NextDayStart = mrt::time::StartOfNextDay(now);
+
+        // The rules are small and do not grow with the number of occurrences, so they are read before the tasks.
+        LoadRecurrences();
+        LoadDependencies();
+        LoadStatistics();
+
+        // The ids are seeded before the load starts, so a task added while loading never takes the id of a stored task of any day.
+        m_NextId = std::max<uint64_t>(m_NextId, m_Storage->GetNextId(m_StoreName));
+
+        m_Reminders.SetReadyCheck([this](uint64_t task_id)
+            {
+                return IsReady(task_id);
+            });
+
+        // At midnight the reminders move on to the new day, and so do the tasks.
+        m_Reminders.SetDayStartHandler([this]()
+            {
+                RollOver();
+            });
+
+        m_Loader = std::thread([this]()
+            {
+                Load();
+            });
     }
 
     /// <summary>
     /// Finalizes an instance of the <see cref="TaskManager"/> class.
-    /// Will write the tasks to the storage, when the object is destroyed.
+    /// Will wait for the tasks to finish loading, then write the tasks to the storage, when the object is destroyed.
     /// </summary>
     ~TaskManager()
 	{
-        StorageEncrypted s(std::make_shared<Storage>());
-		s.Write(std::to_string(typeid(this).hash_code()), m_Tasks);
+        m_Reminders.Stop();
+        m_Loader.join();
+
+		Save();
+
+        // The last report is written as the dump stops, so it includes the save.
+        m_StatsDump.reset();
 	}
 
+    /// <summary>
+    /// Writes the tasks to the storage, in the partition of the active day.
+    /// Only the tasks added, edited or removed since the last save are appended to the day's journal, so a save costs as much as the changes.
+    /// After an undo or redo, or if the last save failed, every task is written.
+    /// If the stored tasks failed to load, the task files are left as they are, so the tasks that could not be read are not lost.
+    /// Saves from several threads are written one after the other, changes can still be made while a save is written.
+    /// Once the clock has passed midnight the task manager rolls over to the new day first, see <see cref="RollOver"/>.
+    /// </summary>
+    /// <returns> True if the tasks were written, false otherwise. </returns>
+    bool Save()
+    {
+        RollOver();
+
+        std::lock_guard<std::mutex> save_lock(m_SaveMutex);
+
+        return WriteChanges();
+    }
+
+    /// <summary>
+    /// Moves the task manager on to the current day once the clock has passed midnight.
+    /// The active day is fixed while it lasts, so the tasks added, the occurrences expanded and the statistics counted all belong to it.
+    /// Rolling over saves the day that ended to its partition and keeps its tasks as a past day, then reads the new day's tasks,
+    /// expands its occurrences and schedules its reminders. The undo history is dropped, as a change of the day that ended cannot be undone on the new day.
+    /// It is called as the reminders pass midnight, and before each save and each task added, so a change always lands on the day it was made.
+    /// The save and the read are made under the lock, once a day. Nothing rolls over until the stored tasks have loaded,
+    /// while another save is being written, or if the day that ended could not be saved, the next call tries again.
+    /// </summary>
+    /// <returns> True if the task manager moved on to a new day, false otherwise. </returns>
+    bool RollOver()
+    {
+        std::unique_lock<std::mutex> save_lock(m_SaveMutex, std::try_to_lock);
+
+        // A save in progress holds its lock while it waits for the lock of the task manager, which the caller may hold.
+        if (!save_lock.owns_lock())
+            return false;
+
+        std::lock_guard<std::recursive_mutex> lock(m_Mutex);
+
+        ReminderScheduler::Clock::time_point now = m_Clock();
+
+        if (!m_IsLoaded || now < m_NextDayStart || !WriteChanges())
+            return false;
+
+        std::string date = mrt::time::LocalDate(now);
+
+        m_PastDays.insert_or_assign(m_Storage->GetActiveDate(), m_Tasks);
+        m_Storage->SetActiveDate(date);
+        m_ActiveDay = mrt::time::ParseDate(date);
+        m_NextDayStart = mrt::time::StartOfNextDay(now);
+
+        // The new day may already have been read as a past day, or written by an earlier session.
+        auto past_day = m_PastDays.find(date);
+
+        if (past_day != m_PastDays.end())
+        {
+            m_Tasks = past_day->second;
+            m_PastDays.erase(past_day);
+        }
+        else
+        {
+            mrt::Vector<Task> tasks;
+            m_Storage->Read(m_StoreName, tasks);
+            m_Tasks = mrt::PersistentVector<Task>(tasks);
+        }
+
+        for (const Task& task : m_Tasks)
+        {
+            m_NextId = std::max(m_NextId, task.id + 1);
+        }
+
+        m_UndoHistory.Clear();
+        m_RedoHistory.Clear();
+
+        RebuildReminders();
+        Notify();
+
+        return true;
+    }
+
+    /// <summary>
+    /// Gets a snapshot of the instrumentation, the histograms are empty when the instrumentation is compiled out.
+    /// Every change, notification, load and save is timed into a lock-free histogram.
+    /// </summary>
+    /// <returns> The latency histograms and counters. </returns>
+    TaskManagerStats Stats() const
+    {
+        TaskManagerStats stats;
+
+        stats.add = m_AddLatency.Snapshot();
+        stats.add_batch = m_AddBatchLatency.Snapshot();
+        stats.remove = m_RemoveLatency.Snapshot();
+        stats.complete = m_CompleteLatency.Snapshot();
+        stats.notify = m_NotifyLatency.Snapshot();
+        stats.load = m_LoadLatency.Snapshot();
+        stats.save = m_SaveLatency.Snapshot();
+        stats.task_count = Snapshot().Size();
+        stats.bytes_persisted = m_Storage->BytesWritten();
+        stats.notifications_sent = m_NotificationsSent.Get();
+
+        return stats;
+    }
+
+    /// <summary>
+    /// Starts writing the stats to a file at a fixed interval, replacing any dump that was already running.
+    /// An empty path stops the dump.
+    /// </summary>
+    /// <param name="path"> The file the stats are written to. </param>
+    /// <param name="interval"> The time between two writes. </param>
+    void DumpStats(const std::string& path, std::chrono::milliseconds interval = std::chrono::seconds(10))
+    {
+        m_StatsDump.reset();
+
+        if (path.empty())
+            return;
+
+        m_StatsDump = std::make_unique<mrt::metrics::PeriodicDump>(path, interval, [this]()
+            {
+                return Stats().ToString();
+            });
+    }
+
     /// <summary>
     /// Attaches the specified observer to the subject.
+    /// The observer is updated synchronously, on the thread that made the change, for every change.
+    /// While the stored tasks load that includes the loading thread, so the observer has to be thread-safe.
+    /// An observer that has to be updated on its own thread, such as a view, is attached with an executor instead.
     /// </summary>
     /// <param name="observer"> The observer. </param>
     void Attach(Observer* observer) override 
     {
-        m_Observers.PushBack(observer);
-        Notify();
+        Subscribe(observer, SubscriptionFilter());
+    }
+
+    /// <summary>
+    /// Attaches the specified observer to the subject, to be updated asynchronously on the specified executor.
+    /// Changes are coalesced, the observer is updated at most once per frame with the latest tasks.
+    /// </summary>
+    /// <param name="observer"> The observer. </param>
+    /// <param name="executor"> The executor that runs the observer's updates, such as the UI thread's event loop. </param>
+    void Attach(Observer* observer, Executor executor)
+    {
+        Subscribe(observer, SubscriptionFilter(), executor);
+    }
+
+    /// <summary>
+    /// Subscribes the specified observer to the changes that match the filter.
+    /// The filters are indexed, so each change is only matched against the filters that can match it, and only the matching observers are notified.
+    /// The observer is updated with the current tasks straight away, then only when a matching change is made.
+    /// </summary>
+    /// <param name="observer"> The observer. </param>
+    /// <param name="filter"> The changed fields, task ids and time window the observer is interested in. </param>
+    /// <param name="executor"> The executor that runs the observer's updates, or null to update it synchronously, from any thread that makes a change or loads tasks. </param>
+    void Subscribe(Observer* observer, const SubscriptionFilter& filter, Executor executor = nullptr)
+    {
+        std::lock_guard<std::recursive_mutex> lock(m_Mutex);
+
+        m_Subscriptions.Add(observer, executor != nullptr, filter);
+
+        if (executor)
+        {
+            m_Dispatcher.Add(observer, executor);
+            m_Dispatcher.Enqueue(observer, VisibleTasks());
+        }
+        else
+        {
+            observer->Update(VisibleTasks());
+        }
     }
 
     /// <summary>
     /// Detaches the specified observer from the subject.
+    /// An asynchronous observer will not be updated again once this returns.
     /// </summary>
     /// <param name="observer"> The observer. </param>
     void Detach(Observer* observer) override 
     {
-        m_Observers.Erase(mrt::Find(m_Observers.begin(), m_Observers.end(), observer));
+        SubscriptionIndex::Entry removed;
+
+        {
+            std::lock_guard<std::recursive_mutex> lock(m_Mutex);
+
+            removed = m_Subscriptions.Remove(observer);
+        }
+
+        // Removing waits for a running update, which may itself be waiting for the lock.
+        if (removed.is_async)
+        {
+            m_Dispatcher.Remove(observer);
+        }
     }
 
     /// <summary>
-    /// Notifies the observers when a task is added, removed or completed.
+    /// Notifies all the observers, regardless of their filters.
     /// </summary>
     void Notify() override 
     {
-        for (Observer* observer : m_Observers) 
+        Notify(TaskChange::Everything());
+    }
+
+    /// <summary>
+    /// Notifies the observers whose filters match the change.
+    /// Synchronous observers are updated straight away, asynchronous observers have the change queued.
+    /// </summary>
+    /// <param name="change"> The change that was made. </param>
+    void Notify(const TaskChange& change)
+    {
+        mrt::metrics::ScopedLatency latency(m_NotifyLatency);
+
+        std::lock_guard<std::recursive_mutex> lock(m_Mutex);
+
+        mrt::PersistentVector<Task> tasks = VisibleTasks();
+
+        // The views are updated first, so an observer reading a view sees the change it is notified about.
+        UpdateDependencies(change, tasks);
+        UpdateStatistics(change, tasks);
+        UpdateViews(change, tasks);
+        NotifySubscribers(change, tasks);
+    }
+
+    /// <summary>
+    /// Creates a view of the tasks that pass the filter, kept in order as the tasks change, each change moves the task in every view in O(log n).
+    /// The view includes the active day's occurrences, and stops being updated once the last reference to it is released.
+    /// </summary>
+    /// <param name="filter"> Returns true for the tasks in the view, such as <see cref="TaskFilter::Incomplete"/>, or null for every task. </param>
+    /// <param name="order"> Returns true if the first task comes before the second, such as <see cref="TaskOrder::ByStartTime"/>, or null for the order the tasks were added in. </param>
+    /// <returns> The view. </returns>
+    std::shared_ptr<TaskView> CreateView(TaskView::filter_func filter, TaskView::order_func order = nullptr)
+    {
+        std::lock_guard<std::recursive_mutex> lock(m_Mutex);
+
+        std::shared_ptr<TaskView> view = std::make_shared<TaskView>(filter, order);
+        view->Reset(VisibleTasks());
+
+        m_Views.push_back(view);
+
+        return view;
+    }
+
+    /// <summary>
+    /// Compiles a query, or gets it from the cache of prepared queries if it has been compiled before.
+    /// </summary>
+    /// <param name="query"> The query, see <see cref="TaskQuery"/> for the syntax. </param>
+    /// <param name="error"> Set to a description of the problem if the query is not valid. </param>
+    /// <returns> The compiled query, or null if the query is not valid. </returns>
+    std::shared_ptr<const TaskQuery> Prepare(const std::string& query, std::string& error)
+    {
+        std::lock_guard<std::mutex> lock(m_PreparedQueriesMutex);
+
+        auto prepared = m_PreparedQueries.find(query);
+
+        if (prepared != m_PreparedQueries.end())
+            return prepared->second;
+
+        std::shared_ptr<const TaskQuery> compiled = TaskQuery::Compile(query, error);
+
+        if (!compiled)
+            return nullptr;
+
+        // Only a few queries are run over and over, the cache is emptied rather than evicting a query at a time.
+        if (m_PreparedQueries.size() >= s_MaxPreparedQueries)
+        {
+            m_PreparedQueries.clear();
+        }
+
+        m_PreparedQueries.emplace(query, compiled);
+
+        return compiled;
+    }
+
+    /// <summary>
+    /// Finds the tasks that match a query, such as: done = false and start >= 09:00 and title ~ "deploy" order by end limit 50.
+    /// The active day's occurrences are included. A query is compiled once and cached, and one that filters on an id, a title or a time range
+    /// reads from a view used as an index. The index is created the first time it is needed, and kept up to date with every change from then on.
+    /// </summary>
+    /// <param name="query"> The query, see <see cref="TaskQuery"/> for the syntax. </param>
+    /// <param name="results"> Set to the tasks that match, in the order of the query. </param>
+    /// <returns> True if the query was run, false if it is not valid. </returns>
+    bool Query(const std::string& query, mrt::Vector<Task>& results)
+    {
+        std::string error;
+        std::shared_ptr<const TaskQuery> prepared = Prepare(query, error);
+
+        if (!prepared)
+            return false;
+
+        mrt::PersistentVector<Task> tasks;
+        std::shared_ptr<TaskView> index;
+
         {
-            observer->Update(this->m_Tasks);
+            std::lock_guard<std::recursive_mutex> lock(m_Mutex);
+
+            tasks = VisibleTasks();
+            index = QueryIndex(prepared->GetIndex());
         }
+
+        // The snapshot and the index have their own locks, so the query runs without holding up changes to the tasks.
+        results = prepared->Execute(tasks, index.get());
+
+        return true;
+    }
+
+    /// <summary>
+    /// Makes a task depend on another task, it is not ready to start until the task before it is done.
+    /// Adding a dependency that agrees with the current order is O(1), otherwise only the tasks between the two are reordered.
+    /// The dependencies are not part of the undo history, and a task that is removed loses its dependencies.
+    /// Occurrences of recurring tasks can have dependencies, which are dropped once the occurrence is no longer on the active day.
+    /// </summary>
+    /// <param name="before_id"> The id of the task that has to be done first. </param>
+    /// <param name="after_id"> The id of the task that waits for it. </param>
+    /// <returns> True if the dependency was added or already existed, false if a task does not exist or the dependency would close a cycle. </returns>
+    bool AddDependency(uint64_t before_id, uint64_t after_id)
+    {
+        std::lock_guard<std::recursive_mutex> lock(m_Mutex);
+
+        Task before;
+        Task after;
+
+        if (!FindTask(before_id, before) || !FindTask(after_id, after))
+            return false;
+
+        if (!m_Dependencies.AddEdge(before_id, after_id))
+            return false;
+
+        m_Dependencies.SetDone(before_id, before.is_done);
+        m_Dependencies.SetDone(after_id, after.is_done);
+        m_DependenciesChanged = true;
+
+        return true;
+    }
+
+    /// <summary>
+    /// Removes a dependency between two tasks.
+    /// </summary>
+    /// <param name="before_id"> The id of the task that had to be done first. </param>
+    /// <param name="after_id"> The id of the task that waited for it. </param>
+    /// <returns> True if the dependency was removed, false if there was no such dependency. </returns>
+    bool RemoveDependency(uint64_t before_id, uint64_t after_id)
+    {
+        std::lock_guard<std::recursive_mutex> lock(m_Mutex);
+
+        if (!m_Dependencies.RemoveEdge(before_id, after_id))
+            return false;
+
+        m_DependenciesChanged = true;
+        return true;
+    }
+
+    /// <summary>
+    /// Checks whether every task a task depends on is done, O(1).
+    /// </summary>
+    /// <param name="task_id"> The id of the task. </param>
+    /// <returns> True if the task can start, false if it waits for another task. </returns>
+    bool IsReady(uint64_t task_id) const
+    {
+        std::lock_guard<std::recursive_mutex> lock(m_Mutex);
+
+        return m_Dependencies.IsReady(task_id);
+    }
+
+    /// <summary>
+    /// Gets the ids of the tasks a task depends on.
+    /// </summary>
+    /// <param name="task_id"> The id of the task. </param>
+    /// <returns> The ids of the tasks that have to be done first. </returns>
+    mrt::Vector<uint64_t> GetPrerequisites(uint64_t task_id) const
+    {
+        std::lock_guard<std::recursive_mutex> lock(m_Mutex);
+
+        return m_Dependencies.GetPrerequisites(task_id);
+    }
+
+    /// <summary>
+    /// Gets every dependency between the tasks.
+    /// </summary>
+    /// <returns> The dependencies. </returns>
+    mrt::Vector<TaskDependency> GetDependencies() const
+    {
+        std::lock_guard<std::recursive_mutex> lock(m_Mutex);
+
+        return m_Dependencies.GetEdges();
+    }
+
+    /// <summary>
+    /// Gets the ids of the tasks that have dependencies, each after the tasks it depends on. O(n), the order is kept as the dependencies are added.
+    /// </summary>
+    /// <returns> The ids of the tasks in topological order. </returns>
+    mrt::Vector<uint64_t> TopologicalOrder() const
+    {
+        std::lock_guard<std::recursive_mutex> lock(m_Mutex);
+
+        return m_Dependencies.TopologicalOrder();
+    }
+
+    /// <summary>
+    /// Gets a snapshot of the measurements of the asynchronous observer dispatch.
+    /// </summary>
+    /// <returns> The dispatch queue depth, latency and delivery counts. </returns>
+    DispatchMetrics GetDispatchMetrics() const
+    {
+        return m_Dispatcher.GetMetrics();
+    }
+
+    /// <summary>
+    /// Gets the scheduler that reminds its observers when tasks start and end, it is kept up to date with every change.
+    /// </summary>
+    /// <returns> The reminder scheduler. </returns>
+    ReminderScheduler& Reminders()
+    {
+        return m_Reminders;
     }
 
     /// <summary>
@@ -72,22 +657,94 @@ public:
     /// <param name="task"> The task. </param>
     void AddTask(const Task& task) 
 	{
-		m_Tasks.PushBack(task);
-		Notify();
+        mrt::metrics::ScopedLatency latency(m_AddLatency);
+
+        RollOverIfDue();
+
+        std::lock_guard<std::recursive_mutex> lock(m_Mutex);
+
+        Task added_task(task);
+        added_task.id = NextId();
+
+        mrt::PersistentVector<Task> tasks(m_Tasks);
+		tasks.PushBack(added_task);
+		Commit(tasks, TaskChange::Added(added_task));
 	}
 
+    /// <summary>
+    /// Adds a batch of tasks as a single change, which is undone as a whole, and notifies the observers once.
+    /// The views and reminders are updated one task at a time, so a batch costs O(k log n) rather than rebuilding them.
+    /// The latency of the whole batch is recorded in its own histogram, apart from the latency of single adds.
+    /// </summary>
+    /// <param name="tasks"> The tasks, their ids are assigned by the task manager. </param>
+    void AddTasks(const mrt::Vector<Task>& tasks)
+    {
+        if (tasks.Empty())
+            return;
+
+        mrt::metrics::ScopedLatency batch_latency(m_AddBatchLatency);
+
+        RollOverIfDue();
+
+        std::lock_guard<std::recursive_mutex> lock(m_Mutex);
+
+        mrt::PersistentVector<Task> version(m_Tasks);
+
+        for (const Task& task : tasks)
+        {
+            Task added_task(task);
+            added_task.id = NextId();
+
+            version.PushBack(added_task);
+
+            TaskChange change = TaskChange::Added(added_task);
+            MarkChanged(change);
+            m_Reminders.Apply(change);
+            m_Statistics.Apply(m_ActiveDay, change);
+            UpdateViews(change, version);
+        }
+
+        PushUndo(m_Tasks);
+        m_RedoHistory.Clear();
+        m_Tasks = version;
+
+        mrt::metrics::ScopedLatency latency(m_NotifyLatency);
+
+        NotifySubscribers(TaskChange::Everything(), VisibleTasks());
+    }
+
     /// <summary>
     /// Removes the task from the tasks vector and notifies the observers.
     /// </summary>
     /// <param name="task_name"> Name of the task. </param>
     void RemoveTask(const std::string& task_name) 
 	{
-        m_Tasks.Erase(mrt::FindIf(m_Tasks.begin(), m_Tasks.end(), [task_name](const Task& task)->bool
+        mrt::metrics::ScopedLatency latency(m_RemoveLatency);
+
+        std::lock_guard<std::recursive_mutex> lock(m_Mutex);
+
+        auto task = mrt::FindIf(m_Tasks.begin(), m_Tasks.end(), [task_name](const Task& task)->bool
             {
                 return task.title == task_name;
-            }));
+            });
+
+        if (task != m_Tasks.end())
+        {
+            TaskChange change = TaskChange::Removed(*task);
+
+            mrt::PersistentVector<Task> tasks(m_Tasks);
+            tasks.Erase(task - m_Tasks.begin());
+            Commit(tasks, change);
+        }
+        else
+        {
+            Task occurrence;
 
-		Notify();
+            if (FindOccurrence(task_name, occurrence))
+            {
+                SkipOccurrence(RecurrenceSet::RuleOf(occurrence.id), m_Storage->GetActiveDate());
+            }
+        }
 	}
 
     /// <summary>
@@ -97,15 +754,986 @@ public:
     /// <param name="completed"> if set to <c>true</c> the task is completed. </param>
     void CompleteTask(const std::string& task_name, bool completed)
     {
+        mrt::metrics::ScopedLatency latency(m_CompleteLatency);
+
+        std::lock_guard<std::recursive_mutex> lock(m_Mutex);
+
         auto task = mrt::FindIf(m_Tasks.begin(), m_Tasks.end(), [task_name](const Task& task)->bool
 			{
 				return task.title == task_name;
 			});
 
-        if (task != m_Tasks.end())
+        if (task != m_Tasks.end() && task->is_done != completed)
 		{
-			task->is_done = completed;
-			Notify();
+            Task completed_task(*task);
+            completed_task.is_done = completed;
+
+            TaskChange change = TaskChange::Modified(*task, completed_task);
+
+            mrt::PersistentVector<Task> tasks(m_Tasks);
+            tasks.Set(task - m_Tasks.begin(), completed_task);
+			Commit(tasks, change);
 		}
+        else if (task == m_Tasks.end())
+        {
+            Task occurrence;
+
+            if (FindOccurrence(task_name, occurrence))
+            {
+                CompleteOccurrence(RecurrenceSet::RuleOf(occurrence.id), m_Storage->GetActiveDate(), completed);
+            }
+        }
+    }
+
+    /// <summary>
+    /// Reverts the tasks to the version before the last change and notifies the observers.
+    /// </summary>
+    /// <returns> True if there was a change to undo, false otherwise. </returns>
+    bool Undo()
+    {
+        std::lock_guard<std::recursive_mutex> lock(m_Mutex);
+
+        if (m_UndoHistory.Empty())
+            return false;
+
+        m_RedoHistory.PushBack(m_Tasks);
+        m_Tasks = m_UndoHistory.Back();
+        m_UndoHistory.PopBack();
+        MarkChanged(TaskChange::Everything());
+        RebuildReminders();
+
+        Notify();
+        return true;
+    }
+
+    /// <summary>
+    /// Re-applies the last change that was undone and notifies the observers.
+    /// </summary>
+    /// <returns> True if there was a change to redo, false otherwise. </returns>
+    bool Redo()
+    {
+        std::lock_guard<std::recursive_mutex> lock(m_Mutex);
+
+        if (m_RedoHistory.Empty())
+            return false;
+
+        PushUndo(m_Tasks);
+        m_Tasks = m_RedoHistory.Back();
+        m_RedoHistory.PopBack();
+        MarkChanged(TaskChange::Everything());
+        RebuildReminders();
+
+        Notify();
+        return true;
+    }
+
+    /// <summary>
+    /// Gets the current version of the tasks.
+    /// Taking a snapshot is O(1), the snapshot is not affected by any later changes.
+    /// </summary>
+    /// <returns> The current version of the tasks. </returns>
+    mrt::PersistentVector<Task> Snapshot() const
+    {
+        std::lock_guard<std::recursive_mutex> lock(m_Mutex);
+
+        return m_Tasks;
+    }
+
+    /// <summary>
+    /// Gets the number of changes that can be undone.
+    /// </summary>
+    /// <returns> The number of changes that can be undone. </returns>
+    uint64_t UndoCount() const
+    {
+        std::lock_guard<std::recursive_mutex> lock(m_Mutex);
+
+        return m_UndoHistory.Size();
+    }
+
+    /// <summary>
+    /// Gets the number of changes that can be redone.
+    /// </summary>
+    /// <returns> The number of changes that can be redone. </returns>
+    uint64_t RedoCount() const
+    {
+        std::lock_guard<std::recursive_mutex> lock(m_Mutex);
+
+        return m_RedoHistory.Size();
+    }
+
+    /// <summary>
+    /// Sets how many changes can be undone, the oldest versions are dropped once there are more.
+    /// Each version shares its nodes with the next, so a version costs as much as the change that replaced it.
+    /// </summary>
+    /// <param name="depth"> The number of changes that can be undone, 0 turns undo off. </param>
+    void SetUndoDepth(uint64_t depth)
+    {
+        std::lock_guard<std::recursive_mutex> lock(m_Mutex);
+
+        m_UndoDepth = depth;
+
+        while (m_UndoHistory.Size() > depth)
+        {
+            m_UndoHistory.Erase(0);
+        }
+
+        while (m_RedoHistory.Size() > depth)
+        {
+            m_RedoHistory.Erase(0);
+        }
+    }
+
+    /// <summary>
+    /// Checks whether all the stored tasks have been loaded.
+    /// </summary>
+    /// <returns> True if the tasks have been loaded, false otherwise. </returns>
+    bool IsLoaded() const
+    {
+        std::lock_guard<std::recursive_mutex> lock(m_Mutex);
+
+        return m_IsLoaded;
+    }
+
+    /// <summary>
+    /// Gets the timings of the background load of the tasks.
+    /// </summary>
+    /// <returns> The timings of the load, the fully loaded time is zero until the load has finished. </returns>
+    TaskLoadMetrics GetLoadMetrics() const
+    {
+        std::lock_guard<std::recursive_mutex> lock(m_Mutex);
+
+        return m_LoadMetrics;
+    }
+
+    /// <summary>
+    /// Gets the days that have tasks stored, including the active day once it has been saved.
+    /// </summary>
+    /// <returns> The stored days and the number of tasks in each. </returns>
+    mrt::Vector<StoragePartition> GetStoredDays() const
+    {
+        return m_Storage->GetPartitions(m_StoreName);
+    }
+
+    /// <summary>
+    /// Gets the tasks of the specified day, followed by the occurrences of the recurring tasks on that day.
+    /// The active day returns the current version of the tasks, any other day is read from its partition
+    /// the first time it is requested, and kept for later requests.
+    /// </summary>
+    /// <param name="date"> The date of the day, formatted as dd-mm-yyyy. </param>
+    /// <returns> The tasks of the day, empty if the day has no tasks stored or recurring. </returns>
+    mrt::PersistentVector<Task> LoadDay(const std::string& date)
+    {
+        {
+            std::lock_guard<std::recursive_mutex> lock(m_Mutex);
+
+            if (date == m_Storage->GetActiveDate())
+                return VisibleTasks();
+
+            auto day = m_PastDays.find(date);
+
+            if (day != m_PastDays.end())
+                return WithOccurrences(day->second, mrt::time::ParseDate(date));
+        }
+
+        mrt::Vector<Task> tasks;
+        m_Storage->ReadDay(m_StoreName, date, tasks);
+
+        std::lock_guard<std::recursive_mutex> lock(m_Mutex);
+
+        int64_t day = mrt::time::ParseDate(date);
+        mrt::PersistentVector<Task> day_tasks = WithOccurrences(m_PastDays.emplace(date, mrt::PersistentVector<Task>(tasks)).first->second, day);
+
+        // Days stored before the statistics were kept are rolled up the first time they are read.
+        if (day >= 0 && !m_Statistics.Contains(day))
+        {
+            m_Statistics.Reset(day, day_tasks);
+        }
+
+        return day_tasks;
+    }
+
+    /// <summary>
+    /// Gets the statistics of a day: the number of tasks and how many are done, their durations and the load of each hour.
+    /// The statistics are read from the day's rollup, without reading its tasks.
+    /// Days stored before the statistics were kept are empty until they have been loaded with <see cref="LoadDay"/>.
+    /// </summary>
+    /// <param name="date"> The date of the day, formatted as dd-mm-yyyy. </param>
+    /// <returns> The rollup of the day. </returns>
+    DayRollup GetDayStatistics(const std::string& date) const
+    {
+        std::lock_guard<std::recursive_mutex> lock(m_Mutex);
+
+        return m_Statistics.GetDay(mrt::time::ParseDate(date));
+    }
+
+    /// <summary>
+    /// Gets the statistics of the week, from Monday to Sunday, that a day falls in. O(7), whatever the number of tasks.
+    /// </summary>
+    /// <param name="date"> The date of a day of the week, formatted as dd-mm-yyyy. </param>
+    /// <returns> The rollups of the week's days merged into one. </returns>
+    DayRollup GetWeekStatistics(const std::string& date) const
+    {
+        std::lock_guard<std::recursive_mutex> lock(m_Mutex);
+
+        return m_Statistics.GetWeek(mrt::time::ParseDate(date));
+    }
+
+    /// <summary>
+    /// Gets the statistics of a range of days, merging one rollup per day.
+    /// Each day's completion counts, durations and hourly load are rolled up as its tasks change and stored next to them, so no tasks are read.
+    /// </summary>
+    /// <param name="from_date"> The first day of the range, formatted as dd-mm-yyyy. </param>
+    /// <param name="to_date"> The last day of the range, formatted as dd-mm-yyyy. </param>
+    /// <returns> The rollups of the days in the range merged into one. </returns>
+    DayRollup GetStatistics(const std::string& from_date, const std::string& to_date) const
+    {
+        std::lock_guard<std::recursive_mutex> lock(m_Mutex);
+
+        return m_Statistics.GetRange(mrt::time::ParseDate(from_date), mrt::time::ParseDate(to_date));
+    }
+
+    /// <summary>
+    /// Gets the rollup of every day that has statistics, in order of day, such as for a dashboard's history.
+    /// </summary>
+    /// <returns> The rollups. </returns>
+    mrt::Vector<DayRollup> GetRollups() const
+    {
+        std::lock_guard<std::recursive_mutex> lock(m_Mutex);
+
+        return m_Statistics.GetRollups();
+    }
+
+    /// <summary>
+    /// Adds a recurring task, it occurs on every day that matches the rule without being stored for each day.
+    /// The rule is stored once, and expanded into the tasks of a day when the day is viewed. Only the occurrences that were completed,
+    /// skipped or edited are stored individually.
+    /// </summary>
+    /// <param name="rule"> The rule, its id is assigned by the task manager. </param>
+    /// <returns> The id of the rule, or 0 if the rule's first day is not valid. </returns>
+    uint64_t AddRecurrence(const RecurrenceRule& rule)
+    {
+        if (rule.from_day < 0)
+            return 0;
+
+        std::lock_guard<std::recursive_mutex> lock(m_Mutex);
+
+        RecurrenceRule added_rule(rule);
+        added_rule.id = m_NextRuleId++;
+
+        m_Recurrences.AddRule(added_rule);
+        RecurrencesChanged(m_ActiveDay);
+
+        return added_rule.id;
+    }
+
+    /// <summary>
+    /// Removes a recurring task, along with the changes made to its occurrences.
+    /// </summary>
+    /// <param name="rule_id"> The id of the rule. </param>
+    /// <returns> True if the rule was removed, false if there was no such rule. </returns>
+    bool RemoveRecurrence(uint64_t rule_id)
+    {
+        std::lock_guard<std::recursive_mutex> lock(m_Mutex);
+
+        if (!m_Recurrences.RemoveRule(rule_id))
+            return false;
+
+        RecurrencesChanged(m_ActiveDay);
+        return true;
+    }
+
+    /// <summary>
+    /// Gets the recurring tasks.
+    /// </summary>
+    /// <returns> The recurrence rules. </returns>
+    mrt::Vector<RecurrenceRule> GetRecurrences() const
+    {
+        std::lock_guard<std::recursive_mutex> lock(m_Mutex);
+
+        return m_Recurrences.GetRules();
+    }
+
+    /// <summary>
+    /// Gets the occurrences of the recurring tasks on a day, expanding the day if it has not been viewed yet.
+    /// </summary>
+    /// <param name="date"> The date of the day, formatted as dd-mm-yyyy. </param>
+    /// <returns> The occurrences of the day. </returns>
+    mrt::Vector<Task> GetOccurrences(const std::string& date) const
+    {
+        std::lock_guard<std::recursive_mutex> lock(m_Mutex);
+
+        mrt::Vector<Task> occurrences;
+
+        for (const Task& occurrence : m_Recurrences.Expand(mrt::time::ParseDate(date)))
+        {
+            occurrences.PushBack(occurrence);
+        }
+
+        return occurrences;
+    }
+
+    /// <summary>
+    /// Completes a single occurrence of a recurring task.
+    /// </summary>
+    /// <param name="rule_id"> The id of the rule. </param>
+    /// <param name="date"> The date of the occurrence, formatted as dd-mm-yyyy. </param>
+    /// <param name="completed"> if set to <c>true</c> the occurrence is completed. </param>
+    /// <returns> True if the occurrence was changed, false if there was no such rule or date. </returns>
+    bool CompleteOccurrence(uint64_t rule_id, const std::string& date, bool completed)
+    {
+        return ChangeOccurrence(rule_id, date, [completed](RecurrenceException& exception)
+            {
+                exception.is_done = completed;
+            });
+    }
+
+    /// <summary>
+    /// Removes a single occurrence of a recurring task, the other occurrences are kept.
+    /// </summary>
+    /// <param name="rule_id"> The id of the rule. </param>
+    /// <param name="date"> The date of the occurrence, formatted as dd-mm-yyyy. </param>
+    /// <returns> True if the occurrence was changed, false if there was no such rule or date. </returns>
+    bool SkipOccurrence(uint64_t rule_id, const std::string& date)
+    {
+        return ChangeOccurrence(rule_id, date, [](RecurrenceException& exception)
+            {
+                exception.is_skipped = true;
+            });
+    }
+
+    /// <summary>
+    /// Replaces the title, description and times of a single occurrence of a recurring task.
+    /// </summary>
+    /// <param name="rule_id"> The id of the rule. </param>
+    /// <param name="date"> The date of the occurrence, formatted as dd-mm-yyyy. </param>
+    /// <param name="task"> The edited task. </param>
+    /// <returns> True if the occurrence was changed, false if there was no such rule or date. </returns>
+    bool EditOccurrence(uint64_t rule_id, const std::string& date, const Task& task)
+    {
+        return ChangeOccurrence(rule_id, date, [&task](RecurrenceException& exception)
+            {
+                exception.is_edited = true;
+                exception.task = task;
+            });
+    }
+
+private:
+    /// <summary>
+    /// Rolls over to the new day if the clock has passed midnight, the check is a single comparison until then.
+    /// </summary>
+    void RollOverIfDue()
+    {
+        {
+            std::lock_guard<std::recursive_mutex> lock(m_Mutex);
+
+            if (m_Clock() < m_NextDayStart)
+                return;
+        }
+
+        RollOver();
+    }
+
+    /// <summary>
+    /// Reads the tasks from the storage, runs on the loading thread.
+    /// The first screenful of tasks is published as soon as it has been decrypted,
+    /// after that the observers are notified each time the number of loaded tasks doubles, and once the load has finished.
+    /// The synchronous observers are updated on this thread, the asynchronous ones through the dispatcher on their executors.
+    /// </summary>
+    void Load()
+    {
+        mrt::metrics::ScopedLatency latency(m_LoadLatency);
+
+        uint64_t next_notify = s_FirstScreenTasks;
+        std::string error;
+
+        // An exception must not leave the loading thread, a damaged task file would end the application.
+        try
+        {
+            m_Storage->Read(m_StoreName, s_FirstScreenTasks, [this, &next_notify](mrt::Vector<Task>& batch)
+                {
+                    std::lock_guard<std::recursive_mutex> lock(m_Mutex);
+
+                    AppendLoaded(batch);
+
+                    if (m_LoadMetrics.task_count >= next_notify)
+                    {
+                        if (m_LoadMetrics.first_task_count == 0)
+                        {
+                            m_LoadMetrics.first_tasks_ms = m_LoadStopwatch.ElapsedMilliseconds();
+                            m_LoadMetrics.first_task_count = m_LoadMetrics.task_count;
+                        }
+
+                        next_notify = m_LoadMetrics.task_count * 2;
+                        Notify();
+                    }
+                });
+        }
+        catch (const std::exception& exception)
+        {
+            error = exception.what();
+        }
+        catch (...)
+        {
+            error = "unknown error";
+        }
+
+        TaskLoadMetrics metrics;
+
+        {
+            std::lock_guard<std::recursive_mutex> lock(m_Mutex);
+
+            if (!error.empty())
+            {
+                m_LoadMetrics.failed = true;
+                m_LoadMetrics.error = "the stored tasks could not be read: " + error;
+            }
+
+            if (m_LoadMetrics.first_task_count == 0)
+            {
+                m_LoadMetrics.first_tasks_ms = m_LoadStopwatch.ElapsedMilliseconds();
+                m_LoadMetrics.first_task_count = m_LoadMetrics.task_count;
+            }
+
+            m_LoadMetrics.fully_loaded_ms = m_LoadStopwatch.ElapsedMilliseconds();
+            m_IsLoaded = true;
+            m_IdsGivenWhileLoading.clear();
+            metrics = m_LoadMetrics;
+
+            Notify();
+        }
+
+        if (m_OnLoaded)
+        {
+            m_OnLoaded(metrics);
+        }
+    }
+
+    /// <summary>
+    /// Adds a batch of loaded tasks to the current version and to every version in the history.
+    /// The loaded tasks are not a change that can be undone, so undoing a change made while loading keeps them.
+    /// The ids are seeded from the store before the load, so a loaded task only has an id that was given out again
+    /// if the store lost its next id, such as a damaged manifest or a store that was not partitioned yet. It is then given a new id.
+    /// </summary>
+    /// <param name="batch"> The loaded tasks. </param>
+    void AppendLoaded(mrt::Vector<Task>& batch)
+    {
+        for (Task& task : batch)
+        {
+            if (task.id == 0 || m_IdsGivenWhileLoading.count(task.id) > 0)
+            {
+                // The stored task keeps its old id, so the whole day is written again rather than patched.
+                task.id = NextId();
+                MarkChanged(TaskChange::Everything());
+            }
+            else
+            {
+                m_NextId = std::max(m_NextId, task.id + 1);
+            }
+
+            m_Tasks.PushBack(task);
+            m_Reminders.Schedule(task);
+        }
+
+        for (mrt::PersistentVector<Task>& version : m_UndoHistory)
+        {
+            for (const Task& task : batch)
+            {
+                version.PushBack(task);
+            }
+        }
+
+        for (mrt::PersistentVector<Task>& version : m_RedoHistory)
+        {
+            for (const Task& task : batch)
+            {
+                version.PushBack(task);
+            }
+        }
+
+        m_LoadMetrics.task_count += batch.Size();
+    }
+
+    /// <summary>
+    /// Reads the recurrence rules and their exceptions from the storage.
+    /// </summary>
+    void LoadRecurrences()
+    {
+        mrt::Vector<RecurrenceRule> rules;
+        mrt::Vector<RecurrenceException> exceptions;
+
+        m_Storage->ReadRecurrences(m_StoreName, rules, exceptions);
+
+        for (const RecurrenceRule& rule : rules)
+        {
+            m_Recurrences.AddRule(rule);
+            m_NextRuleId = std::max(m_NextRuleId, rule.id + 1);
+        }
+
+        for (const RecurrenceException& exception : exceptions)
+        {
+            m_Recurrences.AddException(exception);
+        }
+
+        ScheduleOccurrences();
+    }
+
+    /// <summary>
+    /// Reads the dependencies from the storage, the tasks are marked as done once they have loaded.
+    /// </summary>
+    void LoadDependencies()
+    {
+        mrt::Vector<TaskDependency> dependencies;
+
+        m_Storage->ReadDependencies(m_StoreName, dependencies);
+
+        for (const TaskDependency& dependency : dependencies)
+        {
+            m_Dependencies.AddEdge(dependency.before, dependency.after);
+        }
+    }
+
+    /// <summary>
+    /// Reads the statistics rollups of the stored days from the storage.
+    /// </summary>
+    void LoadStatistics()
+    {
+        mrt::Vector<DayRollup> rollups;
+
+        m_Storage->ReadRollups(m_StoreName, rollups);
+
+        for (const DayRollup& rollup : rollups)
+        {
+            m_Statistics.Add(rollup);
+        }
+    }
+
+    /// <summary>
+    /// Updates the rollup of the active day for a change, a change that affects every task counts the day again.
+    /// </summary>
+    void UpdateStatistics(const TaskChange& change, const mrt::PersistentVector<Task>& tasks)
+    {
+        if (change.affects_all)
+        {
+            m_Statistics.Reset(m_ActiveDay, tasks);
+        }
+        else
+        {
+            m_Statistics.Apply(m_ActiveDay, change);
+        }
+    }
+
+    /// <summary>
+    /// Updates the dependencies for a change. A change that affects every task re-reads whether each task is done,
+    /// and once the tasks have loaded, drops the dependencies of tasks that no longer exist.
+    /// </summary>
+    void UpdateDependencies(const TaskChange& change, const mrt::PersistentVector<Task>& tasks)
+    {
+        bool removed = change.affects_all ? m_Dependencies.Refresh(tasks, m_IsLoaded) : m_Dependencies.Apply(change);
+
+        m_DependenciesChanged = m_DependenciesChanged || removed;
+    }
+
+    /// <summary>
+    /// Updates the observers whose filters match the change with the specified tasks, the views are left as they are.
+    /// </summary>
+    void NotifySubscribers(const TaskChange& change, const mrt::PersistentVector<Task>& tasks)
+    {
+        m_Subscriptions.ForEachMatch(change, [this, &tasks](const SubscriptionIndex::Entry& entry)
+            {
+                m_NotificationsSent.Add();
+
+                if (entry.is_async)
+                {
+                    m_Dispatcher.Enqueue(entry.observer, tasks);
+                }
+                else
+                {
+                    entry.observer->Update(tasks);
+                }
+            });
+    }
+
+    /// <summary>
+    /// Gets the view used as the index of a field by the queries, creating it the first time.
+    /// </summary>
+    std::shared_ptr<TaskView> QueryIndex(QueryField field)
+    {
+        if (field == QueryField::None)
+            return nullptr;
+
+        std::shared_ptr<TaskView>& index = m_QueryIndexes[field];
+
+        if (!index)
+        {
+            index = CreateView(nullptr, TaskQuery::IndexOrder(field));
+        }
+
+        return index;
+    }
+
+    /// <summary>
+    /// Updates the views for a change, a change that affects every task resets them. Views that are no longer used are dropped.
+    /// </summary>
+    void UpdateViews(const TaskChange& change, const mrt::PersistentVector<Task>& tasks)
+    {
+        auto view = m_Views.begin();
+
+        while (view != m_Views.end())
+        {
+            std::shared_ptr<TaskView> locked = view->lock();
+
+            if (!locked)
+            {
+                view = m_Views.erase(view);
+                continue;
+            }
+
+            if (change.affects_all)
+            {
+                locked->Reset(tasks);
+            }
+            else
+            {
+                locked->Apply(change);
+            }
+
+            ++view;
+        }
+    }
+
+    /// <summary>
+    /// Gets the tasks shown to the observers, the current version of the tasks followed by the active day's occurrences.
+    /// </summary>
+    mrt::PersistentVector<Task> VisibleTasks() const
+    {
+        return WithOccurrences(m_Tasks, m_ActiveDay);
+    }
+
+    /// <summary>
+    /// Appends the occurrences of a day to a version of the tasks.
+    /// </summary>
+    mrt::PersistentVector<Task> WithOccurrences(const mrt::PersistentVector<Task>& tasks, int64_t day) const
+    {
+        if (m_Recurrences.Empty())
+            return tasks;
+
+        mrt::PersistentVector<Task> combined(tasks);
+
+        for (const Task& occurrence : m_Recurrences.Expand(day))
+        {
+            combined.PushBack(occurrence);
+        }
+
+        return combined;
+    }
+
+    /// <summary>
+    /// Finds a visible task by its id, an occurrence is looked for among the active day's occurrences.
+    /// </summary>
+    bool FindTask(uint64_t id, Task& found) const
+    {
+        if (RecurrenceSet::IsOccurrenceId(id))
+        {
+            for (const Task& occurrence : m_Recurrences.Expand(m_ActiveDay))
+            {
+                if (occurrence.id == id)
+                {
+                    found = occurrence;
+                    return true;
+                }
+            }
+
+            return false;
+        }
+
+        auto task = mrt::FindIf(m_Tasks.begin(), m_Tasks.end(), [id](const Task& task)->bool
+            {
+                return task.id == id;
+            });
+
+        if (task == m_Tasks.end())
+            return false;
+
+        found = *task;
+        return true;
+    }
+
+    /// <summary>
+    /// Finds an occurrence of the active day by its title.
+    /// </summary>
+    /// <param name="title"> The title of the occurrence. </param>
+    /// <param name="occurrence"> The occurrence that was found. </param>
+    /// <returns> True if an occurrence has the title, false otherwise. </returns>
+    bool FindOccurrence(const std::string& title, Task& occurrence) const
+    {
+        if (m_Recurrences.Empty())
+            return false;
+
+        for (const Task& task : m_Recurrences.Expand(m_ActiveDay))
+        {
+            if (task.title == title)
+            {
+                occurrence = task;
+                return true;
+            }
+        }
+
+        return false;
+    }
+
+    /// <summary>
+    /// Changes the exception of a single occurrence, and notifies the observers if the occurrence is on the active day.
+    /// </summary>
+    template <typename _Func>
+    bool ChangeOccurrence(uint64_t rule_id, const std::string& date, _Func change)
+    {
+        int64_t day = mrt::time::ParseDate(date);
+
+        std::lock_guard<std::recursive_mutex> lock(m_Mutex);
+
+        const RecurrenceRule* rule = m_Recurrences.FindRule(rule_id);
+
+        if (rule == nullptr || !rule->OccursOn(day))
+            return false;
+
+        RecurrenceException exception = m_Recurrences.GetException(rule_id, day);
+        change(exception);
+        m_Recurrences.AddException(exception);
+
+        RecurrencesChanged(day);
+        return true;
+    }
+
+    /// <summary>
+    /// Marks the rules to be saved, and updates the reminders and the observers if the active day changed.
+    /// </summary>
+    void RecurrencesChanged(int64_t day)
+    {
+        m_RecurrencesChanged = true;
+
+        if (day == m_ActiveDay)
+        {
+            ScheduleOccurrences();
+            Notify();
+        }
+    }
+
+    /// <summary>
+    /// Replaces the reminders of the active day's occurrences.
+    /// </summary>
+    void ScheduleOccurrences()
+    {
+        for (uint64_t id : m_RemindedOccurrences)
+        {
+            m_Reminders.Cancel(id);
+        }
+
+        m_RemindedOccurrences.clear();
+
+        for (const Task& occurrence : m_Recurrences.Expand(m_ActiveDay))
+        {
+            m_Reminders.Schedule(occurrence);
+            m_RemindedOccurrences.push_back(occurrence.id);
+        }
+    }
+
+    /// <summary>
+    /// Replaces every reminder after the whole version of the tasks changed.
+    /// </summary>
+    void RebuildReminders()
+    {
+        m_Reminders.Rebuild(m_Tasks);
+        m_RemindedOccurrences.clear();
+        ScheduleOccurrences();
+    }
+
+    /// <summary>
+    /// Makes the specified version the current version of the tasks and notifies the observers.
+    /// The previous version is kept so the change can be undone, any undone changes can no longer be redone.
+    /// </summary>
+    /// <param name="tasks"> The new version of the tasks. </param>
+    /// <param name="change"> The change that was made, used to find the observers to notify. </param>
+    void Commit(const mrt::PersistentVector<Task>& tasks, const TaskChange& change)
+    {
+        PushUndo(m_Tasks);
+        m_RedoHistory.Clear();
+        m_Tasks = tasks;
+
+        MarkChanged(change);
+        m_Reminders.Apply(change);
+        Notify(change);
+    }
+
+    /// <summary>
+    /// Keeps a version so the change that replaced it can be undone, dropping the oldest version past the undo depth.
+    /// The loaded tasks are added to every kept version, so the depth also bounds the cost of each loaded batch.
+    /// </summary>
+    void PushUndo(const mrt::PersistentVector<Task>& version)
+    {
+        if (m_UndoDepth == 0)
+            return;
+
+        m_UndoHistory.PushBack(version);
+
+        if (m_UndoHistory.Size() > m_UndoDepth)
+        {
+            m_UndoHistory.Erase(0);
+        }
+    }
+
+    /// <summary>
+    /// Records a change to be written by the next save. Once a change affects every task, the single changes are no longer recorded.
+    /// </summary>
+    /// <param name="change"> The change that was made. </param>
+    void MarkChanged(const TaskChange& change)
+    {
+        if (m_AllChanged)
+            return;
+
+        if (change.affects_all)
+        {
+            m_AllChanged = true;
+            m_ChangedTasks.clear();
+            m_RemovedIds.clear();
+        }
+        else if ((change.fields & TaskField::Removed) != 0)
+        {
+            m_ChangedTasks.erase(change.id);
+            m_RemovedIds.insert(change.id);
+        }
+        else
+        {
+            m_ChangedTasks.insert_or_assign(change.id, change.after);
+        }
+    }
+
+    /// <summary>
+    /// Writes the changes made since the last save, the save lock has to be held.
+    /// The tasks, the recurrences, the dependencies and the rollups are copied under the lock, which is released while they are written,
+    /// so changes can be made during a save. Whatever could not be written is marked as changed again, so the next save retries it.
+    /// </summary>
+    /// <returns> True if the tasks were written, false otherwise. </returns>
+    bool WriteChanges()
+    {
+        mrt::metrics::ScopedLatency latency(m_SaveLatency);
+
+        mrt::PersistentVector<Task> tasks;
+        TaskDelta delta;
+        uint64_t next_id = 0;
+        bool all_changed = false;
+        bool load_failed = false;
+
+        bool recurrences_changed = false;
+        bool dependencies_changed = false;
+        bool rollups_changed = false;
+        mrt::Vector<RecurrenceRule> rules;
+        mrt::Vector<RecurrenceException> exceptions;
+        mrt::Vector<TaskDependency> dependencies;
+        mrt::Vector<DayRollup> rollups;
+
+        {
+            std::lock_guard<std::recursive_mutex> lock(m_Mutex);
+
+            tasks = m_Tasks;
+            all_changed = TakeChanges(delta);
+            delta.task_count = tasks.Size();
+            next_id = m_NextId;
+            load_failed = m_LoadMetrics.failed;
+
+            recurrences_changed = m_RecurrencesChanged;
+            dependencies_changed = m_DependenciesChanged;
+            rollups_changed = m_Statistics.HasChanged();
+
+            if (recurrences_changed)
+            {
+                rules = m_Recurrences.GetRules();
+                exceptions = m_Recurrences.GetExceptions();
+                m_RecurrencesChanged = false;
+            }
+
+            if (dependencies_changed)
+            {
+                dependencies = m_Dependencies.GetEdges();
+                m_DependenciesChanged = false;
+            }
+
+            if (rollups_changed)
+            {
+                rollups = m_Statistics.GetRollups();
+                m_Statistics.MarkSaved();
+            }
+        }
+
+        // The next id is recorded before the tasks, so the ids written are never given out again.
+        bool saved = !load_failed && m_Storage->SetNextId(m_StoreName, next_id) && (all_changed ? m_Storage->Write(m_StoreName, tasks.ToVector()) :
+            m_Storage->WriteDelta(m_StoreName, delta, [&tasks]()
+                {
+                    return tasks.ToVector();
+                }));
+
+        bool recurrences_written = !recurrences_changed || m_Storage->WriteRecurrences(m_StoreName, rules, exceptions);
+        bool dependencies_written = !dependencies_changed || m_Storage->WriteDependencies(m_StoreName, dependencies);
+        bool rollups_written = !rollups_changed || m_Storage->WriteRollups(m_StoreName, rollups);
+
+        std::lock_guard<std::recursive_mutex> lock(m_Mutex);
+
+        // The changes that were not written are no longer known, so the next save writes every task.
+        if (!saved)
+        {
+            MarkChanged(TaskChange::Everything());
+        }
+
+        m_RecurrencesChanged = m_RecurrencesChanged || !recurrences_written;
+        m_DependenciesChanged = m_DependenciesChanged || !dependencies_written;
+
+        if (!rollups_written)
+        {
+            m_Statistics.MarkChanged();
+        }
+
+        return saved && recurrences_written && dependencies_written && rollups_written;
+    }
+
+    /// <summary>
+    /// Moves the changes recorded since the last save into a delta, and starts recording again.
+    /// </summary>
+    /// <param name="delta"> Set to the changed and removed tasks. </param>
+    /// <returns> True if a change affected every task, so every task has to be written. </returns>
+    bool TakeChanges(TaskDelta& delta)
+    {
+        bool all_changed = m_AllChanged;
+
+        for (auto& changed : m_ChangedTasks)
+        {
+            delta.changed.PushBack(std::move(changed.second));
+        }
+
+        for (uint64_t id : m_RemovedIds)
+        {
+            delta.removed.PushBack(id);
+        }
+
+        m_ChangedTasks.clear();
+        m_RemovedIds.clear();
+        m_AllChanged = false;
+
+        return all_changed;
+    }
+
+    /// <summary>
+    /// Gives out the next task id, the ids are unique across every day of the store.
+    /// Ids given out before the stored tasks have loaded are remembered, so a loaded task with the same id can be given a new one, see <see cref="AppendLoaded"/>.
+    /// </summary>
+    /// <returns> The task id. </returns>
+    uint64_t NextId()
+    {
+        uint64_t id = m_NextId++;
+
+        if (!m_IsLoaded)
+        {
+            m_IdsGivenWhileLoading.insert(id);
+        }
+
+        return id;
     }
 };
\ No newline at end of file
@@ -0,0 +1,281 @@
+#pragma once
+
+#include "../Header Files/NoCopy.h"
+#include "../Header Files/Vector.h"
+#include "../Header Files/TaskManager.h"
+#include "../Header Files/ThreadPool.h"
+
+#include <map>
+#include <memory>
+#include <string>
+#include <vector>
+#include <cctype>
+#include <utility>
+#include <filesystem>
+#include <shared_mutex>
+
+/// <summary>
+/// A task found by a query across the lists, along with the name of its list.
+/// </summary>
+struct ListTask
+{
+    std::string list;
+    Task task;
+};
+
+/// <summary>
+/// TaskManagerRegistry class hosts many named task lists, each one a shard with its own <see cref="TaskManager"/>.
+/// Every list has its own lock, task store and observers, so changes to different lists never wait for each other.
+/// The registry lock only guards the set of lists, it is held shared while a list is used and exclusively only to open or close one.
+/// Queries across the lists are fanned out to a thread pool, one list per task.
+/// </summary>
+class TaskManagerRegistry : private NoCopy
+{
+private:
+    static constexpr const char* s_StorePrefix = "list-";
+
+    mutable std::shared_mutex m_Mutex;
+    std::map<std::string, std::unique_ptr<TaskManager>> m_Lists;
+    ThreadPool& m_Pool;
+public:
+    /// <summary>
+    /// Initializes a new instance of the <see cref="TaskManagerRegistry"/> class.
+    /// </summary>
+    /// <param name="pool"> The pool that runs the queries across the lists. </param>
+    TaskManagerRegistry(ThreadPool& pool = ThreadPool::Shared())
+        : m_Pool(pool)
+    {
+    }
+
+    /// <summary>
+    /// Gets a list, opening it if it is not open yet. A new list starts loading its stored tasks in the background.
+    /// </summary>
+    /// <param name="name"> The name of the list, made of letters, digits, '-' and '_'. </param>
+    /// <returns> The task manager of the list, or null if the name is not valid. </returns>
+    TaskManager* Open(const std::string& name)
+    {
+        if (!IsValidName(name))
+            return nullptr;
+
+        {
+            std::shared_lock<std::shared_mutex> lock(m_Mutex);
+
+            auto list = m_Lists.find(name);
+
+            if (list != m_Lists.end())
+                return list->second.get();
+        }
+
+        std::unique_lock<std::shared_mutex> lock(m_Mutex);
+
+        std::unique_ptr<TaskManager>& list = m_Lists[name];
+
+        if (!list)
+        {
+            list = std::make_unique<TaskManager>(s_StorePrefix + name);
+        }
+
+        return list.get();
+    }
+
+    /// <summary>
+    /// Gets a list that is open.
+    /// </summary>
+    /// <param name="name"> The name of the list. </param>
+    /// <returns> The task manager of the list, or null if the list is not open. </returns>
+    TaskManager* Find(const std::string& name) const
+    {
+        std::shared_lock<std::shared_mutex> lock(m_Mutex);
+
+        auto list = m_Lists.find(name);
+
+        return list != m_Lists.end() ? list->second.get() : nullptr;
+    }
+
+    /// <summary>
+    /// Closes a list, its tasks are saved and its task manager destroyed.
+    /// The caller must make sure nothing else is using the list.
+    /// </summary>
+    /// <param name="name"> The name of the list. </param>
+    /// <returns> True if the list was closed, false if it was not open. </returns>
+    bool Close(const std::string& name)
+    {
+        std::unique_ptr<TaskManager> closed;
+
+        {
+            std::unique_lock<std::shared_mutex> lock(m_Mutex);
+
+            auto list = m_Lists.find(name);
+
+            if (list == m_Lists.end())
+                return false;
+
+            closed = std::move(list->second);
+            m_Lists.erase(list);
+        }
+
+        // Saving happens outside the lock so the other lists are not held up.
+        closed.reset();
+        return true;
+    }
+
+    /// <summary>
+    /// Gets the names of the open lists.
+    /// </summary>
+    /// <returns> The names of the open lists, in order. </returns>
+    mrt::Vector<std::string> GetOpenLists() const
+    {
+        std::shared_lock<std::shared_mutex> lock(m_Mutex);
+
+        mrt::Vector<std::string> names;
+
+        for (const auto& [name, list] : m_Lists)
+        {
+            names.PushBack(name);
+        }
+
+        return names;
+    }
+
+    /// <summary>
+    /// Gets the names of the lists that have been stored in the current directory, whether they are open or not.
+    /// </summary>
+    /// <returns> The names of the stored lists, in order. </returns>
+    mrt::Vector<std::string> GetStoredLists() const
+    {
+        static const std::string s_ManifestSuffix = "-manifest.xml";
+
+        std::map<std::string, bool> found;
+        std::error_code error;
+
+        for (const auto& entry : std::filesystem::directory_iterator(std::filesystem::current_path(), error))
+        {
+            std::string file_name = entry.path().filename().string();
+
+            if (file_name.rfind(s_StorePrefix, 0) != 0 || file_name.size() <= std::string(s_StorePrefix).size() + s_ManifestSuffix.size())
+                continue;
+
+            if (file_name.compare(file_name.size() - s_ManifestSuffix.size(), s_ManifestSuffix.size(), s_ManifestSuffix) != 0)
+                continue;
+
+            found[file_name.substr(std::string(s_StorePrefix).size(), file_name.size() - std::string(s_StorePrefix).size() - s_ManifestSuffix.size())] = true;
+        }
+
+        mrt::Vector<std::string> names;
+
+        for (const auto& [name, stored] : found)
+        {
+            names.PushBack(name);
+        }
+
+        return names;
+    }
+
+    /// <summary>
+    /// Runs a function on every open list in parallel, and waits for all of them.
+    /// The lists cannot be opened or closed while the query runs.
+    /// </summary>
+    /// <param name="func"> Called with the name and the task manager of each list, from a thread of the pool. </param>
+    /// <returns> The result for each list, in the order of the list names. </returns>
+    template <typename _Func>
+    auto Query(_Func func) -> std::vector<decltype(func(std::declval<const std::string&>(), std::declval<TaskManager&>()))>
+    {
+        using Result = decltype(func(std::declval<const std::string&>(), std::declval<TaskManager&>()));
+
+        std::shared_lock<std::shared_mutex> lock(m_Mutex);
+
+        std::vector<std::future<Result>> pending;
+
+        for (const auto& [name, list] : m_Lists)
+        {
+            pending.push_back(m_Pool.Submit([&func, &name = name, list = list.get()]()
+                {
+                    return func(name, *list);
+                }));
+        }
+
+        std::vector<Result> results;
+
+        for (std::future<Result>& result : pending)
+        {
+            results.push_back(result.get());
+        }
+
+        return results;
+    }
+
+    /// <summary>
+    /// Finds the tasks that match a predicate in every open list.
+    /// Each list is searched in a snapshot of its tasks, so the lists are only locked to take the snapshot.
+    /// </summary>
+    /// <param name="predicate"> Called with each task, returns true for the tasks to find. </param>
+    /// <returns> The tasks that were found, grouped by list in the order of the list names. </returns>
+    template <typename _Predicate>
+    mrt::Vector<ListTask> FindTasks(_Predicate predicate)
+    {
+        std::vector<mrt::Vector<ListTask>> found = Query([&predicate](const std::string& name, TaskManager& list)
+            {
+                mrt::Vector<ListTask> matches;
+
+                for (const Task& task : list.Snapshot())
+                {
+                    if (predicate(task))
+                    {
+                        matches.PushBack({ name, task });
+                    }
+                }
+
+                return matches;
+            });
+
+        mrt::Vector<ListTask> tasks;
+
+        for (mrt::Vector<ListTask>& matches : found)
+        {
+            for (ListTask& match : matches)
+            {
+                tasks.PushBack(std::move(match));
+            }
+        }
+
+        return tasks;
+    }
+
+    /// <summary>
+    /// Counts the tasks of every open list.
+    /// </summary>
+    /// <returns> The total number of tasks. </returns>
+    uint64_t TaskCount()
+    {
+        uint64_t count = 0;
+
+        for (uint64_t list_count : Query([](const std::string&, TaskManager& list)
+            {
+                return list.Snapshot().Size();
+            }))
+        {
+            count += list_count;
+        }
+
+        return count;
+    }
+
+    /// <summary>
+    /// Checks whether a list name can be used in the name of its storage files.
+    /// </summary>
+    /// <param name="name"> The name of the list. </param>
+    /// <returns> True if the name is valid, false otherwise. </returns>
+    static bool IsValidName(const std::string& name)
+    {
+        if (name.empty())
+            return false;
+
+        for (char c : name)
+        {
+            if (!isalnum(static_cast<unsigned char>(c)) && c != '-' && c != '_')
+                return false;
+        }
+
+        return true;
+    }
+};
@@ -0,0 +1,986 @@
+#pragma once
+
+#include "../Header Files/NoCopy.h"
+#include "../Header Files/Task.h"
+#include "../Header Files/Vector.h"
+#include "../Header Files/TaskView.h"
+#include "../Header Files/PersistentVector.h"
+
+#include <memory>
+#include <string>
+#include <vector>
+#include <cctype>
+#include <cstdint>
+#include <iterator>
+#include <algorithm>
+#include <functional>
+
+/// <summary>
+/// The fields of a task that a query can test and order by.
+/// </summary>
+enum class QueryField
+{
+    None,
+    Id,
+    Title,
+    Description,
+    Start,
+    End,
+    Done
+};
+
+/// <summary>
+/// The comparisons of a query, ~ tests whether a text contains a word, ignoring case.
+/// </summary>
+enum class QueryOp
+{
+    Equal,
+    NotEqual,
+    Less,
+    LessEqual,
+    Greater,
+    GreaterEqual,
+    Contains
+};
+
+/// <summary>
+/// TaskQuery class is a query over the tasks, parsed and compiled once and then run any number of times.
+/// The syntax is a condition followed by an optional order and limit, every part is optional:
+///     done = false and start >= 09:00 and title ~ "deploy" order by end desc limit 50
+/// The fields are id, title, description, start, end and done, conditions are combined with and, or, not and parentheses.
+/// The condition is compiled into a tree of closures that each filter a batch of tasks, narrowing a selection of the
+/// tasks in the batch, so each test runs as a tight loop over the batch and an and only tests the tasks that are left.
+/// The top level conditions are used to plan the scan: an id, a title, or a start or end time range is read from an index,
+/// a <see cref="TaskView"/> ordered by that field, rather than testing every task. Ordering by an indexed field with a limit
+/// stops as soon as enough tasks are found.
+/// </summary>
+class TaskQuery : private NoCopy
+{
+public:
+    /// <summary>
+    /// The positions in the batch of the tasks that are still selected, in increasing order.
+    /// </summary>
+    using Selection = std::vector<uint32_t>;
+    using filter_func = std::function<void(const Task* const* batch, Selection& selection)>;
+
+    static constexpr uint32_t s_BatchSize = 256;
+
+private:
+    /// <summary>
+    /// A node of the parsed condition.
+    /// </summary>
+    struct Expression
+    {
+        enum class Kind
+        {
+            And,
+            Or,
+            Not,
+            Compare
+        };
+
+        Kind kind{ Kind::Compare };
+        std::unique_ptr<Expression> left;
+        std::unique_ptr<Expression> right;
+
+        QueryField field{ QueryField::None };
+        QueryOp op{ QueryOp::Equal };
+        std::string text;
+        uint64_t number{ 0 };
+        bool flag{ false };
+    };
+
+    /// <summary>
+    /// A token of the query text.
+    /// </summary>
+    struct Token
+    {
+        enum class Kind
+        {
+            Word,
+            String,
+            Symbol,
+            End
+        };
+
+        Kind kind{ Kind::End };
+        std::string text;
+    };
+
+    /// <summary>
+    /// How the tasks are read: every task in order, or a range of an index.
+    /// </summary>
+    struct Plan
+    {
+        QueryField index{ QueryField::None };
+        bool has_lower{ false };
+        bool has_upper{ false };
+        bool upper_inclusive{ true };
+        std::string lower_text;
+        std::string upper_text;
+        uint64_t lower_number{ 0 };
+        uint64_t upper_number{ 0 };
+    };
+
+    filter_func m_Filter;
+    Plan m_Plan;
+    QueryField m_OrderBy{ QueryField::None };
+    bool m_Descending{ false };
+    uint64_t m_Limit{ UINT64_MAX };
+
+    // Parser state, only used while compiling.
+    std::vector<Token> m_Tokens;
+    uint64_t m_Position{ 0 };
+    std::string m_Error;
+public:
+    /// <summary>
+    /// Parses and compiles a query.
+    /// </summary>
+    /// <param name="text"> The query. </param>
+    /// <param name="error"> Set to a description of the problem if the query is not valid. </param>
+    /// <returns> The compiled query, or null if the query is not valid. </returns>
+    static std::shared_ptr<const TaskQuery> Compile(const std::string& text, std::string& error)
+    {
+        std::shared_ptr<TaskQuery> query(new TaskQuery());
+
+        if (!query->Parse(text))
+        {
+            error = query->m_Error;
+            return nullptr;
+        }
+
+        return query;
+    }
+
+    /// <summary>
+    /// Gets the field whose index the query reads from, or <see cref="QueryField::None"/> if it reads every task.
+    /// </summary>
+    QueryField GetIndex() const
+    {
+        return m_Plan.index;
+    }
+
+    /// <summary>
+    /// Runs the query.
+    /// </summary>
+    /// <param name="tasks"> Every task, read when the query does not use an index. </param>
+    /// <param name="index"> The index named by <see cref="GetIndex"/>, the tasks are read in full if it is null. </param>
+    /// <returns> The tasks that match, in the order of the query. </returns>
+    mrt::Vector<Task> Execute(const mrt::PersistentVector<Task>& tasks, const TaskView* index) const
+    {
+        // Tasks come out of an index in the index order, so an ascending order on the same field needs no sort and can stop at the limit.
+        bool is_ordered = m_OrderBy == QueryField::None || (index != nullptr && m_OrderBy == m_Plan.index && !m_Descending);
+
+        Runner runner(m_Filter, is_ordered ? m_Limit : UINT64_MAX);
+
+        if (index != nullptr && m_Plan.index != QueryField::None)
+        {
+            index->ForEachFrom(LowerProbe(), [this, &runner](const Task& task)
+                {
+                    if (PastUpper(task))
+                        return false;
+
+                    // The index can change once it is unlocked, so the tasks read from it are copied into the batch.
+                    return runner.AddCopy(task);
+                });
+
+            runner.Flush();
+        }
+        else
+        {
+            for (const Task& task : tasks)
+            {
+                if (!runner.Add(&task))
+                    break;
+            }
+
+            runner.Flush();
+        }
+
+        std::vector<Task>& results = runner.Results();
+
+        if (!is_ordered)
+        {
+            QueryField field = m_OrderBy;
+            bool descending = m_Descending;
+
+            std::sort(results.begin(), results.end(), [field, descending](const Task& left, const Task& right)
+                {
+                    int compared = CompareField(left, right, field);
+
+                    if (compared == 0)
+                        return left.id < right.id;
+
+                    return descending ? compared > 0 : compared < 0;
+                });
+
+            if (results.size() > m_Limit)
+            {
+                results.resize(m_Limit);
+            }
+        }
+
+        mrt::Vector<Task> found;
+
+        for (Task& task : results)
+        {
+            found.PushBack(std::move(task));
+        }
+
+        return found;
+    }
+
+    /// <summary>
+    /// Gets the order a <see cref="TaskView"/> has to have to be used as the index of a field.
+    /// </summary>
+    /// <param name="field"> The field. </param>
+    /// <returns> The order of the index. </returns>
+    static TaskView::order_func IndexOrder(QueryField field)
+    {
+        switch (field)
+        {
+        case QueryField::Title:
+            return TaskOrder::ByTitle;
+        case QueryField::Start:
+            return TaskOrder::ByStartTime;
+        case QueryField::End:
+            return TaskOrder::ByEndTime;
+        default:
+            return TaskOrder::ById;
+        }
+    }
+
+private:
+    TaskQuery() = default;
+
+    /// <summary>
+    /// Collects the tasks into batches and runs the filter over each full batch.
+    /// </summary>
+    class Runner
+    {
+    private:
+        const filter_func& m_Filter;
+        uint64_t m_Limit;
+        std::vector<const Task*> m_Batch;
+        std::vector<Task> m_Copies;
+        Selection m_Selection;
+        std::vector<Task> m_Results;
+    public:
+        Runner(const filter_func& filter, uint64_t limit)
+            : m_Filter(filter), m_Limit(limit)
+        {
+            m_Batch.reserve(s_BatchSize);
+            m_Copies.reserve(s_BatchSize);
+            m_Selection.reserve(s_BatchSize);
+        }
+
+        /// <summary>
+        /// Adds a task to the batch, the task must stay alive until the batch is flushed.
+        /// </summary>
+        /// <returns> False once the limit has been reached. </returns>
+        bool Add(const Task* task)
+        {
+            m_Batch.push_back(task);
+
+            if (m_Batch.size() == s_BatchSize)
+            {
+                Flush();
+            }
+
+            return m_Results.size() < m_Limit;
+        }
+
+        /// <summary>
+        /// Adds a copy of a task to the batch, for tasks that may not stay alive until the batch is flushed.
+        /// </summary>
+        /// <returns> False once the limit has been reached. </returns>
+        bool AddCopy(const Task& task)
+        {
+            // The copies are reserved for a whole batch, so adding one never moves the others.
+            m_Copies.push_back(task);
+
+            return Add(&m_Copies.back());
+        }
+
+        void Flush()
+        {
+            if (m_Batch.empty())
+                return;
+
+            m_Selection.resize(m_Batch.size());
+
+            for (uint32_t i = 0; i < m_Selection.size(); i++)
+            {
+                m_Selection[i] = i;
+            }
+
+            if (m_Filter)
+            {
+                m_Filter(m_Batch.data(), m_Selection);
+            }
+
+            for (uint32_t i = 0; i < m_Selection.size() && m_Results.size() < m_Limit; i++)
+            {
+                m_Results.push_back(*m_Batch[m_Selection[i]]);
+            }
+
+            m_Batch.clear();
+            m_Copies.clear();
+        }
+
+        std::vector<Task>& Results()
+        {
+            return m_Results;
+        }
+    };
+
+    /// <summary>
+    /// Gets the task the index scan starts at, a default task comes before every task in every index.
+    /// </summary>
+    Task LowerProbe() const
+    {
+        Task probe;
+
+        if (!m_Plan.has_lower)
+            return probe;
+
+        switch (m_Plan.index)
+        {
+        case QueryField::Id:
+            probe.id = m_Plan.lower_number;
+            break;
+        case QueryField::Title:
+            probe.title = m_Plan.lower_text;
+            break;
+        case QueryField::Start:
+            probe.start_time = m_Plan.lower_text;
+            break;
+        case QueryField::End:
+            probe.end_time = m_Plan.lower_text;
+            break;
+        default:
+            break;
+        }
+
+        return probe;
+    }
+
+    /// <summary>
+    /// Checks whether the index scan has gone past the end of its range.
+    /// </summary>
+    bool PastUpper(const Task& task) const
+    {
+        if (!m_Plan.has_upper)
+            return false;
+
+        if (m_Plan.index == QueryField::Id)
+            return m_Plan.upper_inclusive ? task.id > m_Plan.upper_number : task.id >= m_Plan.upper_number;
+
+        const std::string& value = TextOf(task, m_Plan.index);
+
+        return m_Plan.upper_inclusive ? value > m_Plan.upper_text : value >= m_Plan.upper_text;
+    }
+
+    static const std::string& TextOf(const Task& task, QueryField field)
+    {
+        switch (field)
+        {
+        case QueryField::Title:
+            return task.title;
+        case QueryField::Description:
+            return task.description;
+        case QueryField::Start:
+            return task.start_time;
+        default:
+            return task.end_time;
+        }
+    }
+
+    static bool IsText(QueryField field)
+    {
+        return field == QueryField::Title || field == QueryField::Description || field == QueryField::Start || field == QueryField::End;
+    }
+
+    static int CompareField(const Task& left, const Task& right, QueryField field)
+    {
+        switch (field)
+        {
+        case QueryField::Id:
+            return left.id < right.id ? -1 : (left.id > right.id ? 1 : 0);
+        case QueryField::Done:
+            return int(left.is_done) - int(right.is_done);
+        default:
+            return TextOf(left, field).compare(TextOf(right, field));
+        }
+    }
+
+    static std::string Lower(std::string text)
+    {
+        for (char& c : text)
+        {
+            c = static_cast<char>(tolower(static_cast<unsigned char>(c)));
+        }
+
+        return text;
+    }
+
+    static bool IsNumber(const std::string& text)
+    {
+        return !text.empty() && text.size() <= 19 && std::all_of(text.begin(), text.end(), [](char c)
+            {
+                return isdigit(static_cast<unsigned char>(c)) != 0;
+            });
+    }
+
+    static bool ContainsIgnoringCase(const std::string& text, const std::string& lowered_word)
+    {
+        return std::search(text.begin(), text.end(), lowered_word.begin(), lowered_word.end(), [](char left, char right)
+            {
+                return tolower(static_cast<unsigned char>(left)) == right;
+            }) != text.end();
+    }
+
+    // Tokenizer and parser.
+
+    bool Tokenize(const std::string& text)
+    {
+        uint64_t i = 0;
+
+        while (i < text.size())
+        {
+            char c = text[i];
+
+            if (isspace(static_cast<unsigned char>(c)))
+            {
+                i++;
+            }
+            else if (c == '"')
+            {
+                Token token{ Token::Kind::String, "" };
+
+                for (i++; i < text.size() && text[i] != '"'; i++)
+                {
+                    if (text[i] == '\\' && i + 1 < text.size())
+                    {
+                        i++;
+                    }
+
+                    token.text += text[i];
+                }
+
+                if (i == text.size())
+                    return Fail("unterminated string");
+
+                i++;
+                m_Tokens.push_back(token);
+            }
+            else if (c == '(' || c == ')' || c == '=' || c == '~')
+            {
+                m_Tokens.push_back({ Token::Kind::Symbol, std::string(1, c) });
+                i++;
+            }
+            else if (c == '<' || c == '>' || c == '!')
+            {
+                std::string symbol(1, c);
+
+                if (i + 1 < text.size() && text[i + 1] == '=')
+                {
+                    symbol += '=';
+                }
+                else if (c == '!')
+                {
+                    return Fail("expected = after !");
+                }
+
+                m_Tokens.push_back({ Token::Kind::Symbol, symbol });
+                i += symbol.size();
+            }
+            else
+            {
+                Token token{ Token::Kind::Word, "" };
+
+                while (i < text.size() && !isspace(static_cast<unsigned char>(text[i])) && std::string("()=~<>!\"").find(text[i]) == std::string::npos)
+                {
+                    token.text += text[i++];
+                }
+
+                m_Tokens.push_back(token);
+            }
+        }
+
+        m_Tokens.push_back({ Token::Kind::End, "" });
+        return true;
+    }
+
+    bool Parse(const std::string& text)
+    {
+        if (!Tokenize(text))
+            return false;
+
+        std::unique_ptr<Expression> condition;
+
+        if (!IsKeyword("order") && !IsKeyword("limit") && Peek().kind != Token::Kind::End)
+        {
+            condition = ParseOr();
+
+            if (!condition)
+                return false;
+        }
+
+        if (IsKeyword("order"))
+        {
+            m_Position++;
+
+            if (!IsKeyword("by"))
+                return Fail("expected by after order");
+
+            m_Position++;
+            m_OrderBy = FieldOf(Next().text);
+
+            if (m_OrderBy == QueryField::None)
+                return Fail("unknown field to order by");
+
+            if (IsKeyword("asc") || IsKeyword("desc"))
+            {
+                m_Descending = Lower(Next().text) == "desc";
+            }
+        }
+
+        if (IsKeyword("limit"))
+        {
+            m_Position++;
+
+            const Token& limit = Next();
+
+            if (limit.kind != Token::Kind::Word || !IsNumber(limit.text))
+                return Fail("expected a number after limit");
+
+            m_Limit = std::stoull(limit.text);
+        }
+
+        if (Peek().kind != Token::Kind::End)
+            return Fail("unexpected '" + Peek().text + "'");
+
+        if (condition)
+        {
+            m_Filter = CompileExpression(*condition);
+            PlanScan(*condition);
+        }
+
+        if (m_Plan.index == QueryField::None && m_Limit != UINT64_MAX && !m_Descending
+            && (m_OrderBy == QueryField::Title || m_OrderBy == QueryField::Start || m_OrderBy == QueryField::End))
+        {
+            // The first tasks of the order are read from its index, and the scan stops at the limit.
+            m_Plan.index = m_OrderBy;
+        }
+
+        m_Tokens.clear();
+        return true;
+    }
+
+    std::unique_ptr<Expression> ParseOr()
+    {
+        std::unique_ptr<Expression> left = ParseAnd();
+
+        while (left && IsKeyword("or"))
+        {
+            m_Position++;
+            left = Combine(Expression::Kind::Or, std::move(left), ParseAnd());
+        }
+
+        return left;
+    }
+
+    std::unique_ptr<Expression> ParseAnd()
+    {
+        std::unique_ptr<Expression> left = ParseUnary();
+
+        while (left && IsKeyword("and"))
+        {
+            m_Position++;
+            left = Combine(Expression::Kind::And, std::move(left), ParseUnary());
+        }
+
+        return left;
+    }
+
+    std::unique_ptr<Expression> ParseUnary()
+    {
+        if (IsKeyword("not"))
+        {
+            m_Position++;
+            return Combine(Expression::Kind::Not, ParseUnary(), nullptr, true);
+        }
+
+        if (Peek().kind == Token::Kind::Symbol && Peek().text == "(")
+        {
+            m_Position++;
+
+            std::unique_ptr<Expression> inner = ParseOr();
+
+            if (!inner)
+                return nullptr;
+
+            if (Peek().text != ")")
+            {
+                Fail("expected )");
+                return nullptr;
+            }
+
+            m_Position++;
+            return inner;
+        }
+
+        return ParseComparison();
+    }
+
+    std::unique_ptr<Expression> ParseComparison()
+    {
+        const Token& name = Next();
+        QueryField field = name.kind == Token::Kind::Word ? FieldOf(name.text) : QueryField::None;
+
+        if (field == QueryField::None)
+        {
+            Fail("unknown field '" + name.text + "'");
+            return nullptr;
+        }
+
+        const Token& symbol = Next();
+
+        if (symbol.kind != Token::Kind::Symbol || symbol.text == "(" || symbol.text == ")")
+        {
+            Fail("expected a comparison after " + name.text);
+            return nullptr;
+        }
+
+        std::unique_ptr<Expression> comparison = std::make_unique<Expression>();
+        comparison->field = field;
+        comparison->op = OpOf(symbol.text);
+
+        const Token& value = Next();
+
+        if (value.kind != Token::Kind::Word && value.kind != Token::Kind::String)
+        {
+            Fail("expected a value after " + symbol.text);
+            return nullptr;
+        }
+
+        if (field == QueryField::Done)
+        {
+            std::string lowered = Lower(value.text);
+
+            if (lowered != "true" && lowered != "false")
+            {
+                Fail("done is compared with true or false");
+                return nullptr;
+            }
+
+            if (comparison->op != QueryOp::Equal && comparison->op != QueryOp::NotEqual)
+            {
+                Fail("done can only be compared with = or !=");
+                return nullptr;
+            }
+
+            comparison->flag = lowered == "true";
+        }
+        else if (field == QueryField::Id)
+        {
+            if (!IsNumber(value.text))
+            {
+                Fail("id is compared with a number");
+                return nullptr;
+            }
+
+            if (comparison->op == QueryOp::Contains)
+            {
+                Fail("id cannot be compared with ~");
+                return nullptr;
+            }
+
+            comparison->number = std::stoull(value.text);
+        }
+        else
+        {
+            comparison->text = comparison->op == QueryOp::Contains ? Lower(value.text) : value.text;
+        }
+
+        return comparison;
+    }
+
+    std::unique_ptr<Expression> Combine(Expression::Kind kind, std::unique_ptr<Expression> left, std::unique_ptr<Expression> right, bool is_unary = false)
+    {
+        if (!left || (!is_unary && !right))
+            return nullptr;
+
+        std::unique_ptr<Expression> combined = std::make_unique<Expression>();
+        combined->kind = kind;
+        combined->left = std::move(left);
+        combined->right = std::move(right);
+
+        return combined;
+    }
+
+    const Token& Peek() const
+    {
+        return m_Tokens[m_Position];
+    }
+
+    const Token& Next()
+    {
+        const Token& token = m_Tokens[m_Position];
+
+        if (token.kind != Token::Kind::End)
+        {
+            m_Position++;
+        }
+
+        return token;
+    }
+
+    bool IsKeyword(const char* keyword) const
+    {
+        return Peek().kind == Token::Kind::Word && Lower(Peek().text) == keyword;
+    }
+
+    bool Fail(const std::string& error)
+    {
+        if (m_Error.empty())
+        {
+            m_Error = error;
+        }
+
+        return false;
+    }
+
+    static QueryField FieldOf(const std::string& name)
+    {
+        std::string lowered = Lower(name);
+
+        if (lowered == "id")
+            return QueryField::Id;
+        if (lowered == "title")
+            return QueryField::Title;
+        if (lowered == "description")
+            return QueryField::Description;
+        if (lowered == "start")
+            return QueryField::Start;
+        if (lowered == "end")
+            return QueryField::End;
+        if (lowered == "done")
+            return QueryField::Done;
+
+        return QueryField::None;
+    }
+
+    static QueryOp OpOf(const std::string& symbol)
+    {
+        if (symbol == "!=")
+            return QueryOp::NotEqual;
+        if (symbol == "<")
+            return QueryOp::Less;
+        if (symbol == "<=")
+            return QueryOp::LessEqual;
+        if (symbol == ">")
+            return QueryOp::Greater;
+        if (symbol == ">=")
+            return QueryOp::GreaterEqual;
+        if (symbol == "~")
+            return QueryOp::Contains;
+
+        return QueryOp::Equal;
+    }
+
+    // Compiler.
+
+    /// <summary>
+    /// Creates the filter of a comparison, a loop over the selection that keeps the tasks whose field passes the test.
+    /// </summary>
+    template <typename _Get, typename _Value, typename _Test>
+    static filter_func Select(_Get get, _Value value, _Test test)
+    {
+        return [get, value, test](const Task* const* batch, Selection& selection)
+            {
+                uint64_t kept = 0;
+
+                for (uint32_t index : selection)
+                {
+                    if (test(get(*batch[index]), value))
+                    {
+                        selection[kept++] = index;
+                    }
+                }
+
+                selection.resize(kept);
+            };
+    }
+
+    template <typename _Get, typename _Value>
+    static filter_func CompileComparison(_Get get, QueryOp op, _Value value)
+    {
+        switch (op)
+        {
+        case QueryOp::NotEqual:
+            return Select(get, value, std::not_equal_to<>());
+        case QueryOp::Less:
+            return Select(get, value, std::less<>());
+        case QueryOp::LessEqual:
+            return Select(get, value, std::less_equal<>());
+        case QueryOp::Greater:
+            return Select(get, value, std::greater<>());
+        case QueryOp::GreaterEqual:
+            return Select(get, value, std::greater_equal<>());
+        default:
+            return Select(get, value, std::equal_to<>());
+        }
+    }
+
+    static filter_func CompileExpression(const Expression& expression)
+    {
+        switch (expression.kind)
+        {
+        case Expression::Kind::And:
+        {
+            filter_func left = CompileExpression(*expression.left);
+            filter_func right = CompileExpression(*expression.right);
+
+            return [left, right](const Task* const* batch, Selection& selection)
+                {
+                    left(batch, selection);
+
+                    if (!selection.empty())
+                    {
+                        right(batch, selection);
+                    }
+                };
+        }
+        case Expression::Kind::Or:
+        {
+            filter_func left = CompileExpression(*expression.left);
+            filter_func right = CompileExpression(*expression.right);
+
+            return [left, right](const Task* const* batch, Selection& selection)
+                {
+                    // The right side only tests the tasks the left side did not select.
+                    Selection rest;
+                    Selection matched(selection);
+                    left(batch, matched);
+
+                    std::set_difference(selection.begin(), selection.end(), matched.begin(), matched.end(), std::back_inserter(rest));
+
+                    if (!rest.empty())
+                    {
+                        right(batch, rest);
+                    }
+
+                    selection.clear();
+                    std::merge(matched.begin(), matched.end(), rest.begin(), rest.end(), std::back_inserter(selection));
+                };
+        }
+        case Expression::Kind::Not:
+        {
+            filter_func inner = CompileExpression(*expression.left);
+
+            return [inner](const Task* const* batch, Selection& selection)
+                {
+                    Selection matched(selection);
+                    inner(batch, matched);
+
+                    Selection rest;
+                    std::set_difference(selection.begin(), selection.end(), matched.begin(), matched.end(), std::back_inserter(rest));
+                    selection.swap(rest);
+                };
+        }
+        default:
+            break;
+        }
+
+        switch (expression.field)
+        {
+        case QueryField::Id:
+            return CompileComparison([](const Task& task)
+                {
+                    return task.id;
+                }, expression.op, expression.number);
+        case QueryField::Done:
+            return CompileComparison([](const Task& task)
+                {
+                    return task.is_done;
+                }, expression.op, expression.flag);
+        default:
+        {
+            QueryField field = expression.field;
+            auto get = [field](const Task& task) -> const std::string&
+                {
+                    return TextOf(task, field);
+                };
+
+            if (expression.op == QueryOp::Contains)
+                return Select(get, expression.text, ContainsIgnoringCase);
+
+            return CompileComparison(get, expression.op, expression.text);
+        }
+        }
+    }
+
+    /// <summary>
+    /// Picks the index to read from the comparisons that every matching task must pass, the ones joined by a top level and.
+    /// An id is preferred, then a title, then a start or end time range. Every task read from the index is still tested by the whole condition.
+    /// </summary>
+    void PlanScan(const Expression& condition)
+    {
+        std::vector<const Expression*> required;
+        CollectRequired(condition, required);
+
+        for (QueryField field : { QueryField::Id, QueryField::Title, QueryField::Start, QueryField::End })
+        {
+            for (const Expression* comparison : required)
+            {
+                if (comparison->field != field)
+                    continue;
+
+                bool is_lower = comparison->op == QueryOp::Equal || comparison->op == QueryOp::Greater || comparison->op == QueryOp::GreaterEqual;
+                bool is_upper = comparison->op == QueryOp::Equal || comparison->op == QueryOp::Less || comparison->op == QueryOp::LessEqual;
+
+                // A title is only worth reading from the index when it is known exactly.
+                if (field == QueryField::Title && comparison->op != QueryOp::Equal)
+                    continue;
+
+                if (is_lower && (!m_Plan.has_lower || comparison->text > m_Plan.lower_text || comparison->number > m_Plan.lower_number))
+                {
+                    m_Plan.has_lower = true;
+                    m_Plan.lower_text = comparison->text;
+                    m_Plan.lower_number = comparison->number;
+                }
+
+                if (is_upper && (!m_Plan.has_upper || comparison->text < m_Plan.upper_text || comparison->number < m_Plan.upper_number))
+                {
+                    m_Plan.has_upper = true;
+                    m_Plan.upper_text = comparison->text;
+                    m_Plan.upper_number = comparison->number;
+                    m_Plan.upper_inclusive = comparison->op != QueryOp::Less;
+                }
+
+                if (is_lower || is_upper)
+                {
+                    m_Plan.index = field;
+                }
+            }
+
+            if (m_Plan.index != QueryField::None)
+                return;
+        }
+    }
+
+    static void CollectRequired(const Expression& expression, std::vector<const Expression*>& required)
+    {
+        if (expression.kind == Expression::Kind::And)
+        {
+            CollectRequired(*expression.left, required);
+            CollectRequired(*expression.right, required);
+        }
+        else if (expression.kind == Expression::Kind::Compare)
+        {
+            required.push_back(&expression);
+        }
+    }
+};
@@ -0,0 +1,313 @@
+#pragma once
+
+#include "../Header Files/Task.h"
+#include "../Header Files/Time.h"
+#include "../Header Files/Vector.h"
+#include "../Header Files/Subscription.h"
+#include "../Header Files/PersistentVector.h"
+
+#include <map>
+#include <array>
+#include <cstdint>
+#include <algorithm>
+
+/// <summary>
+/// The statistics of the tasks of a single day, kept up to date as the tasks change and stored instead of the tasks
+/// so that a range of days is summarised from one rollup per day.
+/// </summary>
+struct DayRollup
+{
+    static constexpr uint64_t s_Hours = 24;
+    static constexpr uint64_t s_DurationBuckets = 12;
+
+    /// <summary>
+    /// The upper bound, in minutes, of each bucket of the duration histogram. The last bucket holds every longer task.
+    /// </summary>
+    static constexpr std::array<int, s_DurationBuckets - 1> s_DurationBounds{ 15, 30, 45, 60, 90, 120, 180, 240, 360, 480, 720 };
+
+    int64_t day{ -1 };
+    uint64_t task_count{ 0 };
+    uint64_t completed_count{ 0 };
+
+    // The tasks with a valid start and end time, only these count towards the durations and the load.
+    uint64_t timed_count{ 0 };
+    uint64_t total_minutes{ 0 };
+
+    // The minutes of tasks scheduled in each hour of the day, a task that runs past midnight is counted until midnight.
+    std::array<uint64_t, s_Hours> hourly_minutes{};
+
+    // The number of tasks in each duration bucket, see s_DurationBounds.
+    std::array<uint64_t, s_DurationBuckets> duration_counts{};
+
+    /// <summary>
+    /// Adds a task to the rollup, or takes it away.
+    /// </summary>
+    /// <param name="task"> The task. </param>
+    /// <param name="is_added"> Whether the task is added, otherwise it is taken away. </param>
+    void Count(const Task& task, bool is_added)
+    {
+        auto update = [is_added](uint64_t& value, uint64_t amount)
+            {
+                value = is_added ? value + amount : value - amount;
+            };
+
+        update(task_count, 1);
+        update(completed_count, task.is_done ? 1 : 0);
+
+        int start;
+        int end;
+
+        if (!mrt::time::ParseTimeSpan(task.start_time, task.end_time, start, end))
+            return;
+
+        // A task that runs past midnight counts its whole duration, but only the hours up to midnight, on the day it starts.
+        int duration = end - start;
+        int until = std::min(end, 24 * 60);
+
+        update(timed_count, 1);
+        update(total_minutes, duration);
+        update(duration_counts[DurationBucket(duration)], 1);
+
+        for (int hour = start / 60; hour * 60 < until; hour++)
+        {
+            int from = std::max(start, hour * 60);
+            int to = std::min(until, (hour + 1) * 60);
+
+            update(hourly_minutes[hour], to - from);
+        }
+    }
+
+    /// <summary>
+    /// Adds the counts of another rollup, used to summarise a range of days.
+    /// </summary>
+    /// <param name="other"> The other rollup. </param>
+    void Merge(const DayRollup& other)
+    {
+        task_count += other.task_count;
+        completed_count += other.completed_count;
+        timed_count += other.timed_count;
+        total_minutes += other.total_minutes;
+
+        for (uint64_t i = 0; i < s_Hours; i++)
+        {
+            hourly_minutes[i] += other.hourly_minutes[i];
+        }
+
+        for (uint64_t i = 0; i < s_DurationBuckets; i++)
+        {
+            duration_counts[i] += other.duration_counts[i];
+        }
+    }
+
+    /// <summary>
+    /// Gets the share of the tasks that are done, between 0 and 1.
+    /// </summary>
+    double CompletionRatio() const
+    {
+        return task_count > 0 ? static_cast<double>(completed_count) / task_count : 0.0;
+    }
+
+    /// <summary>
+    /// Gets the average duration of the tasks with a start and an end time, in minutes.
+    /// </summary>
+    double AverageMinutes() const
+    {
+        return timed_count > 0 ? static_cast<double>(total_minutes) / timed_count : 0.0;
+    }
+
+    bool operator==(const DayRollup& other) const
+    {
+        return day == other.day && task_count == other.task_count && completed_count == other.completed_count &&
+            timed_count == other.timed_count && total_minutes == other.total_minutes &&
+            hourly_minutes == other.hourly_minutes && duration_counts == other.duration_counts;
+    }
+
+    bool operator!=(const DayRollup& other) const
+    {
+        return !(*this == other);
+    }
+
+    /// <summary>
+    /// Gets the bucket of the duration histogram that a duration falls in.
+    /// </summary>
+    /// <param name="minutes"> The duration in minutes. </param>
+    /// <returns> The index of the bucket. </returns>
+    static uint64_t DurationBucket(int minutes)
+    {
+        return std::upper_bound(s_DurationBounds.begin(), s_DurationBounds.end(), minutes) - s_DurationBounds.begin();
+    }
+};
+
+/// <summary>
+/// TaskStatistics class holds a rollup per day, the rollup of a day is updated in O(1) for each change to its tasks.
+/// A summary of a range of days, such as a week, merges one rollup per day, so it costs O(days) however many tasks there are.
+/// Whether a rollup changed is remembered, so the rollups are only written to the storage after a change, and without scanning the tasks.
+/// </summary>
+class TaskStatistics
+{
+private:
+    std::map<int64_t, DayRollup> m_Rollups;
+    bool m_Changed{ false };
+public:
+    /// <summary>
+    /// Updates the rollup of a day for a change made to one of its tasks.
+    /// A change that affects every task has to be followed by <see cref="Reset"/>.
+    /// </summary>
+    /// <param name="day"> The day of the task, as days since 01-01-1970. </param>
+    /// <param name="change"> The change. </param>
+    void Apply(int64_t day, const TaskChange& change)
+    {
+        if (change.affects_all)
+            return;
+
+        DayRollup& rollup = Rollup(day);
+
+        if (!(change.fields & TaskField::Added))
+        {
+            rollup.Count(change.before, false);
+        }
+
+        if (!(change.fields & TaskField::Removed))
+        {
+            rollup.Count(change.after, true);
+        }
+
+        m_Changed = true;
+    }
+
+    /// <summary>
+    /// Replaces the rollup of a day by counting its tasks, O(n) in the number of tasks.
+    /// </summary>
+    /// <param name="day"> The day, as days since 01-01-1970. </param>
+    /// <param name="tasks"> Every task of the day. </param>
+    void Reset(int64_t day, const mrt::PersistentVector<Task>& tasks)
+    {
+        DayRollup rollup;
+        rollup.day = day;
+
+        for (const Task& task : tasks)
+        {
+            rollup.Count(task, true);
+        }
+
+        DayRollup& current = Rollup(day);
+
+        if (current != rollup)
+        {
+            current = rollup;
+            m_Changed = true;
+        }
+    }
+
+    /// <summary>
+    /// Adds a stored rollup, replacing the rollup of its day.
+    /// </summary>
+    /// <param name="rollup"> The rollup. </param>
+    void Add(const DayRollup& rollup)
+    {
+        m_Rollups[rollup.day] = rollup;
+    }
+
+    /// <summary>
+    /// Checks whether a day has a rollup.
+    /// </summary>
+    bool Contains(int64_t day) const
+    {
+        return m_Rollups.count(day) > 0;
+    }
+
+    /// <summary>
+    /// Gets the rollup of a day.
+    /// </summary>
+    /// <param name="day"> The day, as days since 01-01-1970. </param>
+    /// <returns> The rollup, empty if the day has no tasks counted. </returns>
+    DayRollup GetDay(int64_t day) const
+    {
+        auto rollup = m_Rollups.find(day);
+
+        if (rollup != m_Rollups.end())
+            return rollup->second;
+
+        DayRollup empty;
+        empty.day = day;
+        return empty;
+    }
+
+    /// <summary>
+    /// Summarises a range of days by merging their rollups, O(days in the range).
+    /// </summary>
+    /// <param name="from_day"> The first day of the range. </param>
+    /// <param name="to_day"> The last day of the range. </param>
+    /// <returns> The summary, its day is the first day of the range. </returns>
+    DayRollup GetRange(int64_t from_day, int64_t to_day) const
+    {
+        DayRollup summary;
+        summary.day = from_day;
+
+        for (auto rollup = m_Rollups.lower_bound(from_day); rollup != m_Rollups.end() && rollup->first <= to_day; ++rollup)
+        {
+            summary.Merge(rollup->second);
+        }
+
+        return summary;
+    }
+
+    /// <summary>
+    /// Summarises the week, from Monday to Sunday, that a day falls in.
+    /// </summary>
+    /// <param name="day"> A day of the week, as days since 01-01-1970. </param>
+    /// <returns> The summary, its day is the Monday of the week. </returns>
+    DayRollup GetWeek(int64_t day) const
+    {
+        int64_t monday = day - (mrt::time::DayOfWeek(day) + 6) % 7;
+
+        return GetRange(monday, monday + 6);
+    }
+
+    /// <summary>
+    /// Gets every rollup, in order of day.
+    /// </summary>
+    mrt::Vector<DayRollup> GetRollups() const
+    {
+        mrt::Vector<DayRollup> rollups;
+
+        for (const auto& rollup : m_Rollups)
+        {
+            rollups.PushBack(rollup.second);
+        }
+
+        return rollups;
+    }
+
+    /// <summary>
+    /// Checks whether a rollup changed since the rollups were last marked as saved.
+    /// </summary>
+    bool HasChanged() const
+    {
+        return m_Changed;
+    }
+
+    /// <summary>
+    /// Marks the rollups as saved.
+    /// </summary>
+    void MarkSaved()
+    {
+        m_Changed = false;
+    }
+
+    /// <summary>
+    /// Marks the rollups as changed, so they are written again after a save that failed.
+    /// </summary>
+    void MarkChanged()
+    {
+        m_Changed = true;
+    }
+
+private:
+    DayRollup& Rollup(int64_t day)
+    {
+        DayRollup& rollup = m_Rollups[day];
+        rollup.day = day;
+        return rollup;
+    }
+};
@@ -0,0 +1,288 @@
+#pragma once
+
+#include "../Header Files/NoCopy.h"
+#include "../Header Files/Task.h"
+#include "../Header Files/Subscription.h"
+#include "../Header Files/PersistentVector.h"
+
+#include <set>
+#include <mutex>
+#include <functional>
+#include <unordered_map>
+
+/// <summary>
+/// Filters commonly used to create a <see cref="TaskView"/>.
+/// </summary>
+namespace TaskFilter
+{
+    inline bool All(const Task&)
+    {
+        return true;
+    }
+
+    inline bool Incomplete(const Task& task)
+    {
+        return !task.is_done;
+    }
+
+    inline bool Completed(const Task& task)
+    {
+        return task.is_done;
+    }
+}
+
+/// <summary>
+/// Orders commonly used to create a <see cref="TaskView"/>, each one returns true if the first task comes before the second.
+/// The times are zero padded HH:MM, so they are ordered as text.
+/// </summary>
+namespace TaskOrder
+{
+    inline bool ById(const Task& left, const Task& right)
+    {
+        return left.id < right.id;
+    }
+
+    inline bool ByTitle(const Task& left, const Task& right)
+    {
+        return left.title < right.title;
+    }
+
+    inline bool ByStartTime(const Task& left, const Task& right)
+    {
+        return left.start_time < right.start_time;
+    }
+
+    inline bool ByEndTime(const Task& left, const Task& right)
+    {
+        return left.end_time < right.end_time;
+    }
+}
+
+/// <summary>
+/// TaskView class is a live, ordered selection of the tasks, such as the incomplete tasks ordered by start time.
+/// The tasks that pass the filter are kept in a balanced tree in view order, and each change to a task
+/// moves only that task, in O(log n), so readers iterate the view in order without ever sorting it.
+/// Views are created by the <see cref="TaskManager"/>, which keeps them up to date before it notifies its observers.
+/// A view has its own lock, so it can be read from any thread while the tasks are being changed.
+/// </summary>
+class TaskView : private NoCopy
+{
+public:
+    using filter_func = std::function<bool(const Task&)>;
+    using order_func = std::function<bool(const Task&, const Task&)>;
+
+private:
+    /// <summary>
+    /// Orders the tasks by the order of the view, tasks that are equal in that order are ordered by id so every task has its own place.
+    /// </summary>
+    struct Less
+    {
+        order_func order;
+
+        bool operator()(const Task& left, const Task& right) const
+        {
+            if (order(left, right))
+                return true;
+
+            if (order(right, left))
+                return false;
+
+            return left.id < right.id;
+        }
+    };
+
+    using Tree = std::set<Task, Less>;
+
+    filter_func m_Filter;
+
+    mutable std::mutex m_Mutex;
+    Tree m_Tasks;
+    std::unordered_map<uint64_t, Tree::iterator> m_Positions;
+
+    // The tasks in view order, built when first read after a change.
+    mutable mrt::PersistentVector<Task> m_Ordered;
+    mutable bool m_IsOrderedStale{ true };
+public:
+    /// <summary>
+    /// Initializes a new instance of the <see cref="TaskView"/> class, the view is empty until it is reset with the tasks.
+    /// </summary>
+    /// <param name="filter"> Returns true for the tasks in the view, a null filter keeps every task. </param>
+    /// <param name="order"> Returns true if the first task comes before the second, a null order sorts the tasks by id. </param>
+    TaskView(filter_func filter, order_func order)
+        : m_Filter(filter ? filter : filter_func(TaskFilter::All)), m_Tasks(Less{ order ? order : order_func(TaskOrder::ById) })
+    {
+    }
+
+    /// <summary>
+    /// Replaces the tasks of the view, O(n log n) in the number of tasks.
+    /// </summary>
+    /// <param name="tasks"> Every task, the view keeps the ones that pass its filter. </param>
+    void Reset(const mrt::PersistentVector<Task>& tasks)
+    {
+        std::lock_guard<std::mutex> lock(m_Mutex);
+
+        m_Tasks.clear();
+        m_Positions.clear();
+
+        for (const Task& task : tasks)
+        {
+            InsertLocked(task);
+        }
+
+        m_IsOrderedStale = true;
+    }
+
+    /// <summary>
+    /// Updates the view for a change to a single task, O(log n) in the number of tasks in the view.
+    /// A change that affects every task cannot be applied, the view has to be <see cref="Reset"/> instead.
+    /// </summary>
+    /// <param name="change"> The change. </param>
+    /// <returns> True if the view changed, false otherwise. </returns>
+    bool Apply(const TaskChange& change)
+    {
+        if (change.affects_all)
+            return false;
+
+        std::lock_guard<std::mutex> lock(m_Mutex);
+
+        bool changed = EraseLocked(change.id);
+
+        if (!(change.fields & TaskField::Removed))
+        {
+            changed = InsertLocked(change.after) || changed;
+        }
+
+        m_IsOrderedStale = m_IsOrderedStale || changed;
+
+        return changed;
+    }
+
+    /// <summary>
+    /// Calls the function for every task of the view, in view order.
+    /// The view is locked while the function runs, so the function must not change the tasks.
+    /// </summary>
+    /// <param name="func"> The function to call with each task. </param>
+    template <typename _Func>
+    void ForEach(_Func func) const
+    {
+        std::lock_guard<std::mutex> lock(m_Mutex);
+
+        for (const Task& task : m_Tasks)
+        {
+            func(task);
+        }
+    }
+
+    /// <summary>
+    /// Calls the function for the tasks of the view in view order, starting at the first task that does not come before the specified task.
+    /// This is a range scan when the view is used as an index, a default task starts at the beginning of the view.
+    /// The view is locked while the function runs, so the function must not change the tasks.
+    /// </summary>
+    /// <param name="first"> The task to start at, it does not have to be in the view. </param>
+    /// <param name="func"> The function to call with each task, returns false to stop. </param>
+    template <typename _Func>
+    void ForEachFrom(const Task& first, _Func func) const
+    {
+        std::lock_guard<std::mutex> lock(m_Mutex);
+
+        for (auto task = m_Tasks.lower_bound(first); task != m_Tasks.end(); ++task)
+        {
+            if (!func(*task))
+                break;
+        }
+    }
+
+    /// <summary>
+    /// Gets the tasks of the view in view order, in the form the observers are updated with.
+    /// The tasks are copied out the first time they are read after a change, later reads are O(1).
+    /// </summary>
+    /// <returns> The tasks of the view. </returns>
+    mrt::PersistentVector<Task> Tasks() const
+    {
+        std::lock_guard<std::mutex> lock(m_Mutex);
+
+        if (m_IsOrderedStale)
+        {
+            m_Ordered.Clear();
+
+            for (const Task& task : m_Tasks)
+            {
+                m_Ordered.PushBack(task);
+            }
+
+            m_IsOrderedStale = false;
+        }
+
+        return m_Ordered;
+    }
+
+    /// <summary>
+    /// Checks whether a task is in the view.
+    /// </summary>
+    /// <param name="task_id"> The id of the task. </param>
+    bool Contains(uint64_t task_id) const
+    {
+        std::lock_guard<std::mutex> lock(m_Mutex);
+
+        return m_Positions.count(task_id) > 0;
+    }
+
+    /// <summary>
+    /// Finds a task in the view by its id, O(1).
+    /// </summary>
+    /// <param name="task_id"> The id of the task. </param>
+    /// <param name="task"> Set to a copy of the task if it is in the view. </param>
+    /// <returns> True if the task is in the view, false otherwise. </returns>
+    bool Find(uint64_t task_id, Task& task) const
+    {
+        std::lock_guard<std::mutex> lock(m_Mutex);
+
+        auto found = m_Positions.find(task_id);
+
+        if (found == m_Positions.end())
+            return false;
+
+        task = *found->second;
+        return true;
+    }
+
+    /// <summary>
+    /// Gets the number of tasks in the view.
+    /// </summary>
+    uint64_t Size() const
+    {
+        std::lock_guard<std::mutex> lock(m_Mutex);
+
+        return m_Tasks.size();
+    }
+
+    /// <summary>
+    /// Checks whether the view has no tasks.
+    /// </summary>
+    bool Empty() const
+    {
+        return Size() == 0;
+    }
+
+private:
+    bool InsertLocked(const Task& task)
+    {
+        if (!m_Filter(task))
+            return false;
+
+        m_Positions[task.id] = m_Tasks.insert(task).first;
+        return true;
+    }
+
+    bool EraseLocked(uint64_t task_id)
+    {
+        auto position = m_Positions.find(task_id);
+
+        if (position == m_Positions.end())
+            return false;
+
+        m_Tasks.erase(position->second);
+        m_Positions.erase(position);
+        return true;
+    }
+};
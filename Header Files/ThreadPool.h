@@ -0,0 +1,219 @@
+#pragma once
+
+#include "../Header Files/NoCopy.h"
+
+#include <deque>
+#include <mutex>
+#include <memory>
+#include <thread>
+#include <vector>
+#include <future>
+#include <algorithm>
+#include <exception>
+#include <functional>
+#include <condition_variable>
+
+/// <summary>
+/// ThreadPool class runs functions on a fixed set of worker threads.
+/// Work is taken from a single queue in the order it was submitted, the workers finish the queued work before the pool is destroyed.
+/// </summary>
+class ThreadPool : private NoCopy
+{
+private:
+    std::mutex m_Mutex;
+    std::condition_variable m_Condition;
+    std::deque<std::function<void()>> m_Queue;
+    std::vector<std::thread> m_Workers;
+    bool m_Running{ true };
+
+    // The pool whose worker is running on this thread, null on threads that are not workers.
+    inline static thread_local const ThreadPool* s_Current{ nullptr };
+public:
+    /// <summary>
+    /// Initializes a new instance of the <see cref="ThreadPool"/> class and starts the workers.
+    /// </summary>
+    /// <param name="threads"> The number of worker threads, at least one is started. </param>
+    ThreadPool(uint64_t threads = std::thread::hardware_concurrency())
+    {
+        threads = std::max<uint64_t>(threads, 1);
+
+        for (uint64_t i = 0; i < threads; i++)
+        {
+            m_Workers.emplace_back([this]()
+                {
+                    Work();
+                });
+        }
+    }
+
+    /// <summary>
+    /// Finalizes an instance of the <see cref="ThreadPool"/> class.
+    /// Waits for the queued work to finish, then stops the workers.
+    /// </summary>
+    ~ThreadPool()
+    {
+        {
+            std::lock_guard<std::mutex> lock(m_Mutex);
+            m_Running = false;
+        }
+
+        m_Condition.notify_all();
+
+        for (std::thread& worker : m_Workers)
+        {
+            worker.join();
+        }
+    }
+
+    /// <summary>
+    /// Queues a function to run on a worker.
+    /// </summary>
+    /// <param name="func"> The function. </param>
+    /// <returns> A future that holds the result of the function, or the exception it threw. </returns>
+    template <typename _Func>
+    auto Submit(_Func func) -> std::future<decltype(func())>
+    {
+        using Result = decltype(func());
+
+        std::shared_ptr<std::packaged_task<Result()>> task = std::make_shared<std::packaged_task<Result()>>(std::move(func));
+        std::future<Result> result = task->get_future();
+
+        {
+            std::lock_guard<std::mutex> lock(m_Mutex);
+
+            m_Queue.emplace_back([task]()
+                {
+                    (*task)();
+                });
+        }
+
+        m_Condition.notify_one();
+
+        return result;
+    }
+
+    /// <summary>
+    /// Calls the function for every index in [0, count), splitting the range into one chunk per worker, and waits for them to finish.
+    /// The calling thread runs the first chunk itself. Called from a worker of the same pool, such as from work submitted to it,
+    /// the calling thread runs every index, as waiting for the other workers could wait on itself.
+    /// If the function throws, the first exception is rethrown once every chunk has finished.
+    /// </summary>
+    /// <param name="count"> The number of indexes. </param>
+    /// <param name="func"> The function to call with each index. </param>
+    template <typename _Func>
+    void ParallelFor(uint64_t count, _Func func)
+    {
+        uint64_t chunks = std::min<uint64_t>(count, m_Workers.size());
+
+        if (chunks <= 1 || s_Current == this)
+        {
+            for (uint64_t i = 0; i < count; i++)
+            {
+                func(i);
+            }
+
+            return;
+        }
+
+        uint64_t chunk_size = (count + chunks - 1) / chunks;
+        std::vector<std::future<void>> pending;
+
+        for (uint64_t begin = chunk_size; begin < count; begin += chunk_size)
+        {
+            uint64_t end = std::min(begin + chunk_size, count);
+
+            pending.push_back(Submit([&func, begin, end]()
+                {
+                    for (uint64_t i = begin; i < end; i++)
+                    {
+                        func(i);
+                    }
+                }));
+        }
+
+        // Every chunk is waited for before an exception is passed on, the chunks still refer to the function.
+        std::exception_ptr error;
+
+        try
+        {
+            for (uint64_t i = 0; i < chunk_size; i++)
+            {
+                func(i);
+            }
+        }
+        catch (...)
+        {
+            error = std::current_exception();
+        }
+
+        for (std::future<void>& chunk : pending)
+        {
+            try
+            {
+                chunk.get();
+            }
+            catch (...)
+            {
+                if (!error)
+                {
+                    error = std::current_exception();
+                }
+            }
+        }
+
+        if (error)
+        {
+            std::rethrow_exception(error);
+        }
+    }
+
+    /// <summary>
+    /// Gets the number of worker threads.
+    /// </summary>
+    uint64_t Size() const
+    {
+        return m_Workers.size();
+    }
+
+    /// <summary>
+    /// Gets a pool shared by the whole process, with one worker per hardware thread.
+    /// </summary>
+    /// <returns> The shared pool. </returns>
+    static ThreadPool& Shared()
+    {
+        static ThreadPool s_Pool;
+
+        return s_Pool;
+    }
+
+private:
+    /// <summary>
+    /// The worker thread, runs queued functions until the pool is stopped and the queue is empty.
+    /// </summary>
+    void Work()
+    {
+        s_Current = this;
+
+        while (true)
+        {
+            std::function<void()> work;
+
+            {
+                std::unique_lock<std::mutex> lock(m_Mutex);
+
+                m_Condition.wait(lock, [this]()
+                    {
+                        return !m_Running || !m_Queue.empty();
+                    });
+
+                if (m_Queue.empty())
+                    return;
+
+                work = std::move(m_Queue.front());
+                m_Queue.pop_front();
+            }
+
+            work();
+        }
+    }
+};
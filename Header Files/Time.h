@@ -1,6 +1,10 @@
 #pragma once
 
 #include <ctime>
+#include <cctype>
+#include <cstdio>
+#include <cstdint>
+#include <chrono>
 #include <string>
 
 namespace mrt 
@@ -32,5 +36,200 @@ namespace mrt
 
 			return std::string(buffer);
 		}
+
+		/// <summary>
+		/// Parses a time of day, formatted as HH:MM, into the number of minutes since midnight.
+		/// </summary>
+		/// <param name="time"> The time of day. </param>
+		/// <returns> The minutes since midnight, or -1 if the time is not valid. </returns>
+		inline int ParseMinuteOfDay(const std::string& time)
+		{
+			if (time.size() != 5 || time[2] != ':' || !isdigit(time[0]) || !isdigit(time[1]) || !isdigit(time[3]) || !isdigit(time[4]))
+				return -1;
+
+			int hours = (time[0] - '0') * 10 + (time[1] - '0');
+			int minutes = (time[3] - '0') * 10 + (time[4] - '0');
+
+			if (hours > 23 || minutes > 59)
+				return -1;
+
+			return hours * 60 + minutes;
+		}
+
+		/// <summary>
+		/// Parses the start and end time of a task, formatted as HH:MM, into minutes since the midnight the task starts after.
+		/// An end before the start is taken to be on the next day, so it is at least 24 * 60.
+		/// </summary>
+		/// <param name="start_time"> The start time. </param>
+		/// <param name="end_time"> The end time. </param>
+		/// <param name="start"> Set to the start, in minutes. </param>
+		/// <param name="end"> Set to the end, in minutes. </param>
+		/// <returns> True if both times are valid, false otherwise. </returns>
+		inline bool ParseTimeSpan(const std::string& start_time, const std::string& end_time, int& start, int& end)
+		{
+			start = ParseMinuteOfDay(start_time);
+			end = ParseMinuteOfDay(end_time);
+
+			if (start < 0 || end < 0)
+				return false;
+
+			if (end < start)
+				end += 24 * 60;
+
+			return true;
+		}
+
+		/// <summary>
+		/// Parses a date, formatted as dd-mm-yyyy, into the number of days since 01-01-1970.
+		/// </summary>
+		/// <param name="date"> The date. </param>
+		/// <returns> The days since 01-01-1970, or -1 if the date is not valid. </returns>
+		inline int64_t ParseDate(const std::string& date)
+		{
+			if (date.size() != 10 || date[2] != '-' || date[5] != '-')
+				return -1;
+
+			for (uint64_t i : { 0, 1, 3, 4, 6, 7, 8, 9 })
+			{
+				if (!isdigit(date[i]))
+					return -1;
+			}
+
+			int64_t day = (date[0] - '0') * 10 + (date[1] - '0');
+			int64_t month = (date[3] - '0') * 10 + (date[4] - '0');
+			int64_t year = std::stoll(date.substr(6, 4));
+
+			static constexpr int64_t s_MonthDays[] = { 31, 28, 31, 30, 31, 30, 31, 31, 30, 31, 30, 31 };
+			bool is_leap = (year % 4 == 0 && year % 100 != 0) || year % 400 == 0;
+
+			if (year < 1970 || month < 1 || month > 12 || day < 1 || day > s_MonthDays[month - 1] + (month == 2 && is_leap ? 1 : 0))
+				return -1;
+
+			// Counts the days from a year starting in March, so the leap day is the last day of the year.
+			int64_t shifted_year = month <= 2 ? year - 1 : year;
+			int64_t era = shifted_year / 400;
+			int64_t year_of_era = shifted_year - era * 400;
+			int64_t day_of_year = (153 * (month > 2 ? month - 3 : month + 9) + 2) / 5 + day - 1;
+			int64_t day_of_era = year_of_era * 365 + year_of_era / 4 - year_of_era / 100 + day_of_year;
+
+			return era * 146097 + day_of_era - 719468;
+		}
+
+		/// <summary>
+		/// Formats a number of days since 01-01-1970 as a date.
+		/// </summary>
+		/// <param name="days"> The days since 01-01-1970. </param>
+		/// <returns> The date, formatted as dd-mm-yyyy. </returns>
+		inline std::string FormatDate(int64_t days)
+		{
+			int64_t shifted = days + 719468;
+			int64_t era = shifted / 146097;
+			int64_t day_of_era = shifted - era * 146097;
+			int64_t year_of_era = (day_of_era - day_of_era / 1460 + day_of_era / 36524 - day_of_era / 146096) / 365;
+			int64_t day_of_year = day_of_era - (365 * year_of_era + year_of_era / 4 - year_of_era / 100);
+			int64_t shifted_month = (5 * day_of_year + 2) / 153;
+			int64_t day = day_of_year - (153 * shifted_month + 2) / 5 + 1;
+			int64_t month = shifted_month < 10 ? shifted_month + 3 : shifted_month - 9;
+			int64_t year = year_of_era + era * 400 + (month <= 2 ? 1 : 0);
+
+			char buffer[16];
+			snprintf(buffer, sizeof(buffer), "%02d-%02d-%04d", static_cast<int>(day), static_cast<int>(month), static_cast<int>(year));
+
+			return std::string(buffer);
+		}
+
+		/// <summary>
+		/// Gets the day of the week of a number of days since 01-01-1970, which was a Thursday.
+		/// </summary>
+		/// <param name="days"> The days since 01-01-1970. </param>
+		/// <returns> The day of the week, 0 for Sunday through 6 for Saturday. </returns>
+		inline int DayOfWeek(int64_t days)
+		{
+			return static_cast<int>((days + 4) % 7);
+		}
+
+		/// <summary>
+		/// Gets the local midnight at the start of the day of a point in time.
+		/// </summary>
+		/// <param name="time"> The point in time. </param>
+		/// <returns> The start of the day. </returns>
+		inline std::chrono::system_clock::time_point StartOfDay(std::chrono::system_clock::time_point time)
+		{
+			time_t seconds = std::chrono::system_clock::to_time_t(time);
+			std::tm day = *std::localtime(&seconds);
+
+			day.tm_hour = 0;
+			day.tm_min = 0;
+			day.tm_sec = 0;
+			day.tm_isdst = -1;
+
+			return std::chrono::system_clock::from_time_t(std::mktime(&day));
+		}
+
+		/// <summary>
+		/// Gets the local midnight at the start of the day after the day of a point in time.
+		/// </summary>
+		/// <param name="time"> The point in time. </param>
+		/// <returns> The start of the next day. </returns>
+		inline std::chrono::system_clock::time_point StartOfNextDay(std::chrono::system_clock::time_point time)
+		{
+			time_t seconds = std::chrono::system_clock::to_time_t(time);
+			std::tm day = *std::localtime(&seconds);
+
+			// mktime carries the day past the end of the month, and finds the midnight of a day that is not 24 hours long.
+			day.tm_mday += 1;
+			day.tm_hour = 0;
+			day.tm_min = 0;
+			day.tm_sec = 0;
+			day.tm_isdst = -1;
+
+			return std::chrono::system_clock::from_time_t(std::mktime(&day));
+		}
+
+		/// <summary>
+		/// Gets the local date of a point in time.
+		/// </summary>
+		/// <param name="time"> The point in time. </param>
+		/// <returns> The date, formatted as dd-mm-yyyy. </returns>
+		inline std::string LocalDate(std::chrono::system_clock::time_point time)
+		{
+			time_t seconds = std::chrono::system_clock::to_time_t(time);
+
+			return FormatTime(*std::localtime(&seconds), "%d-%m-%Y");
+		}
+
+		/// <summary>
+		/// A simple stopwatch that measures the time elapsed since it was started, using a steady clock.
+		/// </summary>
+		class Stopwatch
+		{
+		private:
+			std::chrono::steady_clock::time_point m_Start;
+		public:
+			/// <summary>
+			/// Starts the stopwatch.
+			/// </summary>
+			Stopwatch()
+				: m_Start(std::chrono::steady_clock::now())
+			{
+			}
+
+			/// <summary>
+			/// Restarts the stopwatch from zero.
+			/// </summary>
+			void Reset()
+			{
+				m_Start = std::chrono::steady_clock::now();
+			}
+
+			/// <summary>
+			/// Gets the time elapsed since the stopwatch was started.
+			/// </summary>
+			/// <returns> The elapsed time in milliseconds. </returns>
+			double ElapsedMilliseconds() const
+			{
+				return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - m_Start).count();
+			}
+		};
 	}
 };
\ No newline at end of file
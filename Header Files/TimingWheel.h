@@ -0,0 +1,306 @@
+#pragma once
+
+#include <vector>
+#include <cstdint>
+#include <utility>
+
+namespace mrt
+{
+    /// <summary>
+    /// TimingWheel class is a hierarchical timing wheel, it holds timers that expire at a tick and finds the expired ones as time advances.
+    /// There are four levels of 64 slots, each slot of a level covers a whole turn of the level below it.
+    /// A timer is placed in the lowest level that reaches its deadline, and moves down a level each time the wheel turns over its slot.
+    /// Timers further away than the top level are kept in an overflow list until they come within reach.
+    /// Scheduling and cancelling are O(1), advancing a tick only touches the timers that expire or move down a level.
+    /// The timers are kept in a pool and linked into their slots by index, so there is no allocation per timer once the pool has grown.
+    /// </summary>
+    /// <typeparam name="_Payload"> The value held by each timer, handed back when it expires. </typeparam>
+    template <typename _Payload>
+    class TimingWheel
+    {
+    public:
+        /// <summary>
+        /// Identifies a scheduled timer, 0 is never a valid handle.
+        /// </summary>
+        using Handle = uint64_t;
+
+    private:
+        static constexpr uint64_t s_LevelBits = 6;
+        static constexpr uint64_t s_Slots = uint64_t(1) << s_LevelBits;
+        static constexpr uint64_t s_SlotMask = s_Slots - 1;
+        static constexpr uint64_t s_Levels = 4;
+        static constexpr uint64_t s_OverflowSlot = s_Levels * s_Slots;
+        static constexpr uint32_t s_None = UINT32_MAX;
+
+        struct Entry
+        {
+            _Payload payload{};
+            uint64_t deadline{ 0 };
+            uint32_t next{ s_None };
+            uint32_t prev{ s_None };
+            uint32_t slot{ 0 };
+            uint32_t generation{ 0 };
+            bool in_use{ false };
+        };
+
+        std::vector<Entry> m_Entries;
+        uint32_t m_FreeList{ s_None };
+        uint32_t m_Heads[s_OverflowSlot + 1];
+        uint64_t m_Now;
+        uint64_t m_Size{ 0 };
+    public:
+        /// <summary>
+        /// Initializes a new instance of the <see cref="TimingWheel"/> class.
+        /// </summary>
+        /// <param name="now"> The current tick. </param>
+        TimingWheel(uint64_t now = 0)
+            : m_Now(now)
+        {
+            for (uint32_t& head : m_Heads)
+            {
+                head = s_None;
+            }
+        }
+
+        /// <summary>
+        /// Schedules a timer.
+        /// A deadline that is not after the current tick expires on the next tick.
+        /// </summary>
+        /// <param name="deadline"> The tick the timer expires at. </param>
+        /// <param name="payload"> The value handed back when the timer expires. </param>
+        /// <returns> The handle of the timer, used to cancel it. </returns>
+        Handle Schedule(uint64_t deadline, _Payload payload)
+        {
+            uint32_t index = Allocate();
+            Entry& entry = m_Entries[index];
+
+            entry.payload = std::move(payload);
+            entry.deadline = deadline > m_Now ? deadline : m_Now + 1;
+            entry.in_use = true;
+
+            Place(index);
+            m_Size++;
+
+            return (uint64_t(entry.generation) << 32) | (uint64_t(index) + 1);
+        }
+
+        /// <summary>
+        /// Cancels a timer that has not expired.
+        /// </summary>
+        /// <param name="handle"> The handle of the timer. </param>
+        /// <returns> True if the timer was cancelled, false if it had already expired or been cancelled. </returns>
+        bool Cancel(Handle handle)
+        {
+            uint64_t index = (handle & UINT32_MAX);
+
+            if (index == 0 || index > m_Entries.size())
+                return false;
+
+            index--;
+
+            Entry& entry = m_Entries[index];
+
+            if (!entry.in_use || entry.generation != (handle >> 32))
+                return false;
+
+            Unlink(static_cast<uint32_t>(index));
+            Release(static_cast<uint32_t>(index));
+            m_Size--;
+
+            return true;
+        }
+
+        /// <summary>
+        /// Advances the wheel to the specified tick, handing the payload of every timer that expires to the function.
+        /// The function may schedule and cancel timers, timers it schedules expire on a later tick.
+        /// </summary>
+        /// <param name="now"> The tick to advance to, a tick that is not after the current tick does nothing. </param>
+        /// <param name="on_expired"> Called with the payload of each expired timer. </param>
+        template <typename _Func>
+        void Advance(uint64_t now, _Func on_expired)
+        {
+            while (m_Now < now)
+            {
+                m_Now++;
+
+                // Each level turns over when the levels below it wrap, moving the timers of its next slot down.
+                if ((m_Now & s_SlotMask) == 0)
+                {
+                    uint64_t level = 1;
+
+                    while (level < s_Levels && ((m_Now >> (level * s_LevelBits)) & s_SlotMask) == 0)
+                    {
+                        level++;
+                    }
+
+                    if (level == s_Levels)
+                    {
+                        Cascade(s_OverflowSlot);
+                        level--;
+                    }
+
+                    for (; level >= 1; level--)
+                    {
+                        Cascade(level * s_Slots + ((m_Now >> (level * s_LevelBits)) & s_SlotMask));
+                    }
+                }
+
+                uint32_t index = m_Heads[m_Now & s_SlotMask];
+                m_Heads[m_Now & s_SlotMask] = s_None;
+
+                while (index != s_None)
+                {
+                    uint32_t next = m_Entries[index].next;
+                    _Payload payload = std::move(m_Entries[index].payload);
+
+                    Release(index);
+                    m_Size--;
+
+                    on_expired(payload);
+
+                    index = next;
+                }
+            }
+        }
+
+        /// <summary>
+        /// Gets the current tick.
+        /// </summary>
+        uint64_t Now() const
+        {
+            return m_Now;
+        }
+
+        /// <summary>
+        /// Gets the number of timers that have not expired.
+        /// </summary>
+        uint64_t Size() const
+        {
+            return m_Size;
+        }
+
+        /// <summary>
+        /// Checks whether there are no timers.
+        /// </summary>
+        bool Empty() const
+        {
+            return m_Size == 0;
+        }
+
+        /// <summary>
+        /// Cancels every timer.
+        /// </summary>
+        void Clear()
+        {
+            m_Entries.clear();
+            m_FreeList = s_None;
+            m_Size = 0;
+
+            for (uint32_t& head : m_Heads)
+            {
+                head = s_None;
+            }
+        }
+
+    private:
+        /// <summary>
+        /// Takes an entry from the free list, or grows the pool.
+        /// </summary>
+        uint32_t Allocate()
+        {
+            if (m_FreeList != s_None)
+            {
+                uint32_t index = m_FreeList;
+                m_FreeList = m_Entries[index].next;
+                return index;
+            }
+
+            m_Entries.emplace_back();
+            return static_cast<uint32_t>(m_Entries.size() - 1);
+        }
+
+        /// <summary>
+        /// Returns an entry to the free list, the generation is bumped so old handles no longer match.
+        /// </summary>
+        void Release(uint32_t index)
+        {
+            Entry& entry = m_Entries[index];
+
+            entry.payload = _Payload();
+            entry.in_use = false;
+            entry.generation++;
+            entry.prev = s_None;
+            entry.next = m_FreeList;
+
+            m_FreeList = index;
+        }
+
+        /// <summary>
+        /// Links an entry into the slot that reaches its deadline.
+        /// </summary>
+        void Place(uint32_t index)
+        {
+            Entry& entry = m_Entries[index];
+            uint64_t delta = entry.deadline - m_Now;
+            uint32_t slot = s_OverflowSlot;
+
+            for (uint64_t level = 0; level < s_Levels; level++)
+            {
+                if (delta < (uint64_t(1) << ((level + 1) * s_LevelBits)))
+                {
+                    slot = static_cast<uint32_t>(level * s_Slots + ((entry.deadline >> (level * s_LevelBits)) & s_SlotMask));
+                    break;
+                }
+            }
+
+            entry.slot = slot;
+            entry.prev = s_None;
+            entry.next = m_Heads[slot];
+
+            if (entry.next != s_None)
+            {
+                m_Entries[entry.next].prev = index;
+            }
+
+            m_Heads[slot] = index;
+        }
+
+        /// <summary>
+        /// Unlinks an entry from its slot.
+        /// </summary>
+        void Unlink(uint32_t index)
+        {
+            Entry& entry = m_Entries[index];
+
+            if (entry.prev != s_None)
+            {
+                m_Entries[entry.prev].next = entry.next;
+            }
+            else
+            {
+                m_Heads[entry.slot] = entry.next;
+            }
+
+            if (entry.next != s_None)
+            {
+                m_Entries[entry.next].prev = entry.prev;
+            }
+        }
+
+        /// <summary>
+        /// Places every entry of a slot again, relative to the current tick, which moves them down a level.
+        /// </summary>
+        void Cascade(uint32_t slot)
+        {
+            uint32_t index = m_Heads[slot];
+            m_Heads[slot] = s_None;
+
+            while (index != s_None)
+            {
+                uint32_t next = m_Entries[index].next;
+                Place(index);
+                index = next;
+            }
+        }
+    };
+}
@@ -1,6 +1,9 @@
 #pragma once
 
+#include <new>
 #include <cstdint>
+#include <utility>
+#include <stdexcept>
 
 #define NODISCARD [[nodiscard]]
 
@@ -359,6 +362,8 @@ namespace mrt
                 other.m_Size = 0;
                 other.m_Capacity = 20;
             }
+
+            return *this;
         }
 
         /// <summary>
@@ -402,7 +407,7 @@ namespace mrt
         {
             if (m_Size >= m_Capacity)
             {
-                Reserve(m_Capacity * 2);
+                Reserve(m_Capacity > 0 ? m_Capacity * 2 : 1);
             }
 
             new (&m_Data[m_Size++]) _Type(value);
@@ -421,7 +426,7 @@ namespace mrt
         {
             if (m_Size >= m_Capacity)
             {
-                Reserve(m_Capacity * 2);
+                Reserve(m_Capacity > 0 ? m_Capacity * 2 : 1);
             }
 
             new(&m_Data[m_Size]) _Type(std::forward<_Args>(args)...);
@@ -495,13 +500,12 @@ namespace mrt
                 throw std::out_of_range("Index out of range");
             }
 
-            m_Data[index].~_Type();
-
             for (SizeType i = index; i < m_Size - 1; i++)
             {
-                m_Data[i] = m_Data[i + 1];
+                m_Data[i] = std::move(m_Data[i + 1]);
             }
 
+            m_Data[m_Size - 1].~_Type();
             m_Size--;
         }
 
@@ -581,7 +585,7 @@ namespace mrt
         {
             if (m_Size >= m_Capacity)
             {
-                Reserve(m_Capacity * 2);
+                Reserve(m_Capacity > 0 ? m_Capacity * 2 : 1);
             }
 
             for (auto it = end(); it != position; it--)
@@ -606,7 +610,7 @@ namespace mrt
         {
             if (m_Size >= m_Capacity)
             {
-                Reserve(m_Capacity * 2);
+                Reserve(m_Capacity > 0 ? m_Capacity * 2 : 1);
             }
 
             for (auto it = cend(); it != position; it--)
@@ -13,10 +13,15 @@ public:
 	using add_task_click_func = std::function<void(const Task&)>;
 	using remove_task_click_func = std::function<void(const std::string&)>;
 	using check_task_click_func = std::function<void(const std::string&, bool)>;
+	using history_click_func = std::function<void()>;
+	using first_frame_func = std::function<void()>;
 
 	add_task_click_func OnAddTaskClick;
 	remove_task_click_func OnRemoveTaskClick;
 	check_task_click_func OnCheckTaskClick;
+	history_click_func OnUndoClick;
+	history_click_func OnRedoClick;
+	first_frame_func OnFirstFrame;
 
 private:
 	cycfi::elements::color m_BackgroundColor;
@@ -33,10 +38,12 @@ private:
 	std::string m_NewTaskDescription;
 	std::pair<std::string, std::string> m_NewTaskStartTime = { "00", "00" };
 	std::pair<std::string, std::string> m_NewTaskEndTime = { "00", "00" };
+
+	bool m_HasDrawnFrame = false;
 public:
 	View(std::shared_ptr<cycfi::elements::window> main_window, const cycfi::elements::color& background_color);
 
 	void InitView();
 
-	void Update(const mrt::Vector<Task>& tasks) override;
+	void Update(const mrt::PersistentVector<Task>& tasks) override;
 };
\ No newline at end of file
@@ -7,8 +7,9 @@
 // It is designed to be simple and easy to use.
 
 #include <deque>
-#include <format>
+#include <cstdio>
 #include <string>
+#include <string_view>
 #include <vector>
 #include <sstream>
 #include <fstream>
@@ -62,6 +63,7 @@ namespace mrt
 		const std::string& GetName() const;
 
 		void SetValue(std::string value);
+		std::string& GetValue();
 		const std::string& GetValue() const;
 
 		XML_Node& AddAttribute(const std::string& name, const std::string& value);
@@ -150,6 +152,125 @@ namespace mrt
 		static void WriteDocumentToStream(std::ostream* fs, const XML_Document& document, bool addProlog = true, bool newLines = true);
 	};
 
+	/********************************/
+	/* XML_StreamWriter Declaration */
+	/********************************/
+
+	/// <summary>
+	/// XML_StreamWriter writes an xml document to a file node by node, without building the document first.
+	/// The text is gathered in a buffer and written to the file in large blocks, so writing takes as much memory as the buffer,
+	/// however large the document. The buffer is supplied by the caller so it can be reused from one document to the next.
+	/// It writes the same text as <see cref="XML_Document::WriteDocument"/> for the same nodes.
+	/// It can also gather the whole document in the buffer, for a caller that changes the text before writing it.
+	/// </summary>
+	class XML_StreamWriter
+	{
+	public:
+		static constexpr uint64_t s_DefaultBlockSize = 1 << 20;
+
+	private:
+		std::FILE* m_File;
+		std::string& m_Buffer;
+		uint64_t m_BlockSize;
+		bool m_NewLines;
+		bool m_Failed;
+		bool m_ToBuffer;
+	public:
+		// Constructors
+		XML_StreamWriter(std::string& buffer, bool newLines = true, uint64_t blockSize = s_DefaultBlockSize);
+		~XML_StreamWriter();
+
+		// Copiers & Assignments
+		XML_StreamWriter(const XML_StreamWriter& other) = delete;
+		XML_StreamWriter(XML_StreamWriter&& other) noexcept = delete;
+		XML_StreamWriter& operator=(const XML_StreamWriter& other) = delete;
+
+		// Member Functions
+		XML_Document_FileError Open(const std::string& path);
+
+		XML_Document_FileError Open();
+
+		void WriteProlog(const std::string& version);
+
+		void WriteStartNode(std::string_view name, uint32_t tabs, const std::vector<XML_Attribute>& attributes = {});
+
+		void WriteEndNode(std::string_view name, uint32_t tabs);
+
+		void WriteNode(std::string_view name, std::string_view value, uint32_t tabs);
+
+		XML_Document_FileError Close();
+
+	private:
+		void Append(std::string_view text);
+
+		void AppendTabs(uint32_t tabs);
+
+		void EndLine();
+
+		void Flush();
+	};
+
+	/***************************/
+	/* XML_Handler Declaration */
+	/***************************/
+
+	/// <summary>
+	/// XML_Handler receives the parts of an xml document from an <see cref="XML_StreamReader"/> in the order they are read.
+	/// The names and the text point into the text being read, so they are only valid during the call.
+	/// </summary>
+	class XML_Handler
+	{
+	public:
+		virtual ~XML_Handler() = default;
+
+		// Called for the start node of each node, and for a self ending node followed straight away by its end node.
+		virtual void OnStartNode(std::string_view name, const std::vector<XML_Attribute>& attributes) = 0;
+
+		// Called for each run of text between two nodes, the new lines in it are not removed.
+		virtual void OnValue(std::string_view text) = 0;
+
+		// Called for the end node of each node, once its name has been matched to the start node.
+		virtual void OnEndNode(std::string_view name) = 0;
+	};
+
+	/********************************/
+	/* XML_StreamReader Declaration */
+	/********************************/
+
+	/// <summary>
+	/// XML_StreamReader reads an xml document from start to end and hands each node to an <see cref="XML_Handler"/> as it is read,
+	/// without building the document. It keeps only the names of the open nodes, which point into the text,
+	/// so reading takes no more memory than the handler keeps, however large the document.
+	/// A file is mapped into memory and read where it lies.
+	/// The prolog, comments and any text before the root node are skipped, and reading stops when the root node ends.
+	/// </summary>
+	class XML_StreamReader
+	{
+	private:
+		XML_Handler& m_Handler;
+		std::vector<std::string_view> m_OpenNodes;
+		std::vector<XML_Attribute> m_Attributes;
+	public:
+		// Constructors
+		XML_StreamReader(XML_Handler& handler);
+
+		// Copiers & Assignments
+		XML_StreamReader(const XML_StreamReader& other) = delete;
+		XML_StreamReader(XML_StreamReader&& other) noexcept = delete;
+		XML_StreamReader& operator=(const XML_StreamReader& other) = delete;
+
+		// Member Functions
+		XML_Document_FileError ReadFile(const std::string& path);
+
+		void Read(const char* begin, const char* end);
+
+		// Static Functions
+		static bool CopyValue(std::string_view text, std::string& value);
+
+	private:
+		void ReadAttributes(const char* begin, const char* end);
+	};
+
 	/************************/
 	/* MrT Global Functions */
 	/************************/
@@ -170,106 +291,44 @@ namespace mrt
 	/// </summary>
 	namespace mrtInternal
 	{
-		/// <summary>
-		/// Enum class for XML token types.
-		/// TAG_START: Start of a tag.
-		/// TAG_END: End of a tag.
-		/// TAG_SELF_END: Self ending tag.
-		/// VALUE: Value of a tag.
-		/// END_OF_STRING: End of the string.
-		/// </summary>
-		enum class XML_Token_Type : uint8_t
-		{
-			TAG_START = 0,
-			TAG_END = 1,
-			TAG_SELF_END = 2,
-			VALUE = 3,
-			END_OF_STRING = 4
-		};
-
-		/*************************/
-		/* XML_Token Declaration */
-		/*************************/
-
-		/// <summary>
-		/// XML_Token is a simple struct that holds the type and data of a token.
-		/// </summary>
-		struct XML_Token
-		{
-			XML_Token_Type m_Type;
-			std::string m_Data;
-		};
-
-		/*****************************/
-		/* XML_Tokenizer Declaration */
-		/*****************************/
+		/**********************************/
+		/* XML_InPlace_Parser Declaration */
+		/**********************************/
 
 		/// <summary>
-		/// XML_Tokenizer is a simple class that tokenizes an XML string.
-		/// It is used by the XML_Tokenizer_Parser class to parse XML strings.
+		/// XML_InPlace_Parser is a simple class that parses XML text and creates an XML_Node tree.
+		/// It reads the text where it lies, such as a mapped file, with an <see cref="XML_StreamReader"/>,
+		/// so the only copy of the text is the one stored in the nodes.
 		/// It is not meant to be used by the user. It is used by the XML_Document class.
 		/// </summary>
-		class XML_Tokenizer
+		class XML_InPlace_Parser : public XML_Handler
 		{
 		private:
 			// Member Variables
-			std::string m_InputData;
-			uint64_t m_Index;
-		public:
-			// Constructors
-			XML_Tokenizer();
-			XML_Tokenizer(std::istream* inputStream);
-			XML_Tokenizer(const std::string& inputData);
-			XML_Tokenizer(std::string::const_iterator begin, std::string::const_iterator end);
-
-			// Copiers & Assignments
-			XML_Tokenizer(const XML_Tokenizer& other) = delete;
-			XML_Tokenizer(XML_Tokenizer&& other) noexcept = delete;
-			XML_Tokenizer& operator=(const XML_Tokenizer& other) = delete;
-
-			// Member Functions
-			void SetInputData(const std::string& inputData);
-
-			XML_Token Next();
-
-			bool HasNext() const;
-		};
-
-		/*********************************/
-		/* XML_Tokens_Parser Declaration */
-		/*********************************/
-
-		/// <summary>
-		/// XML_Tokenizer_Parser is a simple class that parses XML tokens and creates an XML_Node tree.
-		/// It is used by the XML_Document class to parse XML strings.
-		/// It is not meant to be used by the user. It is used by the XML_Document class.
-		/// </summary>
-		class XML_Tokenizer_Parser
-		{
-		private:
-			// Member Variables
-			std::string m_InputData;
 			XML_Node* m_Root;
-			std::deque<std::string> m_CurrentEndTags;
-			std::deque<XML_Node*> m_CurrentNodes;
+			const char* m_Begin;
+			const char* m_End;
+
+			// Nodes only get children added to the innermost open node, so the pointers to the open nodes stay valid.
+			std::vector<XML_Node*> m_CurrentNodes;
 		public:
 			// Constructors
-			XML_Tokenizer_Parser(XML_Node* const root, std::istream* inputStream);
-			XML_Tokenizer_Parser(XML_Node* const root, const std::string& inputString);
-			XML_Tokenizer_Parser(XML_Node* const root, std::string::const_iterator begin, std::string::const_iterator end);
+			XML_InPlace_Parser(XML_Node* const root, const char* begin, const char* end);
 
 			// Copiers & Assignments
-			XML_Tokenizer_Parser(const XML_Tokenizer_Parser& other) = delete;
-			XML_Tokenizer_Parser(XML_Tokenizer_Parser&& other) noexcept = delete;
-			XML_Tokenizer_Parser& operator=(const XML_Tokenizer_Parser& other) = delete;
+			XML_InPlace_Parser(const XML_InPlace_Parser& other) = delete;
+			XML_InPlace_Parser(XML_InPlace_Parser&& other) noexcept = delete;
+			XML_InPlace_Parser& operator=(const XML_InPlace_Parser& other) = delete;
 
 			// Member Functions
 			void Parse();
 
-			// Static Functions
-			static XML_Node ReadNode(const std::string& line);
+			// Handler Functions
+			void OnStartNode(std::string_view name, const std::vector<XML_Attribute>& attributes) override;
+
+			void OnValue(std::string_view text) override;
 
-			static void ReadAttributes(const std::string& line, XML_Node* const node);
+			void OnEndNode(std::string_view name) override;
 		};
 	}
 }
\ No newline at end of file
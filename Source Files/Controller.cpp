@@ -1,5 +1,7 @@
 #include "../Header Files/Controller.h"
 
+#include <iostream>
+
 /// <summary>
 /// Initializes a new instance of the <see cref="Controller"/> class.
 /// Will initialize all the necessary components for the application to run.
@@ -12,7 +14,16 @@ Controller::Controller(int argc, char* argv[], std::string name, std::string id)
 	: cycfi::elements::app(argc, argv, name, id)
 {
 	m_Window = std::make_unique<cycfi::elements::window>();
-	m_TaskManager = std::make_unique<TaskManager>();
+	m_TaskManager = std::make_unique<TaskManager>([](const TaskLoadMetrics& metrics)
+		{
+			std::clog << "Startup: first " << metrics.first_task_count << " tasks loaded after " << metrics.first_tasks_ms << " ms, "
+				<< "all " << metrics.task_count << " tasks loaded after " << metrics.fully_loaded_ms << " ms" << std::endl;
+
+			if (metrics.failed)
+			{
+				std::cerr << "Startup: " << metrics.error << std::endl;
+			}
+		});
 
 	m_CurrentView = std::make_unique<View>(m_Window, cycfi::artist::rgba(35, 35, 37, 255));
 
@@ -25,11 +36,15 @@ Controller::Controller(int argc, char* argv[], std::string name, std::string id)
 /// <summary>
 /// Initializes everything for the application to run.
 /// Will attach the view to the task manager and initialize the view.
+/// The view is updated on the UI thread, so slow view updates do not hold up changes to the tasks.
 /// Will also set the event handlers for the view.
 /// </summary>
 void Controller::Init()
 {
-	m_TaskManager->Attach(m_CurrentView.get());
+	m_TaskManager->Attach(m_CurrentView.get(), [view = m_CurrentView.get()](std::function<void()> update)
+		{
+			view->post(update);
+		});
 
 	m_CurrentView->OnAddTaskClick = [this](const Task& task) 
 		{
@@ -46,6 +61,21 @@ void Controller::Init()
 			m_TaskManager->CompleteTask(title, checked);
 		};
 
+	m_CurrentView->OnUndoClick = [this]()
+		{
+			m_TaskManager->Undo();
+		};
+
+	m_CurrentView->OnRedoClick = [this]()
+		{
+			m_TaskManager->Redo();
+		};
+
+	m_CurrentView->OnFirstFrame = [this]()
+		{
+			std::clog << "Startup: first frame after " << m_StartupStopwatch.ElapsedMilliseconds() << " ms" << std::endl;
+		};
+
 	m_CurrentView->InitView();
 
 	this->run();
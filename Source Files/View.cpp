@@ -17,6 +17,18 @@ View::View(std::shared_ptr<cycfi::elements::window> main_window, const cycfi::el
 void View::InitView()
 {
 	auto add_button = cycfi::elements::button("Add Task", 1.2f);
+	auto undo_button = cycfi::elements::button("Undo", 1.2f);
+	auto redo_button = cycfi::elements::button("Redo", 1.2f);
+
+	undo_button.on_click = [this](bool)
+		{
+			OnUndoClick();
+		};
+
+	redo_button.on_click = [this](bool)
+		{
+			OnRedoClick();
+		};
 
 	// Add task button click event
 	add_button.on_click = [this](bool)
@@ -206,8 +218,14 @@ void View::InitView()
 					)
 				),
 				cycfi::elements::align_right(
-					cycfi::elements::hstretch(0.2f,
-						add_button
+					cycfi::elements::hstretch(0.45f,
+						cycfi::elements::htile(
+							undo_button,
+							cycfi::elements::hspace(5),
+							redo_button,
+							cycfi::elements::hspace(5),
+							add_button
+						)
 					)
 				)
 			),
@@ -230,13 +248,15 @@ void View::InitView()
 /// <summary>
 /// Updates the view with the given tasks.
 /// This is inherited from the observer interface.
+/// The view is attached asynchronously, so this runs on the UI thread at most once per frame.
+/// The cell composer keeps its own snapshot of the tasks, which is O(1) to take and is not affected by later changes.
 /// </summary>
 /// <param name="tasks"> The tasks. </param>
-void View::Update(const mrt::Vector<Task>& tasks)
+void View::Update(const mrt::PersistentVector<Task>& tasks)
 {
 	// The task display works by creating a cell composer function for each task.
 	// This will then be called internally by the vlist class.
-	auto&& cell_composer_func = [this, &tasks](uint64_t index)
+	auto&& cell_composer_func = [this, tasks](uint64_t index)
 		{
 			auto check_box = cycfi::elements::check_box("");
 
@@ -342,4 +362,14 @@ void View::Update(const mrt::Vector<Task>& tasks)
 
 	// Update the view with the new tasks.
 	this->layout(m_TasksElements);
+
+	if (!m_HasDrawnFrame)
+	{
+		m_HasDrawnFrame = true;
+
+		if (OnFirstFrame)
+		{
+			OnFirstFrame();
+		}
+	}
 }
\ No newline at end of file
@@ -1,4 +1,7 @@
 #include "../Header Files/Xml.h"
+#include "../Header Files/MappedFile.h"
+
+#include <cstring>
 
 /***************************/
 /* XML_Node Implementation */
@@ -52,7 +55,7 @@ mrt::XML_Node& mrt::XML_Node::operator=(const XML_Node& other)
 /// Sets the name of the xml node.
 /// </summary>
 /// <param name="name"> The name of the xml node. </param>
-void mrt::XML_Node::SetName(std::string name) { m_Name = name; }
+void mrt::XML_Node::SetName(std::string name) { m_Name = std::move(name); }
 
 /// <summary>
 /// Gets the name of the xml node.
@@ -64,7 +67,14 @@ const std::string& mrt::XML_Node::GetName() const { return m_Name; }
 /// Sets the value of the xml node.
 /// </summary>
 /// <param name="value"> The value of the xml node. </param>
-void mrt::XML_Node::SetValue(std::string value) { m_Value = value; }
+void mrt::XML_Node::SetValue(std::string value) { m_Value = std::move(value); }
+
+/// <summary>
+/// Gets the value of the xml node.
+/// The value can be moved out when the node is no longer needed, such as when reading a document into other objects.
+/// </summary>
+/// <returns> The value of the xml node. </returns>
+std::string& mrt::XML_Node::GetValue() { return m_Value; }
 
 /// <summary>
 /// Gets the value of the xml node.
@@ -309,6 +319,7 @@ const std::string& mrt::XML_Document::GetVersion() const { return m_Version; }
 /// <summary>
 /// Reads an xml document from a file.
 /// This function reads the xml document from the file at the specified path and stores it in the specified <see cref="XML_Document"/> object.
+/// The file is mapped into memory and parsed where it lies, so it is never copied into a buffer.
 /// On success, it returns <see cref="XML_Document_FileError::SUCCESS"/>.
 /// If any error occurs, it returns the corresponding <see cref="XML_Document_FileError"/> value.
 /// </summary>
@@ -317,48 +328,22 @@ const std::string& mrt::XML_Document::GetVersion() const { return m_Version; }
 /// <returns> The result of the operation. </returns>
 mrt::XML_Document_FileError mrt::XML_Document::ReadDocument(const std::string& path, XML_Document& document)
 {
-	std::ifstream fs(path, std::ios::in);
+	MappedFile file;
 
-	if (!fs.is_open())
+	if (!file.Open(path))
 	{
-		fs.close();
 		return XML_Document_FileError::FAILED_TO_OPEN;
 	}
 
-	if (fs.good())
+	if (file.Size() == 0)
 	{
-		std::string inputString((std::istreambuf_iterator<char>(fs)), std::istreambuf_iterator<char>());
-
-		if (!inputString.empty())
-		{
-			inputString.erase(std::remove_if(inputString.begin(), inputString.end(), [](char c) { return c == '\n'; }), inputString.end());
-
-			size_t pos = inputString.find("?>");
-
-			if (pos != std::string::npos)
-			{
-				pos += 2;
-
-				inputString = inputString.substr(pos);
-			}
+		return XML_Document_FileError::FILE_EMPTY;
+	}
 
-			mrtInternal::XML_Tokenizer_Parser parser(&document.GetRoot(), inputString.cbegin(), inputString.cend());
+	mrtInternal::XML_InPlace_Parser parser(&document.GetRoot(), file.Data(), file.Data() + file.Size());
 
-			parser.Parse();
-		}
-		else
-		{
-			fs.close();
-			return XML_Document_FileError::FILE_EMPTY;
-		}
-	}
-	else
-	{
-		fs.close();
-		return XML_Document_FileError::FAILED_TO_READ;
-	}
+	parser.Parse();
 
-	fs.close();
 	return XML_Document_FileError::SUCCESS;
 }
 
@@ -445,20 +430,9 @@ void mrt::XML_Document::ReadDocumentFromStream(std::istream* inStream, XML_Docum
 {
 	std::string inputString((std::istreambuf_iterator<char>(*inStream)), std::istreambuf_iterator<char>());
 
-	inputString.erase(std::remove_if(inputString.begin(), inputString.end(), [](char c) { return c == '\n'; }), inputString.end());
-
 	if (inputString.empty()) return;
 
-	size_t pos = inputString.find("?>");
-
-	if (pos != std::string::npos)
-	{
-		pos += 2;
-
-		inputString = inputString.substr(pos);
-	}
-
-	mrtInternal::XML_Tokenizer_Parser parser(&document.GetRoot(), inputString.cbegin(), inputString.cend());
+	mrtInternal::XML_InPlace_Parser parser(&document.GetRoot(), inputString.data(), inputString.data() + inputString.size());
 
 	parser.Parse();
 }
@@ -486,6 +460,204 @@ void mrt::XML_Document::WriteDocumentToStream(std::ostream* fs, const XML_Docume
 	*fs << getEndNode(document.GetRoot()) << getNewLine(newLines);
 }
 
+/***********************************/
+/* XML_StreamWriter Implementation */
+/***********************************/
+
+/// <summary>
+/// Initializes a new instance of the <see cref="XML_StreamWriter"/> class.
+/// </summary>
+/// <param name="buffer"> The buffer to gather the text in, it keeps its capacity so it can be reused by the next writer. </param>
+/// <param name="newLines"> Whether to add new lines and tabs to the file. </param>
+/// <param name="blockSize"> The number of bytes gathered before they are written to the file. </param>
+mrt::XML_StreamWriter::XML_StreamWriter(std::string& buffer, bool newLines, uint64_t blockSize)
+	: m_File(nullptr), m_Buffer(buffer), m_BlockSize(blockSize), m_NewLines(newLines), m_Failed(false), m_ToBuffer(false) { }
+
+/// <summary>
+/// Closes the file if it is still open, the text that has not been written yet is written first.
+/// </summary>
+mrt::XML_StreamWriter::~XML_StreamWriter()
+{
+	Close();
+}
+
+/// <summary>
+/// Opens the file at the specified path to write to, replacing its contents.
+/// </summary>
+/// <param name="path"> The path of the file. </param>
+/// <returns> The result of the operation. </returns>
+mrt::XML_Document_FileError mrt::XML_StreamWriter::Open(const std::string& path)
+{
+	Close();
+
+	// Opened as text, like the file stream used by XML_Document::WriteDocument, so the new lines are written the same way.
+	m_File = std::fopen(path.c_str(), "w");
+	m_ToBuffer = false;
+
+	if (m_File == nullptr)
+	{
+		return XML_Document_FileError::FAILED_TO_OPEN;
+	}
+
+	m_Buffer.clear();
+	m_Buffer.reserve(m_BlockSize);
+	m_Failed = false;
+
+	return XML_Document_FileError::SUCCESS;
+}
+
+/// <summary>
+/// Starts a document that is kept in the buffer instead of being written to a file.
+/// The buffer holds the whole document once the writer is closed.
+/// </summary>
+/// <returns> The result of the operation. </returns>
+mrt::XML_Document_FileError mrt::XML_StreamWriter::Open()
+{
+	Close();
+
+	m_Buffer.clear();
+	m_Failed = false;
+	m_ToBuffer = true;
+
+	return XML_Document_FileError::SUCCESS;
+}
+
+/// <summary>
+/// Writes the xml prolog.
+/// </summary>
+/// <param name="version"> The version of the xml document. </param>
+void mrt::XML_StreamWriter::WriteProlog(const std::string& version)
+{
+	Append(getXMLprolog(version));
+	EndLine();
+}
+
+/// <summary>
+/// Writes the start node of a node that has children.
+/// </summary>
+/// <param name="name"> The name of the node. </param>
+/// <param name="tabs"> The depth of the node, 0 for the root node. </param>
+/// <param name="attributes"> The attributes of the node. </param>
+void mrt::XML_StreamWriter::WriteStartNode(std::string_view name, uint32_t tabs, const std::vector<XML_Attribute>& attributes)
+{
+	AppendTabs(tabs);
+	Append("<");
+	Append(name);
+
+	for (const XML_Attribute& attribute : attributes)
+	{
+		Append(" ");
+		Append(attribute.m_Name);
+		Append("=\"");
+		Append(attribute.m_Value);
+		Append("\"");
+	}
+
+	Append(">");
+	EndLine();
+}
+
+/// <summary>
+/// Writes the end node of a node that has children.
+/// </summary>
+/// <param name="name"> The name of the node. </param>
+/// <param name="tabs"> The depth of the node, 0 for the root node. </param>
+void mrt::XML_StreamWriter::WriteEndNode(std::string_view name, uint32_t tabs)
+{
+	AppendTabs(tabs);
+	Append("</");
+	Append(name);
+	Append(">");
+	EndLine();
+}
+
+/// <summary>
+/// Writes a node that has a value and no children or attributes.
+/// </summary>
+/// <param name="name"> The name of the node. </param>
+/// <param name="value"> The value of the node. </param>
+/// <param name="tabs"> The depth of the node. </param>
+void mrt::XML_StreamWriter::WriteNode(std::string_view name, std::string_view value, uint32_t tabs)
+{
+	AppendTabs(tabs);
+	Append("<");
+	Append(name);
+	Append(">");
+	Append(value);
+	Append("</");
+	Append(name);
+	Append(">");
+	EndLine();
+}
+
+/// <summary>
+/// Writes the text that has not been written yet and closes the file, a document kept in the buffer is left there.
+/// </summary>
+/// <returns> The result of the operation, <see cref="XML_Document_FileError::FAILED_TO_WRITE"/> if any part of the text could not be written. </returns>
+mrt::XML_Document_FileError mrt::XML_StreamWriter::Close()
+{
+	if (m_ToBuffer)
+	{
+		m_ToBuffer = false;
+		return XML_Document_FileError::SUCCESS;
+	}
+
+	if (m_File == nullptr)
+	{
+		return m_Failed ? XML_Document_FileError::FAILED_TO_WRITE : XML_Document_FileError::SUCCESS;
+	}
+
+	Flush();
+
+	if (std::fclose(m_File) != 0)
+	{
+		m_Failed = true;
+	}
+
+	m_File = nullptr;
+
+	return m_Failed ? XML_Document_FileError::FAILED_TO_WRITE : XML_Document_FileError::SUCCESS;
+}
+
+void mrt::XML_StreamWriter::Append(std::string_view text)
+{
+	m_Buffer.append(text.data(), text.size());
+}
+
+void mrt::XML_StreamWriter::AppendTabs(uint32_t tabs)
+{
+	if (m_NewLines)
+	{
+		m_Buffer.append(tabs, '\t');
+	}
+}
+
+/// <summary>
+/// Ends the line of a node, and writes the buffer to the file once it holds a block.
+/// </summary>
+void mrt::XML_StreamWriter::EndLine()
+{
+	if (m_NewLines)
+	{
+		m_Buffer.push_back('\n');
+	}
+
+	if (!m_ToBuffer && m_Buffer.size() >= m_BlockSize)
+	{
+		Flush();
+	}
+}
+
+void mrt::XML_StreamWriter::Flush()
+{
+	if (m_File != nullptr && !m_Buffer.empty() && std::fwrite(m_Buffer.data(), 1, m_Buffer.size(), m_File) != m_Buffer.size())
+	{
+		m_Failed = true;
+	}
+
+	m_Buffer.clear();
+}
+
 /***************************************/
 /* MrT Global Functions Implementation */
 /***************************************/
@@ -551,265 +723,293 @@ std::string mrt::getNewLine(bool newLines)
 	return newLines ? "\n" : "";
 }
 
-/********************************/
-/* XML_Tokenizer Implementation */
-/********************************/
+/***********************************/
+/* XML_StreamReader Implementation */
+/***********************************/
 
 /// <summary>
-/// Initializes a new instance of the <see cref="XML_Tokenizer"/> class.
+/// Checks if a character separates the name and the attributes of a tag.
 /// </summary>
-mrt::mrtInternal::XML_Tokenizer::XML_Tokenizer() : m_InputData(), m_Index(0) { }
+static bool isTagSpace(char c)
+{
+	return c == ' ' || c == '\t' || c == '\r' || c == '\n';
+}
 
 /// <summary>
-/// Initializes a new instance of the <see cref="XML_Tokenizer"/> class.
+/// Initializes a new instance of the <see cref="XML_StreamReader"/> class.
 /// </summary>
-/// <param name="inputStream"> The input stream to read from. </param>
-mrt::mrtInternal::XML_Tokenizer::XML_Tokenizer(std::istream* inputStream)
-	: m_InputData((std::istreambuf_iterator<char>(*inputStream)), std::istreambuf_iterator<char>()), m_Index(0) { }
+/// <param name="handler"> The handler to hand the nodes to. </param>
+mrt::XML_StreamReader::XML_StreamReader(XML_Handler& handler) : m_Handler(handler) { }
 
 /// <summary>
-/// Initializes a new instance of the <see cref="XML_Tokenizer"/> class.
+/// Reads an xml document from a file.
+/// The file is mapped into memory and read where it lies, so it is never copied into a buffer.
 /// </summary>
-/// <param name="inputData"> The input data to read from. </param>
-mrt::mrtInternal::XML_Tokenizer::XML_Tokenizer(const std::string& inputData) : m_InputData(inputData), m_Index(0) { }
+/// <param name="path"> The path of the file. </param>
+/// <returns> The result of the operation. </returns>
+mrt::XML_Document_FileError mrt::XML_StreamReader::ReadFile(const std::string& path)
+{
+	MappedFile file;
 
-/// <summary>
-/// Initializes a new instance of the <see cref="XML_Tokenizer"/> class.
-/// </summary>
-/// <param name="begin"> The beginning of the input data. </param>
-/// <param name="end"> The end of the input data. </param>
-mrt::mrtInternal::XML_Tokenizer::XML_Tokenizer(std::string::const_iterator begin, std::string::const_iterator end) : m_InputData(begin, end), m_Index(0) { }
+	if (!file.Open(path))
+	{
+		return XML_Document_FileError::FAILED_TO_OPEN;
+	}
 
-/// <summary>
-/// Initializes a new instance of the <see cref="XML_Tokenizer"/> class.
-/// </summary>
-/// <param name="inputStream"> The input stream to read from. </param>
-void mrt::mrtInternal::XML_Tokenizer::SetInputData(const std::string& inputData) { m_InputData = inputData; m_Index = 0; }
+	if (file.Size() == 0)
+	{
+		return XML_Document_FileError::FILE_EMPTY;
+	}
+
+	Read(file.Data(), file.Data() + file.Size());
+
+	return XML_Document_FileError::SUCCESS;
+}
 
 /// <summary>
-/// Gets the next token. From the input data.
-/// The token can be a start tag, an end tag, a self ending tag or a value.
+/// Reads an xml document from text, which has to stay valid until reading is done.
+/// Throws if an end node does not match the node that is open, or a tag is not closed.
 /// </summary>
-/// <returns> The next token. </returns>
-mrt::mrtInternal::XML_Token mrt::mrtInternal::XML_Tokenizer::Next()
+/// <param name="begin"> The beginning of the text. </param>
+/// <param name="end"> The end of the text. </param>
+void mrt::XML_StreamReader::Read(const char* begin, const char* end)
 {
-	if (m_Index >= m_InputData.size())
-	{
-		return { XML_Token_Type::END_OF_STRING, "" };
-	}
+	const char* current = begin;
+
+	m_OpenNodes.clear();
 
-	if (m_InputData[m_Index] == '<')
+	while (current < end)
 	{
-		if (m_Index + 1 < m_InputData.size() && m_InputData[m_Index + 1] == '/')
+		if (*current != '<')
+		{
+			const char* next = static_cast<const char*>(std::memchr(current, '<', end - current));
+
+			if (next == nullptr)
+			{
+				next = end;
+			}
+
+			if (!m_OpenNodes.empty())
+			{
+				m_Handler.OnValue(std::string_view(current, next - current));
+			}
+
+			current = next;
+			continue;
+		}
+
+		const char* close = static_cast<const char*>(std::memchr(current, '>', end - current));
+
+		if (close == nullptr)
 		{
-			std::string data;
+			throw std::runtime_error("Invalid XML file (Missing the end of a tag).");
+		}
 
-			while (m_Index < m_InputData.size() && m_InputData[m_Index] != '>')
+		if (current + 1 < close && (current[1] == '?' || current[1] == '!'))
+		{
+			// The prolog and comments are skipped.
+		}
+		else if (current + 1 < close && current[1] == '/')
+		{
+			std::string_view name(current + 2, close - (current + 2));
+
+			if (m_OpenNodes.empty() || m_OpenNodes.back() != name)
 			{
-				data += m_InputData[m_Index];
-				m_Index++;
+				throw std::runtime_error("Invalid XML file (Missing an end tag).");
 			}
 
-			data += m_InputData[m_Index];
-			m_Index++;
+			m_OpenNodes.pop_back();
+			m_Handler.OnEndNode(name);
 
-			return { XML_Token_Type::TAG_END, data };
+			if (m_OpenNodes.empty())
+				return;
 		}
 		else
 		{
-			std::string data;
+			bool isSelfEnd = close[-1] == '/' && close - 1 > current;
+			const char* tagEnd = isSelfEnd ? close - 1 : close;
+			const char* nameEnd = current + 1;
 
-			while (m_Index < m_InputData.size() && m_InputData[m_Index] != '>')
+			while (nameEnd < tagEnd && !isTagSpace(*nameEnd))
 			{
-				data += m_InputData[m_Index];
-				m_Index++;
+				nameEnd++;
 			}
 
-			data += m_InputData[m_Index];
+			std::string_view name(current + 1, nameEnd - (current + 1));
+
+			ReadAttributes(nameEnd, tagEnd);
+
+			m_Handler.OnStartNode(name, m_Attributes);
 
-			if (data[data.size() - 1] == '>' && data[data.size() - 2] == '/')
+			if (isSelfEnd)
 			{
-				m_Index++;
-				return { XML_Token_Type::TAG_SELF_END, data };
+				m_Handler.OnEndNode(name);
+
+				if (m_OpenNodes.empty())
+					return;
 			}
 			else
 			{
-				m_Index++;
-				return { XML_Token_Type::TAG_START, data };
+				m_OpenNodes.push_back(name);
 			}
 		}
-	}
-	else
-	{
-		std::string data;
 
-		while (m_Index < m_InputData.size() && m_InputData[m_Index] != '<')
-		{
-			data += m_InputData[m_Index];
-			m_Index++;
-		}
-
-		return { XML_Token_Type::VALUE, data };
+		current = close + 1;
 	}
 }
 
 /// <summary>
-/// Checks if there is a next token.
+/// Copies text handed to <see cref="XML_Handler::OnValue"/> into a value, leaving out new lines,
+/// as the documents are written with a new line after each tag.
 /// </summary>
-/// <returns> Whether there is a next token. </returns>
-bool mrt::mrtInternal::XML_Tokenizer::HasNext() const { return (m_Index < m_InputData.size()) ? true : false; }
+/// <param name="text"> The text. </param>
+/// <param name="value"> Set to the text, unless the text is only new lines. </param>
+/// <returns> Whether the value was set. </returns>
+bool mrt::XML_StreamReader::CopyValue(std::string_view text, std::string& value)
+{
+	if (text.find('\n') == std::string_view::npos)
+	{
+		value.assign(text.data(), text.size());
+		return true;
+	}
 
-/************************************/
-/* XML_Tokens_Parser Implementation */
-/************************************/
+	std::string result;
+	result.reserve(text.size());
 
-/// <summary>
-/// Initializes a new instance of the <see cref="XML_Tokenizer_Parser"/> class.
-/// </summary>
-/// <param name="root"> The root node of the xml document. </param>
-/// <param name="inputStream"> The input stream to read from. </param>
-mrt::mrtInternal::XML_Tokenizer_Parser::XML_Tokenizer_Parser(XML_Node* const root, std::istream* inputStream)
-	: m_Root(root), m_InputData((std::istreambuf_iterator<char>(*inputStream)), std::istreambuf_iterator<char>()) { }
+	for (char c : text)
+	{
+		if (c != '\n')
+		{
+			result.push_back(c);
+		}
+	}
 
-/// <summary>
-/// Initializes a new instance of the <see cref="XML_Tokenizer_Parser"/> class.
-/// </summary>
-/// <param name="root"> The root node of the xml document. </param>
-/// <param name="inputString"> The input string to read from. </param>
-mrt::mrtInternal::XML_Tokenizer_Parser::XML_Tokenizer_Parser(XML_Node* const root, const std::string& inputString)
-	: m_Root(root), m_InputData(inputString) { }
+	if (result.empty())
+		return false;
 
-/// <summary>
-/// Initializes a new instance of the <see cref="XML_Tokenizer_Parser"/> class.
-/// </summary>
-/// <param name="root"> The root node of the xml document. </param>
-/// <param name="begin"> The beginning of the input data. </param>
-/// <param name="end"> The end of the input data. </param>
-mrt::mrtInternal::XML_Tokenizer_Parser::XML_Tokenizer_Parser(XML_Node* const root, std::string::const_iterator begin, std::string::const_iterator end)
-	: m_Root(root), m_InputData(begin, end) { }
+	value = std::move(result);
+	return true;
+}
 
 /// <summary>
-/// Parses the input data.
-/// This function parses the input data and stores the xml document in the specified root node.
-/// Uses the <see cref="XML_Tokenizer"/> class to tokenize the input data.
-/// Then it reads the tokens and stores the xml document in the specified root node.
+/// Reads the attributes of a tag, written as name="value".
+/// Anything that is not an attribute is skipped.
 /// </summary>
-void mrt::mrtInternal::XML_Tokenizer_Parser::Parse()
+/// <param name="begin"> The first character after the name of the tag. </param>
+/// <param name="end"> The end of the tag. </param>
+void mrt::XML_StreamReader::ReadAttributes(const char* begin, const char* end)
 {
-	XML_Tokenizer tokenizer(m_InputData.cbegin(), m_InputData.cend());
-
-	*m_Root = ReadNode(tokenizer.Next().m_Data);
+	const char* current = begin;
 
-	m_CurrentEndTags.push_back(getEndNode(*m_Root));
+	m_Attributes.clear();
 
-	m_CurrentNodes.push_back(m_Root);
-
-	while (tokenizer.HasNext())
+	while (current < end)
 	{
-		XML_Token token = tokenizer.Next();
-
-		switch (token.m_Type)
+		while (current < end && isTagSpace(*current))
 		{
-		case XML_Token_Type::TAG_START:
-		{
-			m_CurrentNodes.push_back(&m_CurrentNodes.back()->AddChild(ReadNode(token.m_Data)));
+			current++;
+		}
 
-			m_CurrentEndTags.push_back(getEndNode(*m_CurrentNodes.back()));
+		const char* name = current;
 
-			break;
+		while (current < end && *current != '=' && !isTagSpace(*current))
+		{
+			current++;
 		}
-		case XML_Token_Type::TAG_END:
+
+		const char* nameEnd = current;
+
+		if (current + 1 >= end || *current != '=' || (current[1] != '\"' && current[1] != '\''))
 		{
-			if (token.m_Data == m_CurrentEndTags.back())
+			while (current < end && !isTagSpace(*current))
 			{
-				m_CurrentEndTags.pop_back();
-				m_CurrentNodes.pop_back();
-			}
-			else
-			{
-				throw std::runtime_error("Invalid XML file (Missing an end tag).");
+				current++;
 			}
 
-			break;
+			continue;
 		}
-		case XML_Token_Type::TAG_SELF_END:
-		{
-			m_CurrentNodes.back()->AddChild(ReadNode(token.m_Data));
 
-			break;
-		}
-		case XML_Token_Type::VALUE:
-		{
-			m_CurrentNodes.back()->SetValue(token.m_Data);
+		char quote = current[1];
+		const char* value = current + 2;
+		const char* valueEnd = static_cast<const char*>(std::memchr(value, quote, end - value));
 
-			break;
-		}
+		if (valueEnd == nullptr)
+		{
+			valueEnd = end;
 		}
+
+		m_Attributes.emplace_back(std::string(name, nameEnd), std::string(value, valueEnd));
+
+		current = valueEnd + 1;
 	}
 }
 
+/*************************************/
+/* XML_InPlace_Parser Implementation */
+/*************************************/
+
+/// <summary>
+/// Initializes a new instance of the <see cref="XML_InPlace_Parser"/> class.
+/// The text is not copied, so it has to stay valid until the parser is done.
+/// </summary>
+/// <param name="root"> The root node of the xml document. </param>
+/// <param name="begin"> The beginning of the input data. </param>
+/// <param name="end"> The end of the input data. </param>
+mrt::mrtInternal::XML_InPlace_Parser::XML_InPlace_Parser(XML_Node* const root, const char* begin, const char* end)
+	: m_Root(root), m_Begin(begin), m_End(end) { }
+
 /// <summary>
-/// Parses a single node from a line of data.
+/// Parses the input data.
+/// This function parses the input data and stores the xml document in the specified root node.
+/// Each value is copied once, into its node.
 /// </summary>
-/// <param name="line"> The line of data. </param>
-/// <returns> The parsed node. </returns>
-mrt::XML_Node mrt::mrtInternal::XML_Tokenizer_Parser::ReadNode(const std::string& line)   //Reads the start node and returns a node with the name, attributes and value.
+void mrt::mrtInternal::XML_InPlace_Parser::Parse()
 {
-	XML_Node node;
+	XML_StreamReader reader(*this);
 
-	if (line.find("/>") != std::string::npos)
-	{
-		size_t pos = line.find(' ');
+	m_CurrentNodes.clear();
 
-		if (pos != std::string::npos)
-		{
-			node.SetName(line.substr(1, pos - 1));
+	reader.Read(m_Begin, m_End);
+}
 
-			ReadAttributes(line.substr(pos + 1, line.find('>') - (pos + 1) - 1), &node);
-		}
-		else
-		{
-			node.SetName(line.substr(1, line.size() - 3));
-		}
+/// <summary>
+/// Adds a node to the innermost open node, the first node read becomes the root node.
+/// </summary>
+void mrt::mrtInternal::XML_InPlace_Parser::OnStartNode(std::string_view name, const std::vector<XML_Attribute>& attributes)
+{
+	XML_Node* node = m_Root;
+
+	if (m_CurrentNodes.empty())
+	{
+		*m_Root = XML_Node();
 	}
 	else
 	{
-		size_t pos = line.find(' ');
+		node = &m_CurrentNodes.back()->EmplaceChild();
+	}
 
-		if (pos != std::string::npos)
-		{
-			node.SetName(line.substr(1, pos - 1));
+	node->SetName(std::string(name));
 
-			ReadAttributes(line.substr(pos + 1, line.size() - (pos + 2)), &node);
-		}
-		else
-		{
-			node.SetName(line.substr(1, line.size() - 2));
-		}
+	for (const XML_Attribute& attribute : attributes)
+	{
+		node->AddAttribute(attribute.m_Name, attribute.m_Value);
 	}
 
-	return node;
+	m_CurrentNodes.push_back(node);
 }
 
 /// <summary>
-/// Parses the attributes of a node from a line of data.
+/// Sets the value of the innermost open node, text that is only new lines does not change the value.
 /// </summary>
-/// <param name="line"> The line of data. </param>
-/// <param name="node"> The node to store the attributes. </param>
-void mrt::mrtInternal::XML_Tokenizer_Parser::ReadAttributes(const std::string& line, XML_Node* const node)
+void mrt::mrtInternal::XML_InPlace_Parser::OnValue(std::string_view text)
 {
-	std::string name, value, attrData;
-
-	std::istringstream is(line);
-
-	while (is >> attrData)
-	{
-		if (attrData.find('\"') != std::string::npos)
-		{
-			name = attrData.substr(0, attrData.find('\"') - 1);
-			value = attrData.substr(attrData.find('\"') + 1, attrData.size() - (attrData.find('\"') + 1) - 1);
+	XML_StreamReader::CopyValue(text, m_CurrentNodes.back()->GetValue());
+}
 
-			node->EmplaceAttribute(name, value);
-		}
-	}
-}
\ No newline at end of file
+/// <summary>
+/// Closes the innermost open node.
+/// </summary>
+void mrt::mrtInternal::XML_InPlace_Parser::OnEndNode(std::string_view)
+{
+	m_CurrentNodes.pop_back();
+}
@@ -0,0 +1,1954 @@
+#include "../Header Files/PersistentVector.h"
+#include "../Header Files/ObserverDispatcher.h"
+#include "../Header Files/Subscription.h"
+#include "../Header Files/TaskQuery.h"
+#include "../Header Files/TaskView.h"
+#include "../Header Files/DependencyGraph.h"
+#include "../Header Files/StorageBinary.h"
+#include "../Header Files/StorageCompressed.h"
+#include "../Header Files/ChaCha20.h"
+#include "../Header Files/TaskManager.h"
+#include "../Header Files/TaskImporter.h"
+
+#include <map>
+#include <set>
+#include <mutex>
+#include <atomic>
+#include <chrono>
+#include <thread>
+#include <cstdio>
+#include <string>
+#include <vector>
+#include <random>
+#include <future>
+#include <fstream>
+#include <memory>
+#include <iostream>
+#include <algorithm>
+#include <functional>
+#include <filesystem>
+
+namespace
+{
+	/// <summary>
+	/// Prints the result of a check, and remembers whether every check so far passed.
+	/// </summary>
+	using report_func = std::function<void(const std::string& name, bool is_ok)>;
+
+	/// <summary>
+	/// The options of a check run, read from the command line.
+	/// </summary>
+	struct CheckOptions
+	{
+		uint64_t seed{ 42 };
+		std::filesystem::path directory{ std::filesystem::temp_directory_path() / "taskcheck" };
+		bool keep_store{ false };
+	};
+
+	void PrintUsage()
+	{
+		std::cout <<
+			"Usage: taskcheck [options]\n"
+			"  --seed N          seed of the random changes the checks make (default 42)\n"
+			"  --dir PATH        directory the task stores are written to (default <temp>/taskcheck)\n"
+			"  --keep            keep the task stores after the run\n";
+	}
+
+	/// <summary>
+	/// Reads the options from the command line.
+	/// </summary>
+	/// <returns> True if the options are valid, false otherwise. </returns>
+	bool ParseArguments(int argc, char* argv[], CheckOptions& options)
+	{
+		for (int i = 1; i < argc; i++)
+		{
+			std::string argument = argv[i];
+			bool has_value = i + 1 < argc;
+
+			if (argument == "--keep")
+			{
+				options.keep_store = true;
+			}
+			else if (!has_value)
+			{
+				return false;
+			}
+			else if (argument == "--seed")
+			{
+				options.seed = std::stoull(argv[++i]);
+			}
+			else if (argument == "--dir")
+			{
+				options.directory = argv[++i];
+			}
+			else
+			{
+				return false;
+			}
+		}
+
+		return true;
+	}
+
+	/// <summary>
+	/// Creates a task manager for a store in the working directory and waits for it to load.
+	/// </summary>
+	std::unique_ptr<TaskManager> OpenStore(const std::string& store_name)
+	{
+		std::shared_ptr<std::promise<void>> loaded = std::make_shared<std::promise<void>>();
+		std::future<void> is_loaded = loaded->get_future();
+
+		std::unique_ptr<TaskManager> manager = std::make_unique<TaskManager>(store_name, [loaded](const TaskLoadMetrics&)
+			{
+				loaded->set_value();
+			});
+
+		is_loaded.wait();
+		return manager;
+	}
+
+	/// <summary>
+	/// Gets a time of day, formatted as HH:MM, from the minutes since midnight.
+	/// </summary>
+	std::string FormatMinute(int minute)
+	{
+		char buffer[16];
+		std::snprintf(buffer, sizeof(buffer), "%02d:%02d", minute / 60, minute % 60);
+
+		return buffer;
+	}
+
+	/// <summary>
+	/// Gets what the checks compare of a version of the tasks, the title and whether each task is done, in order.
+	/// </summary>
+	std::vector<std::string> Describe(const mrt::PersistentVector<Task>& tasks)
+	{
+		std::vector<std::string> described;
+
+		for (const Task& task : tasks)
+		{
+			described.push_back(task.title + (task.is_done ? " [done]" : ""));
+		}
+
+		return described;
+	}
+
+	/// <summary>
+	/// Checks that every version of a persistent vector keeps its values while later versions are changed,
+	/// against a copy of a std::vector kept for each version. The vector grows past two levels of the trie.
+	/// </summary>
+	void CheckPersistentVector(uint64_t seed, const report_func& report)
+	{
+		std::mt19937_64 random(seed);
+		std::vector<mrt::PersistentVector<uint64_t>> versions(1);
+		std::vector<std::vector<uint64_t>> models(1);
+
+		for (uint64_t step = 0; step < 4000; step++)
+		{
+			mrt::PersistentVector<uint64_t> version(versions.back());
+			std::vector<uint64_t> model(models.back());
+			uint64_t op = random() % 10;
+
+			if (op < 6 || model.empty())
+			{
+				version.PushBack(step);
+				model.push_back(step);
+			}
+			else if (op < 8)
+			{
+				uint64_t index = random() % model.size();
+				version.Set(index, step);
+				model[index] = step;
+			}
+			else if (op < 9)
+			{
+				version.PopBack();
+				model.pop_back();
+			}
+			else
+			{
+				uint64_t index = random() % model.size();
+				version.Erase(index);
+				model.erase(model.begin() + index);
+			}
+
+			versions.push_back(version);
+			models.push_back(model);
+		}
+
+		bool is_match = true;
+
+		for (uint64_t i = 0; i < versions.size() && is_match; i++)
+		{
+			is_match = versions[i].Size() == models[i].size();
+
+			uint64_t index = 0;
+
+			for (uint64_t value : versions[i])
+			{
+				is_match = is_match && index < models[i].size() && value == models[i][index] && versions[i].At(index) == value;
+				index++;
+			}
+		}
+
+		report("persistent vector versions", is_match);
+	}
+
+	/// <summary>
+	/// Checks that undo walks back through every version of the tasks and redo walks forward again,
+	/// that a snapshot is not changed by an undo, and that a new change drops the changes that were undone.
+	/// </summary>
+	void CheckUndoRedo(uint64_t seed, const report_func& report)
+	{
+		std::mt19937_64 random(seed);
+		std::unique_ptr<TaskManager> manager = OpenStore("taskcheck-undo");
+		std::vector<std::vector<std::string>> versions{ Describe(manager->Snapshot()) };
+		uint64_t next_title = 0;
+
+		for (uint64_t step = 0; step < 60; step++)
+		{
+			mrt::PersistentVector<Task> tasks = manager->Snapshot();
+			uint64_t op = random() % 4;
+
+			if (op < 2 || tasks.Empty())
+			{
+				manager->AddTask(Task("task " + std::to_string(next_title++), "", "09:00", "10:00", false));
+			}
+			else if (op < 3)
+			{
+				const Task& task = tasks.At(random() % tasks.Size());
+				manager->CompleteTask(task.title, !task.is_done);
+			}
+			else
+			{
+				manager->RemoveTask(tasks.At(random() % tasks.Size()).title);
+			}
+
+			versions.push_back(Describe(manager->Snapshot()));
+		}
+
+		bool is_counted = manager->UndoCount() == versions.size() - 1 && manager->RedoCount() == 0;
+		mrt::PersistentVector<Task> latest = manager->Snapshot();
+		bool is_undone = true;
+
+		for (uint64_t i = versions.size() - 1; i > 0; i--)
+		{
+			is_undone = is_undone && manager->Undo() && Describe(manager->Snapshot()) == versions[i - 1];
+		}
+
+		is_undone = is_undone && !manager->Undo();
+
+		bool is_redone = true;
+
+		for (uint64_t i = 1; i < versions.size(); i++)
+		{
+			is_redone = is_redone && manager->Redo() && Describe(manager->Snapshot()) == versions[i];
+		}
+
+		is_redone = is_redone && !manager->Redo();
+
+		manager->Undo();
+		manager->Undo();
+		manager->AddTask(Task("task " + std::to_string(next_title++), "", "", "", false));
+
+		bool is_branched = manager->RedoCount() == 0 && !manager->Redo();
+
+		// Past the undo depth the oldest versions are dropped, so undo stops at the last version that was kept.
+		manager->SetUndoDepth(10);
+
+		std::vector<std::vector<std::string>> kept{ Describe(manager->Snapshot()) };
+
+		for (uint64_t step = 0; step < 25; step++)
+		{
+			manager->AddTask(Task("task " + std::to_string(next_title++), "", "", "", false));
+			kept.push_back(Describe(manager->Snapshot()));
+		}
+
+		bool is_capped = manager->UndoCount() == 10;
+
+		for (uint64_t i = 0; i < 10; i++)
+		{
+			is_capped = is_capped && manager->Undo();
+		}
+
+		is_capped = is_capped && !manager->Undo() && Describe(manager->Snapshot()) == kept[kept.size() - 11];
+
+		report("undo history size", is_counted);
+		report("undo to the first version", is_undone);
+		report("redo to the last version", is_redone);
+		report("snapshot kept across undo", Describe(latest) == versions.back());
+		report("change after undo drops redo", is_branched);
+		report("undo history capped at its depth", is_capped);
+	}
+
+	/// <summary>
+	/// Checks that a task id is never given out twice, even once the task that had the highest id was removed and the store reopened,
+	/// and that a task added while the stored tasks load does not take the id of a stored task.
+	/// </summary>
+	void CheckTaskIds(const report_func& report)
+	{
+		{
+			std::unique_ptr<TaskManager> manager = OpenStore("taskcheck-ids");
+
+			for (uint64_t i = 0; i < 5; i++)
+			{
+				manager->AddTask(Task("task " + std::to_string(i), "", "", "", false));
+			}
+
+			manager->RemoveTask("task 4");
+		}
+
+		std::set<uint64_t> ids;
+		uint64_t highest = 0;
+		bool is_unique = true;
+
+		{
+			std::shared_ptr<std::promise<void>> loaded = std::make_shared<std::promise<void>>();
+			std::future<void> is_loaded = loaded->get_future();
+
+			TaskManager manager("taskcheck-ids", [loaded](const TaskLoadMetrics&)
+				{
+					loaded->set_value();
+				});
+
+			manager.AddTask(Task("added while loading", "", "", "", false));
+			is_loaded.wait();
+			manager.AddTask(Task("added after loading", "", "", "", false));
+
+			for (const Task& task : manager.Snapshot())
+			{
+				is_unique = is_unique && ids.insert(task.id).second;
+				highest = std::max(highest, task.id);
+			}
+		}
+
+		// Ids 1 to 5 were given out before the store was reopened, so the two new tasks are 6 and 7.
+		report("task ids unique after reopening", is_unique && ids == std::set<uint64_t>{ 1, 2, 3, 4, 6, 7 } && highest == 7);
+	}
+
+	/// <summary>
+	/// Checks that a batch of adds is timed once in its own histogram, and not as single adds.
+	/// </summary>
+	void CheckBatchLatency(const report_func& report)
+	{
+		std::unique_ptr<TaskManager> manager = OpenStore("taskcheck-batch");
+
+		mrt::Vector<Task> tasks;
+
+		for (uint64_t i = 0; i < 3; i++)
+		{
+			tasks.PushBack(Task("task " + std::to_string(i), "", "", "", false));
+		}
+
+		manager->AddTasks(tasks);
+		manager->AddTasks(mrt::Vector<Task>());
+
+		TaskManagerStats stats = manager->Stats();
+
+		report("batch adds timed apart from single adds", stats.task_count == 3 && stats.add.count == 0 &&
+			stats.add_batch.count == (DAILY_TASK_MANAGER_METRICS ? 1 : 0));
+	}
+
+	/// <summary>
+	/// A clock the checks move by hand, shared with the task manager and the reminders that read it.
+	/// </summary>
+	class FakeClock
+	{
+	private:
+		std::shared_ptr<std::atomic<int64_t>> m_Seconds;
+	public:
+		FakeClock(std::chrono::system_clock::time_point start)
+			: m_Seconds(std::make_shared<std::atomic<int64_t>>(std::chrono::duration_cast<std::chrono::seconds>(start.time_since_epoch()).count()))
+		{
+		}
+
+		void Advance(std::chrono::seconds by)
+		{
+			*m_Seconds += by.count();
+		}
+
+		std::function<std::chrono::system_clock::time_point()> Function() const
+		{
+			std::shared_ptr<std::atomic<int64_t>> seconds = m_Seconds;
+
+			return [seconds]()
+				{
+					return std::chrono::system_clock::time_point(std::chrono::seconds(seconds->load()));
+				};
+		}
+	};
+
+	/// <summary>
+	/// Creates a task manager for a store that reads the time from a clock, and waits for it to load.
+	/// </summary>
+	std::unique_ptr<TaskManager> OpenStore(const std::string& store_name, const FakeClock& clock)
+	{
+		std::shared_ptr<std::promise<void>> loaded = std::make_shared<std::promise<void>>();
+		std::future<void> is_loaded = loaded->get_future();
+
+		std::unique_ptr<TaskManager> manager = std::make_unique<TaskManager>(store_name, clock.Function(), [loaded](const TaskLoadMetrics&)
+			{
+				loaded->set_value();
+			});
+
+		is_loaded.wait();
+		return manager;
+	}
+
+	/// <summary>
+	/// Checks that a session that runs past midnight rolls over to the new day: the tasks of the day that ended stay in its partition,
+	/// the tasks added after midnight land on the new day with ids no earlier day used, and each day has its own statistics.
+	/// </summary>
+	void CheckDayRollover(const report_func& report)
+	{
+		std::chrono::system_clock::time_point evening = mrt::time::StartOfDay(std::chrono::system_clock::now()) + std::chrono::hours(23);
+		FakeClock clock(evening);
+
+		std::string first_day = mrt::time::LocalDate(evening);
+		std::string second_day = mrt::time::LocalDate(evening + std::chrono::hours(2));
+		std::set<uint64_t> first_ids;
+		bool is_rolled = false;
+		bool is_kept = false;
+		bool is_counted = false;
+
+		{
+			std::unique_ptr<TaskManager> manager = OpenStore("taskcheck-days", clock);
+
+			manager->AddTask(Task("first 1", "", "09:00", "10:00", false));
+			manager->AddTask(Task("first 2", "", "10:00", "11:00", true));
+
+			for (const Task& task : manager->Snapshot())
+			{
+				first_ids.insert(task.id);
+			}
+
+			clock.Advance(std::chrono::hours(2));
+
+			manager->AddTask(Task("second 1", "", "", "", false));
+			manager->AddTask(Task("second 2", "", "", "", false));
+			manager->AddTask(Task("second 3", "", "", "", false));
+
+			bool is_new_id = true;
+
+			for (const Task& task : manager->Snapshot())
+			{
+				is_new_id = is_new_id && first_ids.count(task.id) == 0;
+			}
+
+			is_rolled = Describe(manager->Snapshot()) == std::vector<std::string>{ "second 1", "second 2", "second 3" } &&
+				is_new_id && manager->UndoCount() == 3;
+			is_kept = Describe(manager->LoadDay(first_day)) == std::vector<std::string>{ "first 1", "first 2 [done]" };
+			is_counted = manager->GetDayStatistics(first_day).task_count == 2 && manager->GetDayStatistics(first_day).completed_count == 1 &&
+				manager->GetDayStatistics(second_day).task_count == 3;
+		}
+
+		// The store is opened again on the second day, each day reads back from its own partition.
+		std::unique_ptr<TaskManager> manager = OpenStore("taskcheck-days", clock);
+		mrt::Vector<StoragePartition> days = manager->GetStoredDays();
+		uint64_t first_count = 0;
+		uint64_t second_count = 0;
+
+		for (const StoragePartition& day : days)
+		{
+			first_count = day.date == first_day ? day.task_count : first_count;
+			second_count = day.date == second_day ? day.task_count : second_count;
+		}
+
+		bool is_stored = days.Size() == 2 && first_count == 2 && second_count == 3 &&
+			Describe(manager->Snapshot()) == std::vector<std::string>{ "second 1", "second 2", "second 3" } &&
+			Describe(manager->LoadDay(first_day)) == std::vector<std::string>{ "first 1", "first 2 [done]" };
+
+		report("day rollover moves new tasks to the new day", is_rolled);
+		report("day rollover keeps the day that ended", is_kept && is_counted);
+		report("day rollover stores one partition per day", is_stored);
+	}
+
+	/// <summary>
+	/// Checks that a dependency between tasks of one day does not carry over to the tasks of the next day, whose ids are new.
+	/// The dependencies are kept in one file for the store, so the check is made again after the store is opened on the second day.
+	/// </summary>
+	void CheckDependenciesOverDays(const report_func& report)
+	{
+		std::chrono::system_clock::time_point evening = mrt::time::StartOfDay(std::chrono::system_clock::now()) + std::chrono::hours(23);
+		FakeClock clock(evening);
+
+		bool is_waiting = false;
+		bool is_dropped = false;
+
+		auto is_every_task_ready = [](const TaskManager& manager)
+			{
+				bool is_ready = true;
+
+				for (const Task& task : manager.Snapshot())
+				{
+					is_ready = is_ready && manager.IsReady(task.id);
+				}
+
+				return is_ready;
+			};
+
+		{
+			std::unique_ptr<TaskManager> manager = OpenStore("taskcheck-chains", clock);
+
+			manager->AddTask(Task("first", "", "", "", false));
+			manager->AddTask(Task("second", "", "", "", false));
+
+			mrt::PersistentVector<Task> tasks = manager->Snapshot();
+			is_waiting = manager->AddDependency(tasks[0].id, tasks[1].id) && !manager->IsReady(tasks[1].id);
+
+			clock.Advance(std::chrono::hours(2));
+
+			manager->AddTask(Task("next first", "", "", "", false));
+			manager->AddTask(Task("next second", "", "", "", false));
+
+			is_dropped = manager->GetDependencies().Empty() && is_every_task_ready(*manager);
+		}
+
+		std::unique_ptr<TaskManager> manager = OpenStore("taskcheck-chains", clock);
+
+		bool is_reopened = manager->Snapshot().Size() == 2 && manager->GetDependencies().Empty() && is_every_task_ready(*manager);
+
+		report("dependencies stay on their day", is_waiting && is_dropped && is_reopened);
+	}
+
+	/// <summary>
+	/// Checks that the statistics rollup of the day, kept up to date from each change, equals the rollup counted from the tasks.
+	/// The changes are adds, batches, completions, removals, undos and redos, with times that run past midnight or are not valid.
+	/// The rollup is checked again after the store is opened again, when it is read back rather than counted.
+	/// </summary>
+	void CheckRollups(uint64_t seed, const report_func& report)
+	{
+		std::mt19937_64 random(seed);
+		FakeClock clock(mrt::time::StartOfDay(std::chrono::system_clock::now()) + std::chrono::hours(12));
+		std::string today = mrt::time::LocalDate(mrt::time::StartOfDay(std::chrono::system_clock::now()) + std::chrono::hours(12));
+		uint64_t next_title = 0;
+
+		auto random_time = [&random]()
+			{
+				return random() % 10 == 0 ? std::string() : FormatMinute(static_cast<int>(random() % (24 * 60)));
+			};
+
+		auto random_task = [&]()
+			{
+				return Task("task " + std::to_string(next_title++), "", random_time(), random_time(), random() % 4 == 0);
+			};
+
+		auto is_counted = [&today](const TaskManager& manager)
+			{
+				DayRollup counted;
+				counted.day = mrt::time::ParseDate(today);
+
+				for (const Task& task : manager.Snapshot())
+				{
+					counted.Count(task, true);
+				}
+
+				return manager.GetDayStatistics(today) == counted;
+			};
+
+		bool is_kept = true;
+
+		{
+			std::unique_ptr<TaskManager> manager = OpenStore("taskcheck-rollups", clock);
+
+			for (uint64_t step = 0; step < 300; step++)
+			{
+				mrt::PersistentVector<Task> tasks = manager->Snapshot();
+				uint64_t op = random() % 7;
+
+				if (op == 0 || tasks.Empty())
+				{
+					manager->AddTask(random_task());
+				}
+				else if (op == 1)
+				{
+					mrt::Vector<Task> batch;
+
+					for (uint64_t i = random() % 4; i > 0; i--)
+					{
+						batch.PushBack(random_task());
+					}
+
+					manager->AddTasks(batch);
+				}
+				else if (op == 2)
+				{
+					const Task& task = tasks.At(random() % tasks.Size());
+					manager->CompleteTask(task.title, !task.is_done);
+				}
+				else if (op == 3)
+				{
+					manager->RemoveTask(tasks.At(random() % tasks.Size()).title);
+				}
+				else if (op == 4 || op == 5)
+				{
+					manager->Undo();
+				}
+				else
+				{
+					manager->Redo();
+				}
+
+				is_kept = is_kept && is_counted(*manager);
+			}
+		}
+
+		std::unique_ptr<TaskManager> manager = OpenStore("taskcheck-rollups", clock);
+
+		report("rollup follows changes, undo and redo", is_kept);
+		report("rollup read back after reopening", is_counted(*manager));
+	}
+
+	/// <summary>
+	/// Checks the timing wheel against a list of every timer, with random timers scheduled, cancelled and advanced over.
+	/// The deadlines reach past the top level, so timers move down from the overflow list and through every level of the wheel.
+	/// Each timer has to expire on its own tick, after it was scheduled and before it was cancelled.
+	/// </summary>
+	void CheckTimingWheel(uint64_t seed, const report_func& report)
+	{
+		// A deadline past 64^4 ticks is held in the overflow list.
+		static constexpr uint64_t s_Reach = uint64_t(1) << 24;
+
+		std::mt19937_64 random(seed);
+		mrt::TimingWheel<uint64_t> wheel(random() % 1000);
+
+		// The handle and the deadline of each timer that has not expired, by its payload.
+		std::map<uint64_t, std::pair<mrt::TimingWheel<uint64_t>::Handle, uint64_t>> pending;
+		uint64_t next_payload = 1;
+		bool is_on_time = true;
+		bool is_cancelled = true;
+		bool has_overflowed = false;
+
+		for (uint64_t step = 0; step < 3000; step++)
+		{
+			uint64_t op = random() % 10;
+
+			if (op < 6)
+			{
+				uint64_t range = random() % 4 == 0 ? 2 * s_Reach : uint64_t(1) << (random() % 24);
+				uint64_t deadline = wheel.Now() + random() % range;
+
+				has_overflowed = has_overflowed || deadline - wheel.Now() >= s_Reach;
+
+				// A deadline that is not after the current tick expires on the next one.
+				pending[next_payload] = { wheel.Schedule(deadline, next_payload), std::max(deadline, wheel.Now() + 1) };
+				next_payload++;
+			}
+			else if (op < 8 && !pending.empty())
+			{
+				auto timer = pending.begin();
+				std::advance(timer, random() % pending.size());
+
+				is_cancelled = is_cancelled && wheel.Cancel(timer->second.first) && !wheel.Cancel(timer->second.first);
+				pending.erase(timer);
+			}
+			else
+			{
+				uint64_t to = wheel.Now() + (random() % 8 == 0 ? s_Reach / 2 : random() % 5000);
+
+				wheel.Advance(to, [&](uint64_t payload)
+					{
+						auto timer = pending.find(payload);
+
+						is_on_time = is_on_time && timer != pending.end() && timer->second.second == wheel.Now();
+
+						if (timer != pending.end())
+						{
+							pending.erase(timer);
+						}
+					});
+
+				// Every timer left is still to come.
+				for (const auto& timer : pending)
+				{
+					is_on_time = is_on_time && timer.second.second > wheel.Now();
+				}
+			}
+
+			is_on_time = is_on_time && wheel.Size() == pending.size();
+		}
+
+		// Whatever is left expires in order as the wheel runs on past the last deadline.
+		uint64_t last = 0;
+
+		for (const auto& timer : pending)
+		{
+			last = std::max(last, timer.second.second);
+		}
+
+		wheel.Advance(last, [&](uint64_t payload)
+			{
+				auto timer = pending.find(payload);
+
+				is_on_time = is_on_time && timer != pending.end() && timer->second.second == wheel.Now();
+
+				if (timer != pending.end())
+				{
+					pending.erase(timer);
+				}
+			});
+
+		report("timing wheel fires each timer on its tick", is_on_time && has_overflowed && pending.empty() && wheel.Empty());
+		report("timing wheel cancels pending timers", is_cancelled);
+	}
+
+	/// <summary>
+	/// A reminder observer that remembers each reminder as the title of its task and whether it started or ended.
+	/// </summary>
+	class RecordingReminders : public ReminderObserver
+	{
+	private:
+		std::mutex m_Mutex;
+		std::vector<std::string> m_Reminded;
+	public:
+		void Remind(const Reminder& reminder) override
+		{
+			std::lock_guard<std::mutex> lock(m_Mutex);
+
+			m_Reminded.push_back(reminder.task.title + (reminder.kind == ReminderKind::Start ? " start" : " end"));
+		}
+
+		/// <summary>
+		/// Gets the reminders since the last call, sorted, as the reminders of a tick have no order.
+		/// </summary>
+		std::vector<std::string> Take()
+		{
+			std::lock_guard<std::mutex> lock(m_Mutex);
+
+			std::vector<std::string> reminded;
+			reminded.swap(m_Reminded);
+			std::sort(reminded.begin(), reminded.end());
+
+			return reminded;
+		}
+	};
+
+	/// <summary>
+	/// Checks that the reminders go on firing after midnight, with a clock moved by hand over the end of the day.
+	/// The tasks are armed again for the new day, and the task manager moves on to the new day as its reminders pass midnight.
+	/// </summary>
+	void CheckReminders(const report_func& report)
+	{
+		using strings = std::vector<std::string>;
+
+		std::chrono::system_clock::time_point late = mrt::time::StartOfDay(std::chrono::system_clock::now()) + std::chrono::hours(23) + std::chrono::minutes(58);
+		FakeClock clock(late);
+
+		ReminderScheduler scheduler(clock.Function(), false, std::chrono::minutes(1));
+		RecordingReminders reminders;
+		uint64_t day_starts = 0;
+
+		scheduler.Attach(&reminders);
+		scheduler.SetDayStartHandler([&day_starts]()
+			{
+				day_starts++;
+			});
+
+		auto task = [](uint64_t id, const std::string& title, const std::string& start, const std::string& end, bool is_done)
+			{
+				Task scheduled(title, "", start, end, is_done);
+				scheduled.id = id;
+				return scheduled;
+			};
+
+		scheduler.Schedule(task(1, "late", "23:59", "00:30", false));
+		scheduler.Schedule(task(2, "early", "00:10", "01:00", false));
+		scheduler.Schedule(task(3, "done", "00:20", "00:40", true));
+
+		auto poll_at = [&](std::chrono::minutes by)
+			{
+				clock.Advance(by);
+				scheduler.Poll();
+				return reminders.Take();
+			};
+
+		bool is_late_day = poll_at(std::chrono::minutes(0)).empty() && poll_at(std::chrono::minutes(1)) == strings{ "late start" } && day_starts == 0;
+
+		// Midnight, the times of the tasks are now for the new day.
+		bool is_new_day = poll_at(std::chrono::minutes(6)).empty() && day_starts == 1 &&
+			poll_at(std::chrono::minutes(5)) == strings{ "early start" } &&
+			poll_at(std::chrono::minutes(50)) == strings{ "early end", "late end" } &&
+			poll_at(std::chrono::minutes(23 * 60 - 1)) == strings{ "late start" } && day_starts == 1;
+
+		// Days that passed without a poll start the day once, and only the reminders of the current day fire.
+		bool is_skipped = poll_at(std::chrono::hours(3 * 24) + std::chrono::minutes(12)) == strings{ "early start" } && day_starts == 2;
+
+		// The task manager moves on to the new day as its reminders pass midnight, without a task being added or saved.
+		FakeClock manager_clock(late);
+		std::unique_ptr<TaskManager> manager = OpenStore("taskcheck-midnight", manager_clock);
+
+		manager->AddTask(Task("before midnight", "", "23:59", "", false));
+		manager_clock.Advance(std::chrono::minutes(3));
+		manager->Reminders().Poll();
+
+		bool is_rolled = manager->Snapshot().Empty() &&
+			Describe(manager->LoadDay(mrt::time::LocalDate(late))) == strings{ "before midnight" };
+
+		report("reminders fire on the day that ends", is_late_day);
+		report("reminders armed again after midnight", is_new_day);
+		report("reminders skip days without a poll", is_skipped);
+		report("task manager rolls over at midnight", is_rolled);
+	}
+
+	/// <summary>
+	/// An observer that remembers the number of tasks of its last update and how many updates it had.
+	/// </summary>
+	class CountingObserver : public Observer
+	{
+	private:
+		mutable std::mutex m_Mutex;
+		uint64_t m_Updates{ 0 };
+		uint64_t m_LastSize{ 0 };
+	public:
+		void Update(const mrt::PersistentVector<Task>& tasks) override
+		{
+			std::lock_guard<std::mutex> lock(m_Mutex);
+
+			m_Updates++;
+			m_LastSize = tasks.Size();
+		}
+
+		uint64_t Updates() const
+		{
+			std::lock_guard<std::mutex> lock(m_Mutex);
+
+			return m_Updates;
+		}
+
+		uint64_t LastSize() const
+		{
+			std::lock_guard<std::mutex> lock(m_Mutex);
+
+			return m_LastSize;
+		}
+	};
+
+	/// <summary>
+	/// Waits until a condition holds, or gives up after two seconds so a broken dispatcher fails the check rather than hanging it.
+	/// </summary>
+	bool WaitFor(const std::function<bool()>& condition)
+	{
+		std::chrono::steady_clock::time_point deadline = std::chrono::steady_clock::now() + std::chrono::seconds(2);
+
+		while (!condition())
+		{
+			if (std::chrono::steady_clock::now() > deadline)
+				return false;
+
+			std::this_thread::sleep_for(std::chrono::milliseconds(1));
+		}
+
+		return true;
+	}
+
+	/// <summary>
+	/// Checks that the dispatcher coalesces the notifications for an observer into the latest tasks, that an observer is not
+	/// handed another delivery while one is waiting on its executor, and that an executor may run a delivery inline.
+	/// </summary>
+	void CheckDispatcher(const report_func& report)
+	{
+		auto tasks_of_size = [](uint64_t size)
+			{
+				mrt::PersistentVector<Task> tasks;
+
+				for (uint64_t i = 0; i < size; i++)
+				{
+					tasks.PushBack(Task());
+				}
+
+				return tasks;
+			};
+
+		// The deliveries are held back, as if the observer's thread were busy, and run by the check.
+		std::mutex held_mutex;
+		std::vector<std::function<void()>> held;
+
+		auto held_count = [&held_mutex, &held]()
+			{
+				std::lock_guard<std::mutex> lock(held_mutex);
+				return held.size();
+			};
+
+		auto run_held = [&held_mutex, &held](uint64_t index)
+			{
+				std::function<void()> delivery;
+
+				{
+					std::lock_guard<std::mutex> lock(held_mutex);
+					delivery = held[index];
+				}
+
+				delivery();
+			};
+
+		CountingObserver held_observer;
+		CountingObserver inline_observer;
+
+		{
+			ObserverDispatcher dispatcher(std::chrono::milliseconds(1));
+
+			dispatcher.Add(&held_observer, [&held_mutex, &held](std::function<void()> delivery)
+				{
+					std::lock_guard<std::mutex> lock(held_mutex);
+					held.push_back(delivery);
+				});
+
+			for (uint64_t size = 1; size <= 10; size++)
+			{
+				dispatcher.Enqueue(&held_observer, tasks_of_size(size));
+			}
+
+			bool is_handed = WaitFor([&held_count]() { return held_count() == 1; });
+
+			for (uint64_t size = 11; size <= 20; size++)
+			{
+				dispatcher.Enqueue(&held_observer, tasks_of_size(size));
+			}
+
+			std::this_thread::sleep_for(std::chrono::milliseconds(20));
+			bool is_held_once = held_count() == 1;
+
+			if (is_handed)
+			{
+				run_held(0);
+			}
+
+			DispatchMetrics metrics = dispatcher.GetMetrics();
+			bool is_coalesced = held_observer.Updates() == 1 && held_observer.LastSize() == 20 &&
+				metrics.notifications == 20 && metrics.coalesced == 19 && metrics.deliveries == 1 && metrics.queue_depth == 0;
+
+			std::this_thread::sleep_for(std::chrono::milliseconds(20));
+			bool is_idle = held_count() == 1;
+
+			dispatcher.Enqueue(&held_observer, tasks_of_size(21));
+			bool is_handed_again = WaitFor([&held_count]() { return held_count() == 2; });
+
+			if (is_handed_again)
+			{
+				run_held(1);
+			}
+
+			report("dispatcher coalesces to the latest tasks", is_handed && is_coalesced);
+			report("dispatcher holds an observer in flight", is_held_once && is_idle);
+			report("dispatcher delivers after in flight", is_handed_again && held_observer.LastSize() == 21);
+
+			dispatcher.Add(&inline_observer, [](std::function<void()> delivery)
+				{
+					delivery();
+				});
+
+			bool is_inline = true;
+
+			for (uint64_t size = 1; size <= 5 && is_inline; size++)
+			{
+				dispatcher.Enqueue(&inline_observer, tasks_of_size(size));
+				is_inline = WaitFor([&inline_observer, size]() { return inline_observer.LastSize() == size; });
+			}
+
+			report("dispatcher runs an inline executor", is_inline);
+		}
+	}
+
+	/// <summary>
+	/// Checks that the subscription index notifies exactly the subscriptions whose filters match a change, against a test of every
+	/// filter on its own. The time windows are compared minute by minute around the clock, so a window or a task that runs past
+	/// midnight has to match in the hours of both days. A window with a time that is not HH:MM is refused.
+	/// </summary>
+	void CheckSubscriptionIndex(uint64_t seed, const report_func& report)
+	{
+		static constexpr uint64_t s_Subscriptions = 150;
+
+		std::mt19937_64 random(seed);
+		std::vector<CountingObserver> observers(s_Subscriptions);
+		std::vector<SubscriptionFilter> filters;
+		SubscriptionIndex index;
+
+		auto random_time = [&random]()
+			{
+				// One time in twenty is not valid, a task with it has no time window.
+				return random() % 20 == 0 ? std::string("25:00") : FormatMinute(static_cast<int>(random() % (24 * 60)));
+			};
+
+		// The minutes of the day from the start to the end, going past midnight when the end is before the start.
+		auto minutes_of = [](int from, int to)
+			{
+				std::vector<bool> minutes(24 * 60, false);
+
+				for (int minute = from; ; minute = (minute + 1) % (24 * 60))
+				{
+					minutes[minute] = true;
+
+					if (minute == to)
+						break;
+				}
+
+				return minutes;
+			};
+
+		auto overlaps = [&minutes_of](const SubscriptionFilter& filter, const Task& task)
+			{
+				int start = mrt::time::ParseMinuteOfDay(task.start_time);
+				int end = mrt::time::ParseMinuteOfDay(task.end_time);
+
+				if (start < 0 || end < 0)
+					return false;
+
+				std::vector<bool> window = minutes_of(filter.from_minute, filter.to_minute);
+				std::vector<bool> covered = minutes_of(start, end);
+
+				for (uint64_t minute = 0; minute < window.size(); minute++)
+				{
+					if (window[minute] && covered[minute])
+						return true;
+				}
+
+				return false;
+			};
+
+		for (uint64_t i = 0; i < s_Subscriptions; i++)
+		{
+			SubscriptionFilter filter;
+
+			if (random() % 3 == 0)
+			{
+				filter.fields = static_cast<uint32_t>(1 + random() % TaskField::All);
+			}
+
+			if (random() % 3 == 0)
+			{
+				for (uint64_t id = 0; id < 3; id++)
+				{
+					filter.ids.insert(1 + random() % 40);
+				}
+			}
+
+			if (random() % 2 == 0)
+			{
+				uint32_t fields = filter.fields;
+				std::unordered_set<uint64_t> ids = filter.ids;
+
+				SubscriptionFilter::TimeRange(FormatMinute(static_cast<int>(random() % (24 * 60))), FormatMinute(static_cast<int>(random() % (24 * 60))), filter);
+				filter.fields = fields;
+				filter.ids = ids;
+			}
+
+			filters.push_back(filter);
+			index.Add(&observers[i], false, filter);
+		}
+
+		bool is_matched = true;
+
+		for (uint64_t step = 0; step < 2000; step++)
+		{
+			auto random_task = [&random, &random_time]()
+				{
+					Task task("task", "", random_time(), random_time(), false);
+					task.id = 1 + random() % 40;
+					return task;
+				};
+
+			Task before = random_task();
+			Task after = random_task();
+			after.id = before.id;
+
+			uint64_t op = random() % 3;
+			TaskChange change = op == 0 ? TaskChange::Added(after) : op == 1 ? TaskChange::Removed(before) : TaskChange::Modified(before, after);
+
+			std::set<Observer*> expected;
+			std::set<Observer*> found;
+
+			for (uint64_t i = 0; i < s_Subscriptions; i++)
+			{
+				const SubscriptionFilter& filter = filters[i];
+
+				if ((filter.fields & change.fields) != 0 && (filter.ids.empty() || filter.ids.count(change.id) > 0) &&
+					(!filter.has_time_range || overlaps(filter, change.before) || overlaps(filter, change.after)))
+				{
+					expected.insert(&observers[i]);
+				}
+			}
+
+			index.ForEachMatch(change, [&found](const SubscriptionIndex::Entry& entry)
+				{
+					found.insert(entry.observer);
+				});
+
+			is_matched = is_matched && found == expected;
+		}
+
+		// An overnight window, against tasks in the evening, in the morning, across midnight, at its edges and outside it.
+		SubscriptionFilter overnight;
+		bool is_parsed = SubscriptionFilter::TimeRange("22:00", "06:00", overnight);
+
+		SubscriptionIndex overnight_index;
+		CountingObserver overnight_observer;
+		overnight_index.Add(&overnight_observer, false, overnight);
+
+		auto is_notified = [&overnight_index](const std::string& start, const std::string& end)
+			{
+				Task task("task", "", start, end, false);
+				task.id = 1;
+
+				bool notified = false;
+
+				overnight_index.ForEachMatch(TaskChange::Added(task), [&notified](const SubscriptionIndex::Entry&)
+					{
+						notified = true;
+					});
+
+				return notified;
+			};
+
+		bool is_overnight = is_parsed &&
+			is_notified("23:00", "23:30") && is_notified("03:00", "04:00") && is_notified("23:30", "00:30") &&
+			is_notified("21:00", "22:00") && is_notified("06:00", "07:00") && is_notified("20:00", "07:00") &&
+			!is_notified("12:00", "13:00") && !is_notified("06:01", "21:59") && !is_notified("", "");
+
+		SubscriptionFilter refused;
+		bool is_refused = !SubscriptionFilter::TimeRange("24:00", "06:00", refused) && !SubscriptionFilter::TimeRange("22:00", "6:00", refused) &&
+			!SubscriptionFilter::TimeRange("", "06:00", refused);
+
+		report("subscription index matches every filter", is_matched);
+		report("subscription overnight window", is_overnight);
+		report("subscription window refuses bad times", is_refused);
+	}
+
+	/// <summary>
+	/// A query of the planner check, with the index it should read from and what it should find, worked out without the planner.
+	/// </summary>
+	struct QueryCase
+	{
+		std::string text;
+		QueryField index;
+		std::function<bool(const Task&)> matches;
+		QueryField order_by{ QueryField::None };
+		bool descending{ false };
+		uint64_t limit{ UINT64_MAX };
+	};
+
+	/// <summary>
+	/// Checks that the query planner reads each query from the index it should, and that a query finds the same tasks in the same
+	/// order from its index as from a scan of every task and as a plain filter and sort. The queries are run again after tasks
+	/// were changed, with the indexes updated by the changes rather than rebuilt.
+	/// </summary>
+	void CheckQueryPlanner(uint64_t seed, const report_func& report)
+	{
+		std::mt19937_64 random(seed);
+		std::vector<Task> tasks;
+
+		auto random_task = [&random](uint64_t id)
+			{
+				int start = static_cast<int>(random() % (20 * 60));
+				Task task("plan " + std::to_string(random() % 50), "", FormatMinute(start), FormatMinute(start + static_cast<int>(random() % 240)), random() % 3 == 0);
+				task.id = id;
+				return task;
+			};
+
+		for (uint64_t id = 1; id <= 3000; id++)
+		{
+			tasks.push_back(random_task(id));
+		}
+
+		std::vector<QueryCase> cases = {
+			{ "id = 1500", QueryField::Id, [](const Task& task) { return task.id == 1500; } },
+			{ "id >= 100 and id < 200", QueryField::Id, [](const Task& task) { return task.id >= 100 && task.id < 200; } },
+			{ "title = \"plan 7\"", QueryField::Title, [](const Task& task) { return task.title == "plan 7"; } },
+			{ "title = \"plan 7\" and done = false", QueryField::Title, [](const Task& task) { return task.title == "plan 7" && !task.is_done; } },
+			{ "start >= 09:00 and start < 12:00", QueryField::Start, [](const Task& task) { return task.start_time >= "09:00" && task.start_time < "12:00"; } },
+			{ "end <= 08:30", QueryField::End, [](const Task& task) { return task.end_time <= "08:30"; } },
+			{ "done = true", QueryField::None, [](const Task& task) { return task.is_done; } },
+			{ "title ~ \"N 4\" or start < 06:00", QueryField::None, [](const Task& task) { return task.title.find("n 4") != std::string::npos || task.start_time < "06:00"; } },
+			{ "start >= 10:00 and id > 500 order by end desc limit 20", QueryField::Id,
+				[](const Task& task) { return task.start_time >= "10:00" && task.id > 500; }, QueryField::End, true, 20 },
+			{ "order by start limit 25", QueryField::Start, [](const Task&) { return true; }, QueryField::Start, false, 25 },
+			{ "done = false order by title limit 40", QueryField::Title, [](const Task& task) { return !task.is_done; }, QueryField::Title, false, 40 },
+			{ "not (start < 12:00) and end > 13:00 order by start", QueryField::End,
+				[](const Task& task) { return !(task.start_time < "12:00") && task.end_time > "13:00"; }, QueryField::Start }
+		};
+
+		auto all_tasks = [&tasks]()
+			{
+				mrt::PersistentVector<Task> all;
+
+				for (const Task& task : tasks)
+				{
+					all.PushBack(task);
+				}
+
+				return all;
+			};
+
+		std::map<QueryField, std::unique_ptr<TaskView>> indexes;
+
+		for (QueryField field : { QueryField::Id, QueryField::Title, QueryField::Start, QueryField::End })
+		{
+			indexes[field] = std::make_unique<TaskView>(nullptr, TaskQuery::IndexOrder(field));
+			indexes[field]->Reset(all_tasks());
+		}
+
+		auto ids_of = [](const mrt::Vector<Task>& found, bool is_ordered)
+			{
+				std::vector<uint64_t> ids;
+
+				for (const Task& task : found)
+				{
+					ids.push_back(task.id);
+				}
+
+				if (!is_ordered)
+				{
+					std::sort(ids.begin(), ids.end());
+				}
+
+				return ids;
+			};
+
+		auto run_cases = [&](const std::string& suffix)
+			{
+				mrt::PersistentVector<Task> all = all_tasks();
+				bool is_planned = true;
+				bool is_found = true;
+
+				for (const QueryCase& query : cases)
+				{
+					std::string error;
+					std::shared_ptr<const TaskQuery> compiled = TaskQuery::Compile(query.text, error);
+
+					if (!compiled)
+					{
+						is_planned = false;
+						continue;
+					}
+
+					is_planned = is_planned && compiled->GetIndex() == query.index;
+
+					mrt::Vector<Task> expected;
+					std::vector<Task> matching;
+
+					for (const Task& task : tasks)
+					{
+						if (query.matches(task))
+						{
+							matching.push_back(task);
+						}
+					}
+
+					if (query.order_by != QueryField::None)
+					{
+						std::sort(matching.begin(), matching.end(), [&query](const Task& left, const Task& right)
+							{
+								const std::string& left_value = query.order_by == QueryField::Title ? left.title : query.order_by == QueryField::Start ? left.start_time : left.end_time;
+								const std::string& right_value = query.order_by == QueryField::Title ? right.title : query.order_by == QueryField::Start ? right.start_time : right.end_time;
+
+								if (left_value == right_value)
+									return left.id < right.id;
+
+								return query.descending ? left_value > right_value : left_value < right_value;
+							});
+
+						matching.resize(std::min<uint64_t>(matching.size(), query.limit));
+					}
+
+					for (const Task& task : matching)
+					{
+						expected.PushBack(task);
+					}
+
+					bool is_ordered = query.order_by != QueryField::None;
+					const TaskView* index = query.index != QueryField::None ? indexes[query.index].get() : nullptr;
+					std::vector<uint64_t> expected_ids = ids_of(expected, is_ordered);
+
+					is_found = is_found &&
+						ids_of(compiled->Execute(all, index), is_ordered) == expected_ids &&
+						ids_of(compiled->Execute(all, nullptr), is_ordered) == expected_ids;
+				}
+
+				report("query planner index choice" + suffix, is_planned);
+				report("query results from index and scan" + suffix, is_found);
+			};
+
+		run_cases("");
+
+		for (uint64_t i = 0; i < 500; i++)
+		{
+			uint64_t position = random() % tasks.size();
+			Task before = tasks[position];
+			Task after = random_task(before.id);
+
+			tasks[position] = after;
+
+			for (auto& index : indexes)
+			{
+				index.second->Apply(TaskChange::Modified(before, after));
+			}
+		}
+
+		run_cases(" after changes");
+	}
+
+	/// <summary>
+	/// Checks the dependency graph against a plain set of edges, through random edges added and removed and tasks done and undone.
+	/// An edge must be refused exactly when a search of the edges finds it would close a cycle, the order kept by the Pearce-Kelly
+	/// reordering must agree with every edge after each change, and the counts of tasks waiting must match the edges.
+	/// </summary>
+	void CheckDependencyGraph(uint64_t seed, const report_func& report)
+	{
+		static constexpr uint64_t s_Tasks = 150;
+
+		std::mt19937_64 random(seed);
+		DependencyGraph graph;
+		std::set<std::pair<uint64_t, uint64_t>> edges;
+		std::vector<bool> done(s_Tasks + 1, false);
+
+		auto reaches = [&edges](uint64_t from, uint64_t to)
+			{
+				std::vector<uint64_t> stack{ from };
+				std::set<uint64_t> seen{ from };
+
+				while (!stack.empty())
+				{
+					uint64_t task = stack.back();
+					stack.pop_back();
+
+					if (task == to)
+						return true;
+
+					for (auto edge = edges.lower_bound({ task, 0 }); edge != edges.end() && edge->first == task; ++edge)
+					{
+						if (seen.insert(edge->second).second)
+						{
+							stack.push_back(edge->second);
+						}
+					}
+				}
+
+				return false;
+			};
+
+		bool is_refused_on_cycle = true;
+		uint64_t refused = 0;
+		bool is_ordered = true;
+		bool is_counted = true;
+
+		for (uint64_t step = 0; step < 3000; step++)
+		{
+			uint64_t op = random() % 10;
+			uint64_t before = 1 + random() % s_Tasks;
+			uint64_t after = 1 + random() % s_Tasks;
+
+			if (op < 7)
+			{
+				bool expected = before != after && (edges.count({ before, after }) > 0 || !reaches(after, before));
+				bool added = graph.AddEdge(before, after);
+
+				is_refused_on_cycle = is_refused_on_cycle && added == expected;
+				refused += added ? 0 : 1;
+
+				if (added)
+				{
+					edges.insert({ before, after });
+					graph.SetDone(before, done[before]);
+					graph.SetDone(after, done[after]);
+				}
+			}
+			else if (op < 9)
+			{
+				if (!edges.empty())
+				{
+					auto edge = edges.lower_bound({ before, after });
+					edge = edge != edges.end() ? edge : edges.begin();
+					before = edge->first;
+					after = edge->second;
+				}
+
+				bool expected = edges.erase({ before, after }) > 0;
+				is_refused_on_cycle = is_refused_on_cycle && graph.RemoveEdge(before, after) == expected;
+			}
+			else
+			{
+				done[before] = !done[before];
+				graph.SetDone(before, done[before]);
+			}
+
+			mrt::Vector<uint64_t> order = graph.TopologicalOrder();
+			std::map<uint64_t, uint64_t> positions;
+
+			for (uint64_t i = 0; i < order.Size(); i++)
+			{
+				positions[order[i]] = i;
+			}
+
+			std::set<uint64_t> linked;
+			std::vector<uint64_t> pending(s_Tasks + 1, 0);
+
+			for (const std::pair<uint64_t, uint64_t>& edge : edges)
+			{
+				linked.insert(edge.first);
+				linked.insert(edge.second);
+				pending[edge.second] += done[edge.first] ? 0 : 1;
+
+				is_ordered = is_ordered && positions.count(edge.first) > 0 && positions.count(edge.second) > 0 &&
+					positions[edge.first] < positions[edge.second];
+			}
+
+			is_ordered = is_ordered && positions.size() == linked.size() && graph.EdgeCount() == edges.size();
+
+			uint64_t blocked = 0;
+
+			for (uint64_t task = 1; task <= s_Tasks; task++)
+			{
+				blocked += pending[task] > 0 ? 1 : 0;
+				is_counted = is_counted && graph.PendingCount(task) == pending[task] && graph.IsReady(task) == (pending[task] == 0);
+			}
+
+			is_counted = is_counted && graph.BlockedCount() == blocked;
+		}
+
+		report("dependency cycles refused", is_refused_on_cycle && refused > 0);
+		report("dependency order agrees with edges", is_ordered);
+		report("dependency readiness counts", is_counted);
+	}
+
+	/// <summary>
+	/// Gets every field of the tasks, in order, so two reads of a task file can be compared.
+	/// </summary>
+	std::vector<std::string> DescribeFields(const std::vector<Task>& tasks)
+	{
+		std::vector<std::string> described;
+
+		for (const Task& task : tasks)
+		{
+			described.push_back(std::to_string(task.id) + "|" + task.title + "|" + task.description + "|" +
+				task.start_time + "|" + task.end_time + "|" + (task.is_done ? "1" : "0"));
+		}
+
+		return described;
+	}
+
+	/// <summary>
+	/// Checks that dependencies and rollups changed while saves are being written on another thread are all read back
+	/// after the store is opened again. A save copies them and writes without the lock, so a change made during the write
+	/// has to be left marked for the next save.
+	/// </summary>
+	void CheckConcurrentSaves(const report_func& report)
+	{
+		static constexpr uint64_t s_Tasks = 40;
+
+		std::set<std::pair<uint64_t, uint64_t>> added;
+		DayRollup written;
+
+		{
+			std::unique_ptr<TaskManager> manager = OpenStore("taskcheck-saves");
+
+			for (uint64_t i = 0; i < s_Tasks; i++)
+			{
+				manager->AddTask(Task("task " + std::to_string(i), "", "09:00", "09:30", false));
+			}
+
+			mrt::PersistentVector<Task> tasks = manager->Snapshot();
+			std::atomic<bool> is_saving{ true };
+
+			std::thread saver([&manager, &is_saving]()
+				{
+					while (is_saving)
+					{
+						manager->Save();
+					}
+				});
+
+			for (uint64_t i = 0; i + 1 < tasks.Size(); i++)
+			{
+				if (manager->AddDependency(tasks.At(i).id, tasks.At(i + 1).id))
+				{
+					added.insert({ tasks.At(i).id, tasks.At(i + 1).id });
+				}
+
+				manager->CompleteTask(tasks.At(i).title, true);
+			}
+
+			is_saving = false;
+			saver.join();
+
+			written = manager->GetDayStatistics(mrt::time::LocalDate(std::chrono::system_clock::now()));
+		}
+
+		std::unique_ptr<TaskManager> manager = OpenStore("taskcheck-saves");
+		std::set<std::pair<uint64_t, uint64_t>> read_back;
+
+		for (const TaskDependency& dependency : manager->GetDependencies())
+		{
+			read_back.insert({ dependency.before, dependency.after });
+		}
+
+		report("saves keep changes made while writing", added.size() == s_Tasks - 1 && read_back == added &&
+			manager->GetDayStatistics(mrt::time::LocalDate(std::chrono::system_clock::now())) == written && written.completed_count == s_Tasks - 1);
+	}
+
+	/// <summary>
+	/// Checks that the binary storage's journal replays to the tasks as they were saved: each save appends the tasks that changed,
+	/// and a fresh storage reads the file and its journal back. The journal grows until it is folded into the file, and a block
+	/// cut short is ignored so the tasks read are those of the save before it.
+	/// </summary>
+	void CheckJournalReplay(uint64_t seed, const report_func& report)
+	{
+		static const std::string s_FileName = "taskcheck-journal";
+
+		std::mt19937_64 random(seed);
+		std::vector<Task> tasks;
+		uint64_t next_id = 1;
+
+		auto random_task = [&random](uint64_t id)
+			{
+				int start = static_cast<int>(random() % (20 * 60));
+				Task task("task " + std::to_string(random() % 1000), std::string(40 + random() % 80, static_cast<char>('a' + random() % 26)),
+					FormatMinute(start), FormatMinute(start + 30), random() % 2 == 0);
+				task.id = id;
+				return task;
+			};
+
+		auto to_vector = [](const std::vector<Task>& from)
+			{
+				mrt::Vector<Task> to;
+
+				for (const Task& task : from)
+				{
+					to.PushBack(task);
+				}
+
+				return to;
+			};
+
+		auto read_back = []()
+			{
+				StorageBinary storage;
+				mrt::Vector<Task> read;
+				std::vector<Task> found;
+
+				if (storage.Read(s_FileName, read))
+				{
+					for (const Task& task : read)
+					{
+						found.push_back(task);
+					}
+				}
+
+				return DescribeFields(found);
+			};
+
+		for (; next_id <= 500; next_id++)
+		{
+			tasks.push_back(random_task(next_id));
+		}
+
+		StorageBinary storage;
+		storage.Write(s_FileName, to_vector(tasks));
+
+		std::filesystem::path journal_path = std::filesystem::current_path() / (s_FileName + ".dtj");
+		bool is_replayed = true;
+		bool has_journal = false;
+		bool is_folded = false;
+
+		for (uint64_t save = 0; save < 60; save++)
+		{
+			TaskDelta delta;
+
+			for (uint64_t i = 0; i < 30; i++)
+			{
+				uint64_t position = random() % tasks.size();
+				tasks[position] = random_task(tasks[position].id);
+				delta.changed.PushBack(tasks[position]);
+			}
+
+			for (uint64_t i = 0; i < 3; i++)
+			{
+				uint64_t position = random() % tasks.size();
+				delta.removed.PushBack(tasks[position].id);
+				tasks.erase(tasks.begin() + position);
+			}
+
+			for (uint64_t i = 0; i < 5; i++)
+			{
+				tasks.push_back(random_task(next_id++));
+				delta.changed.PushBack(tasks.back());
+			}
+
+			// A task changed twice in a save is only written once, with its latest version, in the order it was first changed.
+			mrt::Vector<Task> changed;
+			std::set<uint64_t> seen;
+			std::set<uint64_t> removed;
+
+			for (uint64_t id : delta.removed)
+			{
+				removed.insert(id);
+			}
+
+			for (uint64_t i = 0; i < delta.changed.Size(); i++)
+			{
+				uint64_t id = delta.changed[i].id;
+
+				if (removed.count(id) > 0 || !seen.insert(id).second)
+					continue;
+
+				changed.PushBack(*std::find_if(tasks.begin(), tasks.end(), [id](const Task& task) { return task.id == id; }));
+			}
+
+			delta.changed = std::move(changed);
+			delta.task_count = tasks.size();
+
+			bool had_journal = std::filesystem::exists(journal_path);
+
+			storage.WriteDelta(s_FileName, delta, [&tasks, &to_vector]()
+				{
+					return to_vector(tasks);
+				});
+
+			bool journal_exists = std::filesystem::exists(journal_path);
+			has_journal = has_journal || journal_exists;
+			is_folded = is_folded || (had_journal && !journal_exists);
+			is_replayed = is_replayed && read_back() == DescribeFields(tasks);
+		}
+
+		// One more save, then the block it appended is cut short as if the save had failed part way.
+		std::vector<Task> saved = tasks;
+		TaskDelta delta;
+
+		tasks[0] = random_task(tasks[0].id);
+		delta.changed.PushBack(tasks[0]);
+		delta.task_count = tasks.size();
+
+		std::error_code error;
+		uint64_t journal_size = std::filesystem::exists(journal_path) ? std::filesystem::file_size(journal_path, error) : 0;
+
+		storage.WriteDelta(s_FileName, delta, [&tasks, &to_vector]()
+			{
+				return to_vector(tasks);
+			});
+
+		uint64_t appended_size = std::filesystem::exists(journal_path) ? std::filesystem::file_size(journal_path, error) : 0;
+		bool is_cut = appended_size > journal_size;
+
+		if (is_cut)
+		{
+			std::filesystem::resize_file(journal_path, appended_size - 3, error);
+		}
+
+		report("journal replays every save", is_replayed);
+		report("journal appended, then folded", has_journal && is_folded);
+		report("journal block cut short is ignored", is_cut && read_back() == DescribeFields(saved));
+	}
+
+	/// <summary>
+	/// Checks that the importer reads quoted CSV fields with commas, new lines and quotes in them, keeps a quote inside an
+	/// unquoted field, writes times as HH:MM, and rejects rows with too few or too many fields and rows longer than a chunk.
+	/// The chunks are small, so rows are cut off by the end of a chunk and completed by the next read.
+	/// </summary>
+	void CheckImporter(const report_func& report)
+	{
+		std::string long_title(100, 'x');
+
+		{
+			std::ofstream file("taskcheck-import.csv", std::ios::binary);
+
+			file << "title,description,start,end,done\r\n";
+			file << "\"Buy milk, eggs\",shop,9:00,9:30,no\r\n";
+			file << "\"Say \"\"hi\"\"\",\"two\nlines\",10:00,11:00,yes\n";
+			file << "5\" screen,,12:00,13:00,\n";
+			file << "short row,,12:00\n";
+			file << "long row,,12:00,13:00,no,extra\n";
+			file << long_title << ",,,,\n";
+			file << "bad time,,25:00,,\n";
+			file << "after,,7:05,,\n";
+			file << "last,,,,x";
+		}
+
+		std::unique_ptr<TaskManager> manager = OpenStore("taskcheck-import");
+		TaskImporter importer(*manager, 2, 64);
+
+		ImportProgress progress;
+
+		if (importer.Start("taskcheck-import.csv", ImportFormat::Csv))
+		{
+			progress = importer.Wait();
+		}
+
+		std::vector<std::string> imported;
+
+		for (const Task& task : manager->Snapshot())
+		{
+			imported.push_back(task.title + "|" + task.description + "|" + task.start_time + "|" + task.end_time + (task.is_done ? "|done" : ""));
+		}
+
+		std::vector<std::string> expected{
+			"Buy milk, eggs|shop|09:00|09:30",
+			"Say \"hi\"|two\nlines|10:00|11:00|done",
+			"5\" screen||12:00|13:00",
+			"after||07:05|",
+			"last||||done" };
+
+		report("import reads quoted and unquoted fields", progress.succeeded && imported == expected && progress.tasks_imported == 5);
+		report("import rejects rows of the wrong length", progress.rows_rejected == 4 && progress.error == "row 5: the row has 3 fields, the header has 5");
+	}
+
+	/// <summary>
+	/// Checks that blocks compressed with <see cref="mrt::Lz"/> and files compressed by the compression stage read back as they
+	/// were written, for random, repetitive, empty and tiny inputs. A block cut short is refused. A compressed file with a byte
+	/// changed is refused or reads back as it was written, as a changed match offset inside a run can still copy the same bytes.
+	/// </summary>
+	void CheckCompression(uint64_t seed, const report_func& report)
+	{
+		std::mt19937_64 random(seed);
+
+		// Random bytes do not compress, repetitive ones repeat words of a small vocabulary, runs and matches further back than 64 KiB.
+		auto random_input = [&random](uint64_t kind)
+			{
+				uint64_t size = kind == 0 ? 0 : kind == 1 ? random() % 17 : random() % (kind == 4 ? 300000 : 40000);
+				std::string input;
+
+				if (kind == 2)
+				{
+					for (uint64_t i = 0; i < size; i++)
+					{
+						input.push_back(static_cast<char>(random()));
+					}
+
+					return input;
+				}
+
+				std::vector<std::string> words{ "<task>", "</task>", "<title>", "09:00", "10:30", "true", "false", " ", "\n" };
+
+				while (input.size() < size)
+				{
+					uint64_t choice = random() % 10;
+
+					if (choice == 0)
+					{
+						input.append(random() % 300, static_cast<char>(random()));
+					}
+					else if (choice == 1)
+					{
+						input.push_back(static_cast<char>(random()));
+					}
+					else
+					{
+						input += words[random() % words.size()];
+					}
+				}
+
+				input.resize(size);
+				return input;
+			};
+
+		bool is_round_trip = true;
+		bool is_cut_refused = true;
+		bool is_stage_round_trip = true;
+		bool is_damage_refused = true;
+
+		for (uint64_t step = 0; step < 200; step++)
+		{
+			std::string input = random_input(step % 5);
+
+			std::string compressed(mrt::Lz::Bound(input.size()), '\0');
+			compressed.resize(mrt::Lz::Compress(input.data(), input.size(), compressed.data(), compressed.size()));
+
+			std::string output(input.size(), '\0');
+			is_round_trip = is_round_trip && !compressed.empty() &&
+				mrt::Lz::Decompress(compressed.data(), compressed.size(), output.data(), output.size()) && output == input;
+
+			if (compressed.size() > 1)
+			{
+				uint64_t cut = 1 + random() % (compressed.size() - 1);
+				is_cut_refused = is_cut_refused && !mrt::Lz::Decompress(compressed.data(), compressed.size() - cut, output.data(), output.size());
+			}
+
+			CompressionStage stage(1024 + random() % 4096);
+			std::string stored = input;
+			std::string read_back;
+
+			if (!stage.Encode(stored))
+			{
+				is_stage_round_trip = false;
+				continue;
+			}
+
+			read_back = stored;
+			is_stage_round_trip = is_stage_round_trip && stage.Decode(read_back) && read_back == input;
+
+			// The header is followed by the block table and the blocks, each covered by a checksum.
+			if (stored.size() > CompressionStage::s_HeaderSize)
+			{
+				std::string damaged = stored;
+				damaged[CompressionStage::s_HeaderSize + random() % (stored.size() - CompressionStage::s_HeaderSize)] ^= static_cast<char>(1 + random() % 255);
+
+				std::string cut = stored.substr(0, stored.size() - 1);
+
+				is_damage_refused = is_damage_refused && (!stage.Decode(damaged) || damaged == input) && !stage.Decode(cut);
+			}
+		}
+
+		// A file written before the stage was added has no header, and is read as it is.
+		std::string plain = "<tasks></tasks>";
+		bool is_plain_kept = CompressionStage().Decode(plain) && plain == "<tasks></tasks>";
+
+		report("lz round trip", is_round_trip);
+		report("lz refuses a block cut short", is_cut_refused);
+		report("compressed file round trip", is_stage_round_trip && is_plain_kept);
+		report("compressed file refuses damage", is_damage_refused);
+	}
+
+	/// <summary>
+	/// Checks that every ChaCha20 path the processor has makes the same keystream as the single block function, on buffers
+	/// of several KiB that reach the SSE2 and AVX2 paths, at odd addresses and lengths, and with counters that wrap past 2^32.
+	/// A buffer encrypted in two parts, split at a block, is also compared with the buffer encrypted at once.
+	/// </summary>
+	void CheckChaCha20(uint64_t seed, const report_func& report)
+	{
+		std::mt19937_64 random(seed);
+		uint8_t key[mrt::ChaCha20::s_KeySize];
+		uint8_t nonce[mrt::ChaCha20::s_NonceSize];
+
+		for (uint8_t& byte : key)
+		{
+			byte = static_cast<uint8_t>(random());
+		}
+
+		for (uint8_t& byte : nonce)
+		{
+			byte = static_cast<uint8_t>(random());
+		}
+
+		mrt::ChaCha20 portable(key, nonce, mrt::ChaCha20::Path::Portable);
+		bool is_same = true;
+		bool is_split_same = true;
+
+		for (uint64_t step = 0; step < 200; step++)
+		{
+			uint64_t size = random() % 3 == 0 ? random() % 600 : random() % 9000;
+			uint64_t offset = random() % 64;
+			uint32_t counter = random() % 2 == 0 ? 0xFFFFFFFFu - static_cast<uint32_t>(random() % 300) : static_cast<uint32_t>(random());
+
+			std::vector<char> plain(size);
+
+			for (char& byte : plain)
+			{
+				byte = static_cast<char>(random());
+			}
+
+			// The keystream one block at a time, the counter wraps as a 32-bit number.
+			std::vector<char> expected = plain;
+			uint8_t block[mrt::ChaCha20::s_BlockSize];
+
+			for (uint64_t i = 0; i < size; i++)
+			{
+				if (i % mrt::ChaCha20::s_BlockSize == 0)
+				{
+					portable.Block(counter + static_cast<uint32_t>(i / mrt::ChaCha20::s_BlockSize), block);
+				}
+
+				expected[i] ^= static_cast<char>(block[i % mrt::ChaCha20::s_BlockSize]);
+			}
+
+			for (int path = 0; path <= static_cast<int>(mrt::ChaCha20::FastestPath()); path++)
+			{
+				mrt::ChaCha20 cipher(key, nonce, static_cast<mrt::ChaCha20::Path>(path));
+				std::vector<char> buffer(size + offset);
+
+				std::copy(plain.begin(), plain.end(), buffer.begin() + offset);
+				cipher.Apply(buffer.data() + offset, size, counter);
+
+				is_same = is_same && std::equal(expected.begin(), expected.end(), buffer.begin() + offset);
+
+				uint64_t split = size > 0 ? (random() % size) / mrt::ChaCha20::s_BlockSize * mrt::ChaCha20::s_BlockSize : 0;
+
+				std::copy(plain.begin(), plain.end(), buffer.begin() + offset);
+				cipher.Apply(buffer.data() + offset, split, counter);
+				cipher.Apply(buffer.data() + offset + split, size - split, counter + static_cast<uint32_t>(split / mrt::ChaCha20::s_BlockSize));
+
+				is_split_same = is_split_same && std::equal(expected.begin(), expected.end(), buffer.begin() + offset);
+			}
+		}
+
+		report(std::string("chacha20 paths up to ") + mrt::ChaCha20::PathName(mrt::ChaCha20::FastestPath()) + " agree", is_same);
+		report("chacha20 split at a block agrees", is_split_same);
+	}
+
+	/// <summary>
+	/// Deletes the files written by the run.
+	/// </summary>
+	void RemoveStore(const CheckOptions& options)
+	{
+		for (const auto& entry : std::filesystem::directory_iterator(options.directory))
+		{
+			if (entry.path().filename().string().rfind("taskcheck-", 0) == 0)
+			{
+				std::error_code error;
+				std::filesystem::remove(entry.path(), error);
+			}
+		}
+	}
+}
+
+/// <summary>
+/// Checks the behaviour of the task manager's data structures against simple models, with changes made from a fixed seed.
+/// Every check prints ok or MISMATCH, and the exit code is 0 only if every check passed.
+/// The task stores are written to their own directory, so the application's tasks are never touched.
+/// </summary>
+/// <param name="argc"> The number of arguments. </param>
+/// <param name="argv"> The arguments. </param>
+/// <returns> The exit code. </returns>
+int main(int argc, char* argv[])
+{
+	CheckOptions options;
+
+	try
+	{
+		if (!ParseArguments(argc, argv, options))
+		{
+			PrintUsage();
+			return 1;
+		}
+	}
+	catch (const std::exception&)
+	{
+		PrintUsage();
+		return 1;
+	}
+
+	// The storages write to the working directory they are created in.
+	std::filesystem::create_directories(options.directory);
+	std::filesystem::current_path(options.directory);
+	RemoveStore(options);
+
+	bool passed = true;
+
+	report_func report = [&passed](const std::string& name, bool is_ok)
+		{
+			std::printf("%-48s %s\n", name.c_str(), is_ok ? "ok" : "MISMATCH");
+			passed = passed && is_ok;
+		};
+
+	CheckPersistentVector(options.seed, report);
+	CheckUndoRedo(options.seed, report);
+	CheckTaskIds(report);
+	CheckBatchLatency(report);
+	CheckDayRollover(report);
+	CheckDependenciesOverDays(report);
+	CheckRollups(options.seed, report);
+	CheckTimingWheel(options.seed, report);
+	CheckReminders(report);
+	CheckDispatcher(report);
+	CheckSubscriptionIndex(options.seed, report);
+	CheckQueryPlanner(options.seed, report);
+	CheckDependencyGraph(options.seed, report);
+	CheckJournalReplay(options.seed, report);
+	CheckConcurrentSaves(report);
+	CheckImporter(report);
+	CheckCompression(options.seed, report);
+	CheckChaCha20(options.seed, report);
+
+	if (!options.keep_store)
+	{
+		RemoveStore(options);
+	}
+
+	return passed ? 0 : 2;
+}
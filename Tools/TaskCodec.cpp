@@ -0,0 +1,608 @@
+#include "../Header Files/Storage.h"
+#include "../Header Files/StorageBinary.h"
+#include "../Header Files/StorageEncrypted.h"
+#include "../Header Files/StorageCompressed.h"
+#include "../Header Files/StorageAuthenticated.h"
+#include "../Header Files/ChaCha20Poly1305.h"
+#include "../Header Files/Lz.h"
+
+#include <array>
+#include <cstdio>
+#include <cstring>
+#include <string>
+#include <vector>
+#include <random>
+#include <memory>
+#include <chrono>
+#include <sstream>
+#include <iostream>
+#include <algorithm>
+#include <functional>
+#include <filesystem>
+
+namespace
+{
+	/// <summary>
+	/// The options of a codec run, read from the command line.
+	/// </summary>
+	struct CodecOptions
+	{
+		uint64_t tasks{ 100000 };
+		uint64_t repeat{ 3 };
+		uint64_t seed{ 42 };
+		std::vector<uint64_t> block_sizes{ 16 * 1024, CompressionStage::s_DefaultBlockSize, 1024 * 1024 };
+		std::filesystem::path directory{ std::filesystem::temp_directory_path() / "taskcodec" };
+		bool keep_store{ false };
+	};
+
+	/// <summary>
+	/// A storage chain to measure, and the chain whose files it compresses, if any.
+	/// </summary>
+	struct CodecChain
+	{
+		std::string name;
+		std::function<std::shared_ptr<Storage>()> create;
+		std::string baseline;
+	};
+
+	/// <summary>
+	/// What was measured for a chain, the times are the best of the repeats.
+	/// </summary>
+	struct CodecResult
+	{
+		std::string name;
+		uint64_t size{ 0 };
+		double write_seconds{ 0.0 };
+		double read_seconds{ 0.0 };
+		bool matches{ false };
+	};
+
+	void PrintUsage()
+	{
+		std::cout <<
+			"Usage: taskcodec [options]\n"
+			"  --tasks N         tasks written and read by every storage (default 100000)\n"
+			"  --repeat N        writes and reads of every storage, the best is reported (default 3)\n"
+			"  --blocks A,B,...  block sizes of the compressed storages in KiB (default 16,128,1024)\n"
+			"  --seed N          seed of the task generator (default 42)\n"
+			"  --dir PATH        directory the task stores are written to (default <temp>/taskcodec)\n"
+			"  --keep            keep the task stores after the run\n";
+	}
+
+	/// <summary>
+	/// Reads the options from the command line.
+	/// </summary>
+	/// <returns> True if the options are valid, false otherwise. </returns>
+	bool ParseArguments(int argc, char* argv[], CodecOptions& options)
+	{
+		for (int i = 1; i < argc; i++)
+		{
+			std::string argument = argv[i];
+			bool has_value = i + 1 < argc;
+
+			if (argument == "--keep")
+			{
+				options.keep_store = true;
+			}
+			else if (!has_value)
+			{
+				return false;
+			}
+			else if (argument == "--tasks")
+			{
+				options.tasks = std::stoull(argv[++i]);
+			}
+			else if (argument == "--repeat")
+			{
+				options.repeat = std::stoull(argv[++i]);
+			}
+			else if (argument == "--seed")
+			{
+				options.seed = std::stoull(argv[++i]);
+			}
+			else if (argument == "--dir")
+			{
+				options.directory = argv[++i];
+			}
+			else if (argument == "--blocks")
+			{
+				std::stringstream list(argv[++i]);
+				std::string size;
+
+				options.block_sizes.clear();
+
+				while (std::getline(list, size, ','))
+				{
+					options.block_sizes.push_back(std::stoull(size) * 1024);
+				}
+			}
+			else
+			{
+				return false;
+			}
+		}
+
+		return options.repeat > 0 && !options.block_sizes.empty();
+	}
+
+	/// <summary>
+	/// Generates tasks that look like the ones people write, short titles and descriptions from a small vocabulary.
+	/// </summary>
+	mrt::Vector<Task> GenerateTasks(uint64_t count, uint64_t seed)
+	{
+		static const char* const s_Words[] = {
+			"review", "team", "report", "call", "email", "budget", "plan", "meeting", "draft", "client",
+			"update", "weekly", "notes", "project", "design", "fix", "release", "check", "order", "invoice",
+			"prepare", "slides", "follow", "up", "with", "the", "for", "and", "on", "about"
+		};
+
+		std::mt19937_64 random(seed);
+		std::uniform_int_distribution<int> word(0, static_cast<int>(std::size(s_Words)) - 1);
+		std::uniform_int_distribution<int> minute(0, 23 * 60 + 59);
+
+		auto sentence = [&](int words)
+			{
+				std::string text;
+
+				for (int i = 0; i < words; i++)
+				{
+					text += (i > 0 ? " " : "") + std::string(s_Words[word(random)]);
+				}
+
+				return text;
+			};
+
+		auto time = [](int value)
+			{
+				char buffer[16];
+				std::snprintf(buffer, sizeof(buffer), "%02d:%02d", value / 60, value % 60);
+				return std::string(buffer);
+			};
+
+		mrt::Vector<Task> tasks(count);
+
+		for (uint64_t i = 0; i < count; i++)
+		{
+			int start = minute(random);
+			int end = std::min(start + 30 + static_cast<int>(random() % 120), 23 * 60 + 59);
+
+			Task task(sentence(3), sentence(8 + static_cast<int>(random() % 8)), time(start), time(end), random() % 4 == 0);
+			task.id = i + 1;
+			tasks.PushBack(std::move(task));
+		}
+
+		return tasks;
+	}
+
+	/// <summary>
+	/// Checks whether the tasks read back are the tasks that were written.
+	/// </summary>
+	bool SameTasks(const mrt::Vector<Task>& expected, const mrt::Vector<Task>& actual)
+	{
+		if (expected.Size() != actual.Size())
+			return false;
+
+		for (uint64_t i = 0; i < expected.Size(); i++)
+		{
+			const Task& a = expected[i];
+			const Task& b = actual[i];
+
+			if (a.title != b.title || a.description != b.description || a.start_time != b.start_time ||
+				a.end_time != b.end_time || a.is_done != b.is_done || a.id != b.id)
+				return false;
+		}
+
+		return true;
+	}
+
+	/// <summary>
+	/// Writes and reads the tasks with a storage chain, keeping the best time of the repeats.
+	/// </summary>
+	CodecResult Measure(const CodecChain& chain, const std::string& file_name, const mrt::Vector<Task>& tasks, uint64_t repeat)
+	{
+		CodecResult result;
+		result.name = chain.name;
+		result.matches = true;
+
+		for (uint64_t i = 0; i < repeat; i++)
+		{
+			// A storage skips writing the bytes it wrote last, so each repeat writes through a storage of its own.
+			std::shared_ptr<Storage> storage = chain.create();
+			uint64_t written = storage->BytesWritten();
+
+			auto start = std::chrono::steady_clock::now();
+			bool is_written = storage->Write(file_name, tasks);
+			double write_seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+			mrt::Vector<Task> read_tasks;
+
+			start = std::chrono::steady_clock::now();
+			bool is_read = storage->Read(file_name, read_tasks);
+			double read_seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+			result.size = storage->BytesWritten() - written;
+			result.write_seconds = i == 0 ? write_seconds : std::min(result.write_seconds, write_seconds);
+			result.read_seconds = i == 0 ? read_seconds : std::min(result.read_seconds, read_seconds);
+			result.matches = result.matches && is_written && is_read && SameTasks(tasks, read_tasks);
+		}
+
+		return result;
+	}
+
+	/// <summary>
+	/// Times the block compressor on its own, on one thread, over the binary encoding of the tasks.
+	/// </summary>
+	void MeasureBlocks(const mrt::Vector<Task>& tasks, const std::vector<uint64_t>& block_sizes, uint64_t repeat)
+	{
+		std::string raw;
+		StorageBinary::Encode(tasks, raw);
+
+		std::printf("\n%-22s %12s %10s %14s %14s\n", "lz block, one thread", "compressed", "ratio", "compress MB/s", "decompress MB/s");
+
+		for (uint64_t block_size : block_sizes)
+		{
+			std::vector<char> compressed(mrt::Lz::Bound(block_size));
+			std::string decompressed(raw.size(), '\0');
+			double compress_seconds = 0.0;
+			double decompress_seconds = 0.0;
+			uint64_t compressed_size = 0;
+			bool matches = true;
+
+			for (uint64_t i = 0; i < repeat; i++)
+			{
+				std::vector<uint64_t> sizes;
+				std::string blocks;
+
+				auto start = std::chrono::steady_clock::now();
+
+				for (uint64_t offset = 0; offset < raw.size(); offset += block_size)
+				{
+					uint64_t size = std::min<uint64_t>(block_size, raw.size() - offset);
+					uint64_t block = mrt::Lz::Compress(raw.data() + offset, size, compressed.data(), compressed.size());
+
+					blocks.append(compressed.data(), block);
+					sizes.push_back(block);
+				}
+
+				double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+				compress_seconds = i == 0 ? seconds : std::min(compress_seconds, seconds);
+				compressed_size = blocks.size();
+
+				start = std::chrono::steady_clock::now();
+
+				const char* block = blocks.data();
+
+				for (uint64_t b = 0; b < sizes.size(); b++)
+				{
+					uint64_t offset = b * block_size;
+					matches = mrt::Lz::Decompress(block, sizes[b], decompressed.data() + offset, std::min<uint64_t>(block_size, raw.size() - offset)) && matches;
+					block += sizes[b];
+				}
+
+				seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+				decompress_seconds = i == 0 ? seconds : std::min(decompress_seconds, seconds);
+				matches = matches && decompressed == raw;
+			}
+
+			double megabytes = raw.size() / (1024.0 * 1024.0);
+
+			std::printf("%-22s %12llu %10.2f %14.0f %14.0f%s\n",
+				(std::to_string(block_size / 1024) + " KiB").c_str(),
+				static_cast<unsigned long long>(compressed_size),
+				compressed_size > 0 ? static_cast<double>(raw.size()) / compressed_size : 0.0,
+				compress_seconds > 0.0 ? megabytes / compress_seconds : 0.0,
+				decompress_seconds > 0.0 ? megabytes / decompress_seconds : 0.0,
+				matches ? "" : "  MISMATCH");
+		}
+	}
+
+	/// <summary>
+	/// Reads the bytes of a hexadecimal string, as the test vectors are written.
+	/// </summary>
+	std::vector<uint8_t> FromHex(const char* text)
+	{
+		std::vector<uint8_t> bytes;
+
+		for (; text[0] != '\0' && text[1] != '\0'; text += 2)
+		{
+			bytes.push_back(static_cast<uint8_t>(std::stoi(std::string(text, 2), nullptr, 16)));
+		}
+
+		return bytes;
+	}
+
+	/// <summary>
+	/// Checks the ciphers against the test vectors of RFC 8439, the keystream on every path this processor has.
+	/// </summary>
+	/// <returns> True if every vector matches, false otherwise. </returns>
+	bool CheckVectors()
+	{
+		const std::string sunscreen = "Ladies and Gentlemen of the class of '99: If I could offer you only one tip for the future, sunscreen would be it.";
+		bool matches = true;
+
+		auto report = [&matches](const std::string& name, bool is_match)
+			{
+				std::printf("%-34s %s\n", name.c_str(), is_match ? "ok" : "MISMATCH");
+				matches = matches && is_match;
+			};
+
+		// 2.4.2, the keystream from block counter 1.
+		std::vector<uint8_t> key = FromHex("000102030405060708090a0b0c0d0e0f101112131415161718191a1b1c1d1e1f");
+		std::vector<uint8_t> nonce = FromHex("000000000000004a00000000");
+		std::vector<uint8_t> expected = FromHex(
+			"6e2e359a2568f98041ba0728dd0d6981e97e7aec1d4360c20a27afccfd9fae0bf91b65c5524733ab8f593dabcd62b357"
+			"1639d624e65152ab8f530c359f0861d807ca0dbf500d6a6156a38e088a22b65e52bc514d16ccf806818ce91ab7793736"
+			"5af90bbf74a35be6b40b8eedf2785e42874d");
+
+		for (int path = 0; path <= static_cast<int>(mrt::ChaCha20::FastestPath()); path++)
+		{
+			std::string text = sunscreen;
+			mrt::ChaCha20(key.data(), nonce.data(), static_cast<mrt::ChaCha20::Path>(path)).Apply(&text[0], text.size(), 1);
+
+			report(std::string("chacha20 2.4.2 ") + mrt::ChaCha20::PathName(static_cast<mrt::ChaCha20::Path>(path)),
+				text.size() == expected.size() && std::memcmp(text.data(), expected.data(), text.size()) == 0);
+		}
+
+		// 2.5.2, the tag of a message added in two parts.
+		std::vector<uint8_t> mac_key = FromHex("85d6be7857556d337f4452fe42d506a80103808afb0db2fd4abff6af4149f51b");
+		std::vector<uint8_t> mac_tag = FromHex("a8061dc1305136c6c22b8baf0c0127a9");
+		const std::string message = "Cryptographic Forum Research Group";
+		uint8_t tag[mrt::Poly1305::s_TagSize];
+
+		mrt::Poly1305 mac(mac_key.data());
+		mac.Update(message.data(), 5);
+		mac.Update(message.data() + 5, message.size() - 5);
+		mac.Final(tag);
+
+		report("poly1305 2.5.2", mrt::Poly1305::Equal(tag, mac_tag.data()));
+
+		// 2.8.2, sealed and opened, and refused once a byte is changed.
+		std::vector<uint8_t> aead_key = FromHex("808182838485868788898a8b8c8d8e8f909192939495969798999a9b9c9d9e9f");
+		std::vector<uint8_t> aead_nonce = FromHex("070000004041424344454647");
+		std::vector<uint8_t> aad = FromHex("50515253c0c1c2c3c4c5c6c7");
+		std::vector<uint8_t> sealed = FromHex(
+			"d31a8d34648e60db7b86afbc53ef7ec2a4aded51296e08fea9e2b5a736ee62d63dbea45e8ca9671282fafb69da92728b"
+			"1a71de0a9e060b2905d6a5b67ecd3b3692ddbd7f2d778b8c9803aee328091b58fab324e4fad675945585808b4831d7bc"
+			"3ff4def08e4b7a9de576d26586cec64b6116");
+		std::vector<uint8_t> aead_tag = FromHex("1ae10b594f09e26a7e902ecbd0600691");
+
+		for (int path = 0; path <= static_cast<int>(mrt::ChaCha20::FastestPath()); path++)
+		{
+			mrt::ChaCha20Poly1305 aead(aead_key.data(), static_cast<mrt::ChaCha20::Path>(path));
+			std::string text = sunscreen;
+
+			aead.Seal(aead_nonce.data(), aad.data(), aad.size(), &text[0], text.size(), tag);
+
+			bool is_match = text.size() == sealed.size() && std::memcmp(text.data(), sealed.data(), text.size()) == 0 && mrt::Poly1305::Equal(tag, aead_tag.data());
+			bool is_opened = aead.Open(aead_nonce.data(), aad.data(), aad.size(), &text[0], text.size(), tag) && text == sunscreen;
+
+			text[0] ^= 1;
+			bool is_refused = !aead.Open(aead_nonce.data(), aad.data(), aad.size(), &text[0], text.size(), tag);
+
+			report(std::string("chacha20-poly1305 2.8.2 ") + mrt::ChaCha20::PathName(static_cast<mrt::ChaCha20::Path>(path)), is_match && is_opened && is_refused);
+		}
+
+		return matches;
+	}
+
+	/// <summary>
+	/// Times the ciphers on their own, on one thread, over the binary encoding of the tasks, in GB/s of the bytes encrypted or authenticated.
+	/// </summary>
+	void MeasureCiphers(const mrt::Vector<Task>& tasks, uint64_t repeat)
+	{
+		std::string raw;
+		StorageBinary::Encode(tasks, raw);
+
+		std::vector<uint8_t> key = FromHex("000102030405060708090a0b0c0d0e0f101112131415161718191a1b1c1d1e1f");
+		std::vector<uint8_t> nonce = FromHex("000000000000004a00000000");
+		double gigabytes = raw.size() / 1e9;
+
+		auto best = [repeat](const std::function<void()>& run)
+			{
+				double seconds = 0.0;
+
+				for (uint64_t i = 0; i < repeat; i++)
+				{
+					auto start = std::chrono::steady_clock::now();
+					run();
+					double elapsed = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+					seconds = i == 0 ? elapsed : std::min(seconds, elapsed);
+				}
+
+				return seconds;
+			};
+
+		std::printf("\n%-34s %10s %10s\n", "cipher, one thread", "GB/s", "open GB/s");
+
+		for (int path = 0; path <= static_cast<int>(mrt::ChaCha20::FastestPath()); path++)
+		{
+			mrt::ChaCha20 cipher(key.data(), nonce.data(), static_cast<mrt::ChaCha20::Path>(path));
+			double seconds = best([&]() { cipher.Apply(&raw[0], raw.size(), 1); });
+
+			std::printf("%-34s %10.2f\n", (std::string("chacha20 ") + mrt::ChaCha20::PathName(cipher.GetPath())).c_str(), seconds > 0.0 ? gigabytes / seconds : 0.0);
+		}
+
+		uint8_t tag[mrt::Poly1305::s_TagSize];
+		double mac_seconds = best([&]()
+			{
+				mrt::Poly1305 mac(key.data());
+				mac.Update(raw.data(), raw.size());
+				mac.Final(tag);
+			});
+
+		std::printf("%-34s %10.2f\n", "poly1305", mac_seconds > 0.0 ? gigabytes / mac_seconds : 0.0);
+
+		for (int path = 0; path <= static_cast<int>(mrt::ChaCha20::FastestPath()); path++)
+		{
+			mrt::ChaCha20Poly1305 aead(key.data(), static_cast<mrt::ChaCha20::Path>(path));
+			bool is_opened = true;
+
+			double seal_seconds = best([&]() { aead.Seal(nonce.data(), nullptr, 0, &raw[0], raw.size(), tag); });
+			aead.Open(nonce.data(), nullptr, 0, &raw[0], raw.size(), tag);
+
+			double open_seconds = best([&]()
+				{
+					aead.Seal(nonce.data(), nullptr, 0, &raw[0], raw.size(), tag);
+					is_opened = aead.Open(nonce.data(), nullptr, 0, &raw[0], raw.size(), tag) && is_opened;
+				});
+
+			// The open run seals as well, so the time of a seal is taken off.
+			open_seconds = std::max(open_seconds - seal_seconds, 0.0);
+
+			std::printf("%-34s %10.2f %10.2f%s\n",
+				(std::string("chacha20-poly1305 ") + mrt::ChaCha20::PathName(static_cast<mrt::ChaCha20::Path>(path))).c_str(),
+				seal_seconds > 0.0 ? gigabytes / seal_seconds : 0.0,
+				open_seconds > 0.0 ? gigabytes / open_seconds : 0.0,
+				is_opened ? "" : "  MISMATCH");
+		}
+	}
+
+	/// <summary>
+	/// Deletes the files written by the run.
+	/// </summary>
+	void RemoveStore(const CodecOptions& options)
+	{
+		for (const auto& entry : std::filesystem::directory_iterator(options.directory))
+		{
+			if (entry.path().filename().string().rfind("taskcodec-", 0) == 0)
+			{
+				std::error_code error;
+				std::filesystem::remove(entry.path(), error);
+			}
+		}
+	}
+}
+
+/// <summary>
+/// Measures the size of the task files and the time taken to write and read them for each storage chain,
+/// with and without compression and encryption, and the speed of the block compressor and the ciphers on their own.
+/// The ciphers are checked against the test vectors of RFC 8439 first.
+/// The task stores are written to their own directory, so the application's tasks are never touched.
+/// </summary>
+/// <param name="argc"> The number of arguments. </param>
+/// <param name="argv"> The arguments. </param>
+/// <returns> The exit code. </returns>
+int main(int argc, char* argv[])
+{
+	CodecOptions options;
+
+	try
+	{
+		if (!ParseArguments(argc, argv, options))
+		{
+			PrintUsage();
+			return 1;
+		}
+	}
+	catch (const std::exception&)
+	{
+		PrintUsage();
+		return 1;
+	}
+
+	// The storages write to the working directory they are created in.
+	std::filesystem::create_directories(options.directory);
+	std::filesystem::current_path(options.directory);
+	RemoveStore(options);
+
+	mrt::Vector<Task> tasks = GenerateTasks(options.tasks, options.seed);
+
+	std::vector<CodecChain> chains = {
+		{ "xml", []() { return std::make_shared<Storage>(); }, "" },
+		{ "xml+lz", []() { return std::make_shared<StorageCompressed>(std::make_shared<Storage>()); }, "xml" },
+		{ "binary", []() { return std::make_shared<StorageBinary>(); }, "" }
+	};
+
+	for (uint64_t block_size : options.block_sizes)
+	{
+		chains.push_back({ "binary+lz " + std::to_string(block_size / 1024) + "K", [block_size]()
+			{
+				return std::make_shared<StorageCompressed>(std::make_shared<StorageBinary>(), block_size);
+			}, "binary" });
+	}
+
+	chains.push_back({ "encrypted", []()
+		{
+			return std::make_shared<StorageEncrypted>(std::make_shared<StorageBinary>());
+		}, "" });
+
+	chains.push_back({ "lz(encrypted)", []()
+		{
+			return std::make_shared<StorageCompressed>(std::make_shared<StorageEncrypted>(std::make_shared<StorageBinary>()));
+		}, "encrypted" });
+
+	chains.push_back({ "encrypted(lz)", []()
+		{
+			return std::make_shared<StorageEncrypted>(std::make_shared<StorageCompressed>(std::make_shared<StorageBinary>()));
+		}, "encrypted" });
+
+	chains.push_back({ "stream", []()
+		{
+			return std::make_shared<StorageEncrypted>(std::make_shared<StorageBinary>(), StorageEncrypted::Mode::Stream);
+		}, "encrypted" });
+
+	chains.push_back({ "lz(stream)", []()
+		{
+			return std::make_shared<StorageCompressed>(std::make_shared<StorageEncrypted>(std::make_shared<StorageBinary>(), StorageEncrypted::Mode::Stream));
+		}, "encrypted" });
+
+	chains.push_back({ "authenticated", []()
+		{
+			std::array<uint8_t, mrt::ChaCha20Poly1305::s_KeySize> key{};
+			return std::make_shared<StorageAuthenticated>(std::make_shared<StorageBinary>(), key);
+		}, "binary" });
+
+	chains.push_back({ "lz(authenticated)", []()
+		{
+			std::array<uint8_t, mrt::ChaCha20Poly1305::s_KeySize> key{};
+			return std::make_shared<StorageCompressed>(std::make_shared<StorageAuthenticated>(std::make_shared<StorageBinary>(), key));
+		}, "binary" });
+
+	bool vectors_match = CheckVectors();
+	std::printf("\n");
+
+	std::vector<CodecResult> results;
+
+	std::printf("%-22s %12s %10s %10s %10s %12s %12s\n", "storage", "bytes", "ratio", "write ms", "read ms", "write MB/s", "read MB/s");
+
+	for (const CodecChain& chain : chains)
+	{
+		CodecResult result = Measure(chain, "taskcodec-" + std::to_string(results.size()), tasks, options.repeat);
+		uint64_t baseline = result.size;
+
+		for (const CodecResult& other : results)
+		{
+			if (other.name == chain.baseline)
+			{
+				baseline = other.size;
+			}
+		}
+
+		// The throughput is of the bytes the tasks take up before compression.
+		double megabytes = baseline / (1024.0 * 1024.0);
+
+		std::printf("%-22s %12llu %10.2f %10.2f %10.2f %12.0f %12.0f%s\n",
+			result.name.c_str(),
+			static_cast<unsigned long long>(result.size),
+			result.size > 0 ? static_cast<double>(baseline) / result.size : 0.0,
+			result.write_seconds * 1000.0,
+			result.read_seconds * 1000.0,
+			result.write_seconds > 0.0 ? megabytes / result.write_seconds : 0.0,
+			result.read_seconds > 0.0 ? megabytes / result.read_seconds : 0.0,
+			result.matches ? "" : "  MISMATCH");
+
+		results.push_back(result);
+	}
+
+	MeasureBlocks(tasks, options.block_sizes, options.repeat);
+	MeasureCiphers(tasks, options.repeat);
+
+	if (!options.keep_store)
+	{
+		RemoveStore(options);
+	}
+
+	bool matches = std::all_of(results.begin(), results.end(), [](const CodecResult& result) { return result.matches; });
+
+	return matches && vectors_match ? 0 : 2;
+}
@@ -0,0 +1,178 @@
+#include "../Header Files/TaskManager.h"
+#include "../Header Files/TaskImporter.h"
+#include "../Header Files/Time.h"
+
+#include <cstdio>
+#include <string>
+#include <chrono>
+#include <future>
+#include <memory>
+#include <iostream>
+#include <filesystem>
+
+namespace
+{
+	/// <summary>
+	/// The options of an import, read from the command line.
+	/// </summary>
+	struct ImportOptions
+	{
+		std::string path{ "" };
+		bool has_format{ false };
+		ImportFormat format{ ImportFormat::Csv };
+		std::string store_name{ "taskimport" };
+		std::filesystem::path directory{ "" };
+		uint64_t batch_size{ TaskImporter::s_DefaultBatchSize };
+		uint64_t chunk_size{ TaskImporter::s_DefaultChunkSize };
+	};
+
+	void PrintUsage()
+	{
+		std::cout <<
+			"Usage: taskimport [options] FILE\n"
+			"  FILE              a .csv file with a header row, or a .ndjson file with one object per line\n"
+			"                    the columns or keys are title, description, start, end and done\n"
+			"  --format F        csv or ndjson, when the extension does not say\n"
+			"  --store NAME      task store the tasks are added to (default taskimport)\n"
+			"  --dir PATH        directory of the task store (default the working directory)\n"
+			"  --batch N         tasks added to the task manager at a time (default 1024)\n"
+			"  --chunk N         bytes read from the file at a time, also the longest row (default 65536)\n";
+	}
+
+	/// <summary>
+	/// Reads the options from the command line.
+	/// </summary>
+	/// <returns> True if the options are valid, false otherwise. </returns>
+	bool ParseArguments(int argc, char* argv[], ImportOptions& options)
+	{
+		for (int i = 1; i < argc; i++)
+		{
+			std::string argument = argv[i];
+			bool has_value = i + 1 < argc;
+
+			if (argument == "--format" && has_value)
+			{
+				std::string format = argv[++i];
+
+				if (format != "csv" && format != "ndjson")
+					return false;
+
+				options.has_format = true;
+				options.format = format == "csv" ? ImportFormat::Csv : ImportFormat::Ndjson;
+			}
+			else if (argument == "--store" && has_value)
+			{
+				options.store_name = argv[++i];
+			}
+			else if (argument == "--dir" && has_value)
+			{
+				options.directory = argv[++i];
+			}
+			else if (argument == "--batch" && has_value)
+			{
+				options.batch_size = std::stoull(argv[++i]);
+			}
+			else if (argument == "--chunk" && has_value)
+			{
+				options.chunk_size = std::stoull(argv[++i]);
+			}
+			else if (argument.rfind("--", 0) != 0 && options.path.empty())
+			{
+				options.path = argument;
+			}
+			else
+			{
+				return false;
+			}
+		}
+
+		if (options.path.empty())
+			return false;
+
+		return options.has_format || TaskImporter::FormatOf(options.path, options.format);
+	}
+}
+
+/// <summary>
+/// Imports tasks from a CSV or NDJSON file into a task store, reporting the progress as it goes.
+/// </summary>
+int main(int argc, char* argv[])
+{
+	ImportOptions options;
+
+	try
+	{
+		if (!ParseArguments(argc, argv, options))
+		{
+			PrintUsage();
+			return 1;
+		}
+	}
+	catch (const std::exception&)
+	{
+		PrintUsage();
+		return 1;
+	}
+
+	// The file is opened before the working directory changes to the task store's.
+	std::string path = std::filesystem::absolute(options.path).string();
+
+	if (!options.directory.empty())
+	{
+		std::filesystem::create_directories(options.directory);
+		std::filesystem::current_path(options.directory);
+	}
+
+	std::shared_ptr<std::promise<void>> loaded = std::make_shared<std::promise<void>>();
+	std::future<void> is_loaded = loaded->get_future();
+
+	TaskManager manager(options.store_name, [loaded](const TaskLoadMetrics&)
+		{
+			loaded->set_value();
+		});
+
+	// The imported tasks are added after the stored tasks, so they keep the order of the file.
+	is_loaded.wait();
+
+	if (manager.GetLoadMetrics().failed)
+	{
+		std::cerr << manager.GetLoadMetrics().error << std::endl;
+		return 2;
+	}
+
+	TaskImporter importer(manager, options.batch_size, options.chunk_size);
+	mrt::time::Stopwatch stopwatch;
+
+	bool started = importer.Start(path, options.format, [](const ImportProgress& progress)
+		{
+			double percent = progress.total_bytes > 0 ? 100.0 * progress.bytes_read / progress.total_bytes : 100.0;
+
+			std::fprintf(stderr, "\r%5.1f%%  %llu tasks imported, %llu rows rejected",
+				percent,
+				static_cast<unsigned long long>(progress.tasks_imported),
+				static_cast<unsigned long long>(progress.rows_rejected));
+		});
+
+	if (!started)
+	{
+		std::cerr << "Cannot open " << options.path << std::endl;
+		return 1;
+	}
+
+	ImportProgress progress = importer.Wait();
+	double seconds = stopwatch.ElapsedMilliseconds() / 1000.0;
+
+	std::fprintf(stderr, "\n");
+	std::printf("imported %llu tasks in %.2f s (%.0f tasks/s), %llu rows rejected\n",
+		static_cast<unsigned long long>(progress.tasks_imported),
+		seconds,
+		seconds > 0.0 ? progress.tasks_imported / seconds : 0.0,
+		static_cast<unsigned long long>(progress.rows_rejected));
+
+	if (!progress.error.empty())
+	{
+		std::printf("%s: %s\n", progress.succeeded ? "first rejected row" : "import failed", progress.error.c_str());
+	}
+
+	return progress.succeeded ? 0 : 2;
+}
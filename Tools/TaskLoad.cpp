@@ -0,0 +1,646 @@
+#include "../Header Files/TaskManager.h"
+#include "../Header Files/Observer.h"
+#include "../Header Files/ReminderScheduler.h"
+#include "../Header Files/TaskManagerRegistry.h"
+#include "../Header Files/Time.h"
+
+#include <cstdio>
+#include <cstdlib>
+#include <string>
+#include <vector>
+#include <random>
+#include <thread>
+#include <future>
+#include <memory>
+#include <chrono>
+#include <iostream>
+#include <algorithm>
+#include <filesystem>
+
+namespace
+{
+	/// <summary>
+	/// The options of a load run, read from the command line.
+	/// </summary>
+	struct LoadOptions
+	{
+		uint64_t tasks{ 10000 };
+		uint64_t operations{ 20000 };
+		uint64_t add_weight{ 50 };
+		uint64_t remove_weight{ 25 };
+		uint64_t complete_weight{ 25 };
+		uint64_t observers{ 1 };
+		uint64_t reminders{ 0 };
+		uint64_t lists{ 0 };
+		uint64_t seed{ 42 };
+		std::string store_name{ "taskload" };
+		std::filesystem::path directory{ std::filesystem::temp_directory_path() / "taskload" };
+		std::string stats_path{ "" };
+		bool keep_store{ false };
+	};
+
+	/// <summary>
+	/// Records the latency of each call of an operation, and reports the throughput and the latency percentiles.
+	/// </summary>
+	class LatencyRecorder
+	{
+	private:
+		std::string m_Name;
+		std::vector<uint64_t> m_Samples;
+		std::chrono::steady_clock::duration m_Total{ 0 };
+	public:
+		LatencyRecorder(const std::string& name)
+			: m_Name(name)
+		{
+		}
+
+		/// <summary>
+		/// Runs the function and records how long it took.
+		/// </summary>
+		/// <param name="func"> The operation to run. </param>
+		template <typename _Func>
+		void Measure(_Func func)
+		{
+			auto start = std::chrono::steady_clock::now();
+			func();
+			auto elapsed = std::chrono::steady_clock::now() - start;
+
+			m_Total += elapsed;
+			m_Samples.push_back(std::chrono::duration_cast<std::chrono::nanoseconds>(elapsed).count());
+		}
+
+		/// <summary>
+		/// Prints a line with the operation's count, throughput and latency percentiles.
+		/// </summary>
+		void Report()
+		{
+			if (m_Samples.empty())
+			{
+				std::printf("%-10s %10d\n", m_Name.c_str(), 0);
+				return;
+			}
+
+			std::sort(m_Samples.begin(), m_Samples.end());
+
+			double seconds = std::chrono::duration<double>(m_Total).count();
+
+			std::printf("%-10s %10zu %12.0f %10.2f %10.2f %10.2f %10.2f %10.2f\n",
+				m_Name.c_str(),
+				m_Samples.size(),
+				seconds > 0.0 ? m_Samples.size() / seconds : 0.0,
+				Percentile(0.50), Percentile(0.90), Percentile(0.99), Percentile(0.999),
+				m_Samples.back() / 1000.0);
+		}
+
+		/// <summary>
+		/// Adds the samples of another recorder, used to combine the recorders of several threads.
+		/// </summary>
+		void Merge(const LatencyRecorder& other)
+		{
+			m_Samples.insert(m_Samples.end(), other.m_Samples.begin(), other.m_Samples.end());
+			m_Total += other.m_Total;
+		}
+
+		static void PrintHeader()
+		{
+			std::printf("%-10s %10s %12s %10s %10s %10s %10s %10s\n", "operation", "count", "ops/s", "p50 us", "p90 us", "p99 us", "p99.9 us", "max us");
+		}
+
+	private:
+		/// <summary>
+		/// Gets a percentile of the sorted samples, in microseconds.
+		/// </summary>
+		double Percentile(double fraction) const
+		{
+			uint64_t index = static_cast<uint64_t>(fraction * (m_Samples.size() - 1) + 0.5);
+
+			return m_Samples[index] / 1000.0;
+		}
+	};
+
+	/// <summary>
+	/// An observer that only counts its updates, so the cost of notifying is part of every measured operation.
+	/// </summary>
+	class CountingObserver : public Observer
+	{
+	public:
+		uint64_t updates{ 0 };
+		uint64_t last_size{ 0 };
+
+		void Update(const mrt::PersistentVector<Task>& tasks) override
+		{
+			updates++;
+			last_size = tasks.Size();
+		}
+	};
+
+	void PrintUsage()
+	{
+		std::cout <<
+			"Usage: taskload [options]\n"
+			"  --tasks N         tasks added before the measured mix (default 10000)\n"
+			"  --ops N           operations in the measured mix (default 20000)\n"
+			"  --mix A:R:C       weights of add, remove and complete in the mix (default 50:25:25)\n"
+			"  --observers N     synchronous observers attached to the task manager (default 1)\n"
+			"  --lists N         also run the workload split over N lists of a registry, one thread per list (default 0)\n"
+			"  --reminders N     also schedule N reminders on a manual clock and time a day of ticks (default 0)\n"
+			"  --seed N          seed of the workload generator (default 42)\n"
+			"  --dir PATH        directory the task store is written to (default <temp>/taskload)\n"
+			"  --stats PATH      write the task manager's own stats to a file every second\n"
+			"  --keep            keep the task store after the run\n";
+	}
+
+	/// <summary>
+	/// Reads the options from the command line.
+	/// </summary>
+	/// <returns> True if the options are valid, false otherwise. </returns>
+	bool ParseArguments(int argc, char* argv[], LoadOptions& options)
+	{
+		for (int i = 1; i < argc; i++)
+		{
+			std::string argument = argv[i];
+			bool has_value = i + 1 < argc;
+
+			if (argument == "--keep")
+			{
+				options.keep_store = true;
+			}
+			else if (!has_value)
+			{
+				return false;
+			}
+			else if (argument == "--tasks")
+			{
+				options.tasks = std::stoull(argv[++i]);
+			}
+			else if (argument == "--ops")
+			{
+				options.operations = std::stoull(argv[++i]);
+			}
+			else if (argument == "--observers")
+			{
+				options.observers = std::stoull(argv[++i]);
+			}
+			else if (argument == "--lists")
+			{
+				options.lists = std::stoull(argv[++i]);
+			}
+			else if (argument == "--reminders")
+			{
+				options.reminders = std::stoull(argv[++i]);
+			}
+			else if (argument == "--seed")
+			{
+				options.seed = std::stoull(argv[++i]);
+			}
+			else if (argument == "--dir")
+			{
+				options.directory = argv[++i];
+			}
+			else if (argument == "--stats")
+			{
+				options.stats_path = std::filesystem::absolute(argv[++i]).string();
+			}
+			else if (argument == "--mix")
+			{
+				if (std::sscanf(argv[++i], "%llu:%llu:%llu",
+					reinterpret_cast<unsigned long long*>(&options.add_weight),
+					reinterpret_cast<unsigned long long*>(&options.remove_weight),
+					reinterpret_cast<unsigned long long*>(&options.complete_weight)) != 3)
+					return false;
+			}
+			else
+			{
+				return false;
+			}
+		}
+
+		return options.add_weight + options.remove_weight + options.complete_weight > 0;
+	}
+
+	/// <summary>
+	/// Formats a random time of day as HH:MM.
+	/// </summary>
+	std::string RandomTime(std::mt19937_64& random, int min_minute)
+	{
+		int minute = std::uniform_int_distribution<int>(min_minute, 23 * 60 + 59)(random);
+
+		char buffer[16];
+		std::snprintf(buffer, sizeof(buffer), "%02d:%02d", minute / 60, minute % 60);
+
+		return buffer;
+	}
+
+	/// <summary>
+	/// Creates a task manager and waits for its stored tasks to load.
+	/// </summary>
+	std::unique_ptr<TaskManager> StartTaskManager(const std::string& store_name)
+	{
+		// The callback keeps the promise alive, it may still be running when the wait returns.
+		std::shared_ptr<std::promise<void>> loaded = std::make_shared<std::promise<void>>();
+		std::future<void> is_loaded = loaded->get_future();
+
+		std::unique_ptr<TaskManager> manager = std::make_unique<TaskManager>(store_name, [loaded](const TaskLoadMetrics&)
+			{
+				loaded->set_value();
+			});
+
+		is_loaded.wait();
+
+		return manager;
+	}
+
+	/// <summary>
+	/// Deletes the files of the task store, including the partitions and the manifest.
+	/// </summary>
+	void RemoveStore(const LoadOptions& options)
+	{
+		for (const auto& entry : std::filesystem::directory_iterator(options.directory))
+		{
+			std::string file_name = entry.path().filename().string();
+
+			if (file_name.rfind(options.store_name, 0) == 0 || file_name.rfind("list-" + options.store_name, 0) == 0)
+			{
+				std::filesystem::remove(entry.path());
+			}
+		}
+	}
+
+	Task RandomTask(std::mt19937_64& random, uint64_t number)
+	{
+		std::string start_time = RandomTime(random, 0);
+		std::string end_time = RandomTime(random, mrt::time::ParseMinuteOfDay(start_time));
+
+		return Task("task-" + std::to_string(number), "Generated by taskload", start_time, end_time, false);
+	}
+
+	/// <summary>
+	/// The tasks a workload has added and not removed, so removes and completes always find a task.
+	/// </summary>
+	struct Workload
+	{
+		std::vector<std::string> live_titles;
+		uint64_t next_task{ 0 };
+	};
+
+	/// <summary>
+	/// The recorders of the operations of a workload.
+	/// </summary>
+	struct MixRecorders
+	{
+		LatencyRecorder populate{ "populate" };
+		LatencyRecorder add{ "add" };
+		LatencyRecorder remove{ "remove" };
+		LatencyRecorder complete{ "complete" };
+
+		void Merge(const MixRecorders& other)
+		{
+			populate.Merge(other.populate);
+			add.Merge(other.add);
+			remove.Merge(other.remove);
+			complete.Merge(other.complete);
+		}
+
+		void Report()
+		{
+			populate.Report();
+			add.Report();
+			remove.Report();
+			complete.Report();
+		}
+	};
+
+	/// <summary>
+	/// Adds the specified number of tasks.
+	/// </summary>
+	void Populate(TaskManager& manager, uint64_t count, std::mt19937_64& random, Workload& workload, LatencyRecorder& populate)
+	{
+		for (uint64_t i = 0; i < count; i++)
+		{
+			Task task = RandomTask(random, workload.next_task++);
+			workload.live_titles.push_back(task.title);
+
+			populate.Measure([&]()
+				{
+					manager.AddTask(task);
+				});
+		}
+	}
+
+	/// <summary>
+	/// Runs the specified number of operations, picking add, remove or complete by the weights of the mix.
+	/// </summary>
+	void RunMix(TaskManager& manager, const LoadOptions& options, uint64_t operations, std::mt19937_64& random, Workload& workload, MixRecorders& recorders)
+	{
+		std::discrete_distribution<int> mix({ double(options.add_weight), double(options.remove_weight), double(options.complete_weight) });
+
+		for (uint64_t i = 0; i < operations; i++)
+		{
+			int operation = mix(random);
+
+			// Removing or completing needs a task, an empty task manager gets an add instead.
+			if (workload.live_titles.empty())
+			{
+				operation = 0;
+			}
+
+			if (operation == 0)
+			{
+				Task task = RandomTask(random, workload.next_task++);
+				workload.live_titles.push_back(task.title);
+
+				recorders.add.Measure([&]()
+					{
+						manager.AddTask(task);
+					});
+			}
+			else if (operation == 1)
+			{
+				uint64_t index = std::uniform_int_distribution<uint64_t>(0, workload.live_titles.size() - 1)(random);
+				std::string title = workload.live_titles[index];
+
+				workload.live_titles[index] = workload.live_titles.back();
+				workload.live_titles.pop_back();
+
+				recorders.remove.Measure([&]()
+					{
+						manager.RemoveTask(title);
+					});
+			}
+			else
+			{
+				uint64_t index = std::uniform_int_distribution<uint64_t>(0, workload.live_titles.size() - 1)(random);
+				bool completed = std::bernoulli_distribution(0.5)(random);
+
+				recorders.complete.Measure([&]()
+					{
+						manager.CompleteTask(workload.live_titles[index], completed);
+					});
+			}
+		}
+	}
+
+	/// <summary>
+	/// Splits the workload over several lists of a registry, each list driven by its own thread.
+	/// The lists do not share a lock, so the overall throughput should grow with the number of lists.
+	/// </summary>
+	void RunLists(const LoadOptions& options)
+	{
+		TaskManagerRegistry registry;
+		std::vector<TaskManager*> lists;
+
+		for (uint64_t i = 0; i < options.lists; i++)
+		{
+			lists.push_back(registry.Open(options.store_name + "-" + std::to_string(i)));
+		}
+
+		for (TaskManager* list : lists)
+		{
+			while (!list->IsLoaded())
+			{
+				std::this_thread::sleep_for(std::chrono::milliseconds(1));
+			}
+		}
+
+		std::vector<MixRecorders> list_recorders(options.lists);
+		std::vector<std::thread> threads;
+
+		auto start = std::chrono::steady_clock::now();
+
+		for (uint64_t i = 0; i < options.lists; i++)
+		{
+			threads.emplace_back([&options, &lists, &list_recorders, i]()
+				{
+					std::mt19937_64 random(options.seed + i + 1);
+					Workload workload;
+
+					Populate(*lists[i], options.tasks / options.lists, random, workload, list_recorders[i].populate);
+					RunMix(*lists[i], options, options.operations / options.lists, random, workload, list_recorders[i]);
+				});
+		}
+
+		for (std::thread& thread : threads)
+		{
+			thread.join();
+		}
+
+		double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+		MixRecorders recorders;
+
+		for (const MixRecorders& list_recorder : list_recorders)
+		{
+			recorders.Merge(list_recorder);
+		}
+
+		LatencyRecorder query("query");
+		uint64_t found = 0;
+
+		for (int i = 0; i < 20; i++)
+		{
+			query.Measure([&]()
+				{
+					found = registry.FindTasks([](const Task& task)
+						{
+							return task.is_done;
+						}).Size();
+				});
+		}
+
+		uint64_t operations = (options.tasks / options.lists + options.operations / options.lists) * options.lists;
+
+		std::printf("\n%llu lists on %llu threads: %.0f ops/s overall, %llu tasks, %llu completed found by the query\n",
+			static_cast<unsigned long long>(options.lists),
+			static_cast<unsigned long long>(options.lists),
+			seconds > 0.0 ? operations / seconds : 0.0,
+			static_cast<unsigned long long>(registry.TaskCount()),
+			static_cast<unsigned long long>(found));
+
+		LatencyRecorder::PrintHeader();
+		recorders.Report();
+		query.Report();
+	}
+
+	/// <summary>
+	/// Schedules reminders on a manual clock, then advances the clock through the rest of the day one tick at a time.
+	/// The ticks show whether the cost of polling stays flat with many reminders pending.
+	/// </summary>
+	void RunReminders(const LoadOptions& options, std::mt19937_64& random)
+	{
+		ReminderScheduler::Clock::time_point now = mrt::time::StartOfDay(ReminderScheduler::Clock::now());
+		ReminderScheduler scheduler([&now]() { return now; }, false, std::chrono::minutes(1));
+
+		LatencyRecorder schedule("schedule");
+		LatencyRecorder tick("tick");
+		LatencyRecorder cancel("cancel");
+
+		for (uint64_t i = 0; i < options.reminders; i++)
+		{
+			Task task = RandomTask(random, i);
+			task.id = i + 1;
+
+			schedule.Measure([&]()
+				{
+					scheduler.Schedule(task);
+				});
+		}
+
+		uint64_t pending = scheduler.PendingCount();
+
+		for (uint64_t i = 0; i < options.reminders / 4; i++)
+		{
+			uint64_t task_id = std::uniform_int_distribution<uint64_t>(1, options.reminders)(random);
+
+			cancel.Measure([&]()
+				{
+					scheduler.Cancel(task_id);
+				});
+		}
+
+		// The ticks stop at 23:59, past midnight the scheduler arms every task again for the next day.
+		for (int minute = 1; minute < 24 * 60; minute++)
+		{
+			now += std::chrono::minutes(1);
+
+			tick.Measure([&]()
+				{
+					scheduler.Poll();
+				});
+		}
+
+		std::printf("\n%llu reminders pending after scheduling, %llu left after a day of ticks\n",
+			static_cast<unsigned long long>(pending),
+			static_cast<unsigned long long>(scheduler.PendingCount()));
+
+		LatencyRecorder::PrintHeader();
+		schedule.Report();
+		cancel.Report();
+		tick.Report();
+	}
+}
+
+/// <summary>
+/// Generates a synthetic workload against the task manager and reports the throughput and latency of each operation.
+/// The tasks are first added, then a random mix of add, remove and complete is run, and finally the tasks are saved and loaded again.
+/// The task store is written to its own directory, so the application's tasks are never touched.
+/// </summary>
+/// <param name="argc"> The number of arguments. </param>
+/// <param name="argv"> The arguments. </param>
+/// <returns> The exit code. </returns>
+int main(int argc, char* argv[])
+{
+	LoadOptions options;
+
+	try
+	{
+		if (!ParseArguments(argc, argv, options))
+		{
+			PrintUsage();
+			return 1;
+		}
+	}
+	catch (const std::exception&)
+	{
+		PrintUsage();
+		return 1;
+	}
+
+	// The storage writes to the working directory, a store left by an earlier run would be loaded while the mix runs.
+	std::filesystem::create_directories(options.directory);
+	std::filesystem::current_path(options.directory);
+	RemoveStore(options);
+
+	std::mt19937_64 random(options.seed);
+	std::vector<CountingObserver> observers(options.observers);
+	Workload workload;
+	MixRecorders recorders;
+	LatencyRecorder save("save");
+	LatencyRecorder load("load");
+	LatencyRecorder save_edit("save edit");
+
+	std::unique_ptr<TaskManager> manager = StartTaskManager(options.store_name);
+	manager->DumpStats(options.stats_path, std::chrono::seconds(1));
+
+	for (CountingObserver& observer : observers)
+	{
+		manager->Attach(&observer);
+	}
+
+	Populate(*manager, options.tasks, random, workload, recorders.populate);
+
+	RunMix(*manager, options, options.operations, random, workload, recorders);
+
+	for (CountingObserver& observer : observers)
+	{
+		manager->Detach(&observer);
+	}
+
+	uint64_t saved_tasks = manager->Snapshot().Size();
+
+	// The task manager writes its tasks when it is destroyed.
+	save.Measure([&]()
+		{
+			manager.reset();
+		});
+
+	TaskLoadMetrics load_metrics;
+
+	load.Measure([&]()
+		{
+			manager = StartTaskManager(options.store_name);
+			load_metrics = manager->GetLoadMetrics();
+		});
+
+	bool loaded_all = load_metrics.task_count == saved_tasks;
+
+	// Each save follows a single completed task, so it only writes that task.
+	mrt::PersistentVector<Task> loaded_tasks = manager->Snapshot();
+
+	for (uint64_t i = 0; i < std::min<uint64_t>(loaded_tasks.Size(), 32); i++)
+	{
+		manager->CompleteTask(loaded_tasks[i].title, !loaded_tasks[i].is_done);
+
+		save_edit.Measure([&]()
+			{
+				manager->Save();
+			});
+	}
+
+	// The edits have been saved, so the save as the task manager is destroyed writes nothing.
+	manager.reset();
+
+	LatencyRecorder::PrintHeader();
+	recorders.Report();
+	save.Report();
+	load.Report();
+	save_edit.Report();
+
+	std::printf("\nsaved %llu tasks, loaded %llu tasks, first %llu tasks after %.2f ms\n",
+		static_cast<unsigned long long>(saved_tasks),
+		static_cast<unsigned long long>(load_metrics.task_count),
+		static_cast<unsigned long long>(load_metrics.first_task_count),
+		load_metrics.first_tasks_ms);
+
+	if (options.lists > 0)
+	{
+		RunLists(options);
+	}
+
+	if (options.reminders > 0)
+	{
+		RunReminders(options, random);
+	}
+
+	if (!options.keep_store)
+	{
+		RemoveStore(options);
+	}
+
+	if (!loaded_all)
+	{
+		std::cerr << "taskload: the loaded tasks do not match the saved tasks" << std::endl;
+		return 2;
+	}
+
+	return 0;
+}